@@ -0,0 +1,708 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+/*
+ * bench_ops: per operator micro benchmark.
+ * Every case is a single node graph built with the C API, run for each implementation registry and thread
+ * count, and timed by a graph profiling session. The results are written as JSON, and compared with a
+ * baseline saved by a previous run to tell which kernel regressed.
+ */
+#include <unistd.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+#include "tengine_c_api.h"
+
+struct BenchCase
+{
+    std::string name;
+    std::string op;
+    std::vector<std::vector<int>> inputs;    // var inputs
+    std::vector<std::vector<int>> consts;    // const inputs, after the var inputs
+    std::vector<std::pair<std::string, int>> int_attrs;
+    std::vector<std::pair<std::string, float>> float_attrs;
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string op;
+    std::string registry;
+    std::string impl;
+    int threads;
+    int repeat;
+    double avg_us;
+    double min_us;
+    double gflops;
+    double gbps;
+};
+
+static int repeat_count = 20;
+static int warm_count = 3;
+
+static BenchCase ConvCase(int c, int h, int w, int outc, int k, int s, int p, int g)
+{
+    BenchCase bc;
+    char name[128];
+
+    snprintf(name, sizeof(name), "conv%s_k%ds%dp%d_%dx%dx%d_o%d", g > 1 ? "dw" : "", k, s, p, c, h, w, outc);
+
+    bc.name = name;
+    bc.op = "Convolution";
+    bc.inputs.push_back({1, c, h, w});
+    bc.consts.push_back({outc, c / g, k, k});
+    bc.consts.push_back({outc});
+
+    const char* same_attrs[][2] = {{"kernel_h", "kernel_w"}, {"stride_h", "stride_w"}, {"pad_h0", "pad_w0"},
+                                   {"pad_h1", "pad_w1"}};
+    int same_vals[] = {k, s, p, p};
+
+    for(int i = 0; i < 4; i++)
+    {
+        bc.int_attrs.push_back({same_attrs[i][0], same_vals[i]});
+        bc.int_attrs.push_back({same_attrs[i][1], same_vals[i]});
+    }
+
+    bc.int_attrs.push_back({"output_channel", outc});
+    bc.int_attrs.push_back({"group", g});
+    bc.int_attrs.push_back({"dilation_h", 1});
+    bc.int_attrs.push_back({"dilation_w", 1});
+
+    return bc;
+}
+
+static BenchCase FCCase(int c, int outc)
+{
+    BenchCase bc;
+
+    bc.name = "fc_" + std::to_string(c) + "_o" + std::to_string(outc);
+    bc.op = "FullyConnected";
+    bc.inputs.push_back({1, c});
+    bc.consts.push_back({outc, c});
+    bc.consts.push_back({outc});
+    bc.int_attrs.push_back({"num_output", outc});
+
+    return bc;
+}
+
+/* alg: 0 max, 1 avg */
+static BenchCase PoolCase(int c, int h, int w, int k, int s, int p, int alg, int global)
+{
+    BenchCase bc;
+    char name[128];
+
+    if(global)
+        snprintf(name, sizeof(name), "pool%s_global_%dx%dx%d", alg ? "avg" : "max", c, h, w);
+    else
+        snprintf(name, sizeof(name), "pool%s_k%ds%dp%d_%dx%dx%d", alg ? "avg" : "max", k, s, p, c, h, w);
+
+    bc.name = name;
+    bc.op = "Pooling";
+    bc.inputs.push_back({1, c, h, w});
+    bc.int_attrs = {{"kernel_h", k}, {"kernel_w", k}, {"stride_h", s}, {"stride_w", s}, {"pad_h0", p},
+                    {"pad_w0", p},   {"pad_h1", p},   {"pad_w1", p},   {"alg", alg},    {"global", global}};
+
+    return bc;
+}
+
+static BenchCase EltwiseSumCase(int c, int h, int w)
+{
+    BenchCase bc;
+
+    bc.name = "eltsum_" + std::to_string(c) + "x" + std::to_string(h) + "x" + std::to_string(w);
+    bc.op = "Eltwise";
+    bc.inputs.push_back({1, c, h, w});
+    bc.inputs.push_back({1, c, h, w});
+    bc.int_attrs.push_back({"type", 2});    // ELT_SUM
+
+    return bc;
+}
+
+static BenchCase ReLuCase(int c, int h, int w)
+{
+    BenchCase bc;
+
+    bc.name = "relu_" + std::to_string(c) + "x" + std::to_string(h) + "x" + std::to_string(w);
+    bc.op = "ReLu";
+    bc.inputs.push_back({1, c, h, w});
+    bc.float_attrs.push_back({"negative_slope", 0.f});
+
+    return bc;
+}
+
+static BenchCase SoftmaxCase(int c)
+{
+    BenchCase bc;
+
+    bc.name = "softmax_" + std::to_string(c);
+    bc.op = "Softmax";
+    bc.inputs.push_back({1, c, 1, 1});
+    bc.int_attrs.push_back({"axis", 1});
+
+    return bc;
+}
+
+static std::vector<BenchCase> GetBenchCases(void)
+{
+    std::vector<BenchCase> cases;
+
+    cases.push_back(ConvCase(3, 224, 224, 32, 3, 2, 1, 1));
+    cases.push_back(ConvCase(64, 56, 56, 64, 1, 1, 0, 1));
+    cases.push_back(ConvCase(64, 56, 56, 64, 3, 1, 1, 1));
+    cases.push_back(ConvCase(128, 28, 28, 256, 3, 2, 1, 1));
+    cases.push_back(ConvCase(256, 14, 14, 256, 3, 1, 1, 1));
+    cases.push_back(ConvCase(512, 7, 7, 1024, 1, 1, 0, 1));
+    cases.push_back(ConvCase(128, 56, 56, 128, 3, 1, 1, 128));
+    cases.push_back(ConvCase(512, 14, 14, 512, 3, 2, 1, 512));
+    cases.push_back(FCCase(1024, 1000));
+    cases.push_back(FCCase(4096, 4096));
+    cases.push_back(PoolCase(64, 112, 112, 3, 2, 1, 0, 0));
+    cases.push_back(PoolCase(64, 112, 112, 2, 2, 0, 1, 0));
+    cases.push_back(PoolCase(1024, 7, 7, 7, 1, 0, 1, 1));
+    cases.push_back(EltwiseSumCase(64, 56, 56));
+    cases.push_back(ReLuCase(64, 112, 112));
+    cases.push_back(SoftmaxCase(1000));
+
+    return cases;
+}
+
+static unsigned int rand_seed = 1;
+
+static void FillRandom(std::vector<float>& data)
+{
+    for(auto& v : data)
+    {
+        rand_seed = rand_seed * 1103515245 + 12345;
+        v = ((rand_seed >> 16) & 0x7fff) / 32768.f - 0.5f;
+    }
+}
+
+static int GetShapeSize(const std::vector<int>& dims)
+{
+    int size = 1;
+
+    for(int d : dims)
+        size *= d;
+
+    return size;
+}
+
+/* the value of "key" in one JSON record written by this tool or by dump_graph_profiling() */
+static bool GetJsonItem(const char* line, const char* key, std::string& val)
+{
+    std::string pattern = std::string("\"") + key + "\":";
+    const char* p = strstr(line, pattern.c_str());
+
+    if(p == nullptr)
+        return false;
+
+    p += pattern.size();
+
+    if(*p == '"')
+    {
+        const char* end = strchr(p + 1, '"');
+
+        if(end == nullptr)
+            return false;
+
+        val.assign(p + 1, end);
+    }
+    else
+    {
+        size_t len = strcspn(p, ",}\n");
+
+        val.assign(p, len);
+    }
+
+    return true;
+}
+
+static double GetJsonNumber(const char* line, const char* key)
+{
+    std::string val;
+
+    return GetJsonItem(line, key, val) ? atof(val.c_str()) : 0;
+}
+
+static bool RunCase(const BenchCase& bc, const std::string& registry, BenchResult& result)
+{
+    /* FindNodeOps() looks the env up for each node */
+    if(registry == "default")
+    {
+        unsetenv("OPS_REGISTRY");
+        unsetenv("OP_NAME");
+    }
+    else
+    {
+        setenv("OPS_REGISTRY", registry.c_str(), 1);
+        setenv("OP_NAME", bc.op.c_str(), 1);
+    }
+
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+    node_t node = create_graph_node(graph, "op", bc.op.c_str());
+    std::vector<std::vector<float>> buffers;
+    std::vector<std::string> input_names;
+
+    for(unsigned int i = 0; i < bc.inputs.size() + bc.consts.size(); i++)
+    {
+        bool is_var = i < bc.inputs.size();
+        const std::vector<int>& dims = is_var ? bc.inputs[i] : bc.consts[i - bc.inputs.size()];
+        std::string name = (is_var ? "input" : "const") + std::to_string(i);
+
+        node_t in_node = create_graph_node(graph, name.c_str(), is_var ? "InputOp" : "Const");
+        tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+
+        set_node_output_tensor(in_node, 0, tensor, is_var ? TENSOR_TYPE_INPUT : TENSOR_TYPE_CONST);
+        set_node_input_tensor(node, i, tensor);
+        set_tensor_shape(tensor, dims.data(), dims.size());
+
+        buffers.emplace_back(GetShapeSize(dims));
+        FillRandom(buffers.back());
+        set_tensor_buffer(tensor, buffers.back().data(), buffers.back().size() * sizeof(float));
+
+        if(is_var)
+            input_names.push_back(name);
+
+        release_graph_tensor(tensor);
+        release_graph_node(in_node);
+    }
+
+    for(auto& attr : bc.int_attrs)
+        set_node_attr_int(node, attr.first.c_str(), &attr.second);
+
+    for(auto& attr : bc.float_attrs)
+        set_node_attr_float(node, attr.first.c_str(), &attr.second);
+
+    tensor_t output = create_graph_tensor(graph, "op", TENGINE_DT_FP32);
+
+    set_node_output_tensor(node, 0, output, TENSOR_TYPE_VAR);
+    release_graph_tensor(output);
+    release_graph_node(node);
+
+    std::vector<const char*> inputs;
+    const char* outputs[] = {"op"};
+
+    for(auto& name : input_names)
+        inputs.push_back(name.c_str());
+
+    set_graph_input_node(graph, inputs.data(), inputs.size());
+    set_graph_output_node(graph, outputs, 1);
+
+    bool ret = false;
+    char prof_file[] = "/tmp/bench_ops_XXXXXX";
+    int fd = -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        fprintf(stderr, "%s: prerun failed on registry %s\n", bc.name.c_str(), registry.c_str());
+        goto out;
+    }
+
+    for(int i = 0; i < warm_count; i++)
+        run_graph(graph, 1);
+
+    start_graph_profiling(graph);
+
+    for(int i = 0; i < repeat_count; i++)
+        run_graph(graph, 1);
+
+    stop_graph_profiling(graph);
+
+    fd = mkstemp(prof_file);
+
+    if(fd >= 0 && dump_graph_profiling(graph, prof_file, GRAPH_PROF_SUMMARY) == 0)
+    {
+        FILE* fp = fopen(prof_file, "r");
+        char line[4096];
+
+        while(fp && fgets(line, sizeof(line), fp))
+        {
+            if(strstr(line, "\"name\":\"op\"") == nullptr)
+                continue;
+
+            GetJsonItem(line, "impl", result.impl);
+            result.avg_us = GetJsonNumber(line, "avg_us");
+            result.min_us = GetJsonNumber(line, "min_us");
+            result.gflops = GetJsonNumber(line, "gflops");
+            result.gbps = GetJsonNumber(line, "gbps");
+            ret = true;
+        }
+
+        if(fp)
+            fclose(fp);
+    }
+
+    if(fd >= 0)
+    {
+        close(fd);
+        unlink(prof_file);
+    }
+
+    postrun_graph(graph);
+
+out:
+    destroy_graph(graph);
+
+    result.name = bc.name;
+    result.op = bc.op;
+    result.registry = registry;
+    result.repeat = repeat_count;
+
+    return ret;
+}
+
+static void WriteResult(FILE* fp, const BenchResult& r)
+{
+    fprintf(fp,
+            "{\"case\":\"%s\",\"op\":\"%s\",\"registry\":\"%s\",\"impl\":\"%s\",\"threads\":%d,\"repeat\":%d,"
+            "\"avg_us\":%.2f,\"min_us\":%.2f,\"gflops\":%.3f,\"gbps\":%.3f}",
+            r.name.c_str(), r.op.c_str(), r.registry.c_str(), r.impl.c_str(), r.threads, r.repeat, r.avg_us, r.min_us,
+            r.gflops, r.gbps);
+}
+
+static bool ReadResult(const char* line, BenchResult& r)
+{
+    if(!GetJsonItem(line, "case", r.name))
+        return false;
+
+    GetJsonItem(line, "op", r.op);
+    GetJsonItem(line, "registry", r.registry);
+    GetJsonItem(line, "impl", r.impl);
+    r.threads = GetJsonNumber(line, "threads");
+    r.repeat = GetJsonNumber(line, "repeat");
+    r.avg_us = GetJsonNumber(line, "avg_us");
+    r.min_us = GetJsonNumber(line, "min_us");
+    r.gflops = GetJsonNumber(line, "gflops");
+    r.gbps = GetJsonNumber(line, "gbps");
+
+    return true;
+}
+
+/* the cpu list is fixed at init_tengine(), so that each thread count runs in its own process */
+static bool RunThreads(const std::vector<BenchCase>& cases, const std::vector<std::string>& registries, int threads,
+                       std::vector<BenchResult>& results)
+{
+    int pipe_fd[2];
+
+    if(pipe(pipe_fd) < 0)
+        return false;
+
+    pid_t pid = fork();
+
+    if(pid < 0)
+        return false;
+
+    if(pid == 0)
+    {
+        close(pipe_fd[0]);
+
+        std::string cpu_list = "0";
+
+        for(int i = 1; i < threads; i++)
+            cpu_list += "," + std::to_string(i);
+
+        setenv("TENGINE_CPU_LIST", cpu_list.c_str(), 1);
+
+        if(init_tengine() < 0)
+            exit(1);
+
+        FILE* fp = fdopen(pipe_fd[1], "w");
+
+        for(auto& bc : cases)
+        {
+            for(auto& registry : registries)
+            {
+                BenchResult r;
+
+                if(!RunCase(bc, registry, r))
+                    continue;
+
+                r.threads = threads;
+                WriteResult(fp, r);
+                fprintf(fp, "\n");
+                fflush(fp);
+            }
+        }
+
+        fclose(fp);
+        release_tengine();
+        exit(0);
+    }
+
+    close(pipe_fd[1]);
+
+    FILE* fp = fdopen(pipe_fd[0], "r");
+    char line[1024];
+
+    while(fgets(line, sizeof(line), fp))
+    {
+        BenchResult r;
+
+        if(!ReadResult(line, r))
+            continue;
+
+        fprintf(stderr, "%-32s %-10s %2d thr  avg %10.2f us  min %10.2f us  %8.3f GFLOP/s  %8.3f GB/s  %s\n",
+                r.name.c_str(), r.registry.c_str(), r.threads, r.avg_us, r.min_us, r.gflops, r.gbps, r.impl.c_str());
+        results.push_back(r);
+    }
+
+    fclose(fp);
+
+    int status;
+
+    waitpid(pid, &status, 0);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static std::string ResultKey(const BenchResult& r)
+{
+    return r.name + "/" + r.registry + "/" + std::to_string(r.threads);
+}
+
+/* the min time is compared, it is the least noisy one. Returns the number of regressions */
+static int CompareBaseline(const char* file_name, const std::vector<BenchResult>& results, double threshold)
+{
+    FILE* fp = fopen(file_name, "r");
+
+    if(fp == nullptr)
+    {
+        fprintf(stderr, "cannot open baseline %s\n", file_name);
+        return -1;
+    }
+
+    std::map<std::string, BenchResult> baseline;
+    char line[1024];
+
+    while(fgets(line, sizeof(line), fp))
+    {
+        BenchResult r;
+
+        if(ReadResult(line, r))
+            baseline[ResultKey(r)] = r;
+    }
+
+    fclose(fp);
+
+    int regressed = 0;
+
+    printf("%-32s %-10s %4s %12s %12s %9s\n", "case", "registry", "thr", "base_us", "cur_us", "change");
+
+    for(auto& r : results)
+    {
+        auto ir = baseline.find(ResultKey(r));
+
+        if(ir == baseline.end())
+        {
+            printf("%-32s %-10s %4d %12s %12.2f %9s\n", r.name.c_str(), r.registry.c_str(), r.threads, "-", r.min_us,
+                   "new");
+            continue;
+        }
+
+        const BenchResult& base = ir->second;
+        double change = base.min_us > 0 ? 100.0 * (r.min_us - base.min_us) / base.min_us : 0;
+        bool is_regressed = change > threshold;
+
+        printf("%-32s %-10s %4d %12.2f %12.2f %+8.1f%%%s", r.name.c_str(), r.registry.c_str(), r.threads,
+               base.min_us, r.min_us, change, is_regressed ? "  REGRESSED" : "");
+
+        if(base.impl != r.impl)
+            printf("  impl %s -> %s", base.impl.c_str(), r.impl.c_str());
+
+        printf("\n");
+
+        if(is_regressed)
+            regressed++;
+    }
+
+    return regressed;
+}
+
+static std::vector<std::string> SplitList(const char* str)
+{
+    std::vector<std::string> list;
+    std::string item;
+
+    for(const char* p = str;; p++)
+    {
+        if(*p == ',' || *p == 0)
+        {
+            if(!item.empty())
+                list.push_back(item);
+            item.clear();
+
+            if(*p == 0)
+                break;
+        }
+        else
+            item += *p;
+    }
+
+    return list;
+}
+
+static void Usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-r repeat] [-w warm] [-t 1,2,4] [-i default,reference] [-f filter] [-o out.json]\n"
+            "          [-b baseline.json] [-x threshold_percent] [-l]\n",
+            prog);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* thread_str = nullptr;
+    const char* registry_str = "default";
+    const char* filter = nullptr;
+    const char* out_file = nullptr;
+    const char* baseline_file = nullptr;
+    double threshold = 10;
+    bool list_only = false;
+    int res;
+
+    while((res = getopt(argc, argv, "r:w:t:i:f:o:b:x:lh")) != -1)
+    {
+        switch(res)
+        {
+            case 'r':
+                repeat_count = strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                warm_count = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                thread_str = optarg;
+                break;
+            case 'i':
+                registry_str = optarg;
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'b':
+                baseline_file = optarg;
+                break;
+            case 'x':
+                threshold = atof(optarg);
+                break;
+            case 'l':
+                list_only = true;
+                break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    std::vector<BenchCase> cases;
+
+    for(auto& bc : GetBenchCases())
+    {
+        if(filter == nullptr || bc.name.find(filter) != std::string::npos || bc.op.find(filter) != std::string::npos)
+            cases.push_back(bc);
+    }
+
+    if(list_only)
+    {
+        for(auto& bc : cases)
+            printf("%-32s %s\n", bc.name.c_str(), bc.op.c_str());
+        return 0;
+    }
+
+    int cpu_number = sysconf(_SC_NPROCESSORS_ONLN);
+    std::vector<int> thread_list;
+
+    if(thread_str)
+    {
+        for(auto& item : SplitList(thread_str))
+        {
+            int threads = atoi(item.c_str());
+
+            if(threads < 1 || threads > cpu_number)
+                fprintf(stderr, "skip %d threads, %d cpus online\n", threads, cpu_number);
+            else
+                thread_list.push_back(threads);
+        }
+    }
+    else
+    {
+        thread_list.push_back(1);
+
+        if(cpu_number > 1)
+            thread_list.push_back(cpu_number);
+    }
+
+    std::vector<std::string> registries = SplitList(registry_str);
+    std::vector<BenchResult> results;
+
+    for(int threads : thread_list)
+    {
+        if(!RunThreads(cases, registries, threads, results))
+            fprintf(stderr, "run with %d threads failed\n", threads);
+    }
+
+    if(out_file)
+    {
+        FILE* fp = fopen(out_file, "w");
+
+        if(fp == nullptr)
+        {
+            fprintf(stderr, "cannot write %s\n", out_file);
+            return 1;
+        }
+
+        fprintf(fp, "{\"repeat\":%d,\"results\":[\n", repeat_count);
+
+        for(unsigned int i = 0; i < results.size(); i++)
+        {
+            WriteResult(fp, results[i]);
+            fprintf(fp, "%s\n", i + 1 < results.size() ? "," : "");
+        }
+
+        fprintf(fp, "]}\n");
+        fclose(fp);
+    }
+
+    if(baseline_file)
+    {
+        int regressed = CompareBaseline(baseline_file, results, threshold);
+
+        if(regressed != 0)
+        {
+            if(regressed > 0)
+                printf("%d case(s) regressed by more than %.1f%%\n", regressed, threshold);
+            return 2;
+        }
+    }
+
+    return 0;
+}
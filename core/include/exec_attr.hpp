@@ -48,6 +48,11 @@ enum exec_policy_t
 #define EXEC_KERNEL_INT8 2
 #define EXEC_KERNEL_UINT8 3
 
+/* the storage of the const weights, the kernels which support it widen them back to fp32 on the fly */
+#define EXEC_WEIGHT_FP32 0
+#define EXEC_WEIGHT_FP16 1
+#define EXEC_WEIGHT_BF16 2
+
 #define MODEL_FORMAT_UNKNOWN 0
 #define MODEL_FORMAT_TENGINE 1
 #define MODEL_FORMAT_CAFFE 2
@@ -68,6 +73,7 @@ struct ExecAttr
     exec_policy_t policy;
     int priority;
     int kernel_mode;
+    int weight_type;
     int model_format;
     int model_layout;
     int graph_layout;
@@ -82,6 +88,7 @@ struct ExecAttr
         policy = kExecLatency;
         priority = 100;
         kernel_mode = EXEC_KERNEL_FP32;
+        weight_type = EXEC_WEIGHT_FP32;
         low_mem_mode = true;
         fc_mt = false;
         pooling_mt = true;
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __GRAPH_PROFILER_HPP__
+#define __GRAPH_PROFILER_HPP__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace TEngine {
+
+#define ATTR_GRAPH_PROFILER "GraphProfiler"
+
+/* the GraphProfiler* handed down to a subgraph at prerun, nullptr while profiling is off */
+#define ATTR_SUBGRAPH_PROFILER "SubgraphProfiler"
+
+class Node;
+
+/* one node execution, times in us */
+struct ProfEvent
+{
+    std::string node_name;
+    std::string op_name;
+    std::string impl_name;
+    std::string dev_name;
+    std::vector<std::string> input_shapes;
+    std::vector<std::string> output_shapes;
+
+    uint64_t start_time;
+    uint64_t end_time;
+    int thread_id;
+
+    float fops;
+    uint64_t bytes;
+};
+
+/*
+ * Profiling session of a graph, created by start_graph_profiling().
+ * Devices append one event per executed node while the session is active;
+ * the events are exported as chrome trace-event JSON or as a JSON summary per node and per op.
+ */
+
+class GraphProfiler
+{
+public:
+    GraphProfiler()
+    {
+        active_ = false;
+        base_time_ = 0;
+    }
+
+    void Start(void);
+    void Stop(void);
+
+    bool IsActive(void) const
+    {
+        return active_;
+    }
+
+    /* fill the node related fields of the event: names, shapes, fops and bytes */
+    static void FillNodeInfo(ProfEvent& event, Node* node);
+
+    static std::string GetTypeName(const char* mangled_name);
+    static int GetThreadId(void);
+
+    void AddEvent(ProfEvent& event);
+
+    bool DumpChromeTrace(const char* file_name);
+    bool DumpSummary(const char* file_name);
+
+private:
+    std::mutex lock_;
+    bool active_;
+    uint64_t base_time_;
+    std::vector<ProfEvent> events_;
+};
+
+}    // namespace TEngine
+
+#endif
@@ -235,6 +235,10 @@ public:
     static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height);
     // convenient construct from pixel data and resize to specific size with stride(bytes-per-row) parameter
     static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height);
+    // convenient construct from pixel data, resize to specific size and substract mean / multiply by normalize values, pass 0 to skip
+    static Mat from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, const float* mean_vals, const float* norm_vals);
+    // convenient construct from pixel data, resize and normalize with stride(bytes-per-row) parameter
+    static Mat from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height, const float* mean_vals, const float* norm_vals);
 
     // convenient export to pixel data
     void to_pixels(unsigned char* pixels, int type) const;
@@ -60,6 +60,8 @@ struct StaticGraph
     std::vector<StaticTensorPtr> tensor_list;
     std::unordered_map<std::string, StaticTensorPtr> const_tensor_map;
     std::vector<void*> mem_src;
+    void* mem_map_addr;    // the model file mapping that const tensors point into, if kept
+    size_t mem_map_size;
     int graph_layout;
     int model_layout;
     int model_format;
@@ -70,6 +72,8 @@ struct StaticGraph
         exec_context = nullptr;
         dev_handle = nullptr;
         release_func = nullptr;
+        mem_map_addr = nullptr;
+        mem_map_size = 0;
         graph_layout = -1;
         model_layout = -1;
         model_format = -1;
@@ -121,17 +125,19 @@ struct StaticTensor
 struct StaticConstTensor : public StaticTensor
 {
     void* mem_addr;
+    bool mem_mapped;    // mem_addr points into the graph's file mapping, not owned
     int file_offset;
     int file_size;
 
     StaticConstTensor()
     {
         mem_addr = nullptr;
+        mem_mapped = false;
     }
 
     virtual ~StaticConstTensor()
     {
-        if(mem_addr)
+        if(mem_addr && !mem_mapped)
             std::free(mem_addr);
     }
 };
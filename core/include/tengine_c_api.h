@@ -45,6 +45,11 @@ extern "C" {
 #define TENGINE_DT_INT32 4
 #define TENGINE_DT_INT16 5
 
+/* the storage of the const weights, set_graph_attr(graph, "weight_type", &type, sizeof(int)) before prerun */
+#define TENGINE_WEIGHT_FP32 0
+#define TENGINE_WEIGHT_FP16 1
+#define TENGINE_WEIGHT_BF16 2
+
 /* layout type, not real layout */
 #define TENGINE_LAYOUT_NCHW 0
 #define TENGINE_LAYOUT_NHWC 1
@@ -71,6 +76,10 @@ extern "C" {
 #define GRAPH_PERF_STAT_RESET 4
 #define GRAPH_PERF_STAT_GET 5
 
+/* graph profiling dump format */
+#define GRAPH_PROF_CHROME_TRACE 0
+#define GRAPH_PROF_SUMMARY 1
+
 /* quant mode */
 #define TENGINE_QUANT_FP16 0
 #define TENGINE_QUANT_INT8 1
@@ -124,9 +133,29 @@ typedef void* context_t;
 typedef void* graph_t;
 typedef void* tensor_t;
 typedef void* node_t;
+typedef void* batcher_t;
+typedef void* pipeline_t;
 
 typedef int (*event_handler_t)(graph_t, int, void* arg);
 
+/* one in-flight frame of a graph pipeline */
+struct pipeline_frame
+{
+    int id; /* the frame number, from 0 */
+    int input_num;
+    void** input_data; /* one buffer per graph input node (tensor 0), in input node order */
+    const int* input_size;
+    int output_num;
+    void** output_data; /* one buffer per graph output tensor, in the order of get_graph_output_tensor */
+    const int* output_size;
+};
+
+/* fills the input buffers of the frame: 0 to run it, 1 at the end of the stream, -1 on error */
+typedef int (*pipeline_pre_t)(struct pipeline_frame* frame, void* arg);
+
+/* consumes the outputs of the frame: 0 to go on, -1 to stop the pipeline */
+typedef int (*pipeline_post_t)(struct pipeline_frame* frame, void* arg);
+
 typedef void (*log_print_t)(const char*);
 
 /* performance profiling records */
@@ -1035,6 +1064,79 @@ int get_graph_exec_status(graph_t graph);
  */
 int set_graph_event_hook(graph_t graph, int event, event_handler_t cb_func, void* cb_arg);
 
+/*!
+ * @brief Create a request queue in front of a prerun graph, which coalesces concurrent
+ *        single-sample requests into one batched run of the graph.
+ *
+ * @param [in] graph: The graph handle, prerun with a batch of one on dim 0 of every input.
+ * @param [in] max_batch: The max number of requests run as one batch.
+ * @param [in] max_delay_us: How long the oldest queued request may wait for the batch to fill.
+ *
+ * @return The batcher handle, or NULL on error.
+ * @note  The batcher owns the graph until destroy_graph_batcher: it reshapes dim 0 of the inputs
+ *        and sets their buffers, so the graph must not be run directly meanwhile.
+ *        Every output must carry the batch on dim 0 as well.
+ */
+batcher_t create_graph_batcher(graph_t graph, int max_batch, int max_delay_us);
+
+/*!
+ * @brief Run one sample through the batcher, blocks until its batch is done. It is thread safe.
+ *
+ * @param [in] batcher: The batcher handle.
+ * @param [in] input_data: One sample per graph input node (tensor 0), in input node order.
+ * @param [out] output_data: One buffer per graph output tensor, in the order of get_graph_output_tensor.
+ * @param [in] output_size: The size of each output buffer.
+ *
+ * @return 0: Success, -1: Fail, also when an output buffer is too small for its sample.
+ */
+int run_graph_batcher(batcher_t batcher, const void* input_data[], void* output_data[], const int output_size[]);
+
+/*!
+ * @brief Destroy the batcher, the requests already queued are run first. The inputs get their
+ *        batch of one and their buffers back.
+ *
+ * @param [in] batcher: The batcher handle.
+ *
+ * @return 0: Success, -1: Fail.
+ */
+int destroy_graph_batcher(batcher_t batcher);
+
+/*!
+ * @brief Create a pipeline over a prerun graph, which overlaps the preprocessing of the next frames,
+ *        the inference of the current one and the postprocessing of the previous ones.
+ *
+ * @param [in] graph: The graph handle, prerun with the input shape of every frame.
+ * @param [in] depth: The number of frames in flight, each one with its own input and output buffers;
+ *                    2 double-buffers the frames, a larger one absorbs jitter of the stages.
+ * @param [in] pre: The preprocessing stage, called in frame order from the pipeline thread of its own.
+ * @param [in] post: The postprocessing stage, called in frame order from the pipeline thread of its own.
+ * @param [in] arg: The argument passed to both stages.
+ *
+ * @return The pipeline handle, or NULL on error.
+ * @note  The pipeline owns the graph until destroy_graph_pipeline: it sets the buffers of the inputs,
+ *        so the graph must not be run directly meanwhile. Destroy gives the inputs their buffers back.
+ */
+pipeline_t create_graph_pipeline(graph_t graph, int depth, pipeline_pre_t pre, pipeline_post_t post, void* arg);
+
+/*!
+ * @brief Run the frames through the pipeline until the pre stage ends the stream, blocks until the last
+ *        frame is postprocessed. The graph runs in the calling thread.
+ *
+ * @param [in] pipeline: The pipeline handle.
+ *
+ * @return The number of postprocessed frames, -1 if a stage or a graph run failed.
+ */
+int run_graph_pipeline(pipeline_t pipeline);
+
+/*!
+ * @brief Destroy the pipeline and free the buffers of its frames.
+ *
+ * @param [in] pipeline: The pipeline handle.
+ *
+ * @return 0: Success, -1: Fail.
+ */
+int destroy_graph_pipeline(pipeline_t pipeline);
+
 /***************** Device related *****************************/
 
 /*!
@@ -1132,6 +1234,42 @@ int do_graph_perf_stat(graph_t graph, int action);
 
 int get_graph_perf_stat(graph_t graph, struct perf_info** buf, int buf_size);
 
+/*!
+ * @brief Start a profiling session on a graph: the records of the previous session are dropped,
+ *        and each node executed by the following runs is recorded with its start/end time, thread,
+ *        the selected implementation, tensor shapes, fops and bytes of input and output tensors.
+ *        A session started before prerun_graph() covers the runs after it
+ *
+ * @param [in] graph: the graph handle
+ *
+ * @return 0 success, -1 fail
+ */
+
+int start_graph_profiling(graph_t graph);
+
+/*!
+ * @brief Stop the profiling session of the graph. The records are kept for dump_graph_profiling()
+ *
+ * @param [in] graph: the graph handle
+ *
+ * @return 0 success, -1 fail
+ */
+
+int stop_graph_profiling(graph_t graph);
+
+/*!
+ * @brief Write the records of the profiling session into a JSON file
+ *
+ * @param [in] graph: the graph handle
+ * @param [in] file_name: the file to write
+ * @param [in] format: GRAPH_PROF_CHROME_TRACE, trace events for chrome://tracing or perfetto,
+ *                     GRAPH_PROF_SUMMARY, time/fops/bytes per node and per op, sorted by the total time
+ *
+ * @return 0 success, -1 fail
+ */
+
+int dump_graph_profiling(graph_t graph, const char* file_name, int format);
+
 /*!
  * @brief Get the device number in the system.
  *
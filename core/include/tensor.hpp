@@ -27,6 +27,8 @@
 #include <iostream>
 #include <string>
 #include <atomic>
+#include <memory>
+#include <functional>
 
 #include "base_object.hpp"
 #include "tensor_shape.hpp"
@@ -37,6 +39,7 @@ namespace TEngine {
 class Node;
 struct NodePort;
 struct StaticConstTensor;
+class TensorMem;
 
 struct QuantParam
 {
@@ -62,27 +65,44 @@ public:
         static_tensor_ = nullptr;
         reshaped_count_ = 0;
         producer = nullptr;
+        mem_addr_ = nullptr;
+        mem_slot_ = nullptr;
+        mem_slot_size_ = 0;
     }
     virtual ~Tensor()
     {
         FreeTensor();
     }
 
+    /* "free_mem" marks a const buffer to free, "mem_release" one to hand back to whoever shares it */
     void FreeTensor(void)
     {
-        if(type_ == kConstTensor && ExistAttr("free_mem") && ExistAttr("mem_addr"))
+        if(type_ == kConstTensor && ExistAttr("mem_release") && mem_addr_ != nullptr)
         {
-            void* mem = any_cast<void*>(GetAttr("mem_addr"));
-            std::free(mem);
+            auto release = any_cast<std::function<void(void*)>>(GetAttr("mem_release"));
+
+            release(mem_addr_);
+
+            RemoveAttr("mem_release");
+            mem_addr_ = nullptr;
+        }
+
+        if(type_ == kConstTensor && ExistAttr("free_mem") && mem_addr_ != nullptr)
+        {
+            std::free(mem_addr_);
 
             RemoveAttr("free_mem");
             RemoveAttr("mem_addr");
+
+            mem_addr_ = nullptr;
         }
     }
 
     Tensor(const Tensor& o)
         : BaseObject(o), producer(o.producer), consumer(o.consumer), quant_param_(o.quant_param_), type_(o.type_),
-          name_(o.name_), data_type_(o.data_type_), shape_(o.shape_), static_tensor_(o.static_tensor_){};
+          name_(o.name_), data_type_(o.data_type_), shape_(o.shape_), static_tensor_(o.static_tensor_),
+          mem_addr_(o.mem_addr_), mem_binding_(o.mem_binding_), mem_slot_(o.mem_slot_),
+          mem_slot_size_(o.mem_slot_size_){};
 
     Tensor& operator=(const Tensor& rhs) = delete;
 
@@ -210,17 +230,49 @@ public:
 
     void* GetMemAddr(void) const
     {
-        if(!ExistAttr("mem_addr"))
-            return nullptr;
-
-        return any_cast<void*>(GetAttr("mem_addr"));
+        return mem_addr_;
     }
 
     void SetMemAddr(void* addr)
     {
+        mem_addr_ = addr;
         (*this)["mem_addr"] = addr;
     }
 
+    /* runtime memory slot of var/input tensors.
+       the slot caches the raw address, so that get_tensor_mem() needs no attribute lookup;
+       the binding keeps the TensorMem alive and releases it once the slot is dropped
+     */
+
+    void* GetMemSlot(void) const
+    {
+        return mem_slot_;
+    }
+
+    int GetMemSlotSize(void) const
+    {
+        return mem_slot_size_;
+    }
+
+    const std::shared_ptr<TensorMem>& GetMemBinding(void) const
+    {
+        return mem_binding_;
+    }
+
+    void BindMemSlot(const std::shared_ptr<TensorMem>& binding, void* addr, int size)
+    {
+        mem_binding_ = binding;
+        mem_slot_ = addr;
+        mem_slot_size_ = size;
+    }
+
+    void UnbindMemSlot(void)
+    {
+        mem_binding_.reset();
+        mem_slot_ = nullptr;
+        mem_slot_size_ = 0;
+    }
+
     void FreeMem(void);
     void BindStaticTensor(StaticConstTensor*);
 
@@ -238,6 +290,11 @@ protected:
 
     StaticConstTensor* static_tensor_;
 
+    void* mem_addr_;
+    std::shared_ptr<TensorMem> mem_binding_;
+    void* mem_slot_;
+    int mem_slot_size_;
+
     std::atomic<int> reshaped_count_;
 };
 
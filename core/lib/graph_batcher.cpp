@@ -0,0 +1,352 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+#include "tengine_c_api.h"
+#include "tensor.hpp"
+#include "tensor_mem.hpp"
+
+using namespace TEngine;
+
+/*
+ * The batcher owns a prerun graph and one worker thread. Callers of run_graph_batcher() queue
+ * single-sample requests. The worker takes the oldest request, waits until max_batch requests are
+ * queued or the oldest one has waited max_delay_us, then copies up to max_batch samples into one
+ * staging buffer per input, runs the graph once with dim 0 set to the batch, and scatters the
+ * outputs back. The graph is only reshaped when the batch size changes between two runs. A request
+ * whose output buffer is too small fails alone, the rest of its batch still gets the outputs. At destroy
+ * the inputs get their own memory back, and the inputs and outputs their batch of one.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BatchRequest
+{
+    const void** input_data;
+    void** output_data;
+    const int* output_size;
+    Clock::time_point arrive;
+    bool done;
+    bool ret;
+};
+
+struct GraphBatcher
+{
+    graph_t graph;
+    int max_batch;
+    std::chrono::microseconds max_delay;
+
+    std::vector<tensor_t> inputs;
+    std::vector<TensorMemPtr> input_mem;
+    std::vector<tensor_t> outputs;
+    std::vector<std::vector<int>> output_dims;
+    std::vector<std::vector<int>> input_dims;
+    std::vector<int> input_sample_size;
+    std::vector<char*> input_buf;
+    int cur_batch;
+
+    std::mutex lock;
+    std::condition_variable queue_cv;
+    std::condition_variable done_cv;
+    std::deque<BatchRequest*> queue;
+    std::thread worker;
+    bool quit;
+
+    bool RunBatch(std::vector<BatchRequest*>& batch);
+    void WorkerLoop(void);
+};
+
+bool GraphBatcher::RunBatch(std::vector<BatchRequest*>& batch)
+{
+    int batch_size = batch.size();
+
+    if(batch_size != cur_batch)
+    {
+        for(unsigned int i = 0; i < inputs.size(); i++)
+        {
+            std::vector<int>& dims = input_dims[i];
+
+            dims[0] = batch_size;
+            set_tensor_shape(inputs[i], dims.data(), dims.size());
+            set_tensor_buffer(inputs[i], input_buf[i], input_sample_size[i] * batch_size);
+        }
+
+        cur_batch = batch_size;
+    }
+
+    for(unsigned int i = 0; i < inputs.size(); i++)
+    {
+        for(int n = 0; n < batch_size; n++)
+            memcpy(input_buf[i] + n * input_sample_size[i], batch[n]->input_data[i], input_sample_size[i]);
+    }
+
+    if(run_graph(graph, 1) < 0)
+        return false;
+
+    for(auto req : batch)
+        req->ret = true;
+
+    for(unsigned int i = 0; i < outputs.size(); i++)
+    {
+        int sample_size = get_tensor_buffer_size(outputs[i]) / batch_size;
+        const char* data = ( const char* )get_tensor_buffer(outputs[i]);
+
+        for(int n = 0; n < batch_size; n++)
+        {
+            if(batch[n]->output_size[i] < sample_size)
+            {
+                LOG_ERROR() << "graph batcher: output " << i << " needs " << sample_size << " bytes, got "
+                            << batch[n]->output_size[i] << "\n";
+                batch[n]->ret = false;
+                continue;
+            }
+
+            memcpy(batch[n]->output_data[i], data + n * sample_size, sample_size);
+        }
+    }
+
+    return true;
+}
+
+void GraphBatcher::WorkerLoop(void)
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    while(true)
+    {
+        queue_cv.wait(guard, [this] { return quit || !queue.empty(); });
+
+        if(queue.empty())
+            break;
+
+        /* coalesce until the batch is full or the oldest request is out of budget */
+        Clock::time_point deadline = queue.front()->arrive + max_delay;
+
+        queue_cv.wait_until(guard, deadline, [this] { return quit || ( int )queue.size() >= max_batch; });
+
+        std::vector<BatchRequest*> batch;
+
+        while(!queue.empty() && ( int )batch.size() < max_batch)
+        {
+            batch.push_back(queue.front());
+            queue.pop_front();
+        }
+
+        guard.unlock();
+
+        bool ret = RunBatch(batch);
+
+        guard.lock();
+
+        for(auto req : batch)
+        {
+            if(!ret)
+                req->ret = false;
+            req->done = true;
+        }
+
+        done_cv.notify_all();
+    }
+}
+
+}    // namespace
+
+batcher_t create_graph_batcher(graph_t graph, int max_batch, int max_delay_us)
+{
+    if(graph == nullptr || max_batch <= 0 || max_delay_us < 0)
+    {
+        set_tengine_errno(EINVAL);
+        return nullptr;
+    }
+
+    GraphBatcher* batcher = new GraphBatcher();
+
+    batcher->graph = graph;
+    batcher->max_batch = max_batch;
+    batcher->max_delay = std::chrono::microseconds(max_delay_us);
+    batcher->cur_batch = 0;
+    batcher->quit = false;
+
+    for(int i = 0; i < get_graph_input_node_number(graph); i++)
+    {
+        tensor_t tensor = get_graph_input_tensor(graph, i, 0);
+        int dims[MAX_SHAPE_DIM_NUM];
+        int dim_num = get_tensor_shape(tensor, dims, MAX_SHAPE_DIM_NUM);
+        int size = get_tensor_buffer_size(tensor);
+        TensorMemPtr mem;
+
+        /* the size of one sample: the graph was prerun with a batch of one on dim 0 */
+        if(dim_num < 2 || dims[0] != 1 || size <= 0)
+        {
+            LOG_ERROR() << "graph batcher: input " << i << " has no batch dim of 1\n";
+            set_tengine_errno(EINVAL);
+            release_graph_tensor(tensor);
+            destroy_graph_batcher(batcher);
+            return nullptr;
+        }
+
+        get_tensor_memptr(reinterpret_cast<Tensor*>(tensor), mem);
+
+        batcher->inputs.push_back(tensor);
+        batcher->input_mem.push_back(mem);
+        batcher->input_dims.push_back(std::vector<int>(dims, dims + dim_num));
+        batcher->input_sample_size.push_back(size);
+        batcher->input_buf.push_back(( char* )malloc(size * max_batch));
+    }
+
+    for(int i = 0; i < get_graph_output_node_number(graph); i++)
+    {
+        node_t node = get_graph_output_node(graph, i);
+
+        for(int j = 0; j < get_node_output_number(node); j++)
+        {
+            tensor_t tensor = get_graph_output_tensor(graph, i, j);
+            int dims[MAX_SHAPE_DIM_NUM];
+            int dim_num = get_tensor_shape(tensor, dims, MAX_SHAPE_DIM_NUM);
+
+            batcher->outputs.push_back(tensor);
+            batcher->output_dims.push_back(dim_num > 0 ? std::vector<int>(dims, dims + dim_num) : std::vector<int>());
+
+            if(dim_num < 1 || dims[0] != 1)
+            {
+                LOG_ERROR() << "graph batcher: output " << i << "." << j << " has no batch dim of 1\n";
+                set_tengine_errno(EINVAL);
+                release_graph_node(node);
+                destroy_graph_batcher(batcher);
+                return nullptr;
+            }
+        }
+
+        release_graph_node(node);
+    }
+
+    batcher->worker = std::thread(&GraphBatcher::WorkerLoop, batcher);
+
+    return batcher;
+}
+
+int run_graph_batcher(batcher_t batcher, const void* input_data[], void* output_data[], const int output_size[])
+{
+    if(batcher == nullptr || input_data == nullptr || output_data == nullptr || output_size == nullptr)
+    {
+        set_tengine_errno(EINVAL);
+        return -1;
+    }
+
+    GraphBatcher* real_batcher = reinterpret_cast<GraphBatcher*>(batcher);
+
+    BatchRequest req;
+
+    req.input_data = input_data;
+    req.output_data = output_data;
+    req.output_size = output_size;
+    req.arrive = Clock::now();
+    req.done = false;
+    req.ret = false;
+
+    std::unique_lock<std::mutex> guard(real_batcher->lock);
+
+    if(real_batcher->quit)
+    {
+        set_tengine_errno(EPERM);
+        return -1;
+    }
+
+    real_batcher->queue.push_back(&req);
+    real_batcher->queue_cv.notify_one();
+
+    real_batcher->done_cv.wait(guard, [&req] { return req.done; });
+
+    if(!req.ret)
+    {
+        set_tengine_errno(EIO);
+        return -1;
+    }
+
+    return 0;
+}
+
+int destroy_graph_batcher(batcher_t batcher)
+{
+    if(batcher == nullptr)
+    {
+        set_tengine_errno(EINVAL);
+        return -1;
+    }
+
+    GraphBatcher* real_batcher = reinterpret_cast<GraphBatcher*>(batcher);
+
+    /* the queued requests still run */
+    real_batcher->lock.lock();
+    real_batcher->quit = true;
+    real_batcher->queue_cv.notify_one();
+    real_batcher->lock.unlock();
+
+    if(real_batcher->worker.joinable())
+        real_batcher->worker.join();
+
+    /* the inputs still point to the staging buffers freed below */
+    for(unsigned int i = 0; i < real_batcher->inputs.size(); i++)
+    {
+        std::vector<int>& dims = real_batcher->input_dims[i];
+
+        if(real_batcher->cur_batch != 0)
+        {
+            dims[0] = 1;
+            set_tensor_shape(real_batcher->inputs[i], dims.data(), dims.size());
+            set_tensor_mem(reinterpret_cast<Tensor*>(real_batcher->inputs[i]), real_batcher->input_mem[i]);
+        }
+
+        release_graph_tensor(real_batcher->inputs[i]);
+    }
+
+    /* the output shapes of the last batch would stay until the next run */
+    for(unsigned int i = 0; i < real_batcher->outputs.size(); i++)
+    {
+        std::vector<int>& dims = real_batcher->output_dims[i];
+
+        if(real_batcher->cur_batch > 1)
+            set_tensor_shape(real_batcher->outputs[i], dims.data(), dims.size());
+
+        release_graph_tensor(real_batcher->outputs[i]);
+    }
+
+    for(auto buf : real_batcher->input_buf)
+        free(buf);
+
+    delete real_batcher;
+
+    return 0;
+}
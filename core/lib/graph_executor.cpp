@@ -630,6 +630,15 @@ bool GraphExecutor::SetExecAttrEntry(const char* name, const void* val, int size
     {
         exec_attr_.kernel_mode = *( int* )val;
     }
+    else if(!strcmp("weight_type", name))
+    {
+        int n = *( int* )val;
+
+        if(n != EXEC_WEIGHT_FP32 && n != EXEC_WEIGHT_FP16 && n != EXEC_WEIGHT_BF16)
+            return false;
+
+        exec_attr_.weight_type = n;
+    }
     else if(!strcmp("low_mem_mode", name))
     {
         int n = *( int* )val;
@@ -677,6 +686,10 @@ bool GraphExecutor::GetExecAttrEntry(const char* name, void* val, int size)
     {
         *( int* )val = exec_attr_.kernel_mode;
     }
+    else if(!strcmp("weight_type", name))
+    {
+        *( int* )val = exec_attr_.weight_type;
+    }
     else if(!strcmp("low_mem_mode", name))
     {
         if(exec_attr_.low_mem_mode)
@@ -717,6 +730,7 @@ void GraphExecutor::InitAttrIO(void)
     attr_io_.RegGetFunc("exec_policy", get_func);
     attr_io_.RegGetFunc("exec_priority", get_func);
     attr_io_.RegGetFunc("kernel_mode", get_func);
+    attr_io_.RegGetFunc("weight_type", get_func);
     attr_io_.RegGetFunc("low_mem_mode", get_func);
     attr_io_.RegGetFunc("fc_mt", get_func);
     attr_io_.RegGetFunc("pooling_mt", get_func);
@@ -727,6 +741,7 @@ void GraphExecutor::InitAttrIO(void)
     attr_io_.RegSetFunc("exec_policy", set_func);
     attr_io_.RegSetFunc("exec_priority", set_func);
     attr_io_.RegSetFunc("kernel_mode", set_func);
+    attr_io_.RegSetFunc("weight_type", set_func);
     attr_io_.RegSetFunc("low_mem_mode", set_func);
     attr_io_.RegSetFunc("fc_mt", set_func);
     attr_io_.RegSetFunc("pooling_mt", set_func);
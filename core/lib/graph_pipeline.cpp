@@ -0,0 +1,385 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+#include "tengine_c_api.h"
+#include "tensor.hpp"
+#include "tensor_mem.hpp"
+
+using namespace TEngine;
+
+/*
+ * The pipeline owns a prerun graph and depth frames, each with its own input and output buffers.
+ * Three stages pass the frames along two queues, in frame order:
+ *   pre thread:   takes a free frame, lets the user fill its inputs
+ *   caller:       points the graph inputs to the frame buffers, runs the graph, copies the outputs out
+ *   post thread:  lets the user consume the outputs, gives the frame back
+ * so that decoding and resizing frame N+1 overlaps the inference of frame N. A null frame on a queue
+ * ends the stream; a failed stage stops all of them. The graph inputs get their own memory back at
+ * destroy, so that the graph can be run directly again.
+ */
+
+namespace {
+
+struct PipelineFrame
+{
+    struct pipeline_frame frame;
+
+    std::vector<void*> input_data;
+    std::vector<int> input_size;
+    std::vector<void*> output_data;
+    std::vector<int> output_size;
+};
+
+class FrameQueue
+{
+public:
+    FrameQueue(std::mutex& lock, std::condition_variable& cv, const bool& stop) : lock_(lock), cv_(cv), stop_(stop)
+    {
+    }
+
+    void Push(PipelineFrame* frame)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        queue_.push_back(frame);
+        cv_.notify_all();
+    }
+
+    /* false when the pipeline is stopped */
+    bool Pop(PipelineFrame*& frame)
+    {
+        std::unique_lock<std::mutex> guard(lock_);
+
+        cv_.wait(guard, [this] { return stop_ || !queue_.empty(); });
+
+        if(stop_)
+            return false;
+
+        frame = queue_.front();
+        queue_.pop_front();
+
+        return true;
+    }
+
+    void Clear(void)
+    {
+        queue_.clear();
+    }
+
+private:
+    std::mutex& lock_;
+    std::condition_variable& cv_;
+    const bool& stop_;
+    std::deque<PipelineFrame*> queue_;
+};
+
+struct GraphPipeline
+{
+    graph_t graph;
+    pipeline_pre_t pre;
+    pipeline_post_t post;
+    void* arg;
+
+    std::vector<tensor_t> inputs;
+    std::vector<TensorMemPtr> input_mem;
+    std::vector<tensor_t> outputs;
+    std::vector<PipelineFrame*> frames;
+
+    std::mutex lock;
+    std::condition_variable cv;
+    bool stop;
+    bool failed;
+    int done_num;
+
+    FrameQueue free_queue;
+    FrameQueue ready_queue;
+    FrameQueue done_queue;
+
+    GraphPipeline()
+        : stop(false), failed(false), done_num(0), free_queue(lock, cv, stop), ready_queue(lock, cv, stop),
+          done_queue(lock, cv, stop)
+    {
+    }
+
+    void Fail(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        stop = true;
+        failed = true;
+        cv.notify_all();
+    }
+
+    bool RunFrame(PipelineFrame* frame);
+    void PreLoop(void);
+    void PostLoop(void);
+};
+
+bool GraphPipeline::RunFrame(PipelineFrame* frame)
+{
+    for(unsigned int i = 0; i < inputs.size(); i++)
+    {
+        if(set_tensor_buffer(inputs[i], frame->input_data[i], frame->input_size[i]) < 0)
+            return false;
+    }
+
+    if(run_graph(graph, 1) < 0)
+        return false;
+
+    /* the outputs live in the graph memory, which the next run overwrites */
+    for(unsigned int i = 0; i < outputs.size(); i++)
+    {
+        int size = get_tensor_buffer_size(outputs[i]);
+
+        if(size > frame->output_size[i])
+        {
+            free(frame->output_data[i]);
+            frame->output_data[i] = malloc(size);
+
+            if(frame->output_data[i] == nullptr)
+            {
+                LOG_ERROR() << "graph pipeline: no memory for output " << i << "\n";
+                frame->output_size[i] = 0;
+                return false;
+            }
+        }
+
+        frame->output_size[i] = size;
+        memcpy(frame->output_data[i], get_tensor_buffer(outputs[i]), size);
+    }
+
+    return true;
+}
+
+void GraphPipeline::PreLoop(void)
+{
+    int frame_id = 0;
+    PipelineFrame* frame;
+
+    while(free_queue.Pop(frame))
+    {
+        frame->frame.id = frame_id;
+
+        int ret = pre(&frame->frame, arg);
+
+        if(ret < 0)
+        {
+            LOG_ERROR() << "graph pipeline: pre stage failed on frame " << frame_id << "\n";
+            Fail();
+            return;
+        }
+
+        if(ret > 0)
+        {
+            ready_queue.Push(nullptr);
+            return;
+        }
+
+        ready_queue.Push(frame);
+        frame_id++;
+    }
+}
+
+void GraphPipeline::PostLoop(void)
+{
+    PipelineFrame* frame;
+
+    while(done_queue.Pop(frame))
+    {
+        if(frame == nullptr)
+            return;
+
+        if(post(&frame->frame, arg) < 0)
+        {
+            LOG_ERROR() << "graph pipeline: post stage failed on frame " << frame->frame.id << "\n";
+            Fail();
+            return;
+        }
+
+        done_num++;
+        free_queue.Push(frame);
+    }
+}
+
+}    // namespace
+
+pipeline_t create_graph_pipeline(graph_t graph, int depth, pipeline_pre_t pre, pipeline_post_t post, void* arg)
+{
+    if(graph == nullptr || depth <= 0 || pre == nullptr || post == nullptr)
+    {
+        set_tengine_errno(EINVAL);
+        return nullptr;
+    }
+
+    GraphPipeline* pipeline = new GraphPipeline();
+
+    pipeline->graph = graph;
+    pipeline->pre = pre;
+    pipeline->post = post;
+    pipeline->arg = arg;
+
+    for(int i = 0; i < get_graph_input_node_number(graph); i++)
+    {
+        tensor_t tensor = get_graph_input_tensor(graph, i, 0);
+        TensorMemPtr mem;
+
+        get_tensor_memptr(reinterpret_cast<Tensor*>(tensor), mem);
+
+        pipeline->inputs.push_back(tensor);
+        pipeline->input_mem.push_back(mem);
+
+        if(get_tensor_buffer_size(tensor) <= 0)
+        {
+            LOG_ERROR() << "graph pipeline: input " << i << " has no shape\n";
+            set_tengine_errno(EINVAL);
+            destroy_graph_pipeline(pipeline);
+            return nullptr;
+        }
+    }
+
+    for(int i = 0; i < get_graph_output_node_number(graph); i++)
+    {
+        node_t node = get_graph_output_node(graph, i);
+
+        for(int j = 0; j < get_node_output_number(node); j++)
+            pipeline->outputs.push_back(get_graph_output_tensor(graph, i, j));
+
+        release_graph_node(node);
+    }
+
+    for(int n = 0; n < depth; n++)
+    {
+        PipelineFrame* frame = new PipelineFrame();
+
+        for(auto tensor : pipeline->inputs)
+        {
+            int size = get_tensor_buffer_size(tensor);
+
+            frame->input_data.push_back(malloc(size));
+            frame->input_size.push_back(size);
+        }
+
+        /* allocated at the first run: the output size of some graphs is only known then */
+        frame->output_data.resize(pipeline->outputs.size(), nullptr);
+        frame->output_size.resize(pipeline->outputs.size(), 0);
+
+        frame->frame.id = -1;
+        frame->frame.input_num = frame->input_data.size();
+        frame->frame.input_data = frame->input_data.data();
+        frame->frame.input_size = frame->input_size.data();
+        frame->frame.output_num = frame->output_data.size();
+        frame->frame.output_data = frame->output_data.data();
+        frame->frame.output_size = frame->output_size.data();
+
+        pipeline->frames.push_back(frame);
+    }
+
+    return pipeline;
+}
+
+int run_graph_pipeline(pipeline_t pipeline)
+{
+    GraphPipeline* real_pipeline = reinterpret_cast<GraphPipeline*>(pipeline);
+
+    real_pipeline->stop = false;
+    real_pipeline->failed = false;
+    real_pipeline->done_num = 0;
+
+    real_pipeline->free_queue.Clear();
+    real_pipeline->ready_queue.Clear();
+    real_pipeline->done_queue.Clear();
+
+    for(auto frame : real_pipeline->frames)
+        real_pipeline->free_queue.Push(frame);
+
+    std::thread pre_thread(&GraphPipeline::PreLoop, real_pipeline);
+    std::thread post_thread(&GraphPipeline::PostLoop, real_pipeline);
+
+    PipelineFrame* frame;
+
+    while(real_pipeline->ready_queue.Pop(frame))
+    {
+        if(frame != nullptr && !real_pipeline->RunFrame(frame))
+        {
+            LOG_ERROR() << "graph pipeline: graph run failed on frame " << frame->frame.id << "\n";
+            real_pipeline->Fail();
+            break;
+        }
+
+        real_pipeline->done_queue.Push(frame);
+
+        if(frame == nullptr)
+            break;
+    }
+
+    pre_thread.join();
+    post_thread.join();
+
+    if(real_pipeline->failed)
+    {
+        set_tengine_errno(EIO);
+        return -1;
+    }
+
+    return real_pipeline->done_num;
+}
+
+int destroy_graph_pipeline(pipeline_t pipeline)
+{
+    GraphPipeline* real_pipeline = reinterpret_cast<GraphPipeline*>(pipeline);
+
+    /* the inputs still point to the frame buffers freed below */
+    for(unsigned int i = 0; i < real_pipeline->inputs.size(); i++)
+    {
+        set_tensor_mem(reinterpret_cast<Tensor*>(real_pipeline->inputs[i]), real_pipeline->input_mem[i]);
+        release_graph_tensor(real_pipeline->inputs[i]);
+    }
+
+    for(auto tensor : real_pipeline->outputs)
+        release_graph_tensor(tensor);
+
+    for(auto frame : real_pipeline->frames)
+    {
+        for(auto buf : frame->input_data)
+            free(buf);
+
+        for(auto buf : frame->output_data)
+            free(buf);
+
+        delete frame;
+    }
+
+    delete real_pipeline;
+
+    return 0;
+}
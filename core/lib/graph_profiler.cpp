@@ -0,0 +1,335 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <stdio.h>
+#include <cxxabi.h>
+
+#include <atomic>
+#include <map>
+#include <algorithm>
+
+#include "graph_profiler.hpp"
+#include "prof_utils.hpp"
+#include "node.hpp"
+#include "tensor.hpp"
+#include "operator.hpp"
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+
+namespace TEngine {
+
+void GraphProfiler::Start(void)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+
+    events_.clear();
+    base_time_ = get_cur_time();
+    active_ = true;
+}
+
+void GraphProfiler::Stop(void)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+
+    active_ = false;
+}
+
+void GraphProfiler::AddEvent(ProfEvent& event)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if(!active_)
+        return;
+
+    events_.push_back(event);
+}
+
+static std::string ShapeString(Tensor* tensor)
+{
+    const std::vector<int>& dims = tensor->GetShape().GetDim();
+    std::string str;
+
+    for(unsigned int i = 0; i < dims.size(); i++)
+    {
+        if(i > 0)
+            str += "x";
+
+        str += std::to_string(dims[i]);
+    }
+
+    return str;
+}
+
+void GraphProfiler::FillNodeInfo(ProfEvent& event, Node* node)
+{
+    event.node_name = node->GetName();
+    event.op_name = node->GetOp()->GetName();
+    event.fops = node->GetFops();
+    event.bytes = 0;
+
+    event.input_shapes.clear();
+    event.output_shapes.clear();
+
+    for(unsigned int i = 0; i < node->GetInputNum(); i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+
+        event.input_shapes.push_back(ShapeString(tensor));
+        event.bytes += tensor->GetTotalSize();
+    }
+
+    for(unsigned int i = 0; i < node->GetOutputNum(); i++)
+    {
+        Tensor* tensor = node->GetOutputTensor(i);
+
+        event.output_shapes.push_back(ShapeString(tensor));
+        event.bytes += tensor->GetTotalSize();
+    }
+}
+
+std::string GraphProfiler::GetTypeName(const char* mangled_name)
+{
+    int status = 0;
+    char* name = abi::__cxa_demangle(mangled_name, nullptr, nullptr, &status);
+
+    if(name == nullptr)
+        return mangled_name;
+
+    std::string str = name;
+
+    free(name);
+
+    if(str.compare(0, 9, "TEngine::") == 0)
+        str = str.substr(9);
+
+    return str;
+}
+
+/* small and stable thread ids, as chrome trace wants integers */
+int GraphProfiler::GetThreadId(void)
+{
+    static std::atomic<int> thread_number(0);
+    static thread_local int thread_id = -1;
+
+    if(thread_id < 0)
+        thread_id = thread_number++;
+
+    return thread_id;
+}
+
+static std::string JsonString(const std::string& str)
+{
+    std::string out = "\"";
+
+    for(auto c : str)
+    {
+        if(c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if(( unsigned char )c < 0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+
+    out += "\"";
+
+    return out;
+}
+
+static std::string JsonStringList(const std::vector<std::string>& list)
+{
+    std::string out = "[";
+
+    for(unsigned int i = 0; i < list.size(); i++)
+    {
+        if(i > 0)
+            out += ",";
+
+        out += JsonString(list[i]);
+    }
+
+    out += "]";
+
+    return out;
+}
+
+static FILE* OpenDumpFile(const char* file_name)
+{
+    FILE* fp = fopen(file_name, "w");
+
+    if(fp == nullptr)
+    {
+        LOG_ERROR() << "cannot open profiling dump file: " << file_name << "\n";
+        set_tengine_errno(EIO);
+    }
+
+    return fp;
+}
+
+bool GraphProfiler::DumpChromeTrace(const char* file_name)
+{
+    FILE* fp = OpenDumpFile(file_name);
+
+    if(fp == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock_);
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for(unsigned int i = 0; i < events_.size(); i++)
+    {
+        const ProfEvent& e = events_[i];
+
+        fprintf(fp,
+                "%s{\"name\":%s,\"cat\":%s,\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%llu,\"dur\":%llu,"
+                "\"args\":{\"op\":%s,\"impl\":%s,\"device\":%s,\"inputs\":%s,\"outputs\":%s,\"fops\":%.0f,"
+                "\"bytes\":%llu}}",
+                i ? ",\n" : "", JsonString(e.node_name).c_str(), JsonString(e.op_name).c_str(), e.thread_id,
+                ( unsigned long long )(e.start_time - base_time_), ( unsigned long long )(e.end_time - e.start_time),
+                JsonString(e.op_name).c_str(), JsonString(e.impl_name).c_str(), JsonString(e.dev_name).c_str(),
+                JsonStringList(e.input_shapes).c_str(), JsonStringList(e.output_shapes).c_str(), e.fops,
+                ( unsigned long long )e.bytes);
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    return true;
+}
+
+struct ProfStat
+{
+    const ProfEvent* first;
+    int count;
+    uint64_t total_time;
+    uint64_t min_time;
+    uint64_t max_time;
+};
+
+static void UpdateStat(ProfStat& stat, const ProfEvent& e)
+{
+    uint64_t used = e.end_time - e.start_time;
+
+    if(stat.count == 0)
+    {
+        stat.min_time = used;
+        stat.max_time = used;
+    }
+
+    stat.count++;
+    stat.total_time += used;
+    stat.min_time = std::min(stat.min_time, used);
+    stat.max_time = std::max(stat.max_time, used);
+}
+
+/* rates are in GFLOPS and GB/s: fops per us / 1000 */
+bool GraphProfiler::DumpSummary(const char* file_name)
+{
+    FILE* fp = OpenDumpFile(file_name);
+
+    if(fp == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock_);
+
+    std::map<std::string, ProfStat> node_stats;
+    std::map<std::string, ProfStat> op_stats;
+    uint64_t total_time = 0;
+
+    for(unsigned int i = 0; i < events_.size(); i++)
+    {
+        const ProfEvent& e = events_[i];
+
+        ProfStat& node_stat = node_stats[e.node_name];
+        ProfStat& op_stat = op_stats[e.op_name];
+
+        if(node_stat.count == 0)
+            node_stat.first = &e;
+
+        if(op_stat.count == 0)
+            op_stat.first = &e;
+
+        UpdateStat(node_stat, e);
+        UpdateStat(op_stat, e);
+
+        total_time += e.end_time - e.start_time;
+    }
+
+    auto by_time = [](const ProfStat* a, const ProfStat* b) { return a->total_time > b->total_time; };
+
+    std::vector<const ProfStat*> node_list;
+    std::vector<const ProfStat*> op_list;
+
+    for(auto& ir : node_stats)
+        node_list.push_back(&ir.second);
+
+    for(auto& ir : op_stats)
+        op_list.push_back(&ir.second);
+
+    std::sort(node_list.begin(), node_list.end(), by_time);
+    std::sort(op_list.begin(), op_list.end(), by_time);
+
+    double all = total_time ? total_time : 1;
+
+    fprintf(fp, "{\"event_number\":%u,\"total_time_us\":%llu,\n\"nodes\":[\n", ( unsigned int )events_.size(),
+            ( unsigned long long )total_time);
+
+    for(unsigned int i = 0; i < node_list.size(); i++)
+    {
+        const ProfStat& s = *node_list[i];
+        const ProfEvent& e = *s.first;
+        double avg = 1.0 * s.total_time / s.count;
+        double rate = avg > 0 ? 1.0 / avg / 1000 : 0;
+
+        fprintf(fp,
+                "%s{\"name\":%s,\"op\":%s,\"impl\":%s,\"device\":%s,\"inputs\":%s,\"outputs\":%s,\"count\":%d,"
+                "\"total_us\":%llu,\"avg_us\":%.2f,\"min_us\":%llu,\"max_us\":%llu,\"percent\":%.2f,"
+                "\"fops\":%.0f,\"gflops\":%.3f,\"bytes\":%llu,\"gbps\":%.3f}",
+                i ? ",\n" : "", JsonString(e.node_name).c_str(), JsonString(e.op_name).c_str(),
+                JsonString(e.impl_name).c_str(), JsonString(e.dev_name).c_str(), JsonStringList(e.input_shapes).c_str(),
+                JsonStringList(e.output_shapes).c_str(), s.count, ( unsigned long long )s.total_time, avg,
+                ( unsigned long long )s.min_time, ( unsigned long long )s.max_time, 100.0 * s.total_time / all, e.fops,
+                e.fops * rate, ( unsigned long long )e.bytes, e.bytes * rate);
+    }
+
+    fprintf(fp, "\n],\n\"ops\":[\n");
+
+    for(unsigned int i = 0; i < op_list.size(); i++)
+    {
+        const ProfStat& s = *op_list[i];
+
+        fprintf(fp, "%s{\"op\":%s,\"count\":%d,\"total_us\":%llu,\"percent\":%.2f}", i ? ",\n" : "",
+                JsonString(s.first->op_name).c_str(), s.count, ( unsigned long long )s.total_time,
+                100.0 * s.total_time / all);
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    return true;
+}
+
+}    // namespace TEngine
@@ -47,9 +47,236 @@
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif
+#if !__ARM_NEON && __SSE2__
+#include <emmintrin.h>
+#if __SSSE3__
+#include <tmmintrin.h>
+#endif
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif
+
 #include "net.h"
 #include "cpu_device.h"
 
+#if !__ARM_NEON && __SSE2__
+// x86 counterparts of the neon paths in this file, they produce exactly the same
+// values as the scalar code and leave whatever does not fill a vector to it
+static inline int x86_load_u16(const void* p)
+{
+    unsigned short v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+static inline int x86_load_s32(const void* p)
+{
+    int v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// (S[0]*a0 + S[1]*a1) >> 4 for interleaved S/S' pairs, saturated back to short
+static inline __m128i x86_hresize_pairs(__m128i _S, __m128i _a0a1)
+{
+    __m128i _rows = _mm_srai_epi32(_mm_madd_epi16(_S, _a0a1), 4);
+    return _mm_packs_epi32(_rows, _rows);
+}
+
+static int x86_hresize_c1(const unsigned char* S, const int* xofs, const short* ialpha, short* rows, int w)
+{
+    const __m128i _zero = _mm_setzero_si128();
+
+    int dx = 0;
+    for (; dx + 7 < w; dx += 8)
+    {
+        __m128i _S = _mm_cvtsi32_si128(x86_load_u16(S + xofs[dx]));
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+1]), 1);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+2]), 2);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+3]), 3);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+4]), 4);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+5]), 5);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+6]), 6);
+        _S = _mm_insert_epi16(_S, x86_load_u16(S + xofs[dx+7]), 7);
+
+        __m128i _rows0 = _mm_madd_epi16(_mm_unpacklo_epi8(_S, _zero), _mm_loadu_si128((const __m128i*)(ialpha + dx*2)));
+        __m128i _rows1 = _mm_madd_epi16(_mm_unpackhi_epi8(_S, _zero), _mm_loadu_si128((const __m128i*)(ialpha + dx*2 + 8)));
+        _rows0 = _mm_srai_epi32(_rows0, 4);
+        _rows1 = _mm_srai_epi32(_rows1, 4);
+        _mm_storeu_si128((__m128i*)(rows + dx), _mm_packs_epi32(_rows0, _rows1));
+    }
+
+    return dx;
+}
+
+static inline void x86_hresize_c2(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    __m128i _S = _mm_unpacklo_epi8(_mm_cvtsi32_si128(x86_load_s32(Sp)), _mm_setzero_si128());
+    _S = _mm_unpacklo_epi16(_S, _mm_srli_si128(_S, 4));
+    __m128i _rows = x86_hresize_pairs(_S, _mm_set1_epi32(x86_load_s32(ialphap)));
+    int v = _mm_cvtsi128_si32(_rows);
+    memcpy(rowsp, &v, 4);
+}
+
+// writes one short past the pixel, the c3 rows buffers carry a spare element for that
+static inline void x86_hresize_c3(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    __m128i _S0 = _mm_cvtsi32_si128(x86_load_s32(Sp));
+    __m128i _S1 = _mm_srli_si128(_mm_cvtsi32_si128(x86_load_s32(Sp + 2)), 1);
+    __m128i _S = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_S0, _mm_setzero_si128()), _mm_unpacklo_epi8(_S1, _mm_setzero_si128()));
+    _mm_storel_epi64((__m128i*)rowsp, x86_hresize_pairs(_S, _mm_set1_epi32(x86_load_s32(ialphap))));
+}
+
+static inline void x86_hresize_c4(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    __m128i _S = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)Sp), _mm_setzero_si128());
+    _S = _mm_unpacklo_epi16(_S, _mm_srli_si128(_S, 8));
+    _mm_storel_epi64((__m128i*)rowsp, x86_hresize_pairs(_S, _mm_set1_epi32(x86_load_s32(ialphap))));
+}
+
+// ((b0 * rows0) >> 16 + (b1 * rows1) >> 16 + 2) >> 2
+static int x86_vresize(const short* rows0p, const short* rows1p, unsigned char* Dp, short b0, short b1, int n)
+{
+    int i = 0;
+#if __AVX2__
+    __m256i _b0_256 = _mm256_set1_epi16(b0);
+    __m256i _b1_256 = _mm256_set1_epi16(b1);
+    __m256i _v2_256 = _mm256_set1_epi16(2);
+    for (; i + 15 < n; i += 16)
+    {
+        __m256i _rows0 = _mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows0p + i)), _b0_256);
+        __m256i _rows1 = _mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows1p + i)), _b1_256);
+        __m256i _acc = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(_rows0, _rows1), _v2_256), 2);
+        __m128i _D = _mm_packus_epi16(_mm256_castsi256_si128(_acc), _mm256_extracti128_si256(_acc, 1));
+        _mm_storeu_si128((__m128i*)(Dp + i), _D);
+    }
+#endif // __AVX2__
+    __m128i _b0 = _mm_set1_epi16(b0);
+    __m128i _b1 = _mm_set1_epi16(b1);
+    __m128i _v2 = _mm_set1_epi16(2);
+    for (; i + 7 < n; i += 8)
+    {
+        __m128i _rows0 = _mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows0p + i)), _b0);
+        __m128i _rows1 = _mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows1p + i)), _b1);
+        __m128i _acc = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_rows0, _rows1), _v2), 2);
+        _mm_storel_epi64((__m128i*)(Dp + i), _mm_packus_epi16(_acc, _acc));
+    }
+
+    return i;
+}
+
+static int x86_mean_norm(float* ptr, int size, float mean, float norm)
+{
+    int i = 0;
+#if __AVX__
+    __m256 _mean_256 = _mm256_set1_ps(mean);
+    __m256 _norm_256 = _mm256_set1_ps(norm);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr + i);
+        _mm256_storeu_ps(ptr + i, _mm256_mul_ps(_mm256_sub_ps(_p, _mean_256), _norm_256));
+    }
+#endif // __AVX__
+    __m128 _mean = _mm_set1_ps(mean);
+    __m128 _norm = _mm_set1_ps(norm);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr + i);
+        _mm_storeu_ps(ptr + i, _mm_mul_ps(_mm_sub_ps(_p, _mean), _norm));
+    }
+
+    return i;
+}
+
+// 16 uint8 to float, optionally (v - mean) * norm
+static inline void x86_store_u8_f32(float* ptr, __m128i _v, const float* mean, const float* norm)
+{
+#if __AVX2__
+    __m256 _p0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_v));
+    __m256 _p1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(_v, 8)));
+    if (mean)
+    {
+        __m256 _mean = _mm256_set1_ps(*mean);
+        __m256 _norm = _mm256_set1_ps(*norm);
+        _p0 = _mm256_mul_ps(_mm256_sub_ps(_p0, _mean), _norm);
+        _p1 = _mm256_mul_ps(_mm256_sub_ps(_p1, _mean), _norm);
+    }
+    _mm256_storeu_ps(ptr, _p0);
+    _mm256_storeu_ps(ptr + 8, _p1);
+#else
+    const __m128i _zero = _mm_setzero_si128();
+    __m128i _v16l = _mm_unpacklo_epi8(_v, _zero);
+    __m128i _v16h = _mm_unpackhi_epi8(_v, _zero);
+    __m128 _p[4];
+    _p[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_v16l, _zero));
+    _p[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(_v16l, _zero));
+    _p[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_v16h, _zero));
+    _p[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(_v16h, _zero));
+    for (int k = 0; k < 4; k++)
+    {
+        if (mean)
+            _p[k] = _mm_mul_ps(_mm_sub_ps(_p[k], _mm_set1_ps(*mean)), _mm_set1_ps(*norm));
+        _mm_storeu_ps(ptr + k * 4, _p[k]);
+    }
+#endif // __AVX2__
+}
+
+// deinterleave packed 3 channel pixels into float planes, the plane of byte k gets
+// (v - mean[k]) * norm[k] when mean is given
+static int x86_from_rgb(const unsigned char* rgb, float* ptr0, float* ptr1, float* ptr2, int n, const float* mean, const float* norm)
+{
+    int i = 0;
+#if __SSSE3__
+    const __m128i _m00 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i _m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i _m02 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i _m10 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i _m11 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i _m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i _m20 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i _m21 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i _m22 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    for (; i + 15 < n; i += 16)
+    {
+        __m128i _a = _mm_loadu_si128((const __m128i*)rgb);
+        __m128i _b = _mm_loadu_si128((const __m128i*)(rgb + 16));
+        __m128i _c = _mm_loadu_si128((const __m128i*)(rgb + 32));
+
+        __m128i _p0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(_a, _m00), _mm_shuffle_epi8(_b, _m01)), _mm_shuffle_epi8(_c, _m02));
+        __m128i _p1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(_a, _m10), _mm_shuffle_epi8(_b, _m11)), _mm_shuffle_epi8(_c, _m12));
+        __m128i _p2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(_a, _m20), _mm_shuffle_epi8(_b, _m21)), _mm_shuffle_epi8(_c, _m22));
+
+        x86_store_u8_f32(ptr0 + i, _p0, mean, norm);
+        x86_store_u8_f32(ptr1 + i, _p1, mean ? mean + 1 : 0, mean ? norm + 1 : 0);
+        x86_store_u8_f32(ptr2 + i, _p2, mean ? mean + 2 : 0, mean ? norm + 2 : 0);
+
+        rgb += 3*16;
+    }
+#else
+    // no byte shuffle before ssse3, split the pixels through the stack and convert in vectors
+    unsigned char planes[3][16];
+    for (; i + 15 < n; i += 16)
+    {
+        for (int j=0; j<16; j++)
+        {
+            planes[0][j] = rgb[0];
+            planes[1][j] = rgb[1];
+            planes[2][j] = rgb[2];
+            rgb += 3;
+        }
+
+        x86_store_u8_f32(ptr0 + i, _mm_loadu_si128((const __m128i*)planes[0]), mean, norm);
+        x86_store_u8_f32(ptr1 + i, _mm_loadu_si128((const __m128i*)planes[1]), mean ? mean + 1 : 0, mean ? norm + 1 : 0);
+        x86_store_u8_f32(ptr2 + i, _mm_loadu_si128((const __m128i*)planes[2]), mean ? mean + 2 : 0, mean ? norm + 2 : 0);
+    }
+#endif // __SSSE3__
+
+    return i;
+}
+#endif // !__ARM_NEON && __SSE2__
+
 namespace ncnn {
 bool b_tengine_inited = false;
 
@@ -409,6 +636,7 @@ Mat::Mat(const Mat& m)
     c = m.c;
     h = m.h;
     w = m.w;
+    cstep = m.cstep;
 }
 
 Mat::~Mat()
@@ -488,6 +716,10 @@ void Mat::substract_mean_normalize(const float* mean_vals, const float* norm_val
             );
             }
 #endif // __aarch64__
+#elif __SSE2__
+            int nn = x86_mean_norm(ptr, size, mean, 1.f);
+            ptr += nn;
+            remain -= nn;
 #endif // __ARM_NEON
             for (; remain>0; remain--)
             {
@@ -554,6 +786,10 @@ void Mat::substract_mean_normalize(const float* mean_vals, const float* norm_val
             );
             }
 #endif // __aarch64__
+#elif __SSE2__
+            int nn = x86_mean_norm(ptr, size, 0.f, norm);
+            ptr += nn;
+            remain -= nn;
 #endif // __ARM_NEON
             for (; remain>0; remain--)
             {
@@ -627,6 +863,10 @@ void Mat::substract_mean_normalize(const float* mean_vals, const float* norm_val
             );
             }
 #endif // __aarch64__
+#elif __SSE2__
+            int nn = x86_mean_norm(ptr, size, mean, norm);
+            ptr += nn;
+            remain -= nn;
 #endif // __ARM_NEON
             for (; remain>0; remain--)
             {
@@ -1095,9 +1335,13 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstr
             rows1 = rows0_old;
             const unsigned char *S1 = src + srcstride * (sy+1);
 
-            const short* ialphap = ialpha;
+            int dx = 0;
+#if !__ARM_NEON && __SSE2__
+            dx = x86_hresize_c1(S1, xofs, ialpha, rows1, w);
+#endif
+            const short* ialphap = ialpha + dx*2;
             short* rows1p = rows1;
-            for ( int dx = 0; dx < w; dx++ )
+            for ( ; dx < w; dx++ )
             {
                 int sx = xofs[dx];
                 short a0 = ialphap[0];
@@ -1115,10 +1359,15 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstr
             const unsigned char *S0 = src + srcstride * (sy);
             const unsigned char *S1 = src + srcstride * (sy+1);
 
-            const short* ialphap = ialpha;
+            int dx = 0;
+#if !__ARM_NEON && __SSE2__
+            dx = x86_hresize_c1(S0, xofs, ialpha, rows0, w);
+            x86_hresize_c1(S1, xofs, ialpha, rows1, w);
+#endif
+            const short* ialphap = ialpha + dx*2;
             short* rows0p = rows0;
             short* rows1p = rows1;
-            for ( int dx = 0; dx < w; dx++ )
+            for ( ; dx < w; dx++ )
             {
                 int sx = xofs[dx];
                 short a0 = ialphap[0];
@@ -1235,6 +1484,12 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        nn = x86_vresize(rows0p, rows1p, Dp, b0, b1, remain);
+        rows0p += nn;
+        rows1p += nn;
+        Dp += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -1374,6 +1629,8 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstr
                 int32x4_t _rows1 = vcombine_s32(_rows1low, vget_high_s32(_S1ma0a1));
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c2(S1p, ialphap, rows1p);
 #else
                 short a0 = ialphap[0];
                 short a1 = ialphap[1];
@@ -1430,6 +1687,9 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstr
                 int16x4_t _rows1_sr4 = vext_s16(_rows01_sr4, _rows01_sr4, 2);
                 vst1_s16(rows0p, _rows01_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c2(S0p, ialphap, rows0p);
+                x86_hresize_c2(S1p, ialphap, rows1p);
 #else
                 rows0p[0] = (S0p[0]*a0 + S0p[2]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[3]*a1) >> 4;
@@ -1545,6 +1805,12 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        nn = x86_vresize(rows0p, rows1p, Dp, b0, b1, remain);
+        rows0p += nn;
+        rows1p += nn;
+        Dp += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -1688,6 +1954,8 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstr
                 _rows1 = vmlal_s16(_rows1, _S1high, _a1);
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c3(S1p, ialphap, rows1p);
 #else
                 rows1p[0] = (S1p[0]*a0 + S1p[3]*a1) >> 4;
                 rows1p[1] = (S1p[1]*a0 + S1p[4]*a1) >> 4;
@@ -1749,6 +2017,9 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstr
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows0p, _rows0_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c3(S0p, ialphap, rows0p);
+                x86_hresize_c3(S1p, ialphap, rows1p);
 #else
                 rows0p[0] = (S0p[0]*a0 + S0p[3]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[4]*a1) >> 4;
@@ -1866,6 +2137,12 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        nn = x86_vresize(rows0p, rows1p, Dp, b0, b1, remain);
+        rows0p += nn;
+        rows1p += nn;
+        Dp += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -1973,7 +2250,7 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
         {
             // reuse all rows
         }
-        else if (sy == prev_sy1 + 4)
+        else if (sy == prev_sy1 + 1)
         {
             // hresize one row
             short* rows0_old = rows0;
@@ -2001,6 +2278,8 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
                 _rows1 = vmlal_s16(_rows1, _S1high, _a1);
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c4(S1p, ialphap, rows1p);
 #else
                 rows1p[0] = (S1p[0]*a0 + S1p[4]*a1) >> 4;
                 rows1p[1] = (S1p[1]*a0 + S1p[5]*a1) >> 4;
@@ -2048,6 +2327,9 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows0p, _rows0_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                x86_hresize_c4(S0p, ialphap, rows0p);
+                x86_hresize_c4(S1p, ialphap, rows1p);
 #else
                 rows0p[0] = (S0p[0]*a0 + S0p[4]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[5]*a1) >> 4;
@@ -2167,6 +2449,12 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        nn = x86_vresize(rows0p, rows1p, Dp, b0, b1, remain);
+        rows0p += nn;
+        rows1p += nn;
+        Dp += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -2312,6 +2600,13 @@ static int from_rgb(const unsigned char* rgb, int w, int h, int stride, Mat& m)
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = x86_from_rgb(rgb, ptr0, ptr1, ptr2, remain, 0, 0);
+        rgb += 3*nn;
+        ptr0 += nn;
+        ptr1 += nn;
+        ptr2 += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -2852,6 +3147,13 @@ static int from_rgb2bgr(const unsigned char* rgb, int w, int h, int stride, Mat&
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = x86_from_rgb(rgb, ptr2, ptr1, ptr0, remain, 0, 0);
+        rgb += 3*nn;
+        ptr0 += nn;
+        ptr1 += nn;
+        ptr2 += nn;
+        remain -= nn;
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -2871,6 +3173,71 @@ static int from_rgb2bgr(const unsigned char* rgb, int w, int h, int stride, Mat&
     return 0;
 }
 
+static int from_rgb_normalize(const unsigned char* rgb, int w, int h, int stride, bool swap, const float* mean_vals, const float* norm_vals, Mat& m)
+{
+    m.create(w, h, 3, 4u);
+    if (m.empty())
+        return -100;
+
+    const int wgap = stride - w * 3;
+    if (wgap == 0)
+    {
+        w = w * h;
+        h = 1;
+    }
+
+    // channel q of the output takes byte order[q] of every pixel
+    const int order[3] = {swap ? 2 : 0, 1, swap ? 0 : 2};
+
+    // an absent mean or norm is the identity, (v - 0.f) * 1.f leaves v bit exact
+    float mean[3] = {0.f, 0.f, 0.f};
+    float norm[3] = {1.f, 1.f, 1.f};
+    for (int q=0; q<3; q++)
+    {
+        if (mean_vals)
+            mean[order[q]] = mean_vals[q];
+        if (norm_vals)
+            norm[order[q]] = norm_vals[q];
+    }
+
+    float* ptrs[3];
+    ptrs[order[0]] = m.channel(0);
+    ptrs[order[1]] = m.channel(1);
+    ptrs[order[2]] = m.channel(2);
+
+    float* ptr0 = ptrs[0];
+    float* ptr1 = ptrs[1];
+    float* ptr2 = ptrs[2];
+
+    for (int y=0; y<h; y++)
+    {
+        int remain = w;
+#if !__ARM_NEON && __SSE2__
+        int nn = x86_from_rgb(rgb, ptr0, ptr1, ptr2, remain, mean, norm);
+        rgb += 3*nn;
+        ptr0 += nn;
+        ptr1 += nn;
+        ptr2 += nn;
+        remain -= nn;
+#endif
+        for (; remain>0; remain--)
+        {
+            *ptr0 = ((float)rgb[0] - mean[0]) * norm[0];
+            *ptr1 = ((float)rgb[1] - mean[1]) * norm[1];
+            *ptr2 = ((float)rgb[2] - mean[2]) * norm[2];
+
+            rgb += 3;
+            ptr0++;
+            ptr1++;
+            ptr2++;
+        }
+
+        rgb += wgap;
+    }
+
+    return 0;
+}
+
 static void to_bgr2rgb(const Mat& m, unsigned char* rgb, int stride)
 {
     int w = m.w;
@@ -4506,6 +4873,57 @@ Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h,
     return Mat();
 }
 
+Mat Mat::from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, const float* mean_vals, const float* norm_vals)
+{
+    int type_from = type & PIXEL_FORMAT_MASK;
+
+    if (type_from == PIXEL_RGB || type_from == PIXEL_BGR)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 3, target_width, target_height, mean_vals, norm_vals);
+    }
+    else if (type_from == PIXEL_GRAY)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 1, target_width, target_height, mean_vals, norm_vals);
+    }
+    else if (type_from == PIXEL_RGBA || type_from == PIXEL_BGRA)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 4, target_width, target_height, mean_vals, norm_vals);
+    }
+
+    // unknown convert type
+    return Mat();
+}
+
+Mat Mat::from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height, const float* mean_vals, const float* norm_vals)
+{
+    Mat m;
+
+    if (type != PIXEL_RGB && type != PIXEL_BGR && type != PIXEL_RGB2BGR && type != PIXEL_BGR2RGB)
+    {
+        m = Mat::from_pixels_resize(pixels, type, w, h, stride, target_width, target_height);
+        if (!m.empty())
+            m.substract_mean_normalize(mean_vals, norm_vals);
+
+        return m;
+    }
+
+    const bool swap = (type & PIXEL_CONVERT_MASK) != 0;
+
+    if (w == target_width && h == target_height)
+    {
+        from_rgb_normalize(pixels, w, h, stride, swap, mean_vals, norm_vals, m);
+        return m;
+    }
+
+    // resize in uint8, then widen, swap and normalize in a single pass over the small image
+    Mat dst(1, target_width, target_height, (size_t)3u, 3);
+    resize_bilinear_c3(pixels, w, h, stride, dst, target_width, target_height, target_width * 3);
+
+    from_rgb_normalize(dst, target_width, target_height, target_width * 3, swap, mean_vals, norm_vals, m);
+
+    return m;
+}
+
 void Mat::to_pixels(unsigned char* pixels, int type) const
 {
     int type_to = (type & PIXEL_CONVERT_MASK) ? (type >> PIXEL_CONVERT_SHIFT) : (type & PIXEL_FORMAT_MASK);
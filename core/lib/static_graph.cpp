@@ -24,6 +24,7 @@
 #include <iostream>
 #include <functional>
 #include <algorithm>
+#include <sys/mman.h>
 
 #include "static_graph.hpp"
 #include "static_graph_interface.hpp"
@@ -36,6 +37,9 @@ StaticGraph::~StaticGraph(void)
     for(auto p : mem_src)
         free(p);
 
+    if(mem_map_addr)
+        munmap(mem_map_addr, mem_map_size);
+
     if(release_func)
         release_func(dev_handle);
 }
@@ -486,6 +490,14 @@ void SetConstTensorBuffer(StaticTensor* tensor, void* addr)
 {
     StaticConstTensor* const_tensor = dynamic_cast<StaticConstTensor*>(tensor);
     const_tensor->mem_addr = addr;
+    const_tensor->mem_mapped = false;
+}
+
+void SetConstTensorMappedBuffer(StaticTensor* tensor, void* addr)
+{
+    StaticConstTensor* const_tensor = dynamic_cast<StaticConstTensor*>(tensor);
+    const_tensor->mem_addr = addr;
+    const_tensor->mem_mapped = true;
 }
 
 void SetConstTensorFileLocation(StaticTensor* tensor, int offset, int file_size)
@@ -39,6 +39,7 @@
 
 #include "node_dump.hpp"
 #include "graph_perf.hpp"
+#include "graph_profiler.hpp"
 #include "static_graph.hpp"
 #include "graph_executor.hpp"
 
@@ -1462,6 +1463,91 @@ int get_graph_perf_stat(graph_t graph, struct perf_info** buf, int buf_size)
     return -1;
 }
 
+static GraphProfiler* get_graph_profiler(GraphExecutor* executor, bool create)
+{
+    Graph* graph = executor->GetGraph();
+
+    if(graph->ExistAttr(ATTR_GRAPH_PROFILER))
+        return any_cast<std::shared_ptr<GraphProfiler>>(graph->GetAttr(ATTR_GRAPH_PROFILER)).get();
+
+    if(!create)
+        return nullptr;
+
+    std::shared_ptr<GraphProfiler> profiler(new GraphProfiler());
+
+    graph->SetAttr(ATTR_GRAPH_PROFILER, profiler);
+
+    return profiler.get();
+}
+
+int start_graph_profiling(graph_t graph)
+{
+    GraphExecutor* executor = reinterpret_cast<GraphExecutor*>(graph);
+    GraphProfiler* profiler = get_graph_profiler(executor, true);
+
+    profiler->Start();
+
+    /* before prerun, the devices pick the profiler up when they build their plans */
+    if(!executor->PrerunDone())
+        return 0;
+
+    if(set_graph_attr(graph, ATTR_GRAPH_PROFILER, &profiler, sizeof(profiler)) < 0)
+    {
+        profiler->Stop();
+        return -1;
+    }
+
+    return 0;
+}
+
+int stop_graph_profiling(graph_t graph)
+{
+    GraphExecutor* executor = reinterpret_cast<GraphExecutor*>(graph);
+    GraphProfiler* profiler = get_graph_profiler(executor, false);
+
+    if(profiler == nullptr)
+    {
+        set_tengine_errno(ENOENT);
+        return -1;
+    }
+
+    profiler->Stop();
+
+    if(!executor->PrerunDone())
+        return 0;
+
+    /* detach from the devices */
+    GraphProfiler* none = nullptr;
+
+    return set_graph_attr(graph, ATTR_GRAPH_PROFILER, &none, sizeof(none));
+}
+
+int dump_graph_profiling(graph_t graph, const char* file_name, int format)
+{
+    GraphExecutor* executor = reinterpret_cast<GraphExecutor*>(graph);
+    GraphProfiler* profiler = get_graph_profiler(executor, false);
+
+    if(profiler == nullptr)
+    {
+        set_tengine_errno(ENOENT);
+        return -1;
+    }
+
+    bool ret;
+
+    if(format == GRAPH_PROF_CHROME_TRACE)
+        ret = profiler->DumpChromeTrace(file_name);
+    else if(format == GRAPH_PROF_SUMMARY)
+        ret = profiler->DumpSummary(file_name);
+    else
+    {
+        set_tengine_errno(EINVAL);
+        return -1;
+    }
+
+    return ret ? 0 : -1;
+}
+
 int get_device_number(void)
 {
     return DevExecutorManager::GetNum();
@@ -90,10 +90,13 @@ void Tensor::FreeMem(void)
 
     if(static_tensor_)
     {
-        if(static_tensor_->mem_addr)
+        /* a mapped buffer is left to the other graphs built from the same static graph */
+        if(static_tensor_->mem_addr && !static_tensor_->mem_mapped)
+        {
             std::free(static_tensor_->mem_addr);
+            static_tensor_->mem_addr = nullptr;
+        }
 
-        static_tensor_->mem_addr = nullptr;
         static_tensor_ = nullptr;
     }
 }
@@ -0,0 +1,269 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <sched.h>
+#include <cstdlib>
+#include <new>
+
+#include "cpu_aider_group.hpp"
+
+namespace TEngine {
+
+AiderGroup::AiderGroup(const std::vector<int>& cpu_list, int dispatch_cpu) : cpu_list_(cpu_list)
+{
+    busy = false;
+    dispatch_cpu_ = dispatch_cpu;
+    push_idx_ = 0;
+
+    pending_ = 0;
+    unfinished_ = 0;
+    parked_ = 0;
+    active_ = false;
+    quit_ = false;
+}
+
+AiderGroup::~AiderGroup()
+{
+    std::unique_lock<std::mutex> lock(park_lock_);
+    quit_ = true;
+    lock.unlock();
+
+    park_cv_.notify_all();
+
+    for(auto aider : aiders_)
+    {
+        aider->worker->join();
+        delete aider->worker;
+
+        aider->~Aider();
+        std::free(aider);
+    }
+}
+
+void AiderGroup::LaunchAider(void)
+{
+    for(unsigned int i = 0; i < cpu_list_.size(); i++)
+    {
+        /* the deque indices are alignas(64): plain new does not honour that before C++17 */
+        void* mem = nullptr;
+
+        if(posix_memalign(&mem, alignof(Aider), sizeof(Aider)))
+            break;
+
+        Aider* aider = new(mem) Aider();
+
+        aider->cpu = cpu_list_[i];
+        aider->deque.head = 0;
+        aider->deque.tail = 0;
+
+        aiders_.push_back(aider);
+    }
+
+    /* all deques must exist before any aider starts to steal */
+    for(unsigned int i = 0; i < aiders_.size(); i++)
+        aiders_[i]->worker = new std::thread(&AiderGroup::AiderLoop, this, i);
+}
+
+void AiderGroup::Activate(void)
+{
+    active_ = true;
+}
+
+void AiderGroup::Deactivate(void)
+{
+    active_ = false;
+}
+
+/* only the thread which owns the group pushes, so the tail has a single writer */
+bool AiderGroup::PushToDeque(TaskDeque& deque, sub_op_task* task)
+{
+    unsigned int tail = deque.tail.load(std::memory_order_relaxed);
+    unsigned int head = deque.head.load(std::memory_order_acquire);
+
+    if(tail - head >= AIDER_DEQUE_SIZE)
+        return false;
+
+    deque.slot[tail % AIDER_DEQUE_SIZE].store(task, std::memory_order_relaxed);
+    deque.tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+/*
+  the owner and the thieves both claim the head slot by CAS.
+  A slot read with a stale head may already be reused, but then the CAS fails and it is read again
+*/
+bool AiderGroup::PopFromDeque(TaskDeque& deque, sub_op_task*& task)
+{
+    unsigned int head = deque.head.load(std::memory_order_acquire);
+
+    while(true)
+    {
+        unsigned int tail = deque.tail.load(std::memory_order_acquire);
+
+        if(head == tail)
+            return false;
+
+        sub_op_task* slot_task = deque.slot[head % AIDER_DEQUE_SIZE].load(std::memory_order_relaxed);
+
+        if(deque.head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            task = slot_task;
+            return true;
+        }
+    }
+}
+
+bool AiderGroup::GrabTask(int aider_idx, sub_op_task*& task)
+{
+    int aider_number = aiders_.size();
+
+    for(int i = 0; i < aider_number; i++)
+    {
+        Aider* aider = aiders_[(aider_idx + i) % aider_number];
+
+        if(PopFromDeque(aider->deque, task))
+            return true;
+    }
+
+    return false;
+}
+
+void AiderGroup::PushTask(std::vector<sub_op_task>& task_list)
+{
+    if(aiders_.empty())
+    {
+        for(auto& task : task_list)
+            task.exec_func(dispatch_cpu_, task.seq, task.data);
+
+        return;
+    }
+
+    unfinished_ += task_list.size();
+
+    int aider_number = aiders_.size();
+
+    for(auto& task : task_list)
+    {
+        task_store_.push_back(task);
+
+        sub_op_task* p_task = &task_store_.back();
+
+        pending_++;
+
+        while(true)
+        {
+            bool pushed = false;
+
+            for(int i = 0; i < aider_number && !pushed; i++)
+                pushed = PushToDeque(aiders_[(push_idx_ + i) % aider_number]->deque, p_task);
+
+            if(pushed)
+                break;
+
+            /* all deques are full: let the aiders drain them */
+            std::unique_lock<std::mutex> lock(park_lock_);
+            park_cv_.notify_all();
+            lock.unlock();
+
+            std::this_thread::yield();
+        }
+
+        push_idx_++;
+    }
+
+    if(parked_ > 0)
+    {
+        std::unique_lock<std::mutex> lock(park_lock_);
+        park_cv_.notify_all();
+    }
+}
+
+void AiderGroup::WaitDone(void)
+{
+    for(int spin = 0; unfinished_ > 0 && spin < AIDER_SPIN_LIMIT; spin++)
+        std::this_thread::yield();
+
+    if(unfinished_ > 0)
+    {
+        std::unique_lock<std::mutex> lock(done_lock_);
+        done_cv_.wait(lock, [this] { return unfinished_ == 0; });
+    }
+
+    task_store_.clear();
+}
+
+void AiderGroup::AiderLoop(int aider_idx)
+{
+    int cpu = aiders_[aider_idx]->cpu;
+
+    if(cpu >= 0)
+    {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+
+        sched_setaffinity(0, sizeof(mask), &mask);
+    }
+
+    /* the aider sharing the core with the dispatching thread never spins */
+    int spin_limit = (cpu == dispatch_cpu_) ? 0 : AIDER_SPIN_LIMIT;
+    int spin = 0;
+
+    while(!quit_)
+    {
+        sub_op_task* task;
+
+        if(GrabTask(aider_idx, task))
+        {
+            pending_--;
+
+            task->exec_func(cpu, task->seq, task->data);
+
+            if(unfinished_.fetch_sub(1) == 1)
+            {
+                std::unique_lock<std::mutex> lock(done_lock_);
+                done_cv_.notify_all();
+            }
+
+            spin = 0;
+            continue;
+        }
+
+        if(active_ && spin < spin_limit)
+        {
+            spin++;
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(park_lock_);
+
+        parked_++;
+        park_cv_.wait(lock, [this] { return quit_ || pending_ > 0; });
+        parked_--;
+
+        spin = 0;
+    }
+}
+
+}    // namespace TEngine
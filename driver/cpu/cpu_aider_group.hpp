@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __CPU_AIDER_GROUP_HPP__
+#define __CPU_AIDER_GROUP_HPP__
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "node_ops.hpp"
+
+namespace TEngine {
+
+/*
+ * Work-stealing pool of aider threads for one slice of the device cores.
+ *
+ * Each aider owns a bounded task deque. PushTask() spreads a task list round-robin
+ * over the deques, and an aider first drains its own deque, then steals from the others.
+ * Deque slots are claimed by CAS on the head index, so neither the owner nor a thief takes a lock.
+ * Idle aiders spin for a bounded number of rounds while the group is active and park on a
+ * condition variable afterwards.
+ */
+
+#define AIDER_DEQUE_SIZE 1024
+#define AIDER_SPIN_LIMIT 20000
+
+class AiderGroup
+{
+public:
+    AiderGroup(const std::vector<int>& cpu_list, int dispatch_cpu);
+    ~AiderGroup();
+
+    /* start one aider per cpu. Without aiders, PushTask() runs the tasks in the calling thread */
+    void LaunchAider(void);
+
+    void Activate(void);
+    void Deactivate(void);
+
+    void PushTask(std::vector<sub_op_task>& task_list);
+    void WaitDone(void);
+
+    const std::vector<int>& GetCPUList(void) const
+    {
+        return cpu_list_;
+    }
+
+    /* threads a pushed task list is spread over: the aiders, or just the caller without them */
+    int GetWorkerNumber(void) const
+    {
+        return aiders_.empty() ? 1 : ( int )aiders_.size();
+    }
+
+    bool busy;
+
+private:
+    struct TaskDeque
+    {
+        alignas(64) std::atomic<unsigned int> head;
+        alignas(64) std::atomic<unsigned int> tail;
+        std::atomic<sub_op_task*> slot[AIDER_DEQUE_SIZE];
+    };
+
+    struct Aider
+    {
+        int cpu;
+        std::thread* worker;
+        TaskDeque deque;
+    };
+
+    bool PushToDeque(TaskDeque& deque, sub_op_task* task);
+    bool PopFromDeque(TaskDeque& deque, sub_op_task*& task);
+    bool GrabTask(int aider_idx, sub_op_task*& task);
+
+    void AiderLoop(int aider_idx);
+
+    std::vector<int> cpu_list_;
+    int dispatch_cpu_;
+
+    std::vector<Aider*> aiders_;
+    unsigned int push_idx_;
+
+    /* tasks pushed since the last WaitDone(): the deques only hold pointers into it */
+    std::deque<sub_op_task> task_store_;
+
+    std::atomic<int> pending_;       // pushed but not grabbed yet
+    std::atomic<int> unfinished_;    // pushed but not done yet
+    std::atomic<int> parked_;
+    std::atomic<bool> active_;
+    std::atomic<bool> quit_;
+
+    std::mutex park_lock_;
+    std::condition_variable park_cv_;
+
+    std::mutex done_lock_;
+    std::condition_variable done_cv_;
+};
+
+}    // namespace TEngine
+
+#endif
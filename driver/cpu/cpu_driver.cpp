@@ -21,16 +21,21 @@
  * Copyright (c) 2018, Open AI Lab
  * Author: haitao@openailab.com
  */
+#include <string.h>
+
 #include "cpu_driver.hpp"
 #include "tensor_mem.hpp"
 #include "cpu_executor.hpp"
 
 #include "node_dump.hpp"
 #include "graph_perf.hpp"
+#include "graph_profiler.hpp"
 #include "tengine_errno.hpp"
 
 namespace TEngine {
 
+thread_local AiderGroup* CPUDevice::cur_group_ = nullptr;
+
 bool CPUDriver::InitializeDevice(Device* device)
 {
     CPUDevice* cpu_dev = dynamic_cast<CPUDevice*>(device);
@@ -205,6 +210,17 @@ bool CPUDriver::Postrun(Device* dev, void* graph_handle)
 
 bool CPUDriver::SetDevAttr(Device* dev, const char* attr_name, const void* val, int size)
 {
+    CPUDevice* cpu_dev = dynamic_cast<CPUDevice*>(dev);
+
+    if(!strcmp(attr_name, ATTR_AIDER_GROUP_NUM) && size == sizeof(int))
+    {
+        if(cpu_dev->SetAiderGroupNumber(*( const int* )val))
+            return true;
+
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
     LOG_ERROR() << "try to set attr " << attr_name << " on dev: " << dev->GetName() << "\n";
     set_tengine_errno(ENOTSUP);
     return false;
@@ -212,6 +228,14 @@ bool CPUDriver::SetDevAttr(Device* dev, const char* attr_name, const void* val,
 
 bool CPUDriver::GetDevAttr(Device* dev, const char* attr_name, void* val, int size)
 {
+    CPUDevice* cpu_dev = dynamic_cast<CPUDevice*>(dev);
+
+    if(!strcmp(attr_name, ATTR_AIDER_GROUP_NUM) && size == sizeof(int))
+    {
+        *( int* )val = cpu_dev->GetAiderGroupNumber();
+        return true;
+    }
+
     LOG_ERROR() << "try to get attr " << attr_name << " on dev: " << dev->GetName() << "\n";
     set_tengine_errno(ENOTSUP);
     return false;
@@ -381,8 +405,12 @@ void CPUDriver::InitGraphAttrIO(void)
     auto f3 = std::bind(&CPUDriver::OnGetNodeDumpAttr, this, std::placeholders::_1, std::placeholders::_2,
                         std::placeholders::_3, std::placeholders::_4, std::placeholders::_5);
 
+    auto f4 = std::bind(&CPUDriver::OnSetGraphProfilerAttr, this, std::placeholders::_1, std::placeholders::_2,
+                        std::placeholders::_3, std::placeholders::_4, std::placeholders::_5);
+
     set_attr_table_[ATTR_GRAPH_PERF_STAT] = f0;
     set_attr_table_[ATTR_GRAPH_NODE_DUMP] = f2;
+    set_attr_table_[ATTR_GRAPH_PROFILER] = f4;
 
     get_attr_table_[ATTR_GRAPH_PERF_STAT] = f1;
     get_attr_table_[ATTR_GRAPH_NODE_DUMP] = f3;
@@ -533,6 +561,22 @@ bool CPUDriver::OnSetGraphPerfAttr(DevContext* context, Subgraph* graph, const c
     return dev->SetGraphPerfStat(graph, msg->action);
 }
 
+bool CPUDriver::OnSetGraphProfilerAttr(DevContext* context, Subgraph* graph, const char* name, const void* buf,
+                                       int size)
+{
+    if(size != sizeof(GraphProfiler*))
+    {
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    GraphProfiler* profiler = *( GraphProfiler* const* )buf;
+
+    CPUDevice* dev = context->dev;
+
+    return dev->SetGraphProfiler(graph, profiler);
+}
+
 /************************************/
 
 struct default_cpu_param
@@ -30,6 +30,8 @@
 #include <queue>
 #include <thread>
 #include <condition_variable>
+#include <mutex>
+#include <cstdlib>
 
 #include "cpu_device.h"
 #include "cpu_info.hpp"
@@ -39,6 +41,7 @@
 #include "graph.hpp"
 #include "device_driver.hpp"
 #include "worker_thread.hpp"
+#include "cpu_aider_group.hpp"
 
 #include "graph_perf.hpp"
 
@@ -60,19 +63,27 @@ struct cpu_task
 {
     struct DevContext* context;
 };
+
 }    // namespace cpu_driver
 
 using cpu_task = cpu_driver::cpu_task;
 using DevContext = cpu_driver::DevContext;
 
+#define ATTR_AIDER_GROUP_NUM "aider_group_number"
+
 class CPUDevice : public Device
 {
 public:
     CPUDevice(const char* dev_name, const struct cpu_info* dev_def) : Device(dev_name), cpu_info_(dev_def)
     {
         master_thread_ = nullptr;
-        done_ = 0;
-        request_ = 0;
+        group_number_ = 1;
+        reconfig_ = false;
+
+        const char* group_env = std::getenv("AIDER_GROUP_NUM");
+
+        if(group_env && atoi(group_env) > 0)
+            group_number_ = atoi(group_env);
 
         /* backend runner */
         backend_runner_.AttachCPUDevice(this);
@@ -83,8 +94,7 @@ public:
         if(master_thread_)
             delete master_thread_;
 
-        for(auto tr : aider_threads_)
-            delete tr;
+        KillAider();
     }
 
     const CPUInfo* GetCPUInfo(void)
@@ -105,11 +115,6 @@ public:
         RunGraph(task.context->optimized_graph, task.context->graph_cb);
     }
 
-    void AiderProcess(const sub_op_task& task, int cpu_id)
-    {
-        task.exec_func(cpu_id, task.seq, task.data);
-    }
-
     bool SetGraphPerfStat(Subgraph* graph, int action)
     {
         return backend_runner_.SetGraphPerfStat(graph, action);
@@ -120,6 +125,11 @@ public:
         return backend_runner_.GetGraphPerfStat(graph, buf, buf_size);
     }
 
+    bool SetGraphProfiler(Subgraph* graph, GraphProfiler* profiler)
+    {
+        return backend_runner_.SetGraphProfiler(graph, profiler);
+    }
+
     void LaunchMaster(void)
     {
         auto f = std::bind(&CPUDevice::MasterProcess, this, std::placeholders::_1, std::placeholders::_2);
@@ -132,66 +142,65 @@ public:
         master_thread_->Activate(cpu_info_.master_cpu);
     }
 
+    /* split the online cpus into group_number_ contiguous groups, each one with its own aiders */
     void LaunchAider(void)
     {
-        if(cpu_info_.GetCPUNumber() == 1)
-            return;
+        int cpu_number = cpu_info_.GetCPUNumber();
+        int group_number = group_number_;
 
-        auto f = std::bind(&CPUDevice::AiderProcess, this, std::placeholders::_1, std::placeholders::_2);
+        if(group_number > cpu_number)
+            group_number = cpu_number;
 
-        for(int i = 0; i < cpu_info_.GetCPUNumber(); i++)
+        for(int g = 0; g < group_number; g++)
         {
-            int cpu = cpu_info_.GetOnlineCPU(i);
+            std::vector<int> cpu_list;
 
-            WorkerThread<sub_op_task>* tr = new WorkerThread<sub_op_task>(f, cpu);
+            for(int i = g * cpu_number / group_number; i < (g + 1) * cpu_number / group_number; i++)
+                cpu_list.push_back(cpu_info_.GetOnlineCPU(i));
 
-            tr->SetQueue(&aider_task_queue_, &aider_queue_lock_, &aider_queue_cv_);
+            int dispatch_cpu = cpu_list[0];
 
-            auto inc_req = std::bind(&CPUDevice::IncRequest, this, std::placeholders::_1);
-            auto inc_done = std::bind(&CPUDevice::IncDone, this, std::placeholders::_1);
+            for(auto cpu : cpu_list)
+            {
+                if(cpu == cpu_info_.master_cpu)
+                    dispatch_cpu = cpu;
+            }
 
-            tr->SetCount(inc_req, inc_done);
+            AiderGroup* group = new AiderGroup(cpu_list, dispatch_cpu);
 
-            aider_threads_.push_back(tr);
+            /* a single cpu device runs all the sub tasks in the calling thread */
+            if(cpu_number > 1)
+                group->LaunchAider();
 
-            tr->LaunchWorker();
+            aider_groups_.push_back(group);
         }
     }
 
+    /* without a group of its own, the calling thread runs the sub tasks itself */
     void WaitDone(void)
     {
-        std::unique_lock<std::mutex> lock(wait_mutex_);
-
-        if(done_ != request_)
-            wait_cv_.wait(lock, [this] { return done_ == request_; });
-
-        lock.unlock();
-    }
-
-    void IncRequest(int req_number)
-    {
-        request_ += req_number;
+        if(cur_group_)
+            cur_group_->WaitDone();
     }
 
-    void IncDone(int done_number)
+    int GetWorkerNumber(void)
     {
-        uint64_t prev_val = done_.fetch_add(done_number);
+        if(cur_group_)
+            return cur_group_->GetWorkerNumber();
 
-        if(prev_val + done_number == request_)
-        {
-            std::unique_lock<std::mutex> lock(wait_mutex_);
-
-            wait_cv_.notify_all();
-
-            lock.unlock();
-        }
+        return 1;
     }
 
     bool PushAiderTask(std::vector<sub_op_task>& task_list, int cpu)
     {
-        auto tr = aider_threads_[0];
+        if(cur_group_)
+        {
+            cur_group_->PushTask(task_list);
+            return true;
+        }
 
-        tr->PushTask(task_list);
+        for(auto& task : task_list)
+            task.exec_func(cpu_info_.master_cpu, task.seq, task.data);
 
         return true;
     }
@@ -213,19 +222,61 @@ public:
 
     void KillAider(void)
     {
-        if(aider_threads_.size() > 0)
-        {
-            for(auto& tr : aider_threads_)
-                delete tr;
+        for(auto group : aider_groups_)
+            delete group;
 
-            aider_threads_.clear();
-        }
+        aider_groups_.clear();
+    }
+
+    int GetAiderGroupNumber(void)
+    {
+        std::lock_guard<std::mutex> lock(group_lock_);
+
+        return aider_groups_.empty() ? group_number_ : aider_groups_.size();
+    }
+
+    /* re-partition the aiders: waits until no graph is running on the device */
+    bool SetAiderGroupNumber(int group_number)
+    {
+        if(group_number <= 0)
+            return false;
+
+        std::unique_lock<std::mutex> lock(group_lock_);
+
+        group_cv_.wait(lock, [this] { return !reconfig_; });
+
+        reconfig_ = true;
+
+        group_cv_.wait(lock, [this] {
+            for(auto group : aider_groups_)
+            {
+                if(group->busy)
+                    return false;
+            }
+            return true;
+        });
+
+        bool launched = !aider_groups_.empty();
+
+        KillAider();
+
+        group_number_ = group_number;
+
+        if(launched)
+            LaunchAider();
+
+        reconfig_ = false;
+
+        lock.unlock();
+        group_cv_.notify_all();
+
+        return true;
     }
 
     bool RealPrerun(DevContext* context)
     {
         prerun_lock_.lock();
-        bool ret = backend_runner_.Prerun(context->optimized_graph);
+        bool ret = RunInAiderGroup([&] { return backend_runner_.Prerun(context->optimized_graph); });
         prerun_lock_.unlock();
 
         return ret;
@@ -234,7 +285,7 @@ public:
     bool RealPostrun(DevContext* context)
     {
         postrun_lock_.lock();
-        bool ret = backend_runner_.Postrun(context->optimized_graph);
+        bool ret = RunInAiderGroup([&] { return backend_runner_.Postrun(context->optimized_graph); });
         postrun_lock_.unlock();
 
         return ret;
@@ -242,27 +293,41 @@ public:
 
     bool RealRun(Subgraph* graph)
     {
-        ActivateWorker();
-        run_lock_.lock();
-        bool ret = backend_runner_.Run(graph);
-        run_lock_.unlock();
-        DeActivateWorker();
-
-        return ret;
+        return RunInAiderGroup([&] { return backend_runner_.Run(graph); });
     }
 
-    void ActivateWorker(void)
+    /* inter-op parallelism: a running graph borrows the free groups for its helper threads */
+    AiderGroup* TryAcquireAiderGroup(void)
     {
-       int master_cpu=cpu_info_.master_cpu;
+        std::lock_guard<std::mutex> lock(group_lock_);
+
+        if(reconfig_)
+            return nullptr;
 
-       for(auto t: aider_threads_)
-            t->Activate(master_cpu);
+        for(auto group : aider_groups_)
+        {
+            if(!group->busy)
+            {
+                group->busy = true;
+                return group;
+            }
+        }
+
+        return nullptr;
     }
 
-    void DeActivateWorker(void)
+    void EnterAiderGroup(AiderGroup* group)
     {
-       for(auto t: aider_threads_)
-            t->Deactivate();
+        cur_group_ = group;
+        group->Activate();
+    }
+
+    void LeaveAiderGroup(AiderGroup* group)
+    {
+        group->Deactivate();
+        cur_group_ = nullptr;
+
+        ReleaseAiderGroup(group);
     }
 
     bool RealOptimizeGraph(DevContext* context, Subgraph* graph)
@@ -275,28 +340,90 @@ public:
     dev_status_t dev_status;
 
 private:
+    /* func owns a free aider group while it runs, so the sub tasks it dispatches never land on a group
+       another graph is running on. Before the aiders are launched, func runs its sub tasks inline */
+    template <typename F> bool RunInAiderGroup(F func)
+    {
+        AiderGroup* group = AcquireAiderGroup();
+
+        if(group == nullptr)
+            return func();
+
+        AiderGroup* saved_group = cur_group_;
+
+        cur_group_ = group;
+
+        group->Activate();
+        bool ret = func();
+        group->Deactivate();
+
+        cur_group_ = saved_group;
+
+        ReleaseAiderGroup(group);
+
+        return ret;
+    }
+
+    AiderGroup* AcquireAiderGroup(void)
+    {
+        std::unique_lock<std::mutex> lock(group_lock_);
+        AiderGroup* free_group = nullptr;
+
+        group_cv_.wait(lock, [this, &free_group] {
+            if(reconfig_)
+                return false;
+
+            if(aider_groups_.empty())
+                return true;
+
+            for(auto group : aider_groups_)
+            {
+                if(!group->busy)
+                {
+                    free_group = group;
+                    return true;
+                }
+            }
+            return false;
+        });
+
+        if(free_group)
+            free_group->busy = true;
+
+        return free_group;
+    }
+
+    void ReleaseAiderGroup(AiderGroup* group)
+    {
+        std::unique_lock<std::mutex> lock(group_lock_);
+
+        group->busy = false;
+
+        lock.unlock();
+
+        group_cv_.notify_all();
+    }
+
     WorkerThread<cpu_task>* master_thread_;
-    std::vector<WorkerThread<sub_op_task>*> aider_threads_;
 
     std::mutex master_queue_lock_;
     std::condition_variable master_queue_cv_;
     std::queue<cpu_task> master_task_queue_;
 
-    std::mutex aider_queue_lock_;
-    std::condition_variable aider_queue_cv_;
-    std::queue<sub_op_task> aider_task_queue_;
-
     CPUInfo cpu_info_;
     CPURunner backend_runner_;
 
-    std::atomic<uint64_t> request_;
-    std::atomic<uint64_t> done_;
-    std::mutex wait_mutex_;
-    std::condition_variable wait_cv_;
+    std::vector<AiderGroup*> aider_groups_;
+    int group_number_;
+    bool reconfig_;
+    std::mutex group_lock_;
+    std::condition_variable group_cv_;
+
+    /* the aider group taken by the graph running in this thread */
+    static thread_local AiderGroup* cur_group_;
 
     std::mutex prerun_lock_;
     std::mutex postrun_lock_;
-    std::mutex run_lock_;
 };
 
 class CPUDriver : public Driver
@@ -419,6 +546,7 @@ protected:
     bool OnSetNodeDumpAttr(DevContext* context, Subgraph* graph, const char* name, const void*, int);
 
     bool OnSetGraphPerfAttr(DevContext* context, Subgraph* graph, const char* name, const void*, int);
+    bool OnSetGraphProfilerAttr(DevContext* context, Subgraph* graph, const char* name, const void*, int);
 
     std::unordered_map<std::string, CPUDevice*> device_table_;
     std::unordered_map<std::string, get_func_t> get_attr_table_;
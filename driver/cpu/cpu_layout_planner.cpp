@@ -0,0 +1,620 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "operator/convolution.hpp"
+#include "operator/concat.hpp"
+#include "operator/softmax.hpp"
+#include "operator/transpose.hpp"
+#include "operator/batch_norm.hpp"
+#include "cpu_layout_planner.hpp"
+
+namespace TEngine {
+
+#define ATTR_LAYOUT_EXEC_ATTR "layout_exec_attr"
+
+/*
+ * the costs are counted in touched elements: a transpose reads and writes each element once,
+ * while the reference kernel of a node is taken as a few times slower than an optimized one
+ */
+#define TRANSPOSE_COST 2
+#define REF_KERNEL_COST 4
+
+#define FLOW_INF (int64_t(1) << 60)
+
+namespace {
+
+/* Dinic max flow on the cut graph */
+class MaxFlow
+{
+public:
+    MaxFlow(int node_num) : head_(node_num, -1), level_(node_num), iter_(node_num) {}
+
+    void AddEdge(int from, int to, int64_t cap)
+    {
+        if(cap <= 0)
+            return;
+
+        edges_.push_back({to, head_[from], cap});
+        head_[from] = edges_.size() - 1;
+        edges_.push_back({from, head_[to], 0});
+        head_[to] = edges_.size() - 1;
+    }
+
+    void Run(int s, int t)
+    {
+        while(Bfs(s, t))
+        {
+            iter_ = head_;
+
+            while(Dfs(s, t, FLOW_INF) > 0)
+                ;
+        }
+    }
+
+    /* after Run(): the nodes on the source side of the minimum cut */
+    bool SourceSide(int node) const
+    {
+        return level_[node] >= 0;
+    }
+
+private:
+    struct Edge
+    {
+        int to;
+        int next;
+        int64_t cap;
+    };
+
+    bool Bfs(int s, int t)
+    {
+        std::fill(level_.begin(), level_.end(), -1);
+        std::queue<int> queue;
+
+        level_[s] = 0;
+        queue.push(s);
+
+        while(!queue.empty())
+        {
+            int v = queue.front();
+            queue.pop();
+
+            for(int e = head_[v]; e >= 0; e = edges_[e].next)
+            {
+                if(edges_[e].cap > 0 && level_[edges_[e].to] < 0)
+                {
+                    level_[edges_[e].to] = level_[v] + 1;
+                    queue.push(edges_[e].to);
+                }
+            }
+        }
+
+        return level_[t] >= 0;
+    }
+
+    int64_t Dfs(int v, int t, int64_t flow)
+    {
+        if(v == t)
+            return flow;
+
+        for(int& e = iter_[v]; e >= 0; e = edges_[e].next)
+        {
+            Edge& edge = edges_[e];
+
+            if(edge.cap <= 0 || level_[edge.to] != level_[v] + 1)
+                continue;
+
+            int64_t pushed = Dfs(edge.to, t, std::min(flow, edge.cap));
+
+            if(pushed > 0)
+            {
+                edge.cap -= pushed;
+                edges_[e ^ 1].cap += pushed;
+                return pushed;
+            }
+        }
+
+        return 0;
+    }
+
+    std::vector<Edge> edges_;
+    std::vector<int> head_;
+    std::vector<int> level_;
+    std::vector<int> iter_;
+};
+
+}    // namespace
+
+static int GetNodeLayout(Node* node, int graph_layout)
+{
+    if(node->ExistAttr(ATTR_NODE_LAYOUT))
+        return any_cast<int>(node->GetAttr(ATTR_NODE_LAYOUT));
+
+    return graph_layout;
+}
+
+/* the index of a 4D axis in the other layout */
+static int SwapAxis(int axis, int to_layout)
+{
+    static const int to_nhwc[4] = {0, 3, 1, 2};
+    static const int to_nchw[4] = {0, 2, 3, 1};
+
+    return to_layout == TENGINE_LAYOUT_NHWC ? to_nhwc[axis] : to_nchw[axis];
+}
+
+static int NormalizeAxis(int axis)
+{
+    return axis < 0 ? axis + 4 : axis;
+}
+
+static bool IsFP32_4D(const Tensor* tensor)
+{
+    return tensor->GetDataType() == TENGINE_DT_FP32 && tensor->GetShape().GetDim().size() == 4;
+}
+
+/*
+ * the NCHW weight is [group][out_c][in_c][kh][kw] and the NHWC one [out_c][kh][kw][group][in_c], with the channels
+ * counted per group: OIHW <-> OHWI without groups, and [c][kh][kw] <-> [kh][kw][c] for a depthwise one
+ */
+static void RelayoutConvWeight(Node* node, int to_layout)
+{
+    ConvParam* param = dynamic_cast<Convolution*>(node->GetOp())->GetParam();
+    Tensor* weight = node->GetInputTensor(1);
+    const float* data = ( const float* )get_tensor_mem(weight);
+
+    int group = param->group;
+    int kernel_size = param->kernel_h * param->kernel_w;
+    int output_c = param->output_channel / group;
+    int size = weight->GetShape().GetSize();
+    int input_c = size / (param->output_channel * kernel_size);
+    bool to_nhwc = to_layout == TENGINE_LAYOUT_NHWC;
+
+    float* new_data = ( float* )malloc(size * sizeof(float) + 128);
+
+    for(int g = 0; g < group; g++)
+        for(int c = 0; c < output_c; c++)
+            for(int ic = 0; ic < input_c; ic++)
+                for(int k = 0; k < kernel_size; k++)
+                {
+                    int nchw = ((g * output_c + c) * input_c + ic) * kernel_size + k;
+                    int nhwc = ((c * kernel_size + k) * group + g) * input_c + ic;
+
+                    if(to_nhwc)
+                        new_data[nhwc] = data[nchw];
+                    else
+                        new_data[nchw] = data[nhwc];
+                }
+
+    std::vector<int> dims;
+
+    if(to_nhwc)
+        dims = {param->output_channel, param->kernel_h, param->kernel_w, input_c};
+    else
+        dims = {param->output_channel, input_c, param->kernel_h, param->kernel_w};
+
+    weight->FreeTensor();
+    weight->SetMemAddr(new_data);
+    weight->SetAttr("free_mem", 1);
+
+    TShape shape;
+    shape.SetDim(dims);
+    shape.SetDataLayout(to_layout);
+
+    weight->Reshape(shape);
+}
+
+LayoutPlanner::LayoutPlanner(Subgraph* graph, const CPUInfo* cpu_info)
+{
+    graph_ = graph;
+    cpu_info_ = cpu_info;
+    exec_attr_ = any_cast<const ExecAttr*>(graph->GetAttr("exec_attr"));
+    graph_layout_ = exec_attr_->graph_layout;
+    other_layout_ = graph_layout_ == TENGINE_LAYOUT_NCHW ? TENGINE_LAYOUT_NHWC : TENGINE_LAYOUT_NCHW;
+
+    other_attr_ = *exec_attr_;
+    other_attr_.graph_layout = other_layout_;
+}
+
+const ExecAttr* LayoutPlanner::GetNodeExecAttr(Subgraph* graph, Node* node)
+{
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(graph->GetAttr("exec_attr"));
+
+    if(GetNodeLayout(node, exec_attr->graph_layout) == exec_attr->graph_layout)
+        return exec_attr;
+
+    return any_cast<ExecAttr>(&graph->GetAttr(ATTR_LAYOUT_EXEC_ATTR));
+}
+
+/* the ops whose layout is only a flag of their kernels, with 4D fp32 tensors */
+bool LayoutPlanner::Movable(Node* node)
+{
+    Operator* op = node->GetOp();
+    const std::string& name = op->GetName();
+
+    if(name != "Convolution" && name != "Pooling" && name != "Eltwise" && name != "ReLu" && name != "ReLu6" &&
+       name != BatchNormName && name != "Concat" && name != "Softmax")
+        return false;
+
+    if(node->IsDynamicShape() || graph_->IsOutputNode(node) || graph_->IsInputNode(node))
+        return false;
+
+    for(unsigned int i = 0; i < node->GetInputNum(); i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+
+        if(tensor->GetType() == kVarTensor)
+        {
+            if(!IsFP32_4D(tensor) || tensor->producer == nullptr || !graph_->NodeInGraph(tensor->producer->owner))
+                return false;
+
+            continue;
+        }
+
+        /* the weight of a convolution is rewritten, the other const inputs must be per channel at most */
+        if(name == "Convolution" && i == 1)
+        {
+            if(tensor->consumer.size() != 1 || tensor->GetDataType() != TENGINE_DT_FP32)
+                return false;
+
+            continue;
+        }
+
+        if(tensor->GetShape().GetDim().size() > 1)
+            return false;
+    }
+
+    for(unsigned int i = 0; i < node->GetOutputNum(); i++)
+    {
+        if(!IsFP32_4D(node->GetOutputTensor(i)))
+            return false;
+    }
+
+    if(name == "Concat" || name == "Softmax")
+    {
+        int axis = name == "Concat" ? dynamic_cast<Concat*>(op)->GetParam()->axis :
+                                      dynamic_cast<Softmax*>(op)->GetParam()->axis;
+
+        axis = NormalizeAxis(axis);
+
+        if(axis < 0 || axis > 3)
+            return false;
+    }
+
+    return true;
+}
+
+bool LayoutPlanner::HasOptimizedOps(Node* node, const ExecAttr* exec_attr)
+{
+    node->SetAttr(ATTR_EXEC_ATTR, exec_attr);
+
+    NodeOps* ops = NodeOpsRegistryManager::RealFindNodeOps(cpu_info_, node, false);
+
+    node->RemoveAttr(ATTR_EXEC_ATTR);
+
+    if(ops == nullptr)
+        return false;
+
+    ops->Release();
+
+    return true;
+}
+
+void LayoutPlanner::GetNodeCost(Node* node, int64_t& graph_cost, int64_t& other_cost)
+{
+    graph_cost = 0;
+    other_cost = 0;
+
+    bool graph_opt = HasOptimizedOps(node, exec_attr_);
+    bool other_opt = HasOptimizedOps(node, &other_attr_);
+
+    if(graph_opt == other_opt)
+        return;
+
+    std::vector<TShape> inputs;
+    std::vector<TShape> outputs;
+
+    for(unsigned int i = 0; i < node->GetInputNum(); i++)
+        inputs.push_back(node->GetInputTensor(i)->GetShape());
+
+    for(unsigned int i = 0; i < node->GetOutputNum(); i++)
+        outputs.push_back(node->GetOutputTensor(i)->GetShape());
+
+    int64_t work = std::max(( int64_t )node->GetOp()->GetFops(inputs, outputs), ( int64_t )outputs[0].GetSize());
+    int64_t penalty = work * REF_KERNEL_COST;
+
+    if(graph_opt)
+        other_cost = penalty;
+    else
+        graph_cost = penalty;
+}
+
+/*
+ * source side: the graph layout. A node pays graph_cost through node -> sink and other_cost through
+ * source -> node. Each tensor has two helper vertexes, so that its transpose is paid once whatever
+ * the number of consumers on the other side:
+ *   producer -> a (size), a -> consumer (inf): cut when the producer is in the graph layout only
+ *   consumer -> b (inf), b -> producer (size): cut when the producer is in the other layout only
+ */
+bool LayoutPlanner::Solve(void)
+{
+    std::unordered_map<Node*, int> node_index;
+
+    for(unsigned int i = 0; i < nodes_.size(); i++)
+        node_index[nodes_[i]] = i;
+
+    std::vector<Tensor*> tensors;
+
+    for(unsigned int i = 0; i < nodes_.size(); i++)
+    {
+        for(unsigned int j = 0; j < nodes_[i]->GetOutputNum(); j++)
+        {
+            Tensor* tensor = nodes_[i]->GetOutputTensor(j);
+
+            if(tensor->GetType() == kVarTensor && tensor->consumer.size() > 0)
+                tensors.push_back(tensor);
+        }
+    }
+
+    int node_num = nodes_.size();
+    int source = node_num + 2 * tensors.size();
+    int sink = source + 1;
+
+    MaxFlow flow(sink + 1);
+
+    for(int i = 0; i < node_num; i++)
+    {
+        if(!movable_[i])
+        {
+            flow.AddEdge(source, i, FLOW_INF);
+            continue;
+        }
+
+        flow.AddEdge(source, i, other_cost_[i]);
+        flow.AddEdge(i, sink, graph_cost_[i]);
+    }
+
+    for(unsigned int t = 0; t < tensors.size(); t++)
+    {
+        Tensor* tensor = tensors[t];
+        int producer = node_index[tensor->producer->owner];
+        int a = node_num + 2 * t;
+        int b = a + 1;
+        int64_t cost = ( int64_t )tensor->GetShape().GetSize() * TRANSPOSE_COST;
+
+        flow.AddEdge(producer, a, cost);
+        flow.AddEdge(b, producer, cost);
+
+        for(unsigned int k = 0; k < tensor->consumer.size(); k++)
+        {
+            auto ir = node_index.find(tensor->consumer[k]->owner);
+
+            if(ir == node_index.end())
+                continue;
+
+            flow.AddEdge(a, ir->second, FLOW_INF);
+            flow.AddEdge(ir->second, b, FLOW_INF);
+        }
+    }
+
+    flow.Run(source, sink);
+
+    bool moved = false;
+
+    layout_.resize(node_num);
+
+    for(int i = 0; i < node_num; i++)
+    {
+        layout_[i] = flow.SourceSide(i) ? graph_layout_ : other_layout_;
+
+        if(layout_[i] != graph_layout_)
+            moved = true;
+    }
+
+    return moved;
+}
+
+void LayoutPlanner::MoveNode(Node* node)
+{
+    Operator* op = node->GetOp();
+    const std::string& name = op->GetName();
+
+    node->SetAttr(ATTR_NODE_LAYOUT, other_layout_);
+
+    if(name == "Convolution")
+    {
+        RelayoutConvWeight(node, other_layout_);
+    }
+    else if(name == "Concat")
+    {
+        ConcatParam* param = dynamic_cast<Concat*>(op)->GetParam();
+        param->axis = SwapAxis(NormalizeAxis(param->axis), other_layout_);
+    }
+    else if(name == "Softmax")
+    {
+        SoftmaxParam* param = dynamic_cast<Softmax*>(op)->GetParam();
+        param->axis = SwapAxis(NormalizeAxis(param->axis), other_layout_);
+    }
+}
+
+/* one Transpose into layout, read by all the ports */
+void LayoutPlanner::InsertTranspose(Tensor* tensor, const std::vector<NodePort*>& ports, int layout)
+{
+    std::string suffix = layout == TENGINE_LAYOUT_NCHW ? ".nchw" : ".nhwc";
+
+    Node* node = new Node(tensor->GetName() + suffix);
+    Operator* op = OpManager::CreateOp("Transpose");
+    TransposeParam* param = dynamic_cast<Transpose*>(op)->GetParam();
+
+    if(layout == TENGINE_LAYOUT_NCHW)
+        param->tr_shape = {0, 3, 1, 2};
+    else
+        param->tr_shape = {0, 2, 3, 1};
+
+    node->SetOp(op);
+    node->SetDynamicShape(tensor->producer->owner->IsDynamicShape());
+
+    if(layout != graph_layout_)
+        node->SetAttr(ATTR_NODE_LAYOUT, layout);
+
+    Tensor* new_tensor = new Tensor(tensor->GetName() + suffix);
+
+    new_tensor->SetDataType(tensor->GetDataType());
+    new_tensor->SetType(kVarTensor);
+
+    node->AddInputTensor(tensor);
+    tensor->AddConsumer(node->GetInputPort(0));
+
+    node->AddOutputTensor(new_tensor);
+    new_tensor->producer = node->GetOutputPort(0);
+
+    for(unsigned int i = 0; i < ports.size(); i++)
+    {
+        Node* consumer = ports[i]->owner;
+        int port_index = ports[i]->port_index;
+
+        tensor->RemoveConsumer(ports[i]);
+        consumer->SetInputPort(port_index, new_tensor);
+        new_tensor->AddConsumer(consumer->GetInputPort(port_index));
+    }
+
+    graph_->AddNode(node);
+    graph_->AddTensor(new_tensor);
+}
+
+bool LayoutPlanner::InferShape(void)
+{
+    for(unsigned int i = 0; i < graph_->seq_nodes.size(); i++)
+    {
+        Node* node = graph_->seq_nodes[i];
+        Operator* op = node->GetOp();
+
+        if(op->GetName() == "Const" || op->GetName() == "Input")
+            continue;
+
+        std::vector<TShape> inputs;
+        std::vector<TShape> outputs(node->GetOutputNum());
+
+        for(unsigned int j = 0; j < node->GetInputNum(); j++)
+            inputs.push_back(node->GetInputTensor(j)->GetShape());
+
+        if(!op->InferShape(inputs, outputs, GetNodeLayout(node, graph_layout_)))
+        {
+            LOG_ERROR() << "layout planner: infer shape failed on node: " << node->GetName() << "\n";
+            return false;
+        }
+
+        for(unsigned int j = 0; j < node->GetOutputNum(); j++)
+        {
+            if(outputs[j].GetSize())
+                node->GetOutputTensor(j)->Reshape(outputs[j]);
+        }
+    }
+
+    return true;
+}
+
+bool LayoutPlanner::Plan(void)
+{
+    /* a registry forced by OPS_REGISTRY, or a graph planned already */
+    if(std::getenv("OPS_REGISTRY") || graph_->ExistAttr(ATTR_LAYOUT_EXEC_ATTR))
+        return false;
+
+    bool gain = false;
+
+    for(unsigned int i = 0; i < graph_->seq_nodes.size(); i++)
+    {
+        Node* node = graph_->seq_nodes[i];
+        const std::string& name = node->GetOp()->GetName();
+
+        if(name == "Const" || name == "Input")
+            continue;
+
+        int64_t graph_cost = 0;
+        int64_t other_cost = 0;
+        bool movable = Movable(node);
+
+        if(movable)
+            GetNodeCost(node, graph_cost, other_cost);
+
+        nodes_.push_back(node);
+        movable_.push_back(movable);
+        graph_cost_.push_back(graph_cost);
+        other_cost_.push_back(other_cost);
+
+        if(graph_cost > 0)
+            gain = true;
+    }
+
+    /* no node runs better in the other layout */
+    if(!gain || !Solve())
+        return false;
+
+    graph_->SetAttr(ATTR_LAYOUT_EXEC_ATTR, other_attr_);
+
+    for(unsigned int i = 0; i < nodes_.size(); i++)
+    {
+        if(layout_[i] != graph_layout_)
+            MoveNode(nodes_[i]);
+    }
+
+    int transpose_num = 0;
+
+    for(unsigned int i = 0; i < nodes_.size(); i++)
+    {
+        for(unsigned int j = 0; j < nodes_[i]->GetOutputNum(); j++)
+        {
+            Tensor* tensor = nodes_[i]->GetOutputTensor(j);
+            std::vector<NodePort*> ports;
+
+            for(unsigned int k = 0; k < tensor->consumer.size(); k++)
+            {
+                Node* consumer = tensor->consumer[k]->owner;
+
+                if(GetNodeLayout(consumer, graph_layout_) != layout_[i])
+                    ports.push_back(tensor->consumer[k]);
+            }
+
+            if(ports.empty())
+                continue;
+
+            InsertTranspose(tensor, ports, layout_[i] == graph_layout_ ? other_layout_ : graph_layout_);
+            transpose_num++;
+        }
+    }
+
+    graph_->SanitizeGraph();
+
+    LOG_DEBUG() << "layout planner: " << std::count(layout_.begin(), layout_.end(), other_layout_)
+                << " nodes moved, " << transpose_num << " transposes\n";
+
+    return InferShape();
+}
+
+}    // namespace TEngine
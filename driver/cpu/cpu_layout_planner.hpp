@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __CPU_LAYOUT_PLANNER_HPP__
+#define __CPU_LAYOUT_PLANNER_HPP__
+
+#include <vector>
+
+#include "graph.hpp"
+#include "exec_attr.hpp"
+#include "cpu_info.hpp"
+
+namespace TEngine {
+
+/*
+ * Layout planner for one subgraph.
+ *
+ * Every node runs either in the graph layout or in the other one of NCHW/NHWC. A node costs
+ * nothing in a layout it has an optimized kernel for, and the extra work of the reference
+ * kernel otherwise. A tensor whose consumers run in the other layout than its producer costs
+ * one Transpose, shared by all those consumers. The labelling of the minimum total cost is a
+ * minimum s-t cut, found exactly by a max flow, so that the regions get one layout each and the
+ * fewest transposes which pay off.
+ *
+ * Plan() moves the nodes (the weights of a convolution and the axis of a concat/softmax are
+ * rewritten), inserts the Transpose nodes and infers the shapes again.
+ */
+
+class LayoutPlanner
+{
+public:
+    LayoutPlanner(Subgraph* graph, const CPUInfo* cpu_info);
+
+    /* false when the graph keeps its layout everywhere */
+    bool Plan(void);
+
+    /* the exec attr a node runs with: the graph one, or a copy in the layout the node was moved to */
+    static const ExecAttr* GetNodeExecAttr(Subgraph* graph, Node* node);
+
+private:
+    bool Movable(Node* node);
+    bool HasOptimizedOps(Node* node, const ExecAttr* exec_attr);
+    void GetNodeCost(Node* node, int64_t& graph_cost, int64_t& other_cost);
+    bool Solve(void);
+    void MoveNode(Node* node);
+    void InsertTranspose(Tensor* tensor, const std::vector<NodePort*>& ports, int layout);
+    bool InferShape(void);
+
+    Subgraph* graph_;
+    const CPUInfo* cpu_info_;
+    const ExecAttr* exec_attr_;
+    ExecAttr other_attr_;
+    int graph_layout_;
+    int other_layout_;
+
+    std::vector<Node*> nodes_;
+    std::vector<bool> movable_;
+    std::vector<int64_t> graph_cost_;
+    std::vector<int64_t> other_cost_;
+    std::vector<int> layout_;
+};
+
+}    // namespace TEngine
+
+#endif
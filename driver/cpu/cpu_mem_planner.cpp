@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <algorithm>
+
+#include "cpu_mem_planner.hpp"
+
+namespace TEngine {
+
+int MemPlanner::AddBuffer(int size, int first_use, int last_use)
+{
+    Buffer buf;
+
+    buf.size = AlignSize(size);
+    buf.first_use = first_use;
+    buf.last_use = last_use;
+    buf.offset = -1;
+
+    buffers_.push_back(buf);
+
+    return buffers_.size() - 1;
+}
+
+void MemPlanner::ExtendBuffer(int buf_id, int size, int last_use)
+{
+    Buffer& buf = buffers_[buf_id];
+
+    size = AlignSize(size);
+
+    if(size > buf.size)
+        buf.size = size;
+
+    if(last_use > buf.last_use)
+        buf.last_use = last_use;
+}
+
+int MemPlanner::GetNaiveSize(void) const
+{
+    int total = 0;
+
+    for(unsigned int i = 0; i < buffers_.size(); i++)
+        total += buffers_[i].size;
+
+    return total;
+}
+
+void MemPlanner::Plan(void)
+{
+    int buf_number = buffers_.size();
+    std::vector<int> order(buf_number);
+
+    for(int i = 0; i < buf_number; i++)
+        order[i] = i;
+
+    /* the biggest buffers go first, earlier ones win on tie */
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        if(buffers_[a].size != buffers_[b].size)
+            return buffers_[a].size > buffers_[b].size;
+        return buffers_[a].first_use < buffers_[b].first_use;
+    });
+
+    /* placed buffers, kept sorted by offset */
+    std::vector<int> placed;
+
+    arena_size_ = 0;
+
+    for(int i = 0; i < buf_number; i++)
+    {
+        Buffer& buf = buffers_[order[i]];
+
+        int best_offset = -1;
+        int best_gap = 0;
+        int cur_offset = 0;
+
+        for(unsigned int j = 0; j < placed.size(); j++)
+        {
+            const Buffer& other = buffers_[placed[j]];
+
+            if(other.last_use < buf.first_use || other.first_use > buf.last_use)
+                continue;
+
+            int gap = other.offset - cur_offset;
+
+            if(gap >= buf.size && (best_offset < 0 || gap < best_gap))
+            {
+                best_offset = cur_offset;
+                best_gap = gap;
+            }
+
+            if(other.offset + other.size > cur_offset)
+                cur_offset = other.offset + other.size;
+        }
+
+        if(best_offset < 0)
+            best_offset = cur_offset;
+
+        buf.offset = best_offset;
+
+        if(buf.offset + buf.size > arena_size_)
+            arena_size_ = buf.offset + buf.size;
+
+        auto ir = placed.begin();
+
+        while(ir != placed.end() && buffers_[*ir].offset <= buf.offset)
+            ir++;
+
+        placed.insert(ir, order[i]);
+    }
+}
+
+}    // namespace TEngine
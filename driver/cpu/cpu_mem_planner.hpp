@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __CPU_MEM_PLANNER_HPP__
+#define __CPU_MEM_PLANNER_HPP__
+
+#include <vector>
+
+namespace TEngine {
+
+/*
+ * Offline memory planner for one subgraph.
+ *
+ * Every buffer is described by its size and the range of seq_nodes indexes [first_use, last_use]
+ * it must stay alive. Plan() assigns each buffer an offset inside one arena, so that
+ * buffers with overlapping lifetimes never overlap in memory (greedy by size, best-fit gap).
+ */
+
+class MemPlanner
+{
+public:
+    struct Buffer
+    {
+        int size;
+        int first_use;
+        int last_use;
+        int offset;
+    };
+
+    MemPlanner(int align_size)
+    {
+        align_size_ = align_size;
+        arena_size_ = 0;
+    }
+
+    int AddBuffer(int size, int first_use, int last_use);
+
+    /* used by in-place aliasing: one more tensor lives in the buffer */
+    void ExtendBuffer(int buf_id, int size, int last_use);
+
+    void Plan(void);
+
+    int GetOffset(int buf_id) const
+    {
+        return buffers_[buf_id].offset;
+    }
+
+    int GetBufferNumber(void) const
+    {
+        return buffers_.size();
+    }
+
+    /* peak footprint of the planned arena */
+    int GetArenaSize(void) const
+    {
+        return arena_size_;
+    }
+
+    /* footprint when every buffer gets its own memory */
+    int GetNaiveSize(void) const;
+
+private:
+    int AlignSize(int size) const
+    {
+        return (size + align_size_ - 1) / align_size_ * align_size_;
+    }
+
+    std::vector<Buffer> buffers_;
+    int align_size_;
+    int arena_size_;
+};
+
+}    // namespace TEngine
+
+#endif
@@ -22,6 +22,11 @@
  * Author: haitao@openailab.com
  */
 #include <algorithm>
+#include <typeinfo>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <math.h>
 #include "graph.hpp"
 #include "custom_kernel.hpp"
@@ -29,26 +34,36 @@
 #include "tensor_mem.hpp"
 #include "prof_utils.hpp"
 #include "prof_record.hpp"
+#include "graph_profiler.hpp"
 #include "graph_optimizer.hpp"
+#include "fused_epilogue.hpp"
 #include "cpu_driver.hpp"
+#include "cpu_mem_planner.hpp"
+#include "cpu_layout_planner.hpp"
 #include "operator/convolution.hpp"
 #include "operator/pooling.hpp"
+#include "operator/concat.hpp"
+#include "operator/split.hpp"
+#include "operator/slice.hpp"
 #include "tengine_errno.hpp"
 
 namespace TEngine {
 
 #define ENABLE_TIME_PROFILING
 #define ATTR_GRAPH_PERF_BUFFER "GraphPerfStatBuf"
+#define ATTR_EXEC_PLAN "ExecPlan"
 
 #define MEM_ALIGN_SIZE 64
 #define MEM_ALIGN_MASK (~(MEM_ALIGN_SIZE-1))
 
+/* a node may start while the nodes up to INTER_OP_LEVEL_WINDOW-1 levels above it are still running */
+#define INTER_OP_LEVEL_WINDOW 2
+
 void DumpFloat(const char* fname, float* data, int number);
 
 static std::unordered_map<std::string, CPUInfo> predefined_list;
 
 using tensor_map_t = std::unordered_map<Tensor*, int>;
-using tensor_addr_t = std::unordered_map<void*, int>;
 
 struct GraphPerfStatBuf
 {
@@ -76,163 +91,267 @@ struct GraphPerfStatBuf
     }
 };
 
-struct MemPool
+/*
+ * The execution plan is compiled at Prerun: one entry per node with NodeOps, in seq_nodes order.
+ * NodeOps, tensors and flags are resolved there, so that the steady-state Run() only walks the entries.
+ *
+ * io_mem is the flat table of resolved tensor memory: each entry owns the slice
+ * [io_offset, io_offset + io_number), inputs first and then outputs,
+ * and its NodeOps::io_mem points to that slice
+ */
+
+/*
+ * Inter-op parallelism (INTER_OP_PARALLEL=1): the level of a node is its depth in the subgraph,
+ * and the entries are ordered by level instead of seq_nodes order. Each entry counts its producers,
+ * so that an entry is ready once all of them are done, and ready entries are taken by the threads
+ * which own the free aider groups of the device, see RunPlanDataflow().
+ *
+ * A ready entry is still held back until all the entries INTER_OP_LEVEL_WINDOW levels above it
+ * are done. AllocateMem() plans the arena on the same levels and keeps every buffer alive for
+ * the window, so that two nodes which may run at the same time never share memory.
+ */
+
+struct ExecPlanEntry
 {
-    struct MemBlock
-    {
-        void* addr;
-        void * real_addr;
-        int size;
-        int ref_count;
-        int alloc_count;
-    };
+    Node* node;
+    NodeOps* node_ops;
+    Tensor* first_input;
+    int seq_idx;
+    int io_offset;
+    int io_number;
+    bool dynamic_shape;
 
-    MemPool(const std::vector<int>& mem_block, mem_alloc_t alloc_func, mem_free_t free_func)
-    {
-        mem_alloc = alloc_func;
-        mem_free = free_func;
+    int level;
+    int wait_number;             // producers inside the plan
+    std::vector<int> next;       // consumers inside the plan
 
-        int block_number = mem_block.size();
+    bool run_epilogue;    // the fused epilogue is left to the runner by node_ops
 
-        bool max_block_policy = false;
+    bool Run(void)
+    {
+        if(!node_ops->Run(node))
+            return false;
 
-        const char* block_policy = std::getenv("MAX_BLOCK_POLICY");
+        return !run_epilogue || ApplyFusedEpilogue(node, node_ops);
+    }
+};
 
-        if(block_policy && block_policy[0] == '1')
-            max_block_policy = true;
+struct ExecPlan
+{
+    std::vector<ExecPlanEntry> entries;
+    std::vector<Tensor*> io_tensors;
+    std::vector<void*> io_mem;
 
-        if(max_block_policy)
-        {
-            int block_size = mem_block[block_number - 1];
+    /* hooks selected at Prerun */
+    ProfRecord* prof;
+    bool do_calibration;
 
-            for(int i = 0; i < block_number; i++)
-            {
-                MemBlock b;
-                b.real_addr = mem_alloc(block_size + 128+MEM_ALIGN_SIZE);
-                b.addr=(void*)(((long)b.real_addr+MEM_ALIGN_SIZE-1)&MEM_ALIGN_MASK);
-                b.size = block_size;
-                b.ref_count = 0;
-                b.alloc_count = 0;
-
-                block_list.push_back(b);
-            }
-        }
-        else
-        {
-            // fill block number of least one, to ensure the bigger ones won't be occupied
-            for(int i = 0; i < block_number; i++)
-            {
-                MemBlock b;
-                b.real_addr = mem_alloc(mem_block[0] + 128+MEM_ALIGN_SIZE);
-                b.addr=(void*)(((long)b.real_addr+MEM_ALIGN_SIZE-1)&MEM_ALIGN_MASK);
-                b.size = mem_block[0];
-                b.ref_count = 0;
-                b.alloc_count = 0;
-
-                block_list.push_back(b);
-            }
+    /* set by start_graph_profiling() */
+    GraphProfiler* profiler;
 
-            for(int i = 1; i < block_number; i++)
-            {
-                MemBlock b;
-                b.real_addr = mem_alloc(mem_block[i] + 128+MEM_ALIGN_SIZE);
-                b.addr=(void*)(((long)b.real_addr+MEM_ALIGN_SIZE-1)&MEM_ALIGN_MASK);
-                b.size = mem_block[i];
-                b.ref_count = 0;
+    /* inter-op schedule, level_window is 0 in sequential mode */
+    int level_window;
+    int level_number;
+    int max_width;
+    bool has_dynamic_shape;
 
-                block_list.push_back(b);
-            }
-        }
+    ExecPlan()
+    {
+        prof = nullptr;
+        do_calibration = false;
+        profiler = nullptr;
+        level_window = 0;
+        level_number = 0;
+        max_width = 1;
+        has_dynamic_shape = false;
     }
 
-    ~MemPool()
+    void RefreshIOMem(const ExecPlanEntry& entry)
     {
-        for(unsigned int i = 0; i < block_list.size(); i++)
-        {
-            void* addr = block_list[i].real_addr;
-            mem_free(addr);
+        void** mem = io_mem.data() + entry.io_offset;
+        Tensor** tensors = io_tensors.data() + entry.io_offset;
 
-            // printf("block [%d %p %d] allocated[%d]\n",
-            //		i,addr,block_list[i].size,block_list[i].alloc_count);
-        }
+        for(int i = 0; i < entry.io_number; i++)
+            mem[i] = get_tensor_mem(tensors[i]);
     }
 
-    void* Allocate(Tensor* tensor, int size)
+    bool NeedReshape(const ExecPlanEntry& entry)
     {
-        int block_num = block_list.size();
+        return entry.dynamic_shape || (entry.first_input && entry.first_input->Reshaped());
+    }
+};
 
-        MemBlock* p_block = nullptr;
-        int i;
+bool debug_graph = false;
 
-        for(i = 0; i < block_num; i++)
-        {
-            if(block_list[i].ref_count == 0 && block_list[i].size >= size)
-            {
-                p_block = &block_list[i];
-                break;
-            }
-        }
+#ifdef ENABLE_TIME_PROFILING
+static void parse_node(void* data, int repeat_count, uint64_t total_time);
+#endif
+
+static int GetInterOpWindow(void)
+{
+    const char* env = std::getenv("INTER_OP_PARALLEL");
 
-        if(p_block == nullptr)
+    if(env && env[0] == '1')
+        return INTER_OP_LEVEL_WINDOW;
+
+    return 0;
+}
+
+/* level of each node in seq_nodes: 0 for the nodes without producers in the subgraph */
+static void GetNodeLevels(Subgraph* sub_graph, std::vector<int>& levels)
+{
+    std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
+    std::unordered_map<Node*, int> level_map;
+
+    levels.resize(seq_nodes.size());
+
+    for(unsigned int i = 0; i < seq_nodes.size(); i++)
+    {
+        Node* node = seq_nodes[i];
+        int level = 0;
+
+        for(unsigned int j = 0; j < node->GetInputNum(); j++)
         {
-            XLOG_ERROR() << "cannot allocate memory for tensor: " << tensor->GetName() << "\n";
-            return nullptr;
-        }
+            NodePort* producer = node->GetInputTensor(j)->producer;
 
-        int ref_count = tensor->consumer.size() ? tensor->consumer.size() : 1;
-        p_block->ref_count = ref_count;
-        p_block->alloc_count++;
+            if(producer == nullptr)
+                continue;
+
+            auto ir = level_map.find(producer->owner);
 
-        // record this
-        addr_map[p_block->addr] = i;
+            if(ir != level_map.end() && ir->second + 1 > level)
+                level = ir->second + 1;
+        }
 
-        return p_block->addr;
+        level_map[node] = level;
+        levels[i] = level;
     }
+}
 
-    void AddRef(Tensor* tensor)
-    {
-        void* addr = get_tensor_mem(tensor);
+static ExecPlan* CompileExecPlan(Subgraph* sub_graph)
+{
+    std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
+    int node_number = seq_nodes.size();
+
+    ExecPlan* plan = new ExecPlan();
+    std::vector<int> levels;
 
-        if(addr_map.count(addr) == 0)
-            return;
+    plan->level_window = GetInterOpWindow();
 
-        auto ir = addr_map.find(addr);
+    GetNodeLevels(sub_graph, levels);
 
-        MemBlock* p_block = &block_list[ir->second];
+    std::vector<int> order;
 
-        p_block->ref_count += tensor->consumer.size() ? tensor->consumer.size() : 1;
+    for(int i = 0; i < node_number; i++)
+    {
+        if(seq_nodes[i]->ExistAttr(ATTR_NODE_OPS))
+            order.push_back(i);
     }
 
-    void Free(Tensor* tensor)
+    /* the level order is a valid topological order, which the memory plan of inter-op mode relies on */
+    if(plan->level_window)
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return levels[a] < levels[b]; });
+
+    std::unordered_map<Node*, int> entry_map;
+
+    for(unsigned int k = 0; k < order.size(); k++)
     {
-        void* addr = get_tensor_mem(tensor);
+        int i = order[k];
+        Node* node = seq_nodes[i];
 
-        if(addr_map.count(addr) == 0)
-            return;
+        ExecPlanEntry entry;
 
-        auto ir = addr_map.find(addr);
+        entry.node = node;
+        entry.node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+        entry.first_input = node->GetInputNum() ? node->GetInputTensor(0) : nullptr;
+        entry.seq_idx = i;
+        entry.io_offset = plan->io_tensors.size();
+        entry.io_number = node->GetInputNum() + node->GetOutputNum();
+        entry.dynamic_shape = node->IsDynamicShape();
+        entry.level = levels[i];
+        entry.wait_number = 0;
+        entry.run_epilogue = node->ExistAttr(ATTR_FUSED_EPILOGUE) && !entry.node_ops->fused_epilogue;
 
-        int idx = ir->second;
+        for(unsigned int j = 0; j < node->GetInputNum(); j++)
+            plan->io_tensors.push_back(node->GetInputTensor(j));
 
-        MemBlock* p_block = &block_list[idx];
+        for(unsigned int j = 0; j < node->GetOutputNum(); j++)
+            plan->io_tensors.push_back(node->GetOutputTensor(j));
 
-        p_block->ref_count--;
+        /* dependency counters: one per distinct producer entry */
+        std::set<int> producers;
 
-        if(p_block->ref_count == 0)
+        for(unsigned int j = 0; j < node->GetInputNum(); j++)
         {
-            addr_map.erase(ir);
+            NodePort* producer = node->GetInputTensor(j)->producer;
+
+            if(producer == nullptr)
+                continue;
+
+            auto ir = entry_map.find(producer->owner);
+
+            if(ir != entry_map.end())
+                producers.insert(ir->second);
         }
+
+        entry_map[node] = plan->entries.size();
+
+        for(auto idx : producers)
+            plan->entries[idx].next.push_back(plan->entries.size());
+
+        entry.wait_number = producers.size();
+
+        if(entry.dynamic_shape)
+            plan->has_dynamic_shape = true;
+
+        if(entry.level + 1 > plan->level_number)
+            plan->level_number = entry.level + 1;
+
+        plan->entries.push_back(entry);
     }
 
-    mem_alloc_t mem_alloc;
-    mem_free_t mem_free;
+    std::vector<int> level_width(plan->level_number, 0);
 
-    std::vector<MemBlock> block_list;
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        int width = ++level_width[plan->entries[i].level];
 
-    tensor_addr_t addr_map;
-};
+        if(width > plan->max_width)
+            plan->max_width = width;
+    }
 
-bool debug_graph = false;
+    plan->io_mem.resize(plan->io_tensors.size(), nullptr);
+
+    /* io_mem will not grow anymore, so that it is safe to bind the slices now */
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        ExecPlanEntry& entry = plan->entries[i];
+
+        entry.node_ops->BindIOMem(plan->io_mem.data() + entry.io_offset, entry.node->GetInputNum());
+
+        plan->RefreshIOMem(entry);
+    }
+
+#ifdef ENABLE_TIME_PROFILING
+    const char* prof_env = std::getenv("PROF_TIME");
+
+    if(prof_env && prof_env[0] == '1')
+    {
+        if(sub_graph->ExistAttr("PROF_TIME"))
+            plan->prof = any_cast<ProfRecord*>(sub_graph->GetAttr("PROF_TIME"));
+        else
+        {
+            plan->prof = new ProfTime(node_number, parse_node);
+            sub_graph->SetAttr("PROF_TIME", plan->prof);
+        }
+    }
+#endif
+
+    if(std::getenv("ENABLE_CALIBRATION"))
+        plan->do_calibration = true;
+
+    return plan;
+}
 
 bool CPURunner::Prerun(Subgraph* sub_graph)
 {
@@ -242,16 +361,21 @@ bool CPURunner::Prerun(Subgraph* sub_graph)
     if(!AllocateMem(sub_graph))
         return false;
 
-    for(unsigned int i = 0; i < sub_graph->seq_nodes.size(); i++)
-    {
-        Node* node = sub_graph->seq_nodes[i];
+    ExecPlan* plan = CompileExecPlan(sub_graph);
 
-        if(!node->ExistAttr(ATTR_NODE_OPS))
-            continue;
+    if(sub_graph->ExistAttr(ATTR_SUBGRAPH_PROFILER))
+        plan->profiler = any_cast<GraphProfiler*>(sub_graph->GetAttr(ATTR_SUBGRAPH_PROFILER));
 
-        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+    sub_graph->SetAttr(ATTR_EXEC_PLAN, plan);
 
-        if(!node_ops->Prerun(node))
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        ExecPlanEntry& entry = plan->entries[i];
+        Node* node = entry.node;
+
+        plan->RefreshIOMem(entry);
+
+        if(!entry.node_ops->Prerun(node))
         {
             XLOG_ERROR() << "Prerun for node: " << node->GetName() << " op: " << node->GetOp()->GetName() << " failed\n";
             return false;
@@ -339,195 +463,357 @@ static void parse_node(void* data, int repeat_count, uint64_t total_time)
 
 #endif
 
-bool CPURunner::Run(Subgraph* sub_graph)
+bool CPURunner::ReshapeNode(ExecPlan* plan, ExecPlanEntry& entry)
 {
-    std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
+    Node* node = entry.node;
+    NodeOps* node_ops = entry.node_ops;
+    int output_number = node->GetOutputNum();
 
-#ifdef ENABLE_TIME_PROFILING
-    ProfRecord* prof = nullptr;
+    /* do infer shape */
+    Operator* op = node->GetOp();
 
-    bool do_prof = false;
+    std::vector<TShape> inputs;
 
-    const char* prof_env = std::getenv("PROF_TIME");
+    for(unsigned int i = 0; i < node->GetInputNum(); i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+        inputs.push_back(tensor->GetShape());
 
-    if(prof_env && prof_env[0] == '1')
+        if(tensor->Reshaped())
+            tensor->UpdateReshapeCount();
+    }
+
+    std::vector<TShape> outputs(output_number);
+
+    if(!op->InferShape(inputs, outputs, node_ops->exec_attr->graph_layout))
     {
-        do_prof = true;
+        XLOG_ERROR() << "infer shaped for node: " << node->GetName() << " op: " << op->GetName() << " failed\n";
+        return false;
+    }
 
-        if(sub_graph->ExistAttr("PROF_TIME"))
-            prof = any_cast<ProfRecord*>(sub_graph->GetAttr("PROF_TIME"));
-        else
+    for(int i = 0; i < output_number; i++)
+    {
+        Tensor* tensor = node->GetOutputTensor(i);
+        TShape shape = tensor->GetShape();
+
+        shape = outputs[i];
+
+        tensor->Reshape(shape);
+    }
+
+    /* allocate output memory */
+
+    for(int i = 0; i < output_number; i++)
+    {
+        Tensor* tensor = node->GetOutputTensor(i);
+
+        int input_idx = -1;
+
+        if(node->ExistAttr(ATTR_INPLACE))
+        {
+            const inplace_t& inplace = any_cast<inplace_t>(node->GetAttr("inplace"));
+
+            if(inplace.count(i))
+                input_idx = inplace.at(i);
+        }
+
+        if(input_idx >= 0)
+        {
+            Tensor* input_tensor = node->GetInputTensor(input_idx);
+
+            if(input_tensor->consumer.size() == 1)
+            {
+                void* tensor_addr = get_tensor_mem(input_tensor);
+                int total_size = tensor->GetTotalSize();
+
+                set_tensor_mem(tensor, tensor_addr, total_size, nullptr);
+
+                continue;
+            }
+        }
+
+        // non-inplace or cannot do in-place
+        int total_size = tensor->GetTotalSize();
+        int mem_size = get_tensor_mem_size(tensor);
+
+        if(mem_size < total_size)
         {
-            prof = new ProfTime(seq_nodes.size(), parse_node);
-            sub_graph->SetAttr("PROF_TIME", prof);
+            void* tensor_addr = mem_alloc(total_size);
+            set_tensor_mem(tensor, tensor_addr, total_size, mem_free);
         }
     }
 
-#endif
-    bool ret = true;
+    plan->RefreshIOMem(entry);
 
-    sub_graph->Lock();    // sync with graph perf start/stop/get
+    /* call the Reshape() to prepare for run */
+    node_ops->Reshape(node);
 
-    GraphPerfStatBuf* p_perf_stat = nullptr;
-    int perf_record_idx = 0;
+    return true;
+}
 
-    if(sub_graph->ExistAttr(ATTR_GRAPH_PERF_BUFFER))
+static void UpdateCalibration(Node* node)
+{
+    for(unsigned int i = 0; i < node->GetOutputNum(); i++)
     {
-        GraphPerfStatBuf* stat = any_cast<GraphPerfStatBuf>(&sub_graph->GetAttr(ATTR_GRAPH_PERF_BUFFER));
+        Tensor* t = node->GetOutputTensor(i);
+        int size = t->GetTotalSize();
+        float* data = ( float* )get_tensor_mem(t);
+        auto p_quant = t->GetQuantParam();
+        if(p_quant->size() == 0)
+            p_quant->resize(1);
+        QuantParam& param = (*p_quant)[0];
+        float max = 0.f;
+        for(unsigned int i = 0; i < size / sizeof(float); i++)
+        {
+            if(fabs(data[i]) > max)
+            {
+                max = fabs(data[i]);
+            }
+        }
+        // update the scale;
+        param.scale = max;
+    }
+}
 
-        if(stat->started)
+bool CPURunner::RunPlan(ExecPlan* plan)
+{
+    ExecPlanEntry* entry = plan->entries.data();
+    ExecPlanEntry* end = entry + plan->entries.size();
+
+    for(; entry < end; entry++)
+    {
+        /* dynamic shape process */
+        if(plan->NeedReshape(*entry) && !ReshapeNode(plan, *entry))
+            return false;
+
+        /* producers may rebind their outputs while running, e.g. DetectionOutput */
+        plan->RefreshIOMem(*entry);
+
+        if(!entry->Run())
         {
-            p_perf_stat = stat;
+            Operator* op = entry->node->GetOp();
+            LOG_ERROR() << "Failed to execute on: " << entry->node->GetName() << " Op: " << op->GetName() << std::endl;
+            return false;
         }
+
+        entry->node_ops->SaveDump(entry->node);
     }
 
-    for(unsigned int i = 0; i < seq_nodes.size(); i++)
+    return true;
+}
+
+struct DataflowState
+{
+    std::mutex lock;
+    std::condition_variable cv;
+
+    std::vector<int> wait_count;
+    std::vector<int> level_left;
+    std::set<int> ready;
+    std::set<int> held;    // ready, but out of the level window
+
+    int min_level;
+    int done_number;
+    bool failed;
+};
+
+/* take ready entries until the plan is done or failed: called by every thread which owns an aider group */
+static void RunDataflowWorker(ExecPlan* plan, DataflowState* state)
+{
+    int entry_number = plan->entries.size();
+    std::unique_lock<std::mutex> lock(state->lock);
+
+    while(true)
     {
-        Node* node = seq_nodes[i];
+        state->cv.wait(lock, [state, entry_number] {
+            return state->failed || state->done_number == entry_number || !state->ready.empty();
+        });
 
-        if(!node->ExistAttr(ATTR_NODE_OPS))
-            continue;
+        if(state->failed || state->done_number == entry_number)
+            break;
 
-        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+        int idx = *state->ready.begin();
 
-        /* dynamic shape process */
-        if(node->IsDynamicShape() || node->InputReshaped())
+        state->ready.erase(state->ready.begin());
+
+        lock.unlock();
+
+        ExecPlanEntry& entry = plan->entries[idx];
+
+        /* producers may rebind their outputs while running, e.g. DetectionOutput */
+        plan->RefreshIOMem(entry);
+
+        bool ret = entry.Run();
+
+        if(ret)
+            entry.node_ops->SaveDump(entry.node);
+
+        lock.lock();
+
+        if(!ret)
         {
-            int output_number = node->GetOutputNum();
+            Operator* op = entry.node->GetOp();
+            LOG_ERROR() << "Failed to execute on: " << entry.node->GetName() << " Op: " << op->GetName() << std::endl;
 
-#if 0
-			/* free output tensor first */
+            state->failed = true;
+            state->cv.notify_all();
+            break;
+        }
 
-			for(int i=0;i<output_number;i++)
-			{
-				Tensor * tensor=node->GetOutputTensor(i);
-				free_tensor_mem(tensor);
-			}
-#endif
+        state->done_number++;
 
-            /* do infer shape */
-            Operator* op = node->GetOp();
+        for(auto next : entry.next)
+        {
+            if(--state->wait_count[next] > 0)
+                continue;
+
+            if(plan->entries[next].level < state->min_level + plan->level_window)
+                state->ready.insert(next);
+            else
+                state->held.insert(next);
+        }
 
-            std::vector<TShape> inputs;
+        if(--state->level_left[entry.level] == 0)
+        {
+            while(state->min_level < plan->level_number && state->level_left[state->min_level] == 0)
+                state->min_level++;
 
-            for(unsigned int i = 0; i < node->GetInputNum(); i++)
+            /* entries are sorted by level, so that the held ones are released from the beginning */
+            while(!state->held.empty())
             {
-                Tensor* tensor = node->GetInputTensor(i);
-                inputs.push_back(tensor->GetShape());
+                int held_idx = *state->held.begin();
+
+                if(plan->entries[held_idx].level >= state->min_level + plan->level_window)
+                    break;
 
-                if(tensor->Reshaped())
-                    tensor->UpdateReshapeCount();
+                state->held.erase(state->held.begin());
+                state->ready.insert(held_idx);
             }
+        }
 
-            std::vector<TShape> outputs(output_number);
+        state->cv.notify_all();
+    }
+}
 
-            if(!op->InferShape(inputs, outputs, node_ops->exec_attr->graph_layout))
-            {
-                XLOG_ERROR() << "infer shaped for node: " << node->GetName() << " op: " << op->GetName() << " failed\n";
-                ret = false;
-                break;
-            }
+bool CPURunner::RunPlanDataflow(ExecPlan* plan)
+{
+    /* reshape changes the tensor memory on the fly: keep it in the sequential path */
+    if(plan->has_dynamic_shape)
+        return RunPlan(plan);
 
-            for(int i = 0; i < output_number; i++)
-            {
-                Tensor* tensor = node->GetOutputTensor(i);
-                TShape shape = tensor->GetShape();
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        if(plan->NeedReshape(plan->entries[i]))
+            return RunPlan(plan);
+    }
 
-                shape = outputs[i];
+    /* the calling thread runs on its own group, borrow the free ones for the other branches */
+    std::vector<AiderGroup*> groups;
 
-                tensor->Reshape(shape);
-            }
+    for(int i = 1; i < plan->max_width; i++)
+    {
+        AiderGroup* group = cpu_dev_->TryAcquireAiderGroup();
 
-            /* allocate output memory */
+        if(group == nullptr)
+            break;
 
-            for(int i = 0; i < output_number; i++)
-            {
-                Tensor* tensor = node->GetOutputTensor(i);
+        groups.push_back(group);
+    }
 
-                int input_idx = -1;
+    if(groups.empty())
+        return RunPlan(plan);
 
-                if(node->ExistAttr(ATTR_INPLACE))
-                {
-                    const inplace_t& inplace = any_cast<inplace_t>(node->GetAttr("inplace"));
+    DataflowState state;
 
-                    if(inplace.count(i))
-                        input_idx = inplace.at(i);
-                }
+    state.wait_count.resize(plan->entries.size());
+    state.level_left.resize(plan->level_number, 0);
+    state.min_level = 0;
+    state.done_number = 0;
+    state.failed = false;
 
-                if(input_idx >= 0)
-                {
-                    Tensor* input_tensor = node->GetInputTensor(input_idx);
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        state.wait_count[i] = plan->entries[i].wait_number;
+        state.level_left[plan->entries[i].level]++;
+    }
 
-                    if(input_tensor->consumer.size() == 1)
-                    {
-                        void* tensor_addr = get_tensor_mem(input_tensor);
-                        int total_size = tensor->GetTotalSize();
+    while(state.min_level < plan->level_number && state.level_left[state.min_level] == 0)
+        state.min_level++;
 
-                        set_tensor_mem(tensor, tensor_addr, total_size, nullptr);
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        const ExecPlanEntry& entry = plan->entries[i];
 
-                        continue;
-                    }
-                }
+        if(entry.wait_number > 0)
+            continue;
 
-                // non-inplace or cannot do in-place
-                int total_size = tensor->GetTotalSize();
-                int mem_size = get_tensor_mem_size(tensor);
+        if(entry.level < state.min_level + plan->level_window)
+            state.ready.insert(i);
+        else
+            state.held.insert(i);
+    }
 
-                if(mem_size < total_size)
-                {
-                    void* tensor_addr = mem_alloc(total_size);
-                    set_tensor_mem(tensor, tensor_addr, total_size, mem_free);
-                }
-            }
+    std::vector<std::thread> workers;
 
-            /* call the Reshape() to prepare for run */
-            node_ops->Reshape(node);
-        }
+    for(auto group : groups)
+    {
+        workers.emplace_back([this, plan, &state, group] {
+            cpu_dev_->EnterAiderGroup(group);
+            RunDataflowWorker(plan, &state);
+            cpu_dev_->LeaveAiderGroup(group);
+        });
+    }
+
+    RunDataflowWorker(plan, &state);
+
+    for(auto& worker : workers)
+        worker.join();
+
+    return !state.failed;
+}
+
+bool CPURunner::RunPlanWithHooks(ExecPlan* plan, GraphPerfStatBuf* p_perf_stat)
+{
+    int perf_record_idx = 0;
+
+    for(unsigned int i = 0; i < plan->entries.size(); i++)
+    {
+        ExecPlanEntry& entry = plan->entries[i];
+        Node* node = entry.node;
+        NodeOps* node_ops = entry.node_ops;
+
+        /* dynamic shape process */
+        if(plan->NeedReshape(entry) && !ReshapeNode(plan, entry))
+            return false;
 
 #ifdef ENABLE_TIME_PROFILING
-        if(do_prof)
-            prof->Start(i, node);
+        if(plan->prof)
+            plan->prof->Start(entry.seq_idx, node);
 #endif
         unsigned long start_time = 0;
         unsigned long end_time = 0;
 
-        if(p_perf_stat)
+        if(p_perf_stat || plan->profiler)
             start_time = get_cur_time();
 
-        if(!node_ops->Run(node))
+        /* producers may rebind their outputs while running, e.g. DetectionOutput */
+        plan->RefreshIOMem(entry);
+
+        if(!entry.Run())
         {
             Operator* op = node->GetOp();
             LOG_ERROR() << "Failed to execute on: " << node->GetName() << " Op: " << op->GetName() << std::endl;
-            ret = false;
-            break;
-        }
-        if(getenv("ENABLE_CALIBRATION"))
-        {
-            for(unsigned int i = 0; i < node->GetOutputNum(); i++)
-            {
-                Tensor* t = node->GetOutputTensor(i);
-                int size = t->GetTotalSize();
-                float* data = (float*)get_tensor_mem(t);
-                auto p_quant = t->GetQuantParam();
-                if(p_quant->size() == 0)
-                    p_quant->resize(1);
-                QuantParam& param = (*p_quant)[0];
-                float max = 0.f;
-                for(unsigned int i = 0; i < size/sizeof(float); i++)
-                {
-                    if(fabs(data[i]) > max)
-                    {
-                        max = fabs(data[i]);
-                    }
-                }
-                //update the scale;
-                param.scale = max;
-            }
+            return false;
         }
+
+        if(plan->do_calibration)
+            UpdateCalibration(node);
+
 //#define DUMP_NODE_OUTPUT
 #ifdef DUMP_NODE_OUTPUT
         {
-            std::string fname = "/tmp/debug/node" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+            std::string fname =
+                "/tmp/debug/node" + std::string(entry.seq_idx < 10 ? "0" : "") + std::to_string(entry.seq_idx);
 
             for(unsigned int i = 0; i < node->GetOutputNum(); i++)
             {
@@ -537,22 +823,38 @@ bool CPURunner::Run(Subgraph* sub_graph)
 
                 fname = fname + "." + std::to_string(i);
 
-                DumpFloat(fname.c_str(), ( float* )mem, size / sizeof(float));
-            }
+                DumpFloat(fname.c_str(), ( float* )mem, size / sizeof(float));
+            }
+        }
+#endif
+        node_ops->SaveDump(node);
+
+#ifdef ENABLE_TIME_PROFILING
+        if(plan->prof)
+            plan->prof->Stop(entry.seq_idx);
+#endif
+        if(p_perf_stat || plan->profiler)
+            end_time = get_cur_time();
+
+        if(plan->profiler)
+        {
+            ProfEvent event;
+
+            GraphProfiler::FillNodeInfo(event, node);
+
+            event.impl_name = GraphProfiler::GetTypeName(typeid(*node_ops).name());
+            event.dev_name = cpu_dev_->GetName();
+            event.start_time = start_time;
+            event.end_time = end_time;
+            event.thread_id = GraphProfiler::GetThreadId();
+
+            plan->profiler->AddEvent(event);
         }
-#endif
-        node_ops->SaveDump(node);
 
-#ifdef ENABLE_TIME_PROFILING
-        if(do_prof)
-            prof->Stop(i);
-#endif
         if(p_perf_stat)
         {
             struct perf_info* p_info = &p_perf_stat->records.at(perf_record_idx);
 
-            end_time = get_cur_time();
-
             unsigned long off = end_time - start_time;
 
             if(off > p_info->max)
@@ -570,6 +872,35 @@ bool CPURunner::Run(Subgraph* sub_graph)
         }
     }
 
+    return true;
+}
+
+bool CPURunner::Run(Subgraph* sub_graph)
+{
+    ExecPlan* plan = any_cast<ExecPlan*>(sub_graph->GetAttr(ATTR_EXEC_PLAN));
+    bool ret;
+
+    sub_graph->Lock();    // sync with graph perf start/stop/get
+
+    GraphPerfStatBuf* p_perf_stat = nullptr;
+
+    if(sub_graph->ExistAttr(ATTR_GRAPH_PERF_BUFFER))
+    {
+        GraphPerfStatBuf* stat = any_cast<GraphPerfStatBuf>(&sub_graph->GetAttr(ATTR_GRAPH_PERF_BUFFER));
+
+        if(stat->started)
+        {
+            p_perf_stat = stat;
+        }
+    }
+
+    if(plan->prof != nullptr || plan->do_calibration || p_perf_stat != nullptr || plan->profiler != nullptr)
+        ret = RunPlanWithHooks(plan, p_perf_stat);
+    else if(plan->level_window && plan->max_width > 1)
+        ret = RunPlanDataflow(plan);
+    else
+        ret = RunPlan(plan);
+
     sub_graph->Unlock();    // sync with graph perf start/stop/get
 #if 0
 
@@ -702,21 +1033,25 @@ bool CPURunner::FreeMem(Subgraph* sub_graph)
         }
     }
 
-    if(sub_graph->ExistAttr("shared_temp_memory"))
+    if(sub_graph->ExistAttr(ATTR_EXEC_PLAN))
     {
-        void* mem_addr = any_cast<void*>(sub_graph->GetAttr("shared_temp_memory"));
+        ExecPlan* plan = any_cast<ExecPlan*>(sub_graph->GetAttr(ATTR_EXEC_PLAN));
 
-        mem_free(mem_addr);
+        for(unsigned int i = 0; i < plan->entries.size(); i++)
+            plan->entries[i].node_ops->BindIOMem(nullptr, 0);
+
+        delete plan;
 
-        sub_graph->RemoveAttr("shared_temp_memory");
+        sub_graph->RemoveAttr(ATTR_EXEC_PLAN);
     }
 
-    if(sub_graph->ExistAttr("MemPool"))
+    if(sub_graph->ExistAttr("MemArena"))
     {
-        MemPool* mem_pool = any_cast<MemPool*>(sub_graph->GetAttr("MemPool"));
-        delete mem_pool;
+        void* mem_addr = any_cast<void*>(sub_graph->GetAttr("MemArena"));
 
-        sub_graph->RemoveAttr("MemPool");
+        mem_free(mem_addr);
+
+        sub_graph->RemoveAttr("MemArena");
     }
 
     return true;
@@ -749,197 +1084,352 @@ bool CPURunner::OptimizeGraph(Subgraph* optimized_graph)
 {
     GraphOptimizerManager::RunOpt("BNScale", optimized_graph);
     GraphOptimizerManager::RunOpt("ConvBN", optimized_graph);
+
+    /* the passes below rely on the inferred shapes, and the fused epilogues only live in
+       the runtime graph: a graph optimized to be saved stops here */
+    if(optimized_graph->ExistAttr("optimize_only"))
+    {
+        GraphOptimizerManager::RunOpt("ConvReLu", optimized_graph);
+        GraphOptimizerManager::RunOpt("ConvReLu6", optimized_graph);
+
+        return true;
+    }
+
+    /* before the fusions: the planner only moves the plain ops between the layouts */
+    if(optimized_graph->ExistAttr("exec_attr") && !GraphOptimizerManager::Disabled("LayoutPlan"))
+    {
+        LayoutPlanner planner(optimized_graph, cpu_info_);
+
+        planner.Plan();
+    }
+
+    GraphOptimizerManager::RunOpt("PadFold", optimized_graph);
     GraphOptimizerManager::RunOpt("ConvReLu", optimized_graph);
     GraphOptimizerManager::RunOpt("ConvReLu6", optimized_graph);
+    GraphOptimizerManager::RunOpt("ConvEltwise", optimized_graph);
+    GraphOptimizerManager::RunOpt("ConvActivation", optimized_graph);
+    GraphOptimizerManager::RunOpt("ReshapeChain", optimized_graph);
 
     return true;
 }
 
-static void CalculateMemBlocks(std::vector<int>& mem_block, Subgraph* sub_graph)
+/*
+   zero-copy views: a part of a concat/split/slice lives at its place inside the whole tensor,
+   so the copy of the node finds src == dst and skips it.
+   a part is one contiguous range of the whole only when all the dims before the axis are 1.
+   same_place: every part is the whole, as the caffe split
+ */
+static bool GetViewOffsets(Tensor* whole, const std::vector<Tensor*>& parts, int axis, bool same_place,
+                           std::vector<int>& offsets)
 {
-    // first calculate max var tensor exists
-    tensor_map_t tensor_map;
-
-    const std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
-
-    int node_number = seq_nodes.size();
-    int max_active_num = 0;
-    int active_num = 0;
+    int data_type = whole->GetDataType();
 
-    for(int i = 0; i < node_number; i++)
-    {
-        Node* node = seq_nodes[i];
+    /* quantized concat may rescale the inputs */
+    if(data_type != TENGINE_DT_FP32 && data_type != TENGINE_DT_FP16)
+        return false;
 
-        // first, add output tensor into map
-        if(!node->IsDynamicShape() && node->ExistAttr(ATTR_NODE_OPS))
-        {
-            for(unsigned int j = 0; j < node->GetOutputNum(); j++)
-            {
-                Tensor* tensor = node->GetOutputTensor(j);
+    const std::vector<int>& dims = whole->GetShape().GetDim();
+    int dim_num = dims.size();
 
-                if(get_tensor_mem(tensor))
-                    continue;
+    if(axis < 0)
+        axis += dim_num;
 
-                int consumer_number = tensor->consumer.size();
+    if(!same_place && (axis < 0 || axis >= dim_num))
+        return false;
 
-                tensor_map[tensor] = consumer_number;
-                active_num++;
-            }
-        }
+    for(int i = 0; !same_place && i < axis; i++)
+    {
+        if(dims[i] != 1)
+            return false;
+    }
 
-        if(active_num > max_active_num)
-            max_active_num = active_num;
+    int offset = 0;
 
-        // second, reduce the active_num by  release input
-        for(unsigned int j = 0; j < node->GetInputNum(); j++)
-        {
-            Tensor* tensor = node->GetInputTensor(j);
+    offsets.clear();
 
-            if(tensor_map.count(tensor) == 0)
-                continue;
+    for(unsigned int i = 0; i < parts.size(); i++)
+    {
+        Tensor* part = parts[i];
 
-            auto ir = tensor_map.find(tensor);
+        if(part->GetDataType() != data_type)
+            return false;
 
-            ir->second--;
+        if(same_place)
+        {
+            if(part->GetTotalSize() != whole->GetTotalSize())
+                return false;
 
-            if(ir->second == 0)
-            {
-                active_num--;
-                tensor_map.erase(ir);
-            }
+            offsets.push_back(0);
+            continue;
         }
+
+        offsets.push_back(offset);
+        offset += part->GetTotalSize();
     }
 
-    // suppose each output node only has one output tensor
-    if(active_num > ( int )sub_graph->output_nodes.size())
+    return same_place || offset == ( int )whole->GetTotalSize();
+}
+
+/* a node works in place on the tensor, e.g. the flatten kernel does not copy at all */
+static bool HasInplaceUse(Tensor* tensor)
+{
+    if(tensor->producer && tensor->producer->owner->ExistAttr(ATTR_INPLACE))
     {
-        XLOG_ERROR() << "graph: " << sub_graph->GetName() << " active num is: " << active_num
-                     << " output nodes: " << sub_graph->output_nodes.size() << "\n";
-    }
+        const inplace_t& inplace = any_cast<inplace_t>(tensor->producer->owner->GetAttr(ATTR_INPLACE));
 
-    // collect all tensor size
-    std::vector<int> mem_record;
+        if(inplace.count(tensor->producer->port_index))
+            return true;
+    }
 
-    for(int i = 0; i < node_number; i++)
+    for(unsigned int i = 0; i < tensor->consumer.size(); i++)
     {
-        Node* node = seq_nodes[i];
+        Node* node = tensor->consumer[i]->owner;
 
-        if(node->IsDynamicShape())
+        if(!node->ExistAttr(ATTR_INPLACE))
             continue;
 
-        for(unsigned int j = 0; j < node->GetOutputNum(); j++)
-        {
-            Tensor* tensor = node->GetOutputTensor(j);
-
-            if(get_tensor_mem(tensor))
-                continue;
+        const inplace_t& inplace = any_cast<inplace_t>(node->GetAttr(ATTR_INPLACE));
 
-            mem_record.push_back(tensor->GetTotalSize());
+        for(auto ir = inplace.begin(); ir != inplace.end(); ir++)
+        {
+            if(node->GetInputTensor(ir->second) == tensor)
+                return true;
         }
     }
 
-    // sort mem_record
-    std::sort(mem_record.begin(), mem_record.end(), std::greater<int>());
-
-    // save the most max_active_num into mem_blocks
-    for(int i = 0; i < max_active_num; i++)
-    {
-        mem_block.insert(mem_block.begin(), mem_record[i]);
-    }
+    return false;
 }
 
 bool CPURunner::AllocateMem(Subgraph* sub_graph)
 {
     const std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
+    int node_number = seq_nodes.size();
 
     /*
-       first, check if any nodes supports new memory interface
-       this memory block is only for tempory use and so that it can be shared
-       between operators
+       the liveness of a tensor ends at its last consumer inside the subgraph.
+       tensors consumed outside, graph outputs and the "data" input are kept alive to the end.
+
+       in inter-op mode, the liveness is counted in levels and extended by the level window,
+       see the comments of ExecPlanEntry
      */
 
-    unsigned int max_shared_mem_size = 0;
+    int window = GetInterOpWindow();
+    std::vector<int> node_pos(node_number);
 
-    for(unsigned int i = 0; i < seq_nodes.size(); i++)
+    if(window)
+        GetNodeLevels(sub_graph, node_pos);
+    else
     {
-        Node* node = seq_nodes[i];
+        for(int i = 0; i < node_number; i++)
+            node_pos[i] = i;
+    }
 
-        if(!node->ExistAttr(ATTR_NODE_OPS))
-            continue;
+    int extend = window ? window - 1 : 0;
+    int last_idx = 0;
 
-        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
-        unsigned int mem_size = 0;
+    for(int i = 0; i < node_number; i++)
+        last_idx = std::max(last_idx, node_pos[i] + extend);
+
+    std::unordered_map<Node*, int> node_idx_map;
+
+    for(int i = 0; i < node_number; i++)
+        node_idx_map[seq_nodes[i]] = node_pos[i];
 
-        if(node_ops->GetSharedMemorySize(node, mem_size) && mem_size > max_shared_mem_size)
+    auto get_last_use = [&](Tensor* tensor) -> int {
+        if(tensor->consumer.empty() || tensor->GetName() == "data")
+            return last_idx;
+
+        int last_use = 0;
+
+        for(unsigned int i = 0; i < tensor->consumer.size(); i++)
         {
-            max_shared_mem_size = mem_size;
+            auto ir = node_idx_map.find(tensor->consumer[i]->owner);
+
+            if(ir == node_idx_map.end())
+                return last_idx;
+
+            if(ir->second > last_use)
+                last_use = ir->second;
         }
-    }
 
-    if(max_shared_mem_size > 0)
+        return last_use + extend;
+    };
+
+    /*
+       the inputs of a concat are placed inside the concat output before their producers run.
+       kernels may write a little beyond their outputs, so the aliased inputs must be produced
+       in the order of their offsets. not used in inter-op mode, where producers run concurrently
+     */
+    bool use_view = !window && !GraphOptimizerManager::Disabled("ZeroCopyView");
+
+    std::unordered_map<Tensor*, int> concat_views;    // input --> offset in the concat output
+    std::unordered_map<Tensor*, std::vector<Tensor*>> concat_parts;    // output --> aliased inputs
+    tensor_map_t tensor_off;
+
+    for(int i = 0; use_view && i < node_number; i++)
     {
-        void* shared_memory = mem_alloc(max_shared_mem_size + 128+MEM_ALIGN_SIZE);
-        sub_graph->SetAttr("shared_temp_memory", shared_memory);
+        Node* node = seq_nodes[i];
+
+        if(node->GetOp()->GetName() != "Concat" || node->IsDynamicShape() || !node->ExistAttr(ATTR_NODE_OPS))
+            continue;
+
+        Tensor* output = node->GetOutputTensor(0);
+
+        if(get_tensor_mem(output) || HasInplaceUse(output))
+            continue;
+
+        Concat* concat_op = dynamic_cast<Concat*>(node->GetOp());
+        std::vector<Tensor*> inputs;
+        std::vector<int> offsets;
+
+        for(unsigned int j = 0; j < node->GetInputNum(); j++)
+            inputs.push_back(node->GetInputTensor(j));
 
-        shared_memory=(void *)(((long)(shared_memory)+MEM_ALIGN_SIZE-1)&(MEM_ALIGN_MASK));
+        if(!GetViewOffsets(output, inputs, concat_op->GetParam()->axis, false, offsets))
+            continue;
+
+        std::vector<Tensor*> parts;
+        int last_pos = -1;
 
-        for(unsigned int i = 0; i < seq_nodes.size(); i++)
+        for(unsigned int j = 0; j < inputs.size(); j++)
         {
-            Node* node = seq_nodes[i];
+            Tensor* input = inputs[j];
 
-            if(!node->ExistAttr(ATTR_NODE_OPS))
+            if(input->GetType() != kVarTensor || input->producer == nullptr || input->GetName() == "data" ||
+               get_tensor_mem(input) || HasInplaceUse(input) || concat_views.count(input) ||
+               concat_parts.count(input) || std::count(inputs.begin(), inputs.end(), input) > 1)
                 continue;
 
-            NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+            Node* producer = input->producer->owner;
+            auto ir = node_idx_map.find(producer);
 
-            unsigned int mem_size = 0;
+            if(ir == node_idx_map.end() || ir->second <= last_pos || producer->IsDynamicShape() ||
+               !producer->ExistAttr(ATTR_NODE_OPS))
+                continue;
 
-            if(node_ops->GetSharedMemorySize(node, mem_size))
-                node_ops->SetSharedMemoryAddr(node, shared_memory, mem_size);
+            last_pos = ir->second;
+            concat_views[input] = offsets[j];
+            parts.push_back(input);
         }
 
-        // std::cout<<"max shared memory: "<<max_shared_mem_size<<"\n";
+        if(!parts.empty())
+            concat_parts[output] = parts;
     }
 
-    /*
-     *  now, calculate the maximum input and output memory blocks to run the graph
-     */
+    MemPlanner planner(MEM_ALIGN_SIZE);
 
-    std::vector<int> mem_blocks;
+    tensor_map_t tensor_buf;
 
-    CalculateMemBlocks(mem_blocks, sub_graph);
+    /* the outputs of a split/slice are placed inside its input, which is already planned */
+    auto add_split_views = [&](Node* node) -> bool {
+        const std::string& op_name = node->GetOp()->GetName();
+        bool same_place = false;
+        int axis = 0;
 
-    MemPool* mem_pool = new MemPool(mem_blocks, mem_alloc, mem_free);
+        if(op_name == "Split")
+        {
+            SplitParam* param = dynamic_cast<Split*>(node->GetOp())->GetParam();
 
-    sub_graph->SetAttr("MemPool", mem_pool);
+            axis = param->axis;
+            same_place = param->is_caffe;
+        }
+        else if(op_name == "Slice")
+        {
+            SliceParam* param = dynamic_cast<Slice*>(node->GetOp())->GetParam();
 
-    /*
-     *  Real allocate memory
-     *
-     */
+            /* only the caffe style slice cuts the input into consecutive parts */
+            if(!param->iscaffe && !param->isncnn)
+                return false;
 
-    for(unsigned int i = 0; i < seq_nodes.size(); i++)
+            axis = param->axis;
+        }
+        else
+            return false;
+
+        Tensor* input = node->GetInputTensor(0);
+        auto ir = tensor_buf.find(input);
+
+        if(ir == tensor_buf.end())
+            return false;
+
+        std::vector<Tensor*> outputs;
+        std::vector<int> offsets;
+
+        for(unsigned int j = 0; j < node->GetOutputNum(); j++)
+        {
+            Tensor* output = node->GetOutputTensor(j);
+
+            if(get_tensor_mem(output) || HasInplaceUse(output) || concat_views.count(output) ||
+               concat_parts.count(output))
+                return false;
+
+            outputs.push_back(output);
+        }
+
+        if(!GetViewOffsets(input, outputs, axis, same_place, offsets))
+            return false;
+
+        int base_off = tensor_off.count(input) ? tensor_off[input] : 0;
+
+        for(unsigned int j = 0; j < outputs.size(); j++)
+        {
+            tensor_buf[outputs[j]] = ir->second;
+            tensor_off[outputs[j]] = base_off + offsets[j];
+            planner.ExtendBuffer(ir->second, 0, get_last_use(outputs[j]));
+        }
+
+        return true;
+    };
+
+    std::vector<std::pair<Node*, int>> shared_buf;
+    std::vector<std::pair<Node*, int>> private_buf;
+
+    for(int i = 0; i < node_number; i++)
     {
         Node* node = seq_nodes[i];
 
-        if(node->IsDynamicShape() || !node->ExistAttr(ATTR_NODE_OPS))
+        if(!node->ExistAttr(ATTR_NODE_OPS))
             continue;
 
-        for(unsigned int i = 0; i < node->GetOutputNum(); i++)
+        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+        unsigned int mem_size = 0;
+
+        /* temporary memory: only alive while the node runs */
+        if(node_ops->GetSharedMemorySize(node, mem_size) && mem_size > 0)
+            shared_buf.push_back(std::make_pair(node, planner.AddBuffer(mem_size, node_pos[i], node_pos[i] + extend)));
+
+        /* private memory: kept by the node for the whole graph life */
+        mem_size = 0;
+
+        if(node_ops->GetPrivateMemorySize(node, mem_size) && mem_size > 0)
+            private_buf.push_back(std::make_pair(node, planner.AddBuffer(mem_size, 0, last_idx)));
+
+        if(node->IsDynamicShape())
+            continue;
+
+        if(use_view && add_split_views(node))
+            continue;
+
+        for(unsigned int j = 0; j < node->GetOutputNum(); j++)
         {
-            Tensor* tensor = node->GetOutputTensor(i);
+            Tensor* tensor = node->GetOutputTensor(j);
 
             if(get_tensor_mem(tensor))
                 continue;
 
+            /* planned with the concat output */
+            if(concat_views.count(tensor))
+                continue;
+
+            int total_size = tensor->GetTotalSize();
             int input_idx = -1;
 
             if(node->ExistAttr(ATTR_INPLACE))
             {
                 const inplace_t& inplace = any_cast<inplace_t>(node->GetAttr("inplace"));
 
-                if(inplace.count(i))
-                    input_idx = inplace.at(i);
+                if(inplace.count(j))
+                    input_idx = inplace.at(j);
             }
 
             if(input_idx >= 0)
@@ -948,32 +1438,116 @@ bool CPURunner::AllocateMem(Subgraph* sub_graph)
 
                 if(input_tensor->consumer.size() == 1)
                 {
-                    void* tensor_addr = get_tensor_mem(input_tensor);
-                    int total_size = tensor->GetTotalSize();
-                    if(set_tensor_mem(tensor, tensor_addr, total_size, nullptr))
-                    {
-                        mem_pool->AddRef(tensor);
+                    auto ir = tensor_buf.find(input_tensor);
 
+                    if(ir != tensor_buf.end())
+                    {
+                        planner.ExtendBuffer(ir->second, total_size + 128, get_last_use(tensor));
+                        tensor_buf[tensor] = ir->second;
                         continue;
                     }
+
+                    /* input memory is not managed by the planner, e.g. set by user */
+                    void* tensor_addr = get_tensor_mem(input_tensor);
+
+                    if(set_tensor_mem(tensor, tensor_addr, total_size, nullptr))
+                        continue;
                 }
             }
 
-            // still allocate memory
+            auto parts = concat_parts.find(tensor);
+
+            if(parts == concat_parts.end())
             {
-                int total_size = tensor->GetTotalSize();
-                void* tensor_addr = mem_pool->Allocate(tensor, total_size);
-                if(!set_tensor_mem(tensor, tensor_addr, total_size, nullptr))
-                    return false;
+                tensor_buf[tensor] = planner.AddBuffer(total_size + 128, node_pos[i], get_last_use(tensor));
+                continue;
+            }
+
+            /* the buffer lives from the first aliased input produced */
+            int first_use = node_pos[i];
+            int last_use = get_last_use(tensor);
+
+            for(Tensor* part : parts->second)
+            {
+                first_use = std::min(first_use, node_idx_map[part->producer->owner]);
+                last_use = std::max(last_use, get_last_use(part));
+            }
+
+            int buf_id = planner.AddBuffer(total_size + 128, first_use, last_use);
+
+            tensor_buf[tensor] = buf_id;
+
+            for(Tensor* part : parts->second)
+            {
+                tensor_buf[part] = buf_id;
+                tensor_off[part] = concat_views[part];
             }
         }
-        /* input tensor */
-        for(unsigned int i = 0; i < node->GetInputNum(); i++)
-        {
-            Tensor* input_tensor = node->GetInputTensor(i);
-            if(input_tensor->GetName() != "data")
-                mem_pool->Free(input_tensor);
-        }
+    }
+
+    planner.Plan();
+
+    /*
+     *  Real allocate memory
+     *
+     */
+
+    if(planner.GetArenaSize() == 0)
+        return true;
+
+    void* arena = mem_alloc(planner.GetArenaSize() + MEM_ALIGN_SIZE);
+
+    if(arena == nullptr)
+    {
+        XLOG_ERROR() << "cannot allocate memory arena for graph: " << sub_graph->GetName() << "\n";
+        return false;
+    }
+
+    sub_graph->SetAttr("MemArena", arena);
+
+    char* base = ( char* )((( long )arena + MEM_ALIGN_SIZE - 1) & MEM_ALIGN_MASK);
+
+    for(auto ir = tensor_buf.begin(); ir != tensor_buf.end(); ir++)
+    {
+        Tensor* tensor = ir->first;
+        int offset = planner.GetOffset(ir->second);
+        auto off_ir = tensor_off.find(tensor);
+
+        if(off_ir != tensor_off.end())
+            offset += off_ir->second;
+
+        if(!set_tensor_mem(tensor, base + offset, tensor->GetTotalSize(), nullptr))
+            return false;
+    }
+
+    for(unsigned int i = 0; i < shared_buf.size(); i++)
+    {
+        Node* node = shared_buf[i].first;
+        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+        unsigned int mem_size = 0;
+
+        node_ops->GetSharedMemorySize(node, mem_size);
+        node_ops->SetSharedMemoryAddr(node, base + planner.GetOffset(shared_buf[i].second), mem_size);
+    }
+
+    for(unsigned int i = 0; i < private_buf.size(); i++)
+    {
+        Node* node = private_buf[i].first;
+        NodeOps* node_ops = any_cast<NodeOps*>(node->GetAttr(ATTR_NODE_OPS));
+        unsigned int mem_size = 0;
+
+        node_ops->GetPrivateMemorySize(node, mem_size);
+        node_ops->SetPrivateMemoryAddr(node, base + planner.GetOffset(private_buf[i].second), mem_size);
+    }
+
+    const char* dump_env = std::getenv("DUMP_MEM_PLAN");
+
+    if(dump_env && dump_env[0] == '1')
+    {
+        std::printf("graph %s: %d buffers, %d zero-copy views, planned arena %d bytes, naive sum %d bytes (%.1f%%)\n",
+                    sub_graph->GetName().c_str(), planner.GetBufferNumber(), ( int )tensor_off.size(),
+                    planner.GetArenaSize(), planner.GetNaiveSize(),
+                    100.0f * planner.GetArenaSize() / planner.GetNaiveSize());
     }
 
     return true;
@@ -999,8 +1573,6 @@ bool CPURunner::BindNodeOps(Subgraph* sub_graph)
     std::vector<Node*>& seq_nodes = sub_graph->seq_nodes;
     int node_size = seq_nodes.size();
 
-    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(sub_graph->GetAttr("exec_attr"));
-
     for(int i = 0; i < node_size; i++)
     {
         Node* node = seq_nodes[i];
@@ -1009,6 +1581,9 @@ bool CPURunner::BindNodeOps(Subgraph* sub_graph)
         if(op->GetName() == "Const" || op->GetName() == "Input")
             continue;
 
+        /* the graph exec attr, or the one of the layout the node was planned in */
+        const ExecAttr* exec_attr = LayoutPlanner::GetNodeExecAttr(sub_graph, node);
+
         node->SetAttr(ATTR_EXEC_ATTR, exec_attr);
 
         NodeOps* node_ops;
@@ -1038,7 +1613,9 @@ bool CPURunner::BindNodeOps(Subgraph* sub_graph)
 
         auto wait = std::bind(&CPUDevice::WaitDone, cpu_dev_);
 
-        node_ops->SetHelper(mem_alloc, mem_free, dispatch, wait);
+        auto worker = std::bind(&CPUDevice::GetWorkerNumber, cpu_dev_);
+
+        node_ops->SetHelper(mem_alloc, mem_free, dispatch, wait, worker);
 
         node->SetAttr(ATTR_NODE_OPS, node_ops);
 
@@ -1134,6 +1711,25 @@ bool CPURunner::SetGraphPerfStat(Subgraph* graph, int action)
     return ret;
 }
 
+bool CPURunner::SetGraphProfiler(Subgraph* graph, GraphProfiler* profiler)
+{
+    graph->Lock();
+
+    /* kept on the subgraph too, so that a plan built by a later Prerun() still reports */
+    graph->SetAttr(ATTR_SUBGRAPH_PROFILER, profiler);
+
+    if(graph->ExistAttr(ATTR_EXEC_PLAN))
+    {
+        ExecPlan* plan = any_cast<ExecPlan*>(graph->GetAttr(ATTR_EXEC_PLAN));
+
+        plan->profiler = profiler;
+    }
+
+    graph->Unlock();
+
+    return true;
+}
+
 int CPURunner::GetGraphPerfStat(Subgraph* graph, struct perf_info** buf, int buf_size)
 {
     graph->Lock();
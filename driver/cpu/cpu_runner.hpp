@@ -35,6 +35,10 @@ namespace TEngine {
 
 class Graph;
 class CPUDevice;
+struct ExecPlan;
+struct ExecPlanEntry;
+struct GraphPerfStatBuf;
+class GraphProfiler;
 
 using Subgraph = Graph;
 
@@ -43,6 +47,7 @@ class CPURunner
 public:
     bool SetGraphPerfStat(Subgraph* graph, int action);
     int GetGraphPerfStat(Subgraph* graph, struct perf_info** buf, int buf_size);
+    bool SetGraphProfiler(Subgraph* graph, GraphProfiler* profiler);
 
     bool Prerun(Subgraph* sub_graph);
     bool Run(Subgraph* sub_graph);
@@ -60,6 +65,11 @@ public:
 
     NodeOps* BindCustomKernel(Node* node);
 
+    bool RunPlan(ExecPlan* plan);
+    bool RunPlanWithHooks(ExecPlan* plan, GraphPerfStatBuf* p_perf_stat);
+    bool RunPlanDataflow(ExecPlan* plan);
+    bool ReshapeNode(ExecPlan* plan, ExecPlanEntry& entry);
+
     CPURunner()
     {
         mem_alloc = malloc;
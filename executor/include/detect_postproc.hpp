@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __DETECT_POSTPROC_HPP__
+#define __DETECT_POSTPROC_HPP__
+
+#include <vector>
+#include <functional>
+
+namespace TEngine {
+
+/*
+ * Post processing shared by the detection ops: DetectionOutput, DetectionPostProcess, YOLOV3DetectionOutput
+ * and TopKV2. The candidates are prefiltered by score, only the best top_k are selected (partial sort),
+ * the IoU of NMS runs over boxes kept as a structure of arrays, and the classes are processed in parallel.
+ */
+
+/* runs func(start, end) over [0, work_num), e.g. by NodeOps::ParallelRun(); nullptr runs it inline */
+using post_parallel_t = std::function<void(int work_num, int min_work, const std::function<void(int, int)>& func)>;
+
+/* decodes the box box_idx into rect (x0, y0, x1, y1), returns false to drop it */
+using box_decode_t = std::function<bool(int box_idx, float* rect)>;
+
+struct DetectBox
+{
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    float score;
+    int class_idx;
+    int box_idx;
+};
+
+/* boxes as a structure of arrays, so the IoU loops vectorize */
+struct BoxArrays
+{
+    std::vector<float> x0;
+    std::vector<float> y0;
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> area;
+
+    int Size(void) const
+    {
+        return x0.size();
+    }
+
+    void Resize(int n);
+    void Set(int i, const float* rect);
+};
+
+struct MultiClassNmsParam
+{
+    int num_boxes;
+    int num_classes;
+    int first_class;    // 1 skips the background class
+    float score_threshold;    // a candidate has score > score_threshold
+    int top_k;    // candidates of a class going to NMS, <= 0 for all
+    float iou_threshold;
+    int keep_top_k;    // boxes kept over all classes, <= 0 for all
+    bool fast_nms;
+};
+
+/* appends the indices i in [0, num) with score[i * stride] > threshold */
+void FilterScores(const float* score, int num, int stride, float threshold, std::vector<int>& idx);
+
+/* reorders idx by score[idx * stride], best first, and keeps the top_k (<= 0 for all). ties keep the index order */
+void SelectTopK(const float* score, int stride, std::vector<int>& idx, int top_k);
+
+/*
+ * NMS over boxes sorted by score, picked gets the kept indices in score order.
+ * greedy: a box is dropped by an overlapping kept box.
+ * fast: a box is dropped by any overlapping better box, kept or not. It drops a few more boxes but has no
+ * dependency on the previous decisions.
+ */
+void NmsSortedBoxes(const BoxArrays& boxes, float iou_threshold, bool fast, std::vector<int>& picked);
+
+/*
+ * NMS per class over a num_boxes x num_classes score matrix, boxes decoded on demand.
+ * result: the kept boxes of all classes, best first
+ */
+void MultiClassNms(const float* score, const MultiClassNmsParam& param, const box_decode_t& decode,
+                   const post_parallel_t& parallel, std::vector<DetectBox>& result);
+
+/* DETECT_FAST_NMS=1 switches the detection ops to fast NMS */
+bool FastNmsEnabled(void);
+
+}    // namespace TEngine
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __FUSED_EPILOGUE_HPP__
+#define __FUSED_EPILOGUE_HPP__
+
+#include <cmath>
+#include <algorithm>
+
+namespace TEngine {
+
+#define ATTR_FUSED_EPILOGUE "Fused.Epilogue"
+
+class Node;
+struct NodeOps;
+
+enum FusedActType
+{
+    kFusedActNone,
+    kFusedActReLU,
+    kFusedActReLU6,
+    kFusedActLeakyReLU,
+    kFusedActPReLU,
+    kFusedActHardSwish,
+    kFusedActSigmoid
+};
+
+/*
+ * the tail the graph optimizer fused into a convolution: out = act(conv(x) + residual).
+ * The convolution's own activation in ConvParam is applied before the residual sum.
+ * Only set on FP32 NCHW nodes.
+ */
+struct FusedEpilogue
+{
+    int residual_idx;    // input index of the tensor added to the output, -1 for none
+    int slope_idx;    // input index of the PReLU slope tensor, -1 for none
+    int act_type;
+    float alpha;    // LeakyReLU slope, HardSwish alpha
+    float beta;    // HardSwish beta
+
+    FusedEpilogue()
+    {
+        residual_idx = -1;
+        slope_idx = -1;
+        act_type = kFusedActNone;
+        alpha = 0.f;
+        beta = 0.f;
+    }
+};
+
+/*
+ * run the epilogue on points [start, end) of channel_num planes of size hw.
+ * output, residual and slope point to the first of those channels, residual and slope may be nullptr
+ */
+static inline void RunFusedEpilogue(const FusedEpilogue* ep, float* output, const float* residual,
+                                    const float* slope, int channel_num, int hw, int start, int end)
+{
+    for(int c = 0; c < channel_num; c++)
+    {
+        float* out = output + c * hw;
+
+        if(residual)
+        {
+            const float* res = residual + c * hw;
+
+            for(int i = start; i < end; i++)
+                out[i] += res[i];
+        }
+
+        switch(ep->act_type)
+        {
+            case kFusedActReLU:
+                for(int i = start; i < end; i++)
+                    out[i] = std::max(out[i], 0.f);
+                break;
+            case kFusedActReLU6:
+                for(int i = start; i < end; i++)
+                    out[i] = std::min(std::max(out[i], 0.f), 6.f);
+                break;
+            case kFusedActLeakyReLU:
+            case kFusedActPReLU:
+            {
+                float alpha = ep->act_type == kFusedActPReLU ? slope[c] : ep->alpha;
+
+                for(int i = start; i < end; i++)
+                    out[i] = out[i] < 0.f ? out[i] * alpha : out[i];
+                break;
+            }
+            case kFusedActHardSwish:
+                for(int i = start; i < end; i++)
+                    out[i] = out[i] * std::min(std::max(out[i] * ep->alpha + ep->beta, 0.f), 1.f);
+                break;
+            case kFusedActSigmoid:
+                for(int i = start; i < end; i++)
+                    out[i] = 1.f / (1.f + std::exp(-out[i]));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* the whole output of node, used by the runner for the kernels which do not run the epilogue themselves */
+bool ApplyFusedEpilogue(Node* node, NodeOps* node_ops);
+
+}    // namespace TEngine
+
+#endif
@@ -49,6 +49,9 @@ class GraphOptimizerManager : public SimpleObjectManager<GraphOptimizerManager,
 public:
     static bool RunOpt(const std::string& name, Graph* graph);
 
+    /* GRAPH_OPT_DISABLE=ConvEltwise,PadFold turns off the listed optimizers */
+    static bool Disabled(const std::string& name);
+
     static void Init(void);
 };
 
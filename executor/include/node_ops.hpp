@@ -25,6 +25,7 @@
 #define __NODE_OPS_HPP__
 
 #include <functional>
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -46,6 +47,8 @@ namespace TEngine {
 #define ATTR_NODE_OPS "node_ops"
 #define ATTR_INPLACE "inplace"
 #define ATTR_EXEC_ATTR "exec_attr"
+/* set on a node which the layout planner moved out of the graph layout */
+#define ATTR_NODE_LAYOUT "node_layout"
 
 class Node;
 struct NodeOps;
@@ -56,6 +59,7 @@ using inplace_t = std::unordered_map<int, int>;
 using task_exec_t = std::function<bool(int cpu, int seq, void* data)>;
 using task_dispatch_t = std::function<bool(std::vector<sub_op_task>& tasks, int cpu)>;
 using wait_done_t = std::function<void(void)>;
+using worker_number_t = std::function<int(void)>;
 
 using mem_alloc_t = std::function<void*(int size)>;
 using mem_free_t = std::function<void(void*)>;
@@ -156,6 +160,10 @@ struct NodeOps
         need_free = false;
         dump_enabled = false;
         dump_started = false;
+        io_mem = nullptr;
+        io_input_num = 0;
+        cpu_info = nullptr;
+        fused_epilogue = false;
     }
 
     /* for delete this usage: https://isocpp.org/wiki/faq/freestore-mgmt#delete-this */
@@ -165,12 +173,25 @@ struct NodeOps
             delete this;
     }
 
-    void SetHelper(mem_alloc_t alloc, mem_free_t free, task_dispatch_t disp, wait_done_t wait)
+    void SetHelper(mem_alloc_t alloc, mem_free_t free, task_dispatch_t disp, wait_done_t wait,
+                   worker_number_t worker = nullptr)
     {
         mem_alloc = alloc;
         mem_free = free;
         task_dispatch = disp;
         wait_done = wait;
+        worker_number = worker;
+    }
+
+    /* number of threads the sub tasks of Run() are spread over: the aider group the graph runs on,
+       or the whole device when the runner does not tell
+     */
+    int GetWorkerNumber(void)
+    {
+        if(worker_number)
+            return worker_number();
+
+        return cpu_info ? cpu_info->GetCPUNumber() : 1;
     }
 
     void SetCPUInfo(const CPUInfo* cpu)
@@ -178,6 +199,62 @@ struct NodeOps
         cpu_info = cpu;
     }
 
+    /* io_mem is bound by the runner to the node's slice of the subgraph memory table:
+       input tensor addresses first, then output tensor addresses, refreshed before each Run().
+       Without a bound table, falls back to get_tensor_mem()
+     */
+    void BindIOMem(void** mem, int input_num)
+    {
+        io_mem = mem;
+        io_input_num = input_num;
+    }
+
+    void* GetInputMem(Node* node, int idx)
+    {
+        if(io_mem)
+            return io_mem[idx];
+
+        return LookupInputMem(node, idx);
+    }
+
+    void* GetOutputMem(Node* node, int idx)
+    {
+        if(io_mem)
+            return io_mem[io_input_num + idx];
+
+        return LookupOutputMem(node, idx);
+    }
+
+    static void* LookupInputMem(Node* node, int idx);
+    static void* LookupOutputMem(Node* node, int idx);
+
+    /*
+     * parallel_for over the aider threads: [0, work_num) is cut into one static, contiguous
+     * chunk per worker, and func(start, end) runs on each chunk. Jobs below min_work run inline,
+     * waking the aiders costs more than they save.
+     */
+    template <typename F> void ParallelRun(int work_num, int min_work, F func)
+    {
+        int task_num = std::min(GetWorkerNumber(), work_num);
+
+        if(task_num <= 1 || work_num < min_work)
+        {
+            if(work_num > 0)
+                func(0, work_num);
+            return;
+        }
+
+        int step = (work_num + task_num - 1) / task_num;
+
+        MULTI_THREAD_START(task_num, step, p_id, p_param)
+            int start = p_id * step;
+            int end = std::min(work_num, start + step);
+
+            if(start < end)
+                func(start, end);
+        MULTI_THREAD_END();
+    }
+
     virtual ~NodeOps() {}
 
     std::string name_;
@@ -186,10 +263,18 @@ struct NodeOps
     mem_free_t mem_free;
     task_dispatch_t task_dispatch;
     wait_done_t wait_done;
+    worker_number_t worker_number;
     const ExecAttr* exec_attr;
 
     const CPUInfo* cpu_info;
 
+    void** io_mem;
+    int io_input_num;
+
+    /* set by the implementations whose Run() applies the FusedEpilogue of the node,
+       the runner applies it after Run() for the others */
+    bool fused_epilogue;
+
     bool dump_enabled;
     bool dump_started;
     std::vector<tensor_dump_header> dump_records;
@@ -274,7 +359,8 @@ public:
 
     static void RecordNodeOpsptr(NodeOps* ops);
 
-    static NodeOps* RealFindNodeOps(const CPUInfo*, Node*);
+    /* search_ref false: only the optimized registries, nullptr if the reference one would be used */
+    static NodeOps* RealFindNodeOps(const CPUInfo*, Node*, bool search_ref = true);
     static NodeOps* FindNodeOps(const CPUInfo*, Node*);
     static NodeOps* FindNodeOps(const std::string& registry_name, const CPUInfo*, Node*);
 
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#ifndef __WEIGHT_CACHE_HPP__
+#define __WEIGHT_CACHE_HPP__
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace TEngine {
+
+struct CPUInfo;
+
+/*
+ * On-disk cache of the weights the kernels transform and pack at Prerun, e.g. the winograd kernels.
+ * It is enabled by TENGINE_WEIGHT_CACHE=<dir>. A blob is keyed by the hash of the raw weights, the kernel
+ * implementation, its packing parameters and the cpu, and it is mapped back read only on the next Prerun.
+ */
+bool WeightCacheEnabled(void);
+
+/*
+ * Sharing of the weights between the graphs created from one model in a process, enabled by
+ * TENGINE_WEIGHT_SHARE=1. The model file stays mapped (see TM_MMAP_WEIGHT), so the original weights are
+ * the pages of the page cache, and the fused and packed weights are refcounted blobs, made by the first
+ * graph that needs one and freed with the last one.
+ */
+bool WeightShareEnabled(void);
+
+std::string GetWeightCacheKey(const CPUInfo* cpu_info, const char* impl, const void* weight, int weight_size,
+                              const std::vector<int>& layout);
+
+/*
+ * returns the blob of key and takes a reference on it. The first caller's fill() makes it, or it is mapped
+ * from the disk cache, and it is read only from then on. Returns nullptr when fill() fails.
+ * A memory_only blob skips the disk cache: for a key made from the content, a disk hit saves no work.
+ */
+void* AcquireSharedWeight(const std::string& key, int size, const std::function<bool(void*)>& fill,
+                          bool memory_only = false);
+
+/* returns false when addr is not a shared blob, which the kernel then frees itself */
+bool ReleaseSharedWeight(void* addr);
+
+}    // namespace TEngine
+
+#endif
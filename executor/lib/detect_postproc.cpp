@@ -0,0 +1,256 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "detect_postproc.hpp"
+
+namespace TEngine {
+
+/* below this number of candidates, waking the aider threads costs more than the per class NMS */
+#define PARALLEL_MIN_CANDIDATES 256
+
+/* the kept boxes are checked in blocks, so a suppressed box stops early */
+#define NMS_BLOCK 32
+
+void BoxArrays::Resize(int n)
+{
+    x0.resize(n);
+    y0.resize(n);
+    x1.resize(n);
+    y1.resize(n);
+    area.resize(n);
+}
+
+void BoxArrays::Set(int i, const float* rect)
+{
+    x0[i] = rect[0];
+    y0[i] = rect[1];
+    x1[i] = rect[2];
+    y1[i] = rect[3];
+    area[i] = (rect[2] - rect[0]) * (rect[3] - rect[1]);
+}
+
+void FilterScores(const float* score, int num, int stride, float threshold, std::vector<int>& idx)
+{
+    for(int i = 0; i < num; i++)
+    {
+        if(score[i * stride] > threshold)
+            idx.push_back(i);
+    }
+}
+
+void SelectTopK(const float* score, int stride, std::vector<int>& idx, int top_k)
+{
+    auto better = [score, stride](int a, int b) {
+        float score_a = score[a * stride];
+        float score_b = score[b * stride];
+
+        return score_a > score_b || (score_a == score_b && a < b);
+    };
+
+    if(top_k > 0 && top_k < ( int )idx.size())
+    {
+        std::nth_element(idx.begin(), idx.begin() + top_k, idx.end(), better);
+        idx.resize(top_k);
+    }
+
+    std::sort(idx.begin(), idx.end(), better);
+}
+
+/* true when a box in [start, end) of the arrays has IoU with rect above the threshold */
+static bool Overlapped(const BoxArrays& boxes, int start, int end, const float* rect, float rect_area,
+                       float threshold)
+{
+    const float* x0 = boxes.x0.data();
+    const float* y0 = boxes.y0.data();
+    const float* x1 = boxes.x1.data();
+    const float* y1 = boxes.y1.data();
+    const float* area = boxes.area.data();
+
+    for(int block = start; block < end; block += NMS_BLOCK)
+    {
+        int block_end = std::min(end, block + NMS_BLOCK);
+        int suppressed = 0;
+
+        for(int j = block; j < block_end; j++)
+        {
+            float w = std::max(0.f, std::min(x1[j], rect[2]) - std::max(x0[j], rect[0]));
+            float h = std::max(0.f, std::min(y1[j], rect[3]) - std::max(y0[j], rect[1]));
+            float inter = w * h;
+
+            /* inter / union > threshold, without the division */
+            suppressed |= inter > threshold * (area[j] + rect_area - inter);
+        }
+
+        if(suppressed)
+            return true;
+    }
+
+    return false;
+}
+
+void NmsSortedBoxes(const BoxArrays& boxes, float iou_threshold, bool fast, std::vector<int>& picked)
+{
+    int n = boxes.Size();
+
+    picked.clear();
+
+    if(fast)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            float rect[4] = {boxes.x0[i], boxes.y0[i], boxes.x1[i], boxes.y1[i]};
+
+            if(!Overlapped(boxes, 0, i, rect, boxes.area[i], iou_threshold))
+                picked.push_back(i);
+        }
+
+        return;
+    }
+
+    /* the kept boxes are packed, so the IoU loop runs on contiguous arrays */
+    BoxArrays kept;
+
+    kept.Resize(n);
+
+    for(int i = 0; i < n; i++)
+    {
+        float rect[4] = {boxes.x0[i], boxes.y0[i], boxes.x1[i], boxes.y1[i]};
+
+        if(Overlapped(kept, 0, picked.size(), rect, boxes.area[i], iou_threshold))
+            continue;
+
+        kept.Set(picked.size(), rect);
+        picked.push_back(i);
+    }
+}
+
+void MultiClassNms(const float* score, const MultiClassNmsParam& param, const box_decode_t& decode,
+                   const post_parallel_t& parallel, std::vector<DetectBox>& result)
+{
+    int num_boxes = param.num_boxes;
+    int num_classes = param.num_classes;
+    int first_class = param.first_class;
+    int class_num = num_classes - first_class;
+
+    result.clear();
+
+    if(class_num <= 0)
+        return;
+
+    /* one pass over the rows of the scores: a box is decoded once, when a class passes the threshold */
+    std::vector<std::vector<int>> candidates(class_num);
+    std::vector<float> rects(num_boxes * 4);
+    int candidate_num = 0;
+
+    for(int i = 0; i < num_boxes; i++)
+    {
+        const float* row = score + i * num_classes;
+        bool decoded = false;
+
+        for(int c = first_class; c < num_classes; c++)
+        {
+            if(!(row[c] > param.score_threshold))
+                continue;
+
+            if(!decoded)
+            {
+                if(!decode(i, rects.data() + i * 4))
+                    break;
+
+                decoded = true;
+            }
+
+            candidates[c - first_class].push_back(i);
+            candidate_num++;
+        }
+    }
+
+    std::vector<std::vector<DetectBox>> class_result(class_num);
+
+    auto class_nms = [&](int start, int end) {
+        BoxArrays boxes;
+        std::vector<int> picked;
+
+        for(int k = start; k < end; k++)
+        {
+            std::vector<int>& idx = candidates[k];
+            int c = k + first_class;
+
+            if(idx.empty())
+                continue;
+
+            SelectTopK(score + c, num_classes, idx, param.top_k);
+
+            boxes.Resize(idx.size());
+
+            for(unsigned int j = 0; j < idx.size(); j++)
+                boxes.Set(j, rects.data() + idx[j] * 4);
+
+            NmsSortedBoxes(boxes, param.iou_threshold, param.fast_nms, picked);
+
+            for(unsigned int j = 0; j < picked.size(); j++)
+            {
+                int box_idx = idx[picked[j]];
+                const float* rect = rects.data() + box_idx * 4;
+                DetectBox box = {rect[0], rect[1], rect[2], rect[3], score[box_idx * num_classes + c], c, box_idx};
+
+                class_result[k].push_back(box);
+            }
+        }
+    };
+
+    if(parallel && candidate_num >= PARALLEL_MIN_CANDIDATES)
+        parallel(class_num, 1, class_nms);
+    else
+        class_nms(0, class_num);
+
+    std::vector<DetectBox> merged;
+
+    for(int k = 0; k < class_num; k++)
+        merged.insert(merged.end(), class_result[k].begin(), class_result[k].end());
+
+    std::vector<float> merged_score(merged.size());
+    std::vector<int> order(merged.size());
+
+    for(unsigned int i = 0; i < merged.size(); i++)
+    {
+        merged_score[i] = merged[i].score;
+        order[i] = i;
+    }
+
+    SelectTopK(merged_score.data(), 1, order, param.keep_top_k);
+
+    for(unsigned int i = 0; i < order.size(); i++)
+        result.push_back(merged[order[i]]);
+}
+
+bool FastNmsEnabled(void)
+{
+    const char* env = std::getenv("DETECT_FAST_NMS");
+
+    return env && env[0] == '1';
+}
+
+}    // namespace TEngine
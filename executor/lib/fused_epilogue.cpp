@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include "node.hpp"
+#include "tensor_mem.hpp"
+#include "node_ops.hpp"
+#include "fused_epilogue.hpp"
+
+namespace TEngine {
+
+bool ApplyFusedEpilogue(Node* node, NodeOps* node_ops)
+{
+    const FusedEpilogue ep = any_cast<FusedEpilogue>(node->GetAttr(ATTR_FUSED_EPILOGUE));
+    const std::vector<int>& dims = node->GetOutputTensor(0)->GetShape().GetDim();
+
+    if(dims.size() != 4)
+        return false;
+
+    int channel = dims[1];
+    int hw = dims[2] * dims[3];
+
+    float* output = ( float* )node_ops->GetOutputMem(node, 0);
+    const float* residual = nullptr;
+    const float* slope = nullptr;
+
+    if(ep.residual_idx >= 0)
+        residual = ( const float* )node_ops->GetInputMem(node, ep.residual_idx);
+
+    if(ep.slope_idx >= 0)
+        slope = ( const float* )node_ops->GetInputMem(node, ep.slope_idx);
+
+    /* one plane per work item, the slope is indexed by channel */
+    node_ops->ParallelRun(dims[0] * channel, 2, [&](int start, int end) {
+        for(int i = start; i < end; i++)
+        {
+            int c = i % channel;
+
+            RunFusedEpilogue(&ep, output + i * hw, residual ? residual + i * hw : nullptr,
+                             slope ? slope + c : nullptr, 1, hw, 0, hw);
+        }
+    });
+
+    return true;
+}
+
+}    // namespace TEngine
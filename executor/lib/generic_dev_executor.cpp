@@ -24,6 +24,7 @@
 
 #include "graph_task.hpp"
 #include "generic_dev_executor.hpp"
+#include "graph_profiler.hpp"
 
 namespace TEngine {
 
@@ -227,12 +228,6 @@ bool GenericDevExecutor::PrerunTask(SubgraphTask* task)
     if(DevGetStatus() != kDevNormal)
         return false;
 
-    if(task->graph_handle == nullptr)
-        task->graph_handle = DevCreateGraphHandle(task->sub_graph);
-
-    if(task->graph_handle == nullptr || !OptimizeGraph(task))
-        return false;
-
     GraphTask* graph_task = task->graph_task;
     GraphExecutor* executor = graph_task->GetGraphExecutor();
 
@@ -240,6 +235,30 @@ bool GenericDevExecutor::PrerunTask(SubgraphTask* task)
 
     executor->GetGraphAttr("optimize_only", &optimize_only, sizeof(int));
 
+    /* tells the device optimizers that the graph will be saved instead of run */
+    if(optimize_only)
+        task->sub_graph->SetAttr("optimize_only", 1);
+
+    /* a profiling session outlives the plans: the new plan picks it up at prerun */
+    Graph* graph = executor->GetGraph();
+    GraphProfiler* profiler = nullptr;
+
+    if(graph->ExistAttr(ATTR_GRAPH_PROFILER))
+    {
+        auto graph_profiler = any_cast<std::shared_ptr<GraphProfiler>>(graph->GetAttr(ATTR_GRAPH_PROFILER));
+
+        if(graph_profiler->IsActive())
+            profiler = graph_profiler.get();
+    }
+
+    task->sub_graph->SetAttr(ATTR_SUBGRAPH_PROFILER, profiler);
+
+    if(task->graph_handle == nullptr)
+        task->graph_handle = DevCreateGraphHandle(task->sub_graph);
+
+    if(task->graph_handle == nullptr || !OptimizeGraph(task))
+        return false;
+
     if(optimize_only)
         return true;
 
@@ -23,6 +23,8 @@
  */
 #include <cmath>
 #include <cstring>
+#include <cstdlib>
+#include <cfloat>
 
 #include "node.hpp"
 #include "graph.hpp"
@@ -33,7 +35,13 @@
 #include "operator/relu.hpp"
 #include "operator/scale.hpp"
 #include "operator/eltwise.hpp"
+#include "operator/pooling.hpp"
+#include "operator/pad.hpp"
+#include "operator/reshape.hpp"
+#include "operator/hardswish.hpp"
 #include "tensor_mem.hpp"
+#include "fused_epilogue.hpp"
+#include "weight_cache.hpp"
 
 namespace TEngine {
 
@@ -42,8 +50,34 @@ static bool GraphFuseConvBN(Graph* graph, GraphOptimizer* opt);
 static bool GraphFuseConvReLu(Graph* graph, GraphOptimizer* opt);
 static bool GraphFuseConvReLu6(Graph* graph, GraphOptimizer* opt);
 static bool GraphFuseRelu6(Graph* graph, GraphOptimizer* opt);
+static bool GraphFoldPad(Graph* graph, GraphOptimizer* opt);
+static bool GraphFuseConvEltwise(Graph* graph, GraphOptimizer* opt);
+static bool GraphFuseConvActivation(Graph* graph, GraphOptimizer* opt);
+static bool GraphMergeReshapeChain(Graph* graph, GraphOptimizer* opt);
 static void AddConstNodeToSubGraph(Subgraph* graph, Tensor* tensor, Node* fused_node, int fused_port_index);
 
+/*
+ * swaps the private copy of a fused weight for the one shared by the graphs created from the same model,
+ * found by its content. The 128 bytes of slack behind the weight are kept, as for the private copy.
+ */
+static void ShareFusedWeight(Tensor* tensor, int size)
+{
+    void* addr = tensor->GetMemAddr();
+    std::string key = GetWeightCacheKey(nullptr, "fused", addr, size, {});
+    void* shared = AcquireSharedWeight(key, size + 128, [&](void* blob) {
+        memcpy(blob, addr, size);
+        memset(( char* )blob + size, 0, 128);
+        return true;
+    }, true);
+
+    if(shared == nullptr)
+        return;
+
+    tensor->FreeTensor();
+    tensor->SetMemAddr(shared);
+    tensor->SetAttr("mem_release", std::function<void(void*)>([](void* blob) { ReleaseSharedWeight(blob); }));
+}
+
 static bool Weight_Bn(Subgraph* graph, Node* ConvNode, float* mean, float* var, float* gamma, float* beta, float eps,
                       float rescale_factor, Tensor* bias_tensor)
 {
@@ -195,6 +229,12 @@ static bool Weight_Bn(Subgraph* graph, Node* ConvNode, float* mean, float* var,
     free(scale_var_inv);
     free(scale_mean);
 
+    if(WeightShareEnabled())
+    {
+        ShareFusedWeight(kernel_tensor, sizeof(float) * kernel_size * channel_num);
+        ShareFusedWeight(ConvNode->GetInputTensor(2), sizeof(float) * channel_num);
+    }
+
     return true;
 }
 
@@ -582,9 +622,21 @@ static bool GraphFuseConvBN(Graph* graph, GraphOptimizer* opt)
     return true;
 }
 
+bool GraphOptimizerManager::Disabled(const std::string& name)
+{
+    const char* env = std::getenv("GRAPH_OPT_DISABLE");
+
+    if(env == nullptr)
+        return false;
+
+    std::string list = std::string(",") + env + ",";
+
+    return list.find("," + name + ",") != std::string::npos;
+}
+
 bool GraphOptimizerManager::RunOpt(const std::string& name, Graph* graph)
 {
-    if(!Find(name))
+    if(!Find(name) || Disabled(name))
         return false;
 
     GraphOptimizer* opt = Get(name);
@@ -620,6 +672,26 @@ void GraphOptimizerManager::Init(void)
     opt->name = "Relu6";
     opt->optimizer = graph_opt_t(GraphFuseRelu6);
     Add(opt->name, opt);
+
+    opt = new GraphOptimizer();
+    opt->name = "PadFold";
+    opt->optimizer = graph_opt_t(GraphFoldPad);
+    Add(opt->name, opt);
+
+    opt = new GraphOptimizer();
+    opt->name = "ConvEltwise";
+    opt->optimizer = graph_opt_t(GraphFuseConvEltwise);
+    Add(opt->name, opt);
+
+    opt = new GraphOptimizer();
+    opt->name = "ConvActivation";
+    opt->optimizer = graph_opt_t(GraphFuseConvActivation);
+    Add(opt->name, opt);
+
+    opt = new GraphOptimizer();
+    opt->name = "ReshapeChain";
+    opt->optimizer = graph_opt_t(GraphMergeReshapeChain);
+    Add(opt->name, opt);
 }
 
 static bool NodeInGraph(Node* node, Graph* graph)
@@ -673,6 +745,9 @@ static bool GraphFuseConvReLuCommon(Graph* graph, GraphOptimizer* opt, bool relu
 
         if(!NodeInGraph(conv_node, graph))
             continue;
+        // the relu would run before the fused residual sum
+        if(conv_node->ExistAttr(ATTR_FUSED_EPILOGUE))
+            continue;
         // if parents has muti_consumer: not fuse
         Tensor* conv_otensor = conv_node->GetOutputTensor(0);
         if(conv_otensor->consumer.size() > 1)
@@ -775,4 +850,590 @@ static bool GraphFuseConvReLu6(Graph* graph, GraphOptimizer* opt)
     return GraphFuseConvReLuCommon(graph, opt, true);
 }
 
+static bool IsGraphOutput(Node* node, Graph* graph)
+{
+    for(unsigned int i = 0; i < graph->output_nodes.size(); i++)
+    {
+        if(graph->output_nodes[i] == node)
+            return true;
+    }
+
+    return false;
+}
+
+/* the producer of the single output of node, if it is an op_name node in graph which only feeds node */
+static Node* GetFusableProducer(Graph* graph, Node* node, int input_idx, const std::string& op_name)
+{
+    Tensor* tensor = node->GetInputTensor(input_idx);
+
+    if(tensor->GetType() != kVarTensor || tensor->producer == nullptr || tensor->consumer.size() != 1)
+        return nullptr;
+
+    Node* producer = tensor->producer->owner;
+
+    if(producer->GetOp()->GetName() != op_name || producer->GetOutputNum() != 1)
+        return nullptr;
+
+    if(!NodeInGraph(producer, graph) || IsGraphOutput(producer, graph))
+        return nullptr;
+
+    return producer;
+}
+
+/* the epilogue passes only handle FP32 NCHW tensors */
+static bool IsFP32NCHW(Tensor* tensor)
+{
+    return tensor->GetDataType() == TENGINE_DT_FP32 && tensor->GetShape().GetDataLayout() == TENGINE_LAYOUT_NCHW;
+}
+
+static void AddConstProducers(Subgraph* sub, Node* node)
+{
+    for(unsigned int i = 1; i < node->GetInputNum(); i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+
+        if(tensor->GetType() == kConstTensor)
+            sub->seq_nodes.push_back(tensor->producer->owner);
+    }
+}
+
+/*
+ * a copy of orig_node named first-orig_node, which reads input and writes the output of last.
+ * the other inputs of orig_node are kept at their index, const ones through new const nodes
+ */
+/* Operator::Clone() parses the param from the op attrs again, which misses the items set by the C API */
+static Operator* CloneFusedOp(Operator* orig_op)
+{
+    Operator* op = OpManager::CreateOp(orig_op->GetName());
+
+    if(orig_op->GetName() == "Convolution")
+        *dynamic_cast<Convolution*>(op)->GetParam() = *dynamic_cast<Convolution*>(orig_op)->GetParam();
+    else
+        *dynamic_cast<Pooling*>(op)->GetParam() = *dynamic_cast<Pooling*>(orig_op)->GetParam();
+
+    return op;
+}
+
+static Node* CloneFusedNode(Subgraph* fused, Node* orig_node, Node* first, Node* last, Tensor* input)
+{
+    std::string node_name = first->GetName() + "-" + last->GetName();
+
+    Node* fused_node = new Node(node_name);
+
+    fused_node->SetDynamicShape(orig_node->IsDynamicShape());
+    fused_node->SetOp(CloneFusedOp(orig_node->GetOp()));
+    fused_node->MergeAttr(orig_node);
+
+    if(last != orig_node)
+        fused_node->MergeAttr(last);
+
+    fused_node->AddOutputTensor(last->GetOutputTensor(0));
+    fused_node->AddInputTensor(input);
+
+    fused->seq_nodes.push_back(fused_node);
+    fused->input_nodes.push_back(fused_node);
+    fused->output_nodes.push_back(fused_node);
+    fused->SetNodeOwner(fused_node);
+
+    for(unsigned int i = 1; i < orig_node->GetInputNum(); i++)
+    {
+        Tensor* tensor = orig_node->GetInputTensor(i);
+
+        if(tensor->GetType() == kConstTensor)
+            AddConstNodeToSubGraph(fused, tensor, fused_node, i);
+        else
+            fused_node->AddInputTensor(tensor);
+    }
+
+    return fused_node;
+}
+
+/* the extra inputs of a fused convolution start at 3, so that a missing bias becomes a zero one */
+static void AddZeroBias(Subgraph* fused, Node* conv_node)
+{
+    if(conv_node->GetInputNum() > 2)
+        return;
+
+    int channel_num = conv_node->GetInputTensor(1)->GetShape().Shape(0);
+
+    Tensor* bias_tensor = new Tensor(conv_node->GetName() + ".bias.zero");
+    std::vector<int> dims{channel_num};
+
+    TShape bias_shape;
+    bias_shape.SetDim(dims);
+
+    bias_tensor->Reshape(bias_shape);
+    bias_tensor->SetType(kConstTensor);
+
+    void* bias_mem = malloc(channel_num * sizeof(float) + 128);
+
+    memset(bias_mem, 0, channel_num * sizeof(float));
+    bias_tensor->SetMemAddr(bias_mem);
+
+    AddConstNodeToSubGraph(fused, bias_tensor, conv_node, 2);
+
+    delete bias_tensor;
+
+    conv_node->GetInputTensor(2)->SetAttr("free_mem", 1);
+}
+
+static void ReplaceSubgraphs(Graph* graph, std::vector<Subgraph*>& orig_sub, std::vector<Subgraph*>& fused_sub)
+{
+    for(unsigned int i = 0; i < orig_sub.size(); i++)
+    {
+        graph->Replace(orig_sub[i], fused_sub[i]);
+
+        delete orig_sub[i];
+        delete fused_sub[i];
+    }
+}
+
+/*
+ * the graph optimizer: a constant Pad of H and W folded into the padding of the next
+ * Convolution or max Pooling. The max pooling ignores its padding, so that a zero Pad is only
+ * folded there when the padded data is not negative, e.g. just after a relu
+ */
+static bool PadIsNotNegative(Tensor* tensor, float pad_value)
+{
+    if(pad_value <= -FLT_MAX)
+        return true;
+
+    if(pad_value != 0.f || tensor->producer == nullptr)
+        return false;
+
+    Node* producer = tensor->producer->owner;
+    Operator* op = producer->GetOp();
+
+    if(producer->ExistAttr(ATTR_FUSED_EPILOGUE))
+        return false;
+
+    if(op->GetName() == "ReLu")
+        return dynamic_cast<ReLu*>(op)->GetParam()->negative_slope == 0.f;
+
+    if(op->GetName() == "ReLu6")
+        return true;
+
+    if(op->GetName() == "Convolution")
+    {
+        int activation = dynamic_cast<Convolution*>(op)->GetParam()->activation;
+
+        return activation == ActRELU || activation == ActRELU6;
+    }
+
+    return false;
+}
+
+static bool GraphFoldPad(Graph* graph, GraphOptimizer* opt)
+{
+    int node_number = graph->seq_nodes.size();
+    std::vector<Subgraph*> orig_sub;
+    std::vector<Subgraph*> fused_sub;
+
+    for(int i = 0; i < node_number; i++)
+    {
+        Node* node = graph->seq_nodes[i];
+        Operator* op = node->GetOp();
+        bool is_conv = (op->GetName() == "Convolution");
+
+        if(!is_conv && op->GetName() != "Pooling")
+            continue;
+
+        Node* pad_node = GetFusableProducer(graph, node, 0, "Pad");
+
+        if(pad_node == nullptr || pad_node->GetInputNum() != 1 ||
+           pad_node->GetOutputTensor(0)->GetShape().GetDataLayout() != TENGINE_LAYOUT_NCHW)
+            continue;
+
+        PadParam* pad = dynamic_cast<Pad*>(pad_node->GetOp())->GetParam();
+
+        if(pad->mode != 0 || pad->pad_0_h || pad->pad_0_w || pad->pad_1_h || pad->pad_1_w || pad->pad_2_h < 0 ||
+           pad->pad_2_w < 0 || pad->pad_3_h < 0 || pad->pad_3_w < 0)
+            continue;
+
+        /* pad_2 is H and pad_3 is W, _h is the leading side and _w the trailing side */
+        if(is_conv)
+        {
+            ConvParam* param = dynamic_cast<Convolution*>(op)->GetParam();
+
+            /* the x86 kernels assume the same padding on both sides */
+            if(pad->value != 0.f || param->pad_h0 < 0 || param->pad_w0 < 0 ||
+               param->pad_h0 + pad->pad_2_h != param->pad_h1 + pad->pad_2_w ||
+               param->pad_w0 + pad->pad_3_h != param->pad_w1 + pad->pad_3_w)
+                continue;
+        }
+        else
+        {
+            PoolParam* param = dynamic_cast<Pooling*>(op)->GetParam();
+
+            if(param->alg != kPoolMax || param->global || param->caffe_flavor || param->pad_h0 || param->pad_w0 ||
+               pad->pad_2_h != pad->pad_2_w || pad->pad_3_h != pad->pad_3_w || pad->pad_2_h >= param->kernel_h ||
+               pad->pad_3_h >= param->kernel_w)
+                continue;
+
+            if(!PadIsNotNegative(pad_node->GetInputTensor(0), pad->value))
+                continue;
+        }
+
+        Subgraph* orig = new Subgraph("pad_fold");
+
+        orig->seq_nodes.push_back(pad_node);
+        orig->seq_nodes.push_back(node);
+        orig->input_nodes.push_back(pad_node);
+        orig->output_nodes.push_back(node);
+
+        AddConstProducers(orig, node);
+
+        Subgraph* fused = new Subgraph("fused");
+        Node* fused_node = CloneFusedNode(fused, node, pad_node, node, pad_node->GetInputTensor(0));
+        Operator* fused_op = fused_node->GetOp();
+
+        if(is_conv)
+        {
+            ConvParam* param = dynamic_cast<Convolution*>(fused_op)->GetParam();
+
+            param->pad_h0 += pad->pad_2_h;
+            param->pad_h1 += pad->pad_2_w;
+            param->pad_w0 += pad->pad_3_h;
+            param->pad_w1 += pad->pad_3_w;
+        }
+        else
+        {
+            PoolParam* param = dynamic_cast<Pooling*>(fused_op)->GetParam();
+
+            param->pad_h0 = param->pad_h1 = pad->pad_2_h;
+            param->pad_w0 = param->pad_w1 = pad->pad_3_h;
+        }
+
+        orig_sub.push_back(orig);
+        fused_sub.push_back(fused);
+    }
+
+    ReplaceSubgraphs(graph, orig_sub, fused_sub);
+
+    return true;
+}
+
+/* a FP32 convolution which only feeds its consumer and has no fused epilogue yet */
+static Node* GetEpilogueConv(Graph* graph, Node* node, int input_idx)
+{
+    Node* conv_node = GetFusableProducer(graph, node, input_idx, "Convolution");
+
+    if(conv_node == nullptr || conv_node->GetInputNum() < 2 || !IsFP32NCHW(conv_node->GetOutputTensor(0)))
+        return nullptr;
+
+    return conv_node;
+}
+
+/* the graph optimizer: conv + eltwise sum, the other input of the sum is added in the conv epilogue */
+static bool GraphFuseConvEltwise(Graph* graph, GraphOptimizer* opt)
+{
+    int node_number = graph->seq_nodes.size();
+    std::vector<Subgraph*> orig_sub;
+    std::vector<Subgraph*> fused_sub;
+
+    for(int i = 0; i < node_number; i++)
+    {
+        Node* node = graph->seq_nodes[i];
+        Operator* op = node->GetOp();
+
+        if(op->GetName() != "Eltwise" || node->GetInputNum() != 2)
+            continue;
+
+        if(dynamic_cast<Eltwise*>(op)->GetParam()->type != ELT_SUM)
+            continue;
+
+        Tensor* input0 = node->GetInputTensor(0);
+        Tensor* input1 = node->GetInputTensor(1);
+
+        if(input0->GetType() != kVarTensor || input1->GetType() != kVarTensor ||
+           input0->GetShape().GetDim() != input1->GetShape().GetDim())
+            continue;
+
+        /* prefer the later conv, the other branch is ready by then */
+        Node* conv_node = nullptr;
+        int conv_idx = -1;
+
+        for(int k = 0; k < 2; k++)
+        {
+            Node* cand = GetEpilogueConv(graph, node, k);
+
+            if(cand == nullptr || cand->ExistAttr(ATTR_FUSED_EPILOGUE))
+                continue;
+
+            if(conv_node == nullptr || cand->GetNodeIndex() > conv_node->GetNodeIndex())
+            {
+                conv_node = cand;
+                conv_idx = k;
+            }
+        }
+
+        if(conv_node == nullptr)
+            continue;
+
+        Tensor* residual = node->GetInputTensor(1 - conv_idx);
+
+        Subgraph* orig = new Subgraph("conv_eltwise");
+
+        orig->seq_nodes.push_back(conv_node);
+        orig->seq_nodes.push_back(node);
+        orig->input_nodes.push_back(conv_node);
+        orig->output_nodes.push_back(node);
+
+        AddConstProducers(orig, conv_node);
+
+        Subgraph* fused = new Subgraph("fused");
+        Node* fused_node = CloneFusedNode(fused, conv_node, conv_node, node, conv_node->GetInputTensor(0));
+
+        AddZeroBias(fused, fused_node);
+
+        FusedEpilogue ep;
+
+        ep.residual_idx = fused_node->GetInputNum();
+        fused_node->AddInputTensor(residual);
+        fused_node->SetAttr(ATTR_FUSED_EPILOGUE, ep);
+
+        orig_sub.push_back(orig);
+        fused_sub.push_back(fused);
+    }
+
+    ReplaceSubgraphs(graph, orig_sub, fused_sub);
+
+    return true;
+}
+
+/*
+ * the graph optimizer: conv + PReLU/LeakyReLU/HardSwish/Sigmoid into the conv epilogue.
+ * ReLU and ReLU6 go to ConvParam::activation in ConvReLu, except after a fused residual sum
+ */
+static bool GetEpilogueAct(Node* node, FusedEpilogue& ep, bool has_residual)
+{
+    Operator* op = node->GetOp();
+    const std::string& name = op->GetName();
+
+    if(node->GetInputNum() != 1 && name != "PReLU")
+        return false;
+
+    if(name == "ReLu")
+    {
+        float slope = dynamic_cast<ReLu*>(op)->GetParam()->negative_slope;
+
+        if(slope == 0.f && !has_residual)
+            return false;
+
+        ep.act_type = slope == 0.f ? kFusedActReLU : kFusedActLeakyReLU;
+        ep.alpha = slope;
+    }
+    else if(name == "ReLu6")
+    {
+        if(!has_residual)
+            return false;
+
+        ep.act_type = kFusedActReLU6;
+    }
+    else if(name == "Hardswish")
+    {
+        HardswishParam* param = dynamic_cast<Hardswish*>(op)->GetParam();
+
+        ep.act_type = kFusedActHardSwish;
+        ep.alpha = param->alpha;
+        ep.beta = param->beta;
+    }
+    else if(name == "Sigmoid")
+        ep.act_type = kFusedActSigmoid;
+    else if(name == "PReLU")
+    {
+        if(node->GetInputNum() != 2 || node->GetInputTensor(1)->GetType() != kConstTensor)
+            return false;
+
+        ep.act_type = kFusedActPReLU;
+    }
+    else
+        return false;
+
+    return true;
+}
+
+static bool GraphFuseConvActivation(Graph* graph, GraphOptimizer* opt)
+{
+    int node_number = graph->seq_nodes.size();
+    std::vector<Subgraph*> orig_sub;
+    std::vector<Subgraph*> fused_sub;
+
+    for(int i = 0; i < node_number; i++)
+    {
+        Node* node = graph->seq_nodes[i];
+
+        if(node->GetInputNum() == 0 || node->GetOutputNum() != 1)
+            continue;
+
+        Node* conv_node = GetEpilogueConv(graph, node, 0);
+
+        if(conv_node == nullptr || !IsFP32NCHW(node->GetOutputTensor(0)))
+            continue;
+
+        FusedEpilogue ep;
+
+        if(conv_node->ExistAttr(ATTR_FUSED_EPILOGUE))
+            ep = any_cast<FusedEpilogue>(conv_node->GetAttr(ATTR_FUSED_EPILOGUE));
+
+        if(ep.act_type != kFusedActNone || !GetEpilogueAct(node, ep, ep.residual_idx >= 0))
+            continue;
+
+        Tensor* slope = nullptr;
+
+        if(ep.act_type == kFusedActPReLU)
+        {
+            int channel_num = conv_node->GetOutputTensor(0)->GetShape().GetC();
+
+            slope = node->GetInputTensor(1);
+
+            /* one slope for all channels is a leaky relu */
+            if(slope->GetShape().GetSize() == 1)
+            {
+                ep.act_type = kFusedActLeakyReLU;
+                ep.alpha = (( float* )get_tensor_mem(slope))[0];
+                slope = nullptr;
+            }
+            else if(slope->GetShape().GetSize() != channel_num)
+                continue;
+        }
+
+        Subgraph* orig = new Subgraph("conv_activation");
+
+        orig->seq_nodes.push_back(conv_node);
+        orig->seq_nodes.push_back(node);
+        orig->input_nodes.push_back(conv_node);
+        orig->output_nodes.push_back(node);
+
+        AddConstProducers(orig, conv_node);
+        AddConstProducers(orig, node);
+
+        Subgraph* fused = new Subgraph("fused");
+        Node* fused_node = CloneFusedNode(fused, conv_node, conv_node, node, conv_node->GetInputTensor(0));
+
+        if(slope)
+        {
+            AddZeroBias(fused, fused_node);
+
+            ep.slope_idx = fused_node->GetInputNum();
+            AddConstNodeToSubGraph(fused, slope, fused_node, ep.slope_idx);
+        }
+
+        fused_node->SetAttr(ATTR_FUSED_EPILOGUE, ep);
+
+        orig_sub.push_back(orig);
+        fused_sub.push_back(fused);
+    }
+
+    ReplaceSubgraphs(graph, orig_sub, fused_sub);
+
+    return true;
+}
+
+/* the graph optimizer: a chain of Reshape/Flatten/Squeeze nodes becomes one Reshape */
+static bool IsReshapeOp(Node* node)
+{
+    const std::string& name = node->GetOp()->GetName();
+
+    if(name != "Reshape" && name != "Flatten" && name != "Squeeze")
+        return false;
+
+    return node->GetInputNum() == 1 && node->GetOutputNum() == 1 && !node->IsDynamicShape();
+}
+
+static Node* GetReshapeProducer(Graph* graph, Node* node)
+{
+    Tensor* tensor = node->GetInputTensor(0);
+
+    if(tensor->producer == nullptr)
+        return nullptr;
+
+    Node* producer = tensor->producer->owner;
+
+    if(!IsReshapeOp(producer))
+        return nullptr;
+
+    return GetFusableProducer(graph, node, 0, producer->GetOp()->GetName());
+}
+
+static bool GraphMergeReshapeChain(Graph* graph, GraphOptimizer* opt)
+{
+    int node_number = graph->seq_nodes.size();
+    std::vector<Subgraph*> orig_sub;
+    std::vector<Subgraph*> fused_sub;
+
+    for(int i = 0; i < node_number; i++)
+    {
+        Node* last = graph->seq_nodes[i];
+
+        if(!IsReshapeOp(last))
+            continue;
+
+        /* start from the end of a chain only */
+        Tensor* output = last->GetOutputTensor(0);
+
+        if(output->consumer.size() == 1 && IsReshapeOp(output->consumer[0]->owner) &&
+           GetReshapeProducer(graph, output->consumer[0]->owner) == last)
+            continue;
+
+        std::vector<Node*> chain{last};
+        Node* first = last;
+
+        while(Node* producer = GetReshapeProducer(graph, first))
+        {
+            chain.push_back(producer);
+            first = producer;
+        }
+
+        if(chain.size() < 2)
+            continue;
+
+        const std::vector<int>& in_dims = first->GetInputTensor(0)->GetShape().GetDim();
+        std::vector<int> out_dims = output->GetShape().GetDim();
+
+        if(in_dims.empty() || out_dims.empty())
+            continue;
+
+        /* keep the batch dimension following the input */
+        if(out_dims[0] == in_dims[0])
+            out_dims[0] = 0;
+
+        Subgraph* orig = new Subgraph("reshape_chain");
+
+        for(auto ir = chain.rbegin(); ir != chain.rend(); ir++)
+            orig->seq_nodes.push_back(*ir);
+
+        orig->input_nodes.push_back(first);
+        orig->output_nodes.push_back(last);
+
+        Subgraph* fused = new Subgraph("fused");
+        Node* fused_node = new Node(first->GetName() + "-" + last->GetName());
+        Operator* op = OpManager::CreateOp("Reshape");
+        ReshapeParam* param = dynamic_cast<Reshape*>(op)->GetParam();
+
+        param->re_shape = out_dims;
+        param->reverse = false;
+        param->is_mxnet = false;
+        param->is_onnx = false;
+        param->dim_size = out_dims.size();
+
+        fused_node->SetOp(op);
+        fused_node->MergeAttr(first);
+        fused_node->AddInputTensor(first->GetInputTensor(0));
+        fused_node->AddOutputTensor(output);
+
+        fused->seq_nodes.push_back(fused_node);
+        fused->input_nodes.push_back(fused_node);
+        fused->output_nodes.push_back(fused_node);
+        fused->SetNodeOwner(fused_node);
+
+        orig_sub.push_back(orig);
+        fused_sub.push_back(fused);
+    }
+
+    ReplaceSubgraphs(graph, orig_sub, fused_sub);
+
+    return true;
+}
+
 }    // namespace TEngine
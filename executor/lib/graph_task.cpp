@@ -33,6 +33,7 @@
 #include "graph_executor.hpp"
 #include "dev_scheduler.hpp"
 #include "graph_perf.hpp"
+#include "graph_profiler.hpp"
 
 namespace TEngine {
 
@@ -563,7 +564,8 @@ bool GraphTask::GetGraphPerfAttr(const char* name, void* val, int size)
 
 bool GraphTask::SetAttr(const char* name, const void* val, int size)
 {
-    if(!strncmp(name, ATTR_GRAPH_PERF_STAT, strlen(ATTR_GRAPH_PERF_STAT)))
+    if(!strncmp(name, ATTR_GRAPH_PERF_STAT, strlen(ATTR_GRAPH_PERF_STAT)) ||
+       !strncmp(name, ATTR_GRAPH_PROFILER, strlen(ATTR_GRAPH_PROFILER)))
     {
         return SetGraphPerfAttr(name, val, size);
     }
@@ -33,6 +33,16 @@ namespace TEngine {
 
 static std::mutex node_dump_lock;
 
+void* NodeOps::LookupInputMem(Node* node, int idx)
+{
+    return get_tensor_mem(node->GetInputTensor(idx));
+}
+
+void* NodeOps::LookupOutputMem(Node* node, int idx)
+{
+    return get_tensor_mem(node->GetOutputTensor(idx));
+}
+
 bool NodeOps::EnableDump(Node* node)
 {
     dump_enabled = true;
@@ -250,7 +260,7 @@ NodeOps* NodeOpsRegistryManager::FindNodeOps(const CPUInfo* cpu_info, Node* node
     return ops;
 }
 
-NodeOps* NodeOpsRegistryManager::RealFindNodeOps(const CPUInfo* cpu_info, Node* node)
+NodeOps* NodeOpsRegistryManager::RealFindNodeOps(const CPUInfo* cpu_info, Node* node, bool search_ref)
 {
     NodeOps* ops;
 
@@ -304,6 +314,8 @@ NodeOps* NodeOpsRegistryManager::RealFindNodeOps(const CPUInfo* cpu_info, Node*
         return ops;
 
     // the final search: reference
+    if(!search_ref)
+        return nullptr;
 
     ops = FindNodeOps(REF_REGISTRY_NAME, cpu_info, node);
 
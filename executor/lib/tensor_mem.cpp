@@ -32,12 +32,7 @@ void* get_tensor_mem(const Tensor* tensor)
     if(tensor->GetType() == kConstTensor)
         return tensor->GetMemAddr();
 
-    TensorMemPtr ptr;
-
-    if(get_tensor_memptr(tensor, ptr) && ptr.get() != nullptr)
-        return ptr.get()->GetMem();
-
-    return nullptr;
+    return tensor->GetMemSlot();
 }
 
 int get_tensor_mem_size(const Tensor* tensor)
@@ -45,23 +40,17 @@ int get_tensor_mem_size(const Tensor* tensor)
     if(tensor->GetType() == kConstTensor)
         return tensor->GetTotalSize();
 
-    TensorMemPtr ptr;
-
-    if(get_tensor_memptr(tensor, ptr) && ptr.get() != nullptr)
-        return ptr.get()->GetSize();
-    else
-        return 0;
+    return tensor->GetMemSlotSize();
 }
 
 bool get_tensor_memptr(const Tensor* tensor, TensorMemPtr& ptr)
 {
-    if(tensor->ExistAttr("tensor_mem"))
-    {
-        ptr = any_cast<TensorMemPtr>(tensor->GetAttr("tensor_mem"));
-        return true;
-    }
+    if(tensor->GetMemBinding().get() == nullptr)
+        return false;
 
-    return false;
+    ptr = tensor->GetMemBinding();
+
+    return true;
 }
 
 bool set_tensor_mem(Tensor* tensor, void* addr, int size, mem_release_t releaser)
@@ -94,7 +83,13 @@ bool set_tensor_mem(Tensor* tensor, void* addr, int size, mem_release_t releaser
 
 void set_tensor_mem(Tensor* tensor, const TensorMemPtr& ptr)
 {
-    tensor->SetAttr("tensor_mem", ptr);
+    if(ptr.get() == nullptr)
+    {
+        tensor->UnbindMemSlot();
+        return;
+    }
+
+    tensor->BindMemSlot(ptr, ptr->GetMem(), ptr->GetSize());
 }
 
 void free_tensor_mem(Tensor* tensor)
@@ -102,8 +97,7 @@ void free_tensor_mem(Tensor* tensor)
     if(tensor->GetType() == kConstTensor)
         return;
 
-    if(tensor->ExistAttr("tensor_mem"))
-        tensor->RemoveAttr("tensor_mem");
+    tensor->UnbindMemSlot();
 }
 
 }    // namespace TEngine
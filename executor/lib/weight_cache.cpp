@@ -0,0 +1,336 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <cstring>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+#include "logger.hpp"
+#include "cpu_info.hpp"
+#include "weight_cache.hpp"
+
+namespace TEngine {
+
+#define WEIGHT_CACHE_MAGIC "TMWCACHE"
+
+/* 64 bytes, so that the blob keeps the alignment of the page */
+struct WeightCacheHeader
+{
+    char magic[8];
+    uint64_t blob_size;
+    char reserved[48];
+};
+
+struct WeightMap
+{
+    void* base;
+    size_t size;
+};
+
+struct SharedWeight
+{
+    void* addr;
+    int ref;
+};
+
+static std::mutex map_lock;
+static std::map<void*, WeightMap> mapped_blobs;
+
+/* the blobs in use, by key and by address */
+static std::mutex share_lock;
+static std::map<std::string, SharedWeight> shared_blobs;
+static std::map<void*, std::string> shared_keys;
+
+static const char* GetCacheDir(void)
+{
+    static const char* cache_dir = std::getenv("TENGINE_WEIGHT_CACHE");
+
+    return cache_dir && cache_dir[0] ? cache_dir : nullptr;
+}
+
+/* the cpu features the kernels are built with */
+static const char* GetBuildISA(void)
+{
+#if defined(__aarch64__)
+    return "arm64";
+#elif defined(__arm__)
+    return "arm32";
+#elif defined(__AVX2__) && defined(__FMA__)
+    return "x86.avx2.fma";
+#elif defined(__AVX__)
+    return "x86.avx";
+#else
+    return "x86.sse";
+#endif
+}
+
+/* two 64 bit lanes of the xxhash64 round, it only has to tell the weights of different models apart */
+static inline uint64_t HashRound(uint64_t h, uint64_t w)
+{
+    h += w * 0xC2B2AE3D27D4EB4FULL;
+    h = (h << 31) | (h >> 33);
+
+    return h * 0x9E3779B185EBCA87ULL;
+}
+
+static inline uint64_t HashFinal(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    h *= 0x165667B19E3779F9ULL;
+    h ^= h >> 32;
+
+    return h;
+}
+
+static void HashBytes(uint64_t* h, const void* data, size_t size)
+{
+    const uint8_t* p = ( const uint8_t* )data;
+    size_t i = 0;
+
+    for(; i + 16 <= size; i += 16)
+    {
+        uint64_t w[2];
+
+        memcpy(w, p + i, 16);
+        h[0] = HashRound(h[0], w[0]);
+        h[1] = HashRound(h[1], w[1]);
+    }
+
+    for(; i < size; i++)
+        h[i & 1] = HashRound(h[i & 1], p[i]);
+
+    h[0] = HashRound(h[0], size);
+}
+
+bool WeightCacheEnabled(void)
+{
+    return GetCacheDir() != nullptr;
+}
+
+bool WeightShareEnabled(void)
+{
+    static const char* env = std::getenv("TENGINE_WEIGHT_SHARE");
+
+    return env && env[0] == '1';
+}
+
+std::string GetWeightCacheKey(const CPUInfo* cpu_info, const char* impl, const void* weight, int weight_size,
+                              const std::vector<int>& layout)
+{
+    uint64_t h[2] = {0x60EA27EEADC0B5D6ULL, 0x61C8864E7A143579ULL};
+    std::string cpu = GetBuildISA();
+
+    if(cpu_info)
+    {
+        int master = cpu_info->GetMasterCPU();
+        const char* arch = cpu_info->GetCPUArchString(master);
+        const char* model = cpu_info->GetCPUModelString(master);
+
+        cpu = cpu + "/" + (arch ? arch : "") + "/" + (model ? model : "");
+    }
+
+    HashBytes(h, cpu.c_str(), cpu.size());
+    HashBytes(h, layout.data(), layout.size() * sizeof(int));
+    HashBytes(h, weight, weight_size);
+
+    char hex[40];
+
+    snprintf(hex, sizeof(hex), "%016llx%016llx", ( unsigned long long )HashFinal(h[0]),
+             ( unsigned long long )HashFinal(h[1] ^ h[0]));
+
+    return std::string(impl) + "-" + hex;
+}
+
+static std::string GetCachePath(const std::string& key)
+{
+    return std::string(GetCacheDir()) + "/" + key + ".bin";
+}
+
+static void* MapCachedWeight(const std::string& key, int size)
+{
+    if(!WeightCacheEnabled())
+        return nullptr;
+
+    std::string path = GetCachePath(key);
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if(fd < 0)
+        return nullptr;
+
+    struct stat st;
+    size_t file_size = sizeof(WeightCacheHeader) + size;
+
+    if(fstat(fd, &st) < 0 || ( size_t )st.st_size != file_size)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* base = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if(base == MAP_FAILED)
+        return nullptr;
+
+    WeightCacheHeader* header = ( WeightCacheHeader* )base;
+
+    if(memcmp(header->magic, WEIGHT_CACHE_MAGIC, sizeof(header->magic)) || header->blob_size != ( uint64_t )size)
+    {
+        LOG_WARN() << "weight cache: ignore the broken blob " << path << "\n";
+        munmap(base, file_size);
+        return nullptr;
+    }
+
+    void* addr = ( char* )base + sizeof(WeightCacheHeader);
+
+    map_lock.lock();
+    mapped_blobs[addr] = {base, file_size};
+    map_lock.unlock();
+
+    return addr;
+}
+
+static bool SaveCachedWeight(const std::string& key, const void* blob, int size)
+{
+    if(!WeightCacheEnabled())
+        return false;
+
+    mkdir(GetCacheDir(), 0755);
+
+    /* written aside and renamed, the processes started together may share the directory */
+    std::string path = GetCachePath(key);
+    std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+
+    FILE* fp = fopen(tmp_path.c_str(), "wb");
+
+    if(fp == nullptr)
+    {
+        LOG_WARN() << "weight cache: cannot create " << tmp_path << "\n";
+        return false;
+    }
+
+    WeightCacheHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WEIGHT_CACHE_MAGIC, sizeof(header.magic));
+    header.blob_size = size;
+
+    bool ret = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(blob, size, 1, fp) == 1;
+
+    ret = (fclose(fp) == 0) && ret;
+
+    if(!ret || rename(tmp_path.c_str(), path.c_str()) < 0)
+    {
+        LOG_WARN() << "weight cache: failed to save " << path << "\n";
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool UnmapCachedWeight(void* addr)
+{
+    std::lock_guard<std::mutex> guard(map_lock);
+
+    auto ir = mapped_blobs.find(addr);
+
+    if(ir == mapped_blobs.end())
+        return false;
+
+    munmap(ir->second.base, ir->second.size);
+    mapped_blobs.erase(ir);
+
+    return true;
+}
+
+void* AcquireSharedWeight(const std::string& key, int size, const std::function<bool(void*)>& fill, bool memory_only)
+{
+    /* held while the blob is made, so the graphs prerun together wait for the first one instead of packing too */
+    std::lock_guard<std::mutex> guard(share_lock);
+
+    std::string blob_key = key + ":" + std::to_string(size);
+    auto ir = shared_blobs.find(blob_key);
+
+    if(ir != shared_blobs.end())
+    {
+        ir->second.ref++;
+        return ir->second.addr;
+    }
+
+    void* addr = memory_only ? nullptr : MapCachedWeight(key, size);
+
+    if(addr == nullptr)
+    {
+        if(posix_memalign(&addr, 64, size))
+            return nullptr;
+
+        if(!fill(addr))
+        {
+            std::free(addr);
+            return nullptr;
+        }
+
+        if(!memory_only)
+            SaveCachedWeight(key, addr, size);
+    }
+
+    shared_blobs[blob_key] = {addr, 1};
+    shared_keys[addr] = blob_key;
+
+    return addr;
+}
+
+bool ReleaseSharedWeight(void* addr)
+{
+    std::lock_guard<std::mutex> guard(share_lock);
+
+    auto ir = shared_keys.find(addr);
+
+    if(ir == shared_keys.end())
+        return false;
+
+    auto blob = shared_blobs.find(ir->second);
+
+    if(--blob->second.ref == 0)
+    {
+        if(!UnmapCachedWeight(addr))
+            std::free(addr);
+
+        shared_blobs.erase(blob);
+        shared_keys.erase(ir);
+    }
+
+    return true;
+}
+
+}    // namespace TEngine
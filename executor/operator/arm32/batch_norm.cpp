@@ -156,7 +156,7 @@ struct BNOps : public NodeOps
         float* scale_var_inv = any_cast<float*>(node->GetAttr("scale_var_inv"));
 
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int block = channel_num;
         block = block > 0 ? block : 1;
         int num_task = cpu_number < block ? cpu_number : block;
@@ -319,7 +319,7 @@ bool ConvDw_nhwc_float::Run(Node* node)
 {
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     //int cpu_number = 1;
     int pad_w0 = param->pad_w0;
     int pad_w1 = param->pad_w1;
@@ -225,7 +225,7 @@ bool Conv2dDepth::Run(Node* node)
     int input_size = input_c * input_h * input_w;
     int output_size = output_c * output_h * output_w;
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
 
     float* bias = nullptr;
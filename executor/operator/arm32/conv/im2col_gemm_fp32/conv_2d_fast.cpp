@@ -1066,6 +1066,9 @@ bool ConvFast::direct_3x3_run(Node* node)
 
 bool ConvFast::Run(Node* node)
 {
+    /* split over the aider group the graph runs on */
+    cpu_number = GetWorkerNumber();
+
     bool ret = RealRun(node);
 
     // if(ret && activation>0)
@@ -682,6 +682,9 @@ bool ConvFastNHWC::Reshape(Node* node)
 
 bool ConvFastNHWC::Run(Node* node)
 {
+    /* split over the aider group the graph runs on */
+    cpu_number = GetWorkerNumber();
+
     /* input */
     Tensor* input_tensor = node->GetInputTensor(0);
 
@@ -263,6 +263,9 @@ bool Conv2dWinograd::Prerun(Node* node)
 // run
 bool Conv2dWinograd::Run(Node* node)
 {
+    /* split over the aider group the graph runs on */
+    cpu_number = GetWorkerNumber();
+
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
 
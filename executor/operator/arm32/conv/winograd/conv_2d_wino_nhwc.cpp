@@ -217,6 +217,9 @@ bool Conv2dWinogradNHWC::Prerun(Node* node)
 // run
 bool Conv2dWinogradNHWC::Run(Node* node)
 {
+    /* split over the aider group the graph runs on */
+    cpu_number = GetWorkerNumber();
+
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
 
@@ -519,7 +519,7 @@ struct DeconvolutionOps : public MTNodeOps
         int input_cnt_l2 = L2_CACHE_SIZE / 4 / input_ch * 7 / 8;
         input_cnt_l2 = input_cnt_l2 > 4 ? (input_cnt_l2 & -4) : 4;
         
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int weight_size_g = ((weight_size + 3) & -4) * input_ch;
         for(int b = 0; b < batch; ++b)
         {
@@ -175,7 +175,7 @@ struct EltwiseOps : public NodeOps
 
 		int stride = ishape.GetH() * ishape.GetW();
 		int channel = ishape.GetC();
-		int cpu_number = cpu_info->GetCPUNumber();
+		int cpu_number = GetWorkerNumber();
 
 		for(int n = 0; n < batch_num; n++)
 		{
@@ -94,7 +94,7 @@ struct EluOps : public NodeOps
         float* data = ( float* )get_tensor_mem(input_tensor);
         float* out_data = ( float* )get_tensor_mem(output_tensor);
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int block = elem_num >> 8;
         block = block > 0 ? block : 1;
         int num_task = cpu_number < block ? cpu_number : block;
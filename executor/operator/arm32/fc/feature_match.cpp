@@ -213,7 +213,7 @@ struct FMOps : public MTNodeOps
     {
         Refresh(node);
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
 
         Tensor* tensor;
 
@@ -263,7 +263,7 @@ struct LRNOps : public NodeOps
         float bias = param->k;
         int local_size = param->local_size;
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int num_task = c < cpu_number ? c : cpu_number;
         int step = c / num_task;
         for(int i = 0; i < n; i++)
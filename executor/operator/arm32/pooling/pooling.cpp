@@ -178,7 +178,7 @@ struct PoolingOps : public MTNodeOps
 #endif
         int is_caffe = param_->caffe_flavor;
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int block = in_dim[1];
         block = block > 0 ? block : 1;
         int num_task = cpu_number < block ? cpu_number : block;
@@ -181,7 +181,7 @@ struct PoolingOps : public MTNodeOps
 #endif
         int is_caffe = param_->caffe_flavor;
         bool pooling_mt = exec_attr->pooling_mt;
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         if(in_dim[3] < 128)
             pooling_mt = false;
         for(int n = 0; n < in_dim[0]; n++)
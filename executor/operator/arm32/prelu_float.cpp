@@ -105,7 +105,7 @@ bool PreluOps::Run(Node* node)
     const Tensor* slope_tensor = node->GetInputTensor(1);
     float* slope = ( float* )get_tensor_mem(slope_tensor);
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     int block = channel_num ;
     block = block > 0 ? block : 1;
     int num_task = cpu_number < block ? cpu_number : block;
@@ -178,6 +178,9 @@ struct SoftmaxOps : public MTNodeOps
     }
     bool Run(Node* node)
     {
+        /* split over the aider group the graph runs on */
+        cpu_number = GetWorkerNumber();
+
         Tensor* input_tensor = node->GetInputTensor(0);
         Tensor* output_tensor = node->GetOutputTensor(0);
         const std::vector<int>& dims = input_tensor->GetShape().GetDim();
@@ -312,7 +312,7 @@ bool Conv2dDepthDilation::Run(Node* node)
     float* input_buf = ( float* )get_tensor_mem(input_tensor);
     float* output_buf = ( float* )get_tensor_mem(output_tensor);
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     int pad_h0 = param->pad_h0;
     // int pad_w0 = param->pad_w0;
     // int pad_h1 = param->pad_h1;
@@ -116,7 +116,7 @@ bool Conv2dDepthK5::Run(Node* node)
     float* input_buf = ( float* )get_tensor_mem(input_tensor);
     float* output_buf = ( float* )get_tensor_mem(output_tensor);
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     int stride_h = param->stride_h;
     int pad0 = param->pad_w0;
     int pad1 = param->pad_w1;
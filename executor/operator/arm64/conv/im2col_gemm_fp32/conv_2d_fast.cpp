@@ -921,7 +921,7 @@ bool ConvFast::direct_run(Node* node)
     if(output_chan % 16 != 0)
         return false;
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     int cpu_type;
 
     if(cpu_info->GetCPUModel(cpu_info->GetMasterCPU()) == CPU_A72)
@@ -1048,7 +1048,7 @@ bool ConvFast::Run(Node* node)
 
     float* kernel_interleaved = any_cast<float*>(node->GetAttr("kernel_interleaved"));
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
     if(pad_w0 == 1 && pad_h0 == 1 && kernel_x == 3 && kernel_y == 3 && stride_x == 1 && stride_y == 1 &&
        dilation_x == 1 && dilation_y == 1 && group == 1 && input_chan < output_chan && output_chan <= 160 &&
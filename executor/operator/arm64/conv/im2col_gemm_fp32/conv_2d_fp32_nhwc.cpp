@@ -720,7 +720,7 @@ bool ConvFastNHWC::Run(Node* node)
 
     float* kernel_interleaved = any_cast<float*>(node->GetAttr("kernel_interleaved"));
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     /* biases */
 
     float* biases = NULL;
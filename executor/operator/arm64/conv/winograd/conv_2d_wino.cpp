@@ -30,6 +30,7 @@
 #include "tensor_mem.hpp"
 #include "graph.hpp"
 #include "node_ops.hpp"
+#include "weight_cache.hpp"
 #include "operator/convolution.hpp"
 
 #include "wino_trans_ker.h"
@@ -218,14 +219,32 @@ bool Conv2dWinograd::Prerun(Node* node)
 
     int trans_ker_size = output_c * input_c * 36 * sizeof(float);
     float* kernel_org = ( float* )get_tensor_mem(kernel_tensor);
-    float* kernel_trans = ( float* )mem_alloc(trans_ker_size);
-    float* kernel_interleaved = ( float* )mem_alloc(trans_ker_size + 128);
+    float* kernel_interleaved = nullptr;
 
     // transform & interleave kernel
-    transform_kernel_f43_tile(kernel_org, kernel_trans, input_c, output_c);
-    interleave_kernel(kernel_trans, kernel_interleaved, output_c, input_c);
+    auto transform_kernel = [&](void* blob) {
+        float* kernel_trans = ( float* )mem_alloc(trans_ker_size);
+
+        transform_kernel_f43_tile(kernel_org, kernel_trans, input_c, output_c);
+        interleave_kernel(kernel_trans, ( float* )blob, output_c, input_c);
+        mem_free(kernel_trans);
+
+        return true;
+    };
+
+    if(WeightCacheEnabled() || WeightShareEnabled())
+    {
+        std::string cache_key = GetWeightCacheKey(cpu_info, "arm64.wino43", kernel_org,
+                                                  output_c * input_c * 9 * sizeof(float), {input_c, output_c});
+        kernel_interleaved = ( float* )AcquireSharedWeight(cache_key, trans_ker_size + 128, transform_kernel);
+    }
+
+    if(kernel_interleaved == nullptr)
+    {
+        kernel_interleaved = ( float* )mem_alloc(trans_ker_size + 128);
+        transform_kernel(kernel_interleaved);
+    }
     (*node)["kernel_interleaved"] = kernel_interleaved;
-    mem_free(kernel_trans);
 
     if(exec_attr->low_mem_mode)
     {
@@ -237,6 +256,9 @@ bool Conv2dWinograd::Prerun(Node* node)
 // run
 bool Conv2dWinograd::Run(Node* node)
 {
+    /* split over the aider group the graph runs on */
+    cpu_number = GetWorkerNumber();
+
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
     int pad_h0 = param->pad_h0;
@@ -497,7 +519,8 @@ bool Conv2dWinograd::Postrun(Node* node)
     if(node->ExistAttr("kernel_interleaved"))
     {
         addr = any_cast<float*>(node->GetAttr("kernel_interleaved"));
-        mem_free(addr);
+        if(!ReleaseSharedWeight(addr))
+            mem_free(addr);
         node->RemoveAttr("kernel_interleaved");
     }
     activation = 0;
@@ -243,7 +243,7 @@ bool Conv2dWinograd_1::Run(Node* node)
         bias_term = 1;
     }
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
     int cout_count16 = output_c/16;
     int cout_nn16 =  cout_count16*16;
 
@@ -255,7 +255,7 @@ bool Conv2dWinogradNHWC::Run(Node* node)
     int L2_n = L2_CACHE_SIZE * 0.3 / (ELEM_SIZE * input_c * sizeof(float));
     L2_n = L2_n > 16 ? (L2_n & -16) : 16;
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
     for(int n = 0; n < output_n; n++)
     {
@@ -517,7 +517,7 @@ struct DeconvolutionOps : public MTNodeOps
         input_cnt_l2 = input_cnt_l2 > 4 ? (input_cnt_l2 & -4) : 4;
 
         int weight_size_g = ((weight_size + 3) & -4) * input_ch;
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
 
         for(int b = 0; b < batch; ++b)
         {
@@ -975,7 +975,7 @@ bool DeConv2dDepth4x4::Run(Node* node)
     int output_size = output_c * output_h * output_w;
     int cg=input_c/group;
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
     float* bias = nullptr;
 
@@ -196,7 +196,7 @@ struct FCOps : public MTNodeOps
 
     bool Run(Node* node)
     {
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
 
         Tensor* tensor;
 
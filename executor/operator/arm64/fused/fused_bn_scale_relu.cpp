@@ -99,7 +99,7 @@ struct FusedOps : public MTNodeOps
         const float* input = ( const float* )get_tensor_mem(input_tensor);
         float* output = ( float* )get_tensor_mem(output_tensor);
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
 
         for(int i = 0; i < batch_number; i++)
         {
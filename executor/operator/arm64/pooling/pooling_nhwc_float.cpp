@@ -180,7 +180,7 @@ struct PoolingOps : public MTNodeOps
                 param_->pad_h0,param_->pad_w0,param_->pad_h1,param_->pad_w1);
 #endif
         int is_caffe = param_->caffe_flavor;
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         bool pooling_mt = exec_attr->pooling_mt;
 
         if(in_dim[3] < 128)
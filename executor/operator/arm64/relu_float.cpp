@@ -117,7 +117,7 @@ struct ReluOps : public NodeOps
         float* out_data = ( float* )get_tensor_mem(output_tensor);
         float negativeslope = param->negative_slope;
 
-        int cpu_number = cpu_info->GetCPUNumber();
+        int cpu_number = GetWorkerNumber();
         int block = elem_num >> 8;
         block = block > 0 ? block : 1;
         int num_task = cpu_number < block ? cpu_number : block;
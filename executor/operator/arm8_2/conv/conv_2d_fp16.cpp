@@ -726,7 +726,7 @@ bool ConvFP16::Run(Node* node)
     __fp16* kernel_interleaved = any_cast<__fp16*>(node->GetAttr("kernel_interleaved"));
     __fp16* col = any_cast<__fp16*>(node->GetAttr("col_buf"));
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
     /* biases */
     __fp16* biases = NULL;
@@ -298,7 +298,7 @@ bool Conv2dWinograd::Run(Node* node)
     int L3_n =L3_CACHE_SIZE*0.8/ (ELEM_SIZE * input_c * sizeof(__fp16));
     L3_n = L3_n > 16 ? (L3_n & -16) : 16;
 
-    int cpu_number = cpu_info->GetCPUNumber();
+    int cpu_number = GetWorkerNumber();
 
     for(int n = 0; n < output_n; n++)
     {
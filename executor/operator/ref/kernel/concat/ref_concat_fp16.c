@@ -57,7 +57,9 @@ static int ref_concat_fp16(const __fp16** in_data, __fp16* out_data, const struc
         for(int j = 0; j < param->input_counts; ++j)
         {
             int cp_size = param->input_shape[j].dim[axis] * in_size;
-            memcpy(output_ptr, in_data[j] + k * cp_size, cp_size * sizeof(__fp16));
+            /* the input may already be in place, see the zero-copy views of the memory planner */
+            if(output_ptr != in_data[j] + k * cp_size)
+                memcpy(output_ptr, in_data[j] + k * cp_size, cp_size * sizeof(__fp16));
             output_ptr += cp_size;
         }
     }
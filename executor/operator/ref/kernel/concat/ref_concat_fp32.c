@@ -57,7 +57,9 @@ static int ref_concat_fp32(const float** in_data, float* out_data, const struct
         for(int j = 0; j < param->input_counts; ++j)
         {
             int cp_size = param->input_shape[j].dim[axis] * in_size;
-            memcpy(output_ptr, in_data[j] + k * cp_size, cp_size * sizeof(float));
+            /* the input may already be in place, see the zero-copy views of the memory planner */
+            if(output_ptr != in_data[j] + k * cp_size)
+                memcpy(output_ptr, in_data[j] + k * cp_size, cp_size * sizeof(float));
             output_ptr += cp_size;
         }
     }
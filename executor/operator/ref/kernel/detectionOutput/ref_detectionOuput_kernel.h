@@ -28,6 +28,7 @@
 #include <stdint.h>
 
 #include "compiler_fp16.h"
+#include "detect_postproc.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,11 +54,53 @@ struct ddo_param
     float out_scale;
     float scale[3];
     std::vector<Box> bbox_rects;
+    bool fast_nms;
+    TEngine::post_parallel_t parallel;
 };
 
 typedef int (*ref_DetectionOutput_kernel_t)(const void* location, const void* confidence, const void* priorbox,
                                             std::vector<int> dims, ddo_param* param);
 
+/* per class NMS of the decoded boxes, with the scores as float */
+static int ref_DetectionOutput_nms(const float* confidence, const std::vector<Box>& boxes, ddo_param* param_)
+{
+    TEngine::MultiClassNmsParam nms_param;
+
+    nms_param.num_boxes = boxes.size();
+    nms_param.num_classes = param_->num_classes;
+    nms_param.first_class = 1;
+    nms_param.score_threshold = param_->confidence_threshold;
+    nms_param.top_k = param_->nms_top_k;
+    nms_param.iou_threshold = param_->nms_threshold;
+    nms_param.keep_top_k = param_->keep_top_k;
+    nms_param.fast_nms = param_->fast_nms;
+
+    auto decode = [&boxes](int i, float* rect) {
+        rect[0] = boxes[i].x0;
+        rect[1] = boxes[i].y0;
+        rect[2] = boxes[i].x1;
+        rect[3] = boxes[i].y1;
+
+        return true;
+    };
+
+    std::vector<TEngine::DetectBox> result;
+
+    TEngine::MultiClassNms(confidence, nms_param, decode, param_->parallel, result);
+
+    param_->bbox_rects.clear();
+
+    for(unsigned int i = 0; i < result.size(); i++)
+    {
+        const TEngine::DetectBox& r = result[i];
+        Box box = {r.x0, r.y0, r.x1, r.y1, r.class_idx, r.score};
+
+        param_->bbox_rects.push_back(box);
+    }
+
+    return 0;
+}
+
 #ifdef CONFIG_KERNEL_FP32
 #include "ref_detectionOutput_fp32.c"
 #endif
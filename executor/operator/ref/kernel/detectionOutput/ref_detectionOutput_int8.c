@@ -30,67 +30,16 @@ int ref_DetectionOutput_int8(const int8_t* location, const int8_t* confidence, c
 {
     const int num_priorx4 = dims[2];
     const int num_prior = num_priorx4 / 4;
-    const int num_classes = param_->num_classes;
-
-    const int8_t* loc_ptr = location;
-    const int8_t* conf_ptr = confidence;
-    const int8_t* prior_ptr = priorbox;
+    const int conf_size = num_prior * param_->num_classes;
 
     std::vector<Box> boxes(num_prior);
-    get_boxes_int8(boxes, num_prior, loc_ptr, prior_ptr, param_);
-
-    std::vector<std::vector<Box>> temp_all_box;
-    temp_all_box.resize(num_classes);
-
-    for(int i = 1; i < num_classes; i++)
-    {
-        std::vector<Box> class_box;
-        for(int j = 0; j < num_prior; j++)
-        {
-            float score = conf_ptr[j * num_classes + i] * param_->scale[1];
-            if(score > param_->confidence_threshold)
-            {
-                boxes[j].score = score;
-                boxes[j].class_idx = i;
-                class_box.push_back(boxes[j]);
-            }
-        }
-        // sort
-        std::sort(class_box.begin(), class_box.end(), [](const Box& a, const Box& b) { return a.score > b.score; });
+    get_boxes_int8(boxes, num_prior, location, priorbox, param_);
 
-        if(param_->nms_top_k < ( int )class_box.size())
-        {
-            class_box.resize(param_->nms_top_k);
-        }
-        // apply nms
-
-        std::vector<int> picked;
-        nms_sorted_bboxes(class_box, picked, param_->nms_threshold);
-        // select
-
-        for(int j = 0; j < ( int )picked.size(); j++)
-        {
-            int z = picked[j];
-            temp_all_box[i].push_back(class_box[z]);
-        }
-    }
+    std::vector<float> conf(conf_size);
+    for(int i = 0; i < conf_size; i++)
+        conf[i] = confidence[i] * param_->scale[1];
 
-    param_->bbox_rects.clear();
-    for(int i = 0; i < param_->num_classes; i++)
-    {
-        const std::vector<Box> class_bbox_rects = temp_all_box[i];
-        param_->bbox_rects.insert(param_->bbox_rects.end(), class_bbox_rects.begin(), class_bbox_rects.end());
-    }
-
-    // global sort inplace
-    std::sort(param_->bbox_rects.begin(), param_->bbox_rects.end(),
-              [](const Box& a, const Box& b) { return a.score > b.score; });
-
-    // keep_top_k
-    if(param_->keep_top_k < ( int )param_->bbox_rects.size())
-    {
-        param_->bbox_rects.resize(param_->keep_top_k);
-    }
+    ref_DetectionOutput_nms(conf.data(), boxes, param_);
 
     float max_value = 0.0f;
 
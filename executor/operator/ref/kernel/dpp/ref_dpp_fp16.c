@@ -15,14 +15,14 @@ int ref_dpp_fp16(const __fp16* input, const __fp16* score, const __fp16* anchor,
 #if !defined(__ARM_ARCH) || __ARM_ARCH < 8
     for(int i = 0; i < input_size; i++)
         input_f[i] = fp16_to_fp32(input[i]);
-    for(int i = 0; i < input_size; i++)
+    for(int i = 0; i < score_size; i++)
         score_f[i] = fp16_to_fp32(score[i]);
     for(int i = 0; i < input_size; i++)
         anchor_f[i] = fp16_to_fp32(anchor[i]);
 #else
     for(int i = 0; i < input_size; i++)
         input_f[i] = input[i];
-    for(int i = 0; i < input_size; i++)
+    for(int i = 0; i < score_size; i++)
         score_f[i] = score[i];
     for(int i = 0; i < input_size; i++)
         anchor_f[i] = anchor[i];
@@ -35,7 +35,7 @@ int ref_gru_fp32(float* input,float* output,gru_param* param)
     }
     else
     {
-        memset(init_h, 0x0, sizeof(param->batch_size * param->hidden_size * sizeof(float)));
+        memset(init_h, 0x0, param->batch_size * param->hidden_size * sizeof(float));
     }
     for(int i = 0; i < param->seq_lens; i++)
     {
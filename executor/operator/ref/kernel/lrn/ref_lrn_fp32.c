@@ -37,7 +37,13 @@ static int ref_lrn_fp32(const float* in_data, float* out_data, ref_lrn_param* pa
     int channel_size = h * w;
     int img_size = c * channel_size;
 
-    float* square = ( float* )(malloc(img_size * sizeof(float)));
+    /* only the channels around [c_first, c_last) are squared */
+    int c_first = param->channel_range[0];
+    int c_last = param->channel_range[1];
+    int sq_first = c_first - local_size / 2 > 0 ? c_first - local_size / 2 : 0;
+    int sq_last = c_last + local_size / 2 < c ? c_last + local_size / 2 : c;
+
+    float* square = ( float* )(malloc((sq_last - sq_first) * channel_size * sizeof(float)));
     float* accum_square = ( float* )(malloc(channel_size * sizeof(float)));
 
     for(int i = 0; i < n; i++)
@@ -45,14 +51,14 @@ static int ref_lrn_fp32(const float* in_data, float* out_data, ref_lrn_param* pa
         const float* img_base = in_data + i * img_size;
 
         /* get square value */
-        for(int j = 0; j < img_size; j++)
-            square[j] = img_base[j] * img_base[j] + bias;
+        for(int j = sq_first * channel_size; j < sq_last * channel_size; j++)
+            square[j - sq_first * channel_size] = img_base[j] * img_base[j] + bias;
 
         if(param->norm_region == 0) /* LRN_ACROSS_CHANNELS */
         {
             float alpha_over_size = alpha / local_size;
 
-            for(int j = 0; j < c; j++)
+            for(int j = c_first; j < c_last; j++)
             {
                 int c_start = j - local_size / 2;
                 int c_end = j + local_size / 2;
@@ -66,7 +72,7 @@ static int ref_lrn_fp32(const float* in_data, float* out_data, ref_lrn_param* pa
 
                     for(int n = 0; n < channel_size; n++)
                     {
-                        accum_square[n] += square[l * channel_size + n];
+                        accum_square[n] += square[(l - sq_first) * channel_size + n];
                     }
                 }
 
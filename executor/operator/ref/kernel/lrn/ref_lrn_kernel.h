@@ -45,6 +45,7 @@ struct ref_lrn_param
     int dims[4];
     int zero[2]; /* input, output */
     float scale[2]; /* input, output */
+    int channel_range[2]; /* [start, end) of the output channels, fp32 only */
 };
 
 typedef int (*ref_lrn_kernel_t)(const void* in_data, void* out_data, ref_lrn_param* param);
@@ -41,8 +41,8 @@ int ref_lstm_fp32(float* input,float* output,lstm_param* param)
     }
     else
     {
-        memset(init_h, 0x0, sizeof(param->batch_size * param->hidden_size * sizeof(float)));
-        memset(init_c, 0x0, sizeof(param->batch_size * param->cell_size * sizeof(float)));
+        memset(init_h, 0x0, param->batch_size * param->hidden_size * sizeof(float));
+        memset(init_c, 0x0, param->batch_size * param->cell_size * sizeof(float));
     }
     for(int i = 0; i < param->seq_lens; i++)
     {
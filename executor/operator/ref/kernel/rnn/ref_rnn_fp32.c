@@ -35,7 +35,7 @@ int ref_rnn_fp32(float* input,float* output,rnn_param* param)
     }
     else
     {
-        memset(init_h, 0x0, sizeof(param->batch_size * param->hidden_size * sizeof(float)));
+        memset(init_h, 0x0, param->batch_size * param->hidden_size * sizeof(float));
     }
 
     for(int i = 0; i < param->seq_lens; i++)
@@ -53,7 +53,8 @@ static int caffe_run(const int8_t* in_data, int8_t** out_data, int element_size,
             int in_offset = (n * in_slice + slice_index) * slice_size * element_size;
             int out_offset = n * out_slice * slice_size * element_size;
             //printf("%d %d\n", in_offset, slice_size);
-            memcpy(output + out_offset, input + in_offset, slice_size * out_slice * element_size);
+            if(output + out_offset != input + in_offset)
+                memcpy(output + out_offset, input + in_offset, slice_size * out_slice * element_size);
         }
         slice_index += out_slice;
     }
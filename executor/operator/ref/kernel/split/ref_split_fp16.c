@@ -31,7 +31,8 @@ static int ref_split_fp16(const __fp16* in_data, __fp16** out_data, struct split
         {
             int in_offset = (n * in_slice + slice_index) * slice_size;
             int out_offset = n * out_slice * slice_size;
-            memcpy(output + out_offset, in_data + in_offset, slice_size * out_slice * sizeof(__fp16));
+            if(output + out_offset != in_data + in_offset)
+                memcpy(output + out_offset, in_data + in_offset, slice_size * out_slice * sizeof(__fp16));
         }
         slice_index += out_slice;
     }
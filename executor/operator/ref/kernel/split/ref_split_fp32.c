@@ -46,7 +46,8 @@ static int ref_split_fp32(const float* in_data, float** out_data, struct split_p
             for(int i = 0; i < 4; i++){
                 size *= param->input_shape.dim[i];
             }
-            memcpy(output, in_data, sizeof(float)*size);
+            if(output != in_data)
+                memcpy(output, in_data, sizeof(float)*size);
         } else {
             int out_slice = 0;
             // if(param->squeeze_dim == 1)
@@ -61,7 +62,8 @@ static int ref_split_fp32(const float* in_data, float** out_data, struct split_p
             {
                 int in_offset = (n * in_slice + slice_index) * slice_size;
                 int out_offset = n * out_slice * slice_size;
-                memcpy(output + out_offset, in_data + in_offset, slice_size * out_slice * sizeof(float));
+                if(output + out_offset != in_data + in_offset)
+                    memcpy(output + out_offset, in_data + in_offset, slice_size * out_slice * sizeof(float));
             }
             slice_index += out_slice;
         }
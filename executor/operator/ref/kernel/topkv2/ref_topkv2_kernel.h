@@ -27,7 +27,9 @@
 
 #include <stdint.h>
 #include <math.h>
+#include <algorithm>
 #include "compiler_fp16.h"
+#include "detect_postproc.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,10 +40,44 @@ struct topkv2_param
     int k;
     int row_size;
     int num_rows;
+    TEngine::post_parallel_t parallel;
 };
 
 typedef int (*ref_topkv2_t)(void* data, void* out_data, int* out_index, topkv2_param* param);
 
+/* the k largest of each row and their indices, rows in parallel. ties keep the index order */
+static void ref_topkv2_common(const float* in_data, float* out_data, int* out_index, struct topkv2_param* param)
+{
+    int k = param->k;
+    int row_size = param->row_size;
+
+    auto run_rows = [&](int start, int end) {
+        std::vector<int> index(row_size);
+
+        for(int i = start; i < end; i++)
+        {
+            const float* row = in_data + i * row_size;
+
+            index.resize(row_size);
+            for(int j = 0; j < row_size; j++)
+                index[j] = j;
+
+            TEngine::SelectTopK(row, 1, index, k);
+
+            for(int j = 0; j < k && j < row_size; j++)
+            {
+                out_data[i * k + j] = row[index[j]];
+                out_index[i * k + j] = index[j];
+            }
+        }
+    };
+
+    if(param->parallel)
+        param->parallel(param->num_rows, std::max(1, 4096 / std::max(row_size, 1)), run_rows);
+    else
+        run_rows(0, param->num_rows);
+}
+
 #ifdef CONFIG_KERNEL_FP32
 #include "ref_topkv2_fp32.c"
 #endif
@@ -1,60 +1,8 @@
-float intersection_area(const Box& box1, const Box& box2)
-{
-    //printf("box1:%f %f %f %f\n", box1.x0, box1.x1, box1.y0, box1.y1);
-    //printf("box2:%f %f %f %f\n", box2.x0, box2.x1, box2.y0, box2.y1);
-    if(box1.x0 > box2.x1||box1.x1 < box2.x0 ||box1.y0 > box2.y1||box1.y1 < box2.y0)
-        return 0;
-
-    float width = std::min(box1.x1, box2.x1) - std::max(box1.x0, box2.x0);
-    float height = std::min(box1.y1, box2.y1) - std::max(box1.y0, box2.y0);
-
-    return width * height;
-}
-
 static float sigmoid(float x)
 {
     return 1.f / (1.f + std::exp(-x));
 }
 
-void nms_sorted_box(const std::vector<Box>& box, std::vector<int>& picked, float nms_threshold)
-{
-    picked.clear();
-    const int n = box.size();
-
-    std::vector<float> areas(n);
-    for(int i = 0; i < n; i++)
-    {
-        const Box& r = box[i];
-        
-        float width = r.x1 - r.x0;
-        float height = r.y1 - r.y0;
-
-        areas[i] = width * height;
-    }
-
-    for(int i = 0; i < n ;i++)
-    {
-        const Box& a = box[i];
-
-        int keep = 1;
-
-        for(int j = 0; j < (int)picked.size(); j++)
-        {
-            const Box& b = box[picked[j]];
-            //printf("%d\n", a.class_idx);
-            float inter_area = intersection_area(a, b);
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            //printf("%f %f\n", inter_area/union_area, nms_threshold);
-            if(inter_area / union_area > nms_threshold)
-                keep = 0;
-        }
-    
-        if(keep)
-            picked.push_back(i);
-    }
-
-}
-
 int ref_YOLOV3DetectionOutput_fp32(float* input, YOLOV3_ddo_parm* param_)
 {
     int input_num = param_->anchors_scale.size();
@@ -100,6 +48,19 @@ int ref_YOLOV3DetectionOutput_fp32(float* input, YOLOV3_ddo_parm* param_)
                 {
                     //printf("%d %d\n", m, n);
                     float box_score = sigmoid(box_score_ptr[0]);
+
+                    /* the class score is at most 1, so the confidence can not pass the threshold */
+                    if(box_score < param_->confidence_threshold)
+                    {
+                        x_ptr++;
+                        y_ptr++;
+                        w_ptr++;
+                        h_ptr++;
+
+                        box_score_ptr++;
+                        continue;
+                    }
+
                     int class_index = 0;
                     float class_score = -9999;
                     for (int cl = 0; cl < num_classes; cl++)
@@ -152,15 +113,38 @@ int ref_YOLOV3DetectionOutput_fp32(float* input, YOLOV3_ddo_parm* param_)
             //printf("%d %d.\n", all_boxes.size(), bboxes.size());
         }
     }
-    std::sort(all_boxes.begin(), all_boxes.end(),
-                [](const Box& a, const Box& b) { return a.score > b.score; });
-    //printf("sorted done.\n");
+
+    /* class agnostic NMS over the boxes of all the scales */
+    int all_num = all_boxes.size();
+    std::vector<float> scores(all_num);
+    std::vector<int> order(all_num);
+
+    for(int i = 0; i < all_num; i++)
+    {
+        scores[i] = all_boxes[i].score;
+        order[i] = i;
+    }
+
+    TEngine::SelectTopK(scores.data(), 1, order, 0);
+
+    TEngine::BoxArrays boxes;
+    boxes.Resize(all_num);
+
+    for(int i = 0; i < all_num; i++)
+    {
+        const Box& r = all_boxes[order[i]];
+        float rect[4] = {r.x0, r.y0, r.x1, r.y1};
+
+        boxes.Set(i, rect);
+    }
+
     std::vector<int> picked;
-    nms_sorted_box(all_boxes, picked, param_->nms_threshold);
-    //printf("nms done.\n");
+    TEngine::NmsSortedBoxes(boxes, param_->nms_threshold, param_->fast_nms, picked);
+
+    param_->output_box.clear();
     for(size_t j = 0; j < picked.size(); j++)
     {
-        param_->output_box.push_back(all_boxes[picked[j]]);
+        param_->output_box.push_back(all_boxes[order[picked[j]]]);
     }
 
     return 0;
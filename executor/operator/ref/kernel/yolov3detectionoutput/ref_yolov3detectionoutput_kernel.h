@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <vector>
 #include "compiler_fp16.h"
+#include "detect_postproc.hpp"
 
 #ifdef __cplusplus
 extern "C"{
@@ -32,6 +33,7 @@ struct YOLOV3_ddo_parm
     int mask_group_num;
     float out_scale;
     std::vector<Box> output_box;
+    bool fast_nms;
 };
 
 typedef int (*ref_YOLOV3DetectionOutput_kernel_t)(void* input, YOLOV3_ddo_parm* param);
@@ -181,11 +181,65 @@ bool RefConv::Run(Node* node)
     Tensor* o_tensor = node->GetOutputTensor(0);
     void* output = get_tensor_mem(o_tensor);
 
-    int ret = kernel_run(input, output, kernel, bias, &op_param);
-    if(ret < 0)
-        return false;
-    
-    return true;
+    /* NHWC and quantized kernels run as a whole */
+    if(op_param.layout != TENGINE_LAYOUT_NCHW || op_param.k_scale)
+        return kernel_run(input, output, kernel, bias, &op_param) >= 0;
+
+    /*
+     * static chunks of the output channels, or of the groups for group convolution.
+     * Each chunk runs image by image, with the tensors sliced to its channels
+     */
+    int group = op_param.group;
+    int in_c = op_param.in_shape[0] / group;
+    int out_c = op_param.out_shape[0] / group;
+    int in_hw = op_param.in_shape[1] * op_param.in_shape[2];
+    int out_hw = op_param.out_shape[1] * op_param.out_shape[2];
+    int kernel_size = in_c * op_param.kernels[0] * op_param.kernels[1];
+
+    int data_size = DataType::GetTypeSize(i_tensor->GetDataType());
+    int kernel_elem = DataType::GetTypeSize(k_tensor->GetDataType());
+    int bias_elem = bias ? DataType::GetTypeSize(b_tensor->GetDataType()) : 0;
+
+    bool failed = false;
+
+    ParallelRun(group > 1 ? group : out_c, 2, [&](int start, int end) {
+        op_data chunk = op_param;
+        int in_off, oc_start;
+
+        chunk.batch = 1;
+
+        if(group > 1)
+        {
+            chunk.group = end - start;
+            chunk.in_shape[0] = chunk.group * in_c;
+            chunk.out_shape[0] = chunk.group * out_c;
+            in_off = start * in_c * in_hw;
+            oc_start = start * out_c;
+        }
+        else
+        {
+            chunk.out_shape[0] = end - start;
+            in_off = 0;
+            oc_start = start;
+        }
+
+        const char* chunk_kernel = ( const char* )kernel + ( size_t )oc_start * kernel_size * kernel_elem;
+        const char* chunk_bias = bias ? ( const char* )bias + oc_start * bias_elem : nullptr;
+
+        for(int n = 0; n < op_param.batch; n++)
+        {
+            size_t in_pos = ( size_t )n * op_param.in_shape[0] * in_hw + in_off;
+            size_t out_pos = (( size_t )n * op_param.out_shape[0] + oc_start) * out_hw;
+
+            const char* chunk_input = ( const char* )input + in_pos * data_size;
+            char* chunk_output = ( char* )output + out_pos * data_size;
+
+            if(kernel_run(chunk_input, chunk_output, chunk_kernel, chunk_bias, &chunk) < 0)
+                failed = true;
+        }
+    });
+
+    return !failed;
 }
 
 bool RefConv::Postrun(Node* node)
@@ -74,6 +74,10 @@ bool RefDetectionOutput::Prerun(Node* node)
     param.nms_threshold = param_->nms_threshold;
     param.nms_top_k = param_->nms_top_k;
     param.confidence_threshold = param_->confidence_threshold;
+    param.fast_nms = FastNmsEnabled();
+    param.parallel = [this](int work_num, int min_work, const std::function<void(int, int)>& func) {
+        ParallelRun(work_num, min_work, func);
+    };
 
     if(!kernel_registry.GetKernel(kernel_run, layout, input->GetDataType()))
     {
@@ -74,6 +74,10 @@ bool RefDetectionPost::Prerun(Node* node)
     param.scales[1] = param_->scales[1];
     param.scales[2] = param_->scales[2];
     param.scales[3] = param_->scales[3];
+    param.fast_nms = FastNmsEnabled();
+    param.parallel = [this](int work_num, int min_work, const std::function<void(int, int)>& func) {
+        ParallelRun(work_num, min_work, func);
+    };
 
     Tensor* input = node->GetInputTensor(0);
     if(input->GetDataType() != TENGINE_DT_FP32 && input->GetDataType() != TENGINE_DT_FP16 &&
@@ -166,7 +166,28 @@ bool RefLrn::RunNCHW(Node* node)
         op_param.zero[1] = 0;
     }
 
-    if(kernel_run(input, output, &op_param) < 0)
+    op_param.channel_range[0] = 0;
+    op_param.channel_range[1] = op_param.dims[1];
+
+    if(data_type == TENGINE_DT_FP32)
+    {
+        /* the fp32 kernel computes a range of output channels: static chunks of the channels */
+        bool failed = false;
+
+        ParallelRun(op_param.dims[1], 2, [&](int start, int end) {
+            ref_lrn_param chunk = op_param;
+
+            chunk.channel_range[0] = start;
+            chunk.channel_range[1] = end;
+
+            if(kernel_run(input, output, &chunk) < 0)
+                failed = true;
+        });
+
+        if(failed)
+            return false;
+    }
+    else if(kernel_run(input, output, &op_param) < 0)
         return false;
 
     if(data_type == TENGINE_DT_INT8)
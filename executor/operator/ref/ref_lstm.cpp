@@ -108,7 +108,8 @@ bool RefLSTM::Prerun(Node* node)
         {
             init_h_tensor = temptensor;
         }
-        if(name.find(lstm_op->GetBiasName()) != std::string::npos)
+        if(name.find(lstm_op->GetBiasName()) != std::string::npos &&
+            name.find(lstm_op->Geth2hBiasName()) == std::string::npos)
         {
             bias_tensor = temptensor;
         }
@@ -243,8 +244,8 @@ bool RefLSTM::Run(Node* node)
     }
     else
     {
-        memset(init_h, 0x0, sizeof(batch_size * hidden_size * sizeof(float)));
-        memset(init_c, 0x0, sizeof(batch_size * cell_size * sizeof(float)));
+        memset(init_h, 0x0, batch_size * hidden_size * sizeof(float));
+        memset(init_c, 0x0, batch_size * cell_size * sizeof(float));
     }
 
     float* kernel = nullptr;
@@ -152,6 +152,26 @@ bool RefPad::Run(Node* node)
     param.in_size = in_size;
     param.out_size = out_size;
 
+    /* the kernel pads dim 1 and 2 of [n][h][w][c]: an NCHW tensor without a channel pad is
+       padded as n * c planes of one channel, with pad_2 on H and pad_3 on W */
+    if(exec_attr->graph_layout == TENGINE_LAYOUT_NCHW && i_dims.size() == 4 && op_param->pad_1_h == 0 &&
+       op_param->pad_1_w == 0)
+    {
+        param.in_n = param.out_n = i_dims[0] * i_dims[1];
+        param.in_c = 1;
+        param.in_h = i_dims[2];
+        param.in_w = i_dims[3];
+        param.out_h = o_dims[2];
+        param.out_w = o_dims[3];
+
+        param.pad_1_h = op_param->pad_2_h;
+        param.pad_1_w = op_param->pad_2_w;
+        param.pad_2_h = op_param->pad_3_h;
+        param.pad_2_w = op_param->pad_3_w;
+        param.pad_3_h = 0;
+        param.pad_3_w = 0;
+    }
+
     void* in_data = get_tensor_mem(input_tensor);
     void* out_data = get_tensor_mem(out_tensor);
 
@@ -140,10 +140,27 @@ bool RefPooling::Run(Node* node)
     const void* input_data = get_tensor_mem(input);
     void* output_data = get_tensor_mem(output);
 
-    if(kernel_run(input_data, output_data, &param) < 0)
-        return false;
+    if(param.layout != TENGINE_LAYOUT_NCHW)
+        return kernel_run(input_data, output_data, &param) >= 0;
 
-    return true;
+    /* the NCHW planes are independent: each chunk of batch * channel planes runs as one image */
+    int elem_size = DataType::GetTypeSize(input->GetDataType());
+    int in_plane = param.input[0] * param.input[1] * elem_size;
+    int out_plane = param.output[0] * param.output[1] * elem_size;
+    bool failed = false;
+
+    ParallelRun(param.batch * param.channel, 2, [&](int start, int end) {
+        struct op_data chunk = param;
+
+        chunk.batch = 1;
+        chunk.channel = end - start;
+
+        if(kernel_run(( const char* )input_data + start * in_plane, ( char* )output_data + start * out_plane,
+                      &chunk) < 0)
+            failed = true;
+    });
+
+    return !failed;
 }
 
 void RefPooling::InitRegistry(void)
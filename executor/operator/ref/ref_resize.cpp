@@ -96,14 +96,27 @@ bool ResizeOps::Run(Node* node)
 
     float* input = ( float* )get_tensor_mem(input_tensor);
     float* output = ( float* )get_tensor_mem(output_tensor);
-    int ret = -1;
 
-    ret = kernel_run(input, output, &op_param, layout);
+    if(layout != TENGINE_LAYOUT_NCHW)
+        return kernel_run(input, output, &op_param, layout) >= 0;
 
-    if(ret < 0)
-        return false;
-    else
-        return true;
+    /* the NCHW planes are independent: each chunk of batch * channel planes runs as one image */
+    int elem_size = DataType::GetTypeSize(input_tensor->GetDataType());
+    int in_plane = op_param.input_h * op_param.input_w * elem_size;
+    int out_plane = op_param.output_h * op_param.output_w * elem_size;
+    bool failed = false;
+
+    ParallelRun(op_param.batch * op_param.channel, 2, [&](int start, int end) {
+        struct resize_param chunk = op_param;
+
+        chunk.batch = 1;
+        chunk.channel = end - start;
+
+        if(kernel_run(( char* )input + start * in_plane, ( char* )output + start * out_plane, &chunk, layout) < 0)
+            failed = true;
+    });
+
+    return !failed;
 }
 
 bool ResizeOps::Postrun(Node* node)
@@ -148,7 +148,7 @@ bool RefRNN::Run(Node* node)
     }
     else
     {
-        memset(init_h, 0x0, sizeof(batch_size * hidden_size * sizeof(float)));
+        memset(init_h, 0x0, batch_size * hidden_size * sizeof(float));
     }
 
     float* kernel = ( float* )get_tensor_mem(kernel_tensor);
@@ -65,9 +65,6 @@ struct RefSoftmax : public MTNodeOps
     bool Run(Node* node) override;
     void InitRegistry(void);
 
-    float* max_array;
-    float* sum_array;
-
     op_data op_param;
 
     ref_softmax_kernel_t kernel_run;
@@ -76,8 +73,6 @@ struct RefSoftmax : public MTNodeOps
 
     RefSoftmax(void)
     {
-        max_array = nullptr;
-        sum_array = nullptr;
         kernel_run = nullptr;
         InitRegistry();
     }
@@ -119,9 +114,6 @@ bool RefSoftmax::Run(Node* node)
     }
     int on_size = dims[axis];
 
-    max_array = ( float* )std::malloc(in_size * sizeof(float));
-    sum_array = ( float* )std::malloc(in_size * sizeof(float));
-
     //
     op_param.out_size = out_size;
     op_param.in_size = in_size;
@@ -138,16 +130,27 @@ bool RefSoftmax::Run(Node* node)
         if(get_scale_zero(input_tensor, output_tensor, &op_param) < 0)
             return false;
     }
-    //
-    int ret = kernel_run(input, output, max_array, sum_array, &op_param);
-    
-    std::free(max_array);
-    std::free(sum_array);
+    /* the outer slices are independent: static chunks of out_size, each with its own max/sum arrays */
+    int slice_size = in_size * on_size * DataType::GetTypeSize(input_tensor->GetDataType());
+    bool failed = false;
 
-    if(ret < 0)
-        return false;
-    else
-        return true;
+    ParallelRun(out_size, 2, [&](int start, int end) {
+        op_data chunk = op_param;
+
+        chunk.out_size = end - start;
+
+        float* max_array = ( float* )std::malloc(in_size * sizeof(float));
+        float* sum_array = ( float* )std::malloc(in_size * sizeof(float));
+
+        if(kernel_run(( char* )input + start * slice_size, ( char* )output + start * slice_size, max_array, sum_array,
+                      &chunk) < 0)
+            failed = true;
+
+        std::free(max_array);
+        std::free(sum_array);
+    });
+
+    return !failed;
 }
 
 void RefSoftmax::InitRegistry(void)
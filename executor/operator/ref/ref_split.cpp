@@ -80,7 +80,6 @@ void RefSplit::InitRegistry(void)
 bool RefSplit::Prerun(Node* node)
 {
     int layout = exec_attr->graph_layout;
-    Tensor* output_tensor = node->GetOutputTensor(0);
     Split* split_op = dynamic_cast<Split*>(node->GetOp());
     SplitParam* param = split_op->GetParam();
     // op_param.squeeze_dim = param->squeeze_axis;
@@ -94,10 +93,12 @@ bool RefSplit::Prerun(Node* node)
     op_param.output_shape = new shape_dim[out_nums];
     op_param.output_counts = out_nums;
     op_param.is_caffe = param->is_caffe;
-    auto dims = output_tensor->GetShape().GetDim();
-    op_param.output_dim = ( int )(dims.size());
+    op_param.output_dim = ( int )(node->GetOutputTensor(0)->GetShape().GetDim().size());
     for(int i = 0; i < out_nums; i++)
     {
+        /* the parts may differ along the axis */
+        auto dims = node->GetOutputTensor(i)->GetShape().GetDim();
+
         for(std::size_t ii = 0; ii < dims.size(); ++ii)
         {
             op_param.output_shape[i].dim[ii] = dims[ii];
@@ -104,6 +104,9 @@ bool RefTopkV2::Prerun(Node* node)
     op_param.k = param_->k;
     op_param.row_size = in_dims.back();
     op_param.num_rows = num_rows;
+    op_param.parallel = [this](int work_num, int min_work, const std::function<void(int, int)>& func) {
+        ParallelRun(work_num, min_work, func);
+    };
 #endif
     if(!kernel_registry.GetKernel(kernel_run, layout, data_type))
     {
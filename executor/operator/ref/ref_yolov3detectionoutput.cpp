@@ -53,6 +53,7 @@ bool RefYOLOV3DetectionOutput::Prerun(Node* node)
     param.confidence_threshold = param_->confidence_threshold;
     param.bias = param_->bias;
     param.mask = param_->mask;
+    param.fast_nms = FastNmsEnabled();
     if(!kernel_registry.GetKernel(kernel_run, layout, input->GetDataType()))
     {
         set_tengine_errno(ENOENT);
@@ -91,7 +92,7 @@ bool RefYOLOV3DetectionOutput::Run(Node* node)
     for(int i = 0; i < node->GetInputNum(); i++)
     { 
         memcpy((float*)input_ptr+offset, input_datas[i], data_len[i]);
-        offset += data_len[i];
+        offset += data_len[i] / sizeof(float);
         //printf("%d\n", data_len[i]);
     }
     Tensor* output_tensor = node->GetOutputTensor(0);
@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/batch_norm.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace BatchNormImpl {
+
+struct BatchNormOps : public NodeOps
+{
+    bool Prerun(Node* node) override;
+    bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
+};
+
+/* fold mean, var, gamma and beta into one scale and one bias per channel */
+bool BatchNormOps::Prerun(Node* node)
+{
+    BatchNorm* bn_op = dynamic_cast<BatchNorm*>(node->GetOp());
+    BatchNormParam* param = bn_op->GetParam();
+
+    const Tensor* input_tensor = node->GetInputTensor(0);
+    int channel_num = input_tensor->GetShape().GetDim()[1];
+
+    const float* mean = ( const float* )GetInputMem(node, 3);
+    const float* var = ( const float* )GetInputMem(node, 4);
+    const float* gamma = nullptr;
+    const float* beta = nullptr;
+
+    if(!param->caffe_flavor)
+    {
+        gamma = ( const float* )GetInputMem(node, 1);
+        beta = ( const float* )GetInputMem(node, 2);
+    }
+
+    float* scale_bias = ( float* )mem_alloc(sizeof(float) * channel_num * 2);
+    float* scale = scale_bias;
+    float* bias = scale_bias + channel_num;
+
+    float rescale_factor = param->rescale_factor ? 1 / param->rescale_factor : 0;
+
+    for(int c = 0; c < channel_num; c++)
+    {
+        float var_inv = 1.f / std::sqrt(var[c] * rescale_factor + param->eps);
+        float scale_mean = -mean[c] * (rescale_factor * var_inv);
+
+        if(param->caffe_flavor)
+        {
+            scale[c] = var_inv;
+            bias[c] = scale_mean;
+        }
+        else
+        {
+            scale[c] = gamma[c] * var_inv;
+            bias[c] = beta[c] + gamma[c] * scale_mean;
+        }
+    }
+
+    (*node)["scale_bias"] = scale_bias;
+
+    return true;
+}
+
+bool BatchNormOps::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const std::vector<int>& dims = input_tensor->GetShape().GetDim();
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    const float* scale = any_cast<float*>(node->GetAttr("scale_bias"));
+
+    int channel_num = dims[1];
+    const float* bias = scale + channel_num;
+    int plane_num = dims[0] * channel_num;
+    int plane_size = 1;
+
+    for(unsigned int i = 2; i < dims.size(); i++)
+        plane_size *= dims[i];
+
+    ParallelRun(plane_num, std::max(1, 4096 / plane_size), [&](int start, int end) {
+        for(int p = start; p < end; p++)
+        {
+            const float* in = input + p * plane_size;
+            float* out = output + p * plane_size;
+            int c = p % channel_num;
+            vfloat v_scale = vf_set1(scale[c]);
+            vfloat v_bias = vf_set1(bias[c]);
+            int i = 0;
+
+            for(; i + VF_LANE <= plane_size; i += VF_LANE)
+                vf_store(out + i, vf_add(vf_mul(vf_load(in + i), v_scale), v_bias));
+
+            for(; i < plane_size; i++)
+                out[i] = in[i] * scale[c] + bias[c];
+        }
+    });
+
+    return true;
+}
+
+bool BatchNormOps::Postrun(Node* node)
+{
+    if(node->ExistAttr("scale_bias"))
+    {
+        float* addr = any_cast<float*>(node->GetAttr("scale_bias"));
+
+        mem_free(addr);
+        node->RemoveAttr("scale_bias");
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+        return nullptr;
+
+    if(input->GetShape().GetDim().size() < 2)
+        return nullptr;
+
+    BatchNormOps* ops = new BatchNormOps();
+
+    return ops;
+}
+
+}    // namespace BatchNormImpl
+
+void RegisterBatchNormNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "BatchNormalization", BatchNormImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
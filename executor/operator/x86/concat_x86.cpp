@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/concat.hpp"
+
+namespace TEngine {
+
+namespace ConcatImpl {
+
+struct ConcatOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+/* every (outer index, input) pair is one contiguous copy, the copies are spread over the cpus */
+bool ConcatOps::Run(Node* node)
+{
+    Concat* concat_op = dynamic_cast<Concat*>(node->GetOp());
+    ConcatParam* param = concat_op->GetParam();
+
+    Tensor* output_tensor = node->GetOutputTensor(0);
+    const std::vector<int>& out_dims = output_tensor->GetShape().GetDim();
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    int dim_num = out_dims.size();
+    int axis = param->axis;
+
+    if(axis < 0)
+        axis += dim_num;
+
+    int out_size = 1;
+    for(int i = 0; i < axis; i++)
+        out_size *= out_dims[i];
+
+    int in_size = 1;
+    for(int i = axis + 1; i < dim_num; i++)
+        in_size *= out_dims[i];
+
+    int input_num = node->GetInputNum();
+    std::vector<const float*> inputs(input_num);
+    std::vector<int> copy_size(input_num);
+    std::vector<int> copy_offset(input_num);
+    int out_step = 0;
+
+    for(int i = 0; i < input_num; i++)
+    {
+        Tensor* input_tensor = node->GetInputTensor(i);
+
+        inputs[i] = ( float* )GetInputMem(node, i);
+        copy_size[i] = input_tensor->GetShape().GetDim()[axis] * in_size;
+        copy_offset[i] = out_step;
+        out_step += copy_size[i];
+    }
+
+    if(out_step != out_dims[axis] * in_size)
+    {
+        LOG_ERROR() << "concat dimensions is not same output: " << out_step / in_size << " vs " << out_dims[axis]
+                    << "\n";
+        return false;
+    }
+
+    int min_work = std::max(1, 64 * 1024 / std::max(out_step / input_num, 1));
+
+    ParallelRun(out_size * input_num, min_work, [&](int start, int end) {
+        for(int w = start; w < end; w++)
+        {
+            int k = w / input_num;
+            int j = w % input_num;
+
+            float* dst = output + k * out_step + copy_offset[j];
+            const float* src = inputs[j] + k * copy_size[j];
+
+            /* the input is already in place when the memory planner made it a view of the output */
+            if(dst != src)
+                memcpy(dst, src, copy_size[j] * sizeof(float));
+        }
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    /* the axis is an index of the dims, whatever the layout */
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    ConcatOps* ops = new ConcatOps();
+
+    return ops;
+}
+
+}    // namespace ConcatImpl
+
+void RegisterConcatNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Concat", ConcatImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -159,16 +159,15 @@ bool ConvolutionDwOps::Run(Node* node)
 
     Tensor* input_tensor = node->GetInputTensor(0);
     Tensor* output_tensor = node->GetOutputTensor(0);
-    Tensor* weight_tensor = node->GetInputTensor(1);
     float* buffer = any_cast<float*>(node->GetAttr("buffer"));
 
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
     int activation = param->activation;
 
-    float* input = ( float* )get_tensor_mem(input_tensor);
-    float* output = ( float* )get_tensor_mem(output_tensor);
-    float* kernel = ( float* )get_tensor_mem(weight_tensor);
+    float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    float* kernel = ( float* )GetInputMem(node, 1);
 
     const TShape& shape = input_tensor->GetShape();
     const std::vector<int> in_dims = shape.GetDim();
@@ -207,39 +206,44 @@ bool ConvolutionDwOps::Run(Node* node)
     float* biases = nullptr;
     bool have_biases = node->GetInputNum() > 2;
     if (have_biases)
-        biases = (float*)get_tensor_mem(node->GetInputTensor(2));
+        biases = (float*)GetInputMem(node, 2);
 
     /* pading */
     int inh_tmp = inh + pad_h + pad_h;
     int inw_tmp = inw + pad_w + pad_w;
+    bool need_pad = !(inh_tmp == inh && inw_tmp == inw);
     float* input_tmp = NULL;
-    if (inh_tmp == inh && inw_tmp == inw)
-        input_tmp = input;
-    else
-    {
+    if (need_pad)
         input_tmp = (float*)malloc(inh_tmp * inw_tmp * group * sizeof(float));
-        for (int g=0; g<group; g++)
-        {
-            float* pad_in  = input + g * inh * inw;
-            float* pad_out = input_tmp + g * inh_tmp * inw_tmp;
-            pad(pad_in, pad_out, inh, inw, inh_tmp, inw_tmp, pad_h, pad_w, 0.f);
-        }
-    }
 
     /* process */
     for(int i = 0; i < batch_number; i++)
     {
+        float* cur_input = input + i * in_chw;
+        float* cur_output = output + i * out_chw;
+
+        if (need_pad)
+        {
+            for (int g=0; g<group; g++)
+            {
+                float* pad_in  = cur_input + g * inh * inw;
+                float* pad_out = input_tmp + g * inh_tmp * inw_tmp;
+                pad(pad_in, pad_out, inh, inw, inh_tmp, inw_tmp, pad_h, pad_w, 0.f);
+            }
+            cur_input = input_tmp;
+        }
+
         if (stride_h == 1)
-            dwconv3x3s1d1(inc, inw_tmp, inh_tmp, outw, outh, kernel, input_tmp, biases, output, have_biases);
+            dwconv3x3s1d1(inc, inw_tmp, inh_tmp, outw, outh, kernel, cur_input, biases, cur_output, have_biases);
         else
-            dwconv3x3s2d1(inc, inw_tmp, inh_tmp, outw, outh, kernel, input_tmp, biases, output, have_biases);
+            dwconv3x3s2d1(inc, inw_tmp, inh_tmp, outw, outh, kernel, cur_input, biases, cur_output, have_biases);
     }
 
     /* relu */
     if (activation >= 0)
         relu(output, batch_number * out_chw, activation);
 
-    if (!(inh_tmp == inh && inw_tmp == inw))
+    if (need_pad)
         free(input_tmp);
 
     return true;
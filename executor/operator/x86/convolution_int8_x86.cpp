@@ -0,0 +1,283 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "tengine_errno.hpp"
+#include "graph.hpp"
+#include "operator/convolution.hpp"
+#include "gemm_int8_x86.h"
+
+namespace TEngine {
+
+namespace ConvolutionInt8Impl {
+
+/*
+ * symmetric int8 convolution: int8 input and kernel, int32 bias, per output channel kernel scales.
+ * The im2col is folded into the packing of the gemm input, and the requantization into its epilogue.
+ */
+struct ConvolutionInt8Ops : public NodeOps
+{
+    bool Prerun(Node* node) override;
+    bool Reshape(Node* node) override;
+    bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
+};
+
+/* im2col the column blocks in [n_start, n_end) of one group straight into the packed gemm input */
+static void im2col_pack_int8(const int8_t* input, int32_t* pack, int inh, int inw, int outw, int n, int k,
+                             const ConvParam* p, int n_start, int n_end)
+{
+    int ksize = p->kernel_h * p->kernel_w;
+    int k2 = (k + 1) / 2;
+    int iy0[I8_NB], ix0[I8_NB];
+
+    for(int nb = n_start; nb < n_end; nb += I8_NB)
+    {
+        int16_t* dst = ( int16_t* )(pack + nb * k2);
+        int cols = std::min(I8_NB, n - nb);
+
+        for(int j = 0; j < I8_NB; j++)
+        {
+            int oh = (nb + j) / outw;
+            int ow = (nb + j) % outw;
+
+            /* a padded column reads nothing */
+            iy0[j] = j < cols ? oh * p->stride_h - p->pad_h0 : -inh - p->kernel_h * p->dilation_h;
+            ix0[j] = ow * p->stride_w - p->pad_w0;
+        }
+
+        for(int kk = 0; kk < k; kk++)
+        {
+            int c = kk / ksize;
+            int ky = (kk % ksize) / p->kernel_w * p->dilation_h;
+            int kx = kk % p->kernel_w * p->dilation_w;
+            const int8_t* cur_input = input + c * inh * inw;
+            int16_t* d = dst + (kk >> 1) * I8_NB * 2 + (kk & 1);
+
+            for(int j = 0; j < I8_NB; j++)
+            {
+                int iy = iy0[j] + ky;
+                int ix = ix0[j] + kx;
+
+                d[j * 2] = (iy >= 0 && iy < inh && ix >= 0 && ix < inw) ? cur_input[iy * inw + ix] : 0;
+            }
+        }
+
+        if(k & 1)
+        {
+            int16_t* d = dst + (k >> 1) * I8_NB * 2 + 1;
+
+            for(int j = 0; j < I8_NB; j++)
+                d[j * 2] = 0;
+        }
+    }
+}
+
+bool ConvolutionInt8Ops::Prerun(Node* node)
+{
+    Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
+    ConvParam* param = conv_op->GetParam();
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* kernel_tensor = node->GetInputTensor(1);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+
+    auto i_quant = input_tensor->GetQuantParam();
+    auto k_quant = kernel_tensor->GetQuantParam();
+    auto o_quant = output_tensor->GetQuantParam();
+
+    const std::vector<int>& in_dims = input_tensor->GetShape().GetDim();
+    const std::vector<int>& out_dims = output_tensor->GetShape().GetDim();
+
+    int group = param->group;
+    int outc = out_dims[1];
+    int m = outc / group;
+    int k = param->kernel_h * param->kernel_w * in_dims[1] / group;
+    int n = out_dims[2] * out_dims[3];
+
+    if(i_quant->size() != 1 || o_quant->size() != 1 ||
+       (k_quant->size() != 1 && k_quant->size() < ( unsigned int )outc))
+    {
+        LOG_ERROR() << "conv int8: bad quant param size <" << i_quant->size() << "," << k_quant->size() << ","
+                    << o_quant->size() << ">\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    float* scale = ( float* )mem_alloc(sizeof(float) * outc);
+
+    for(int i = 0; i < outc; i++)
+        scale[i] = (*i_quant)[0].scale * (*k_quant)[k_quant->size() == 1 ? 0 : i].scale;
+
+    const int8_t* kernel_org = ( int8_t* )GetInputMem(node, 1);
+    int kernel_pack_size = i8gemm_a_pack_size(m, k);
+    int32_t* kernel_packed = ( int32_t* )mem_alloc(sizeof(int32_t) * kernel_pack_size * group);
+
+    for(int g = 0; g < group; g++)
+        i8gemm_pack_a(m, k, kernel_org + g * m * k, k, kernel_packed + g * kernel_pack_size);
+
+    (*node)["int8_scale"] = scale;
+    (*node)["int8_kernel_packed"] = kernel_packed;
+    (*node)["int8_input_packed"] = ( int32_t* )mem_alloc(sizeof(int32_t) * i8gemm_b_pack_size(n, k));
+
+    return true;
+}
+
+bool ConvolutionInt8Ops::Reshape(Node* node)
+{
+    Postrun(node);
+
+    return Prerun(node);
+}
+
+bool ConvolutionInt8Ops::Run(Node* node)
+{
+    Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
+    ConvParam* param = conv_op->GetParam();
+
+    const float* scale = any_cast<float*>(node->GetAttr("int8_scale"));
+    const int32_t* kernel_packed = any_cast<int32_t*>(node->GetAttr("int8_kernel_packed"));
+    int32_t* input_packed = any_cast<int32_t*>(node->GetAttr("int8_input_packed"));
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+    const std::vector<int>& in_dims = input_tensor->GetShape().GetDim();
+    const std::vector<int>& out_dims = output_tensor->GetShape().GetDim();
+
+    const int8_t* input = ( int8_t* )GetInputMem(node, 0);
+    int8_t* output = ( int8_t* )GetOutputMem(node, 0);
+    const int32_t* bias = nullptr;
+
+    if(node->GetInputNum() > 2)
+        bias = ( int32_t* )GetInputMem(node, 2);
+
+    int batch_number = in_dims[0];
+    int inh = in_dims[2];
+    int inw = in_dims[3];
+    int outh = out_dims[2];
+    int outw = out_dims[3];
+    int group = param->group;
+    int inc_g = in_dims[1] / group;
+    int m = out_dims[1] / group;
+    int k = param->kernel_h * param->kernel_w * inc_g;
+    int n = outh * outw;
+    int kernel_pack_size = i8gemm_a_pack_size(m, k);
+    int n_block = (n + I8_NB - 1) / I8_NB;
+
+    /* a 1x1 s1 convolution reads the input as the gemm operand as is */
+    bool direct = param->kernel_h == 1 && param->kernel_w == 1 && param->stride_h == 1 && param->stride_w == 1 &&
+                  param->pad_h0 == 0 && param->pad_w0 == 0 && inh == outh && inw == outw;
+
+    i8_requant rq;
+    rq.per_col = false;
+    rq.out_scale = (*output_tensor->GetQuantParam())[0].scale;
+    rq.activation = param->activation;
+
+    for(int i = 0; i < batch_number; i++)
+    {
+        for(int g = 0; g < group; g++)
+        {
+            const int8_t* cur_input = input + (i * group + g) * inc_g * inh * inw;
+            int8_t* cur_output = output + (i * group + g) * m * n;
+            const int32_t* cur_kernel = kernel_packed + g * kernel_pack_size;
+
+            rq.bias = bias ? bias + g * m : nullptr;
+            rq.scale = scale + g * m;
+
+            ParallelRun(n_block, 2, [&](int start, int end) {
+                int n_start = start * I8_NB;
+                int n_end = std::min(n, end * I8_NB);
+
+                if(direct)
+                    i8gemm_pack_b(n, k, cur_input, n, 1, input_packed, n_start, n_end);
+                else
+                    im2col_pack_int8(cur_input, input_packed, inh, inw, outw, n, k, param, n_start, n_end);
+
+                i8gemm_compute(m, n, k, cur_kernel, input_packed, cur_output, n, &rq, n_start, n_end);
+            });
+        }
+    }
+
+    return true;
+}
+
+bool ConvolutionInt8Ops::Postrun(Node* node)
+{
+    if(node->ExistAttr("int8_scale"))
+    {
+        mem_free(any_cast<float*>(node->GetAttr("int8_scale")));
+        node->RemoveAttr("int8_scale");
+    }
+
+    const char* attr_names[] = {"int8_kernel_packed", "int8_input_packed"};
+
+    for(auto name : attr_names)
+    {
+        if(node->ExistAttr(name))
+        {
+            int32_t* addr = any_cast<int32_t*>(node->GetAttr(name));
+
+            if(addr)
+                mem_free(addr);
+            node->RemoveAttr(name);
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_INT8 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+        return nullptr;
+
+    if(node->GetInputTensor(1)->GetDataType() != TENGINE_DT_INT8)
+        return nullptr;
+
+    if(node->GetInputNum() > 2 && node->GetInputTensor(2)->GetDataType() != TENGINE_DT_INT32)
+        return nullptr;
+
+    ConvolutionInt8Ops* ops = new ConvolutionInt8Ops();
+
+    return ops;
+}
+
+}    // namespace ConvolutionInt8Impl
+
+void RegisterConvInt8NodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Convolution", ConvolutionInt8Impl::SelectFunc, 100))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,430 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/convolution.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace ConvolutionNHWCImpl {
+
+/* output channels per weight panel, and output points per block of the direct convolution */
+#define NHWC_OC_BLOCK (VF_LANE * 2)
+#define NHWC_POINT_BLOCK 4
+
+struct conv_shape
+{
+    int inh;
+    int inw;
+    int inc;
+    int outh;
+    int outw;
+    int outc;
+    int kernel_h;
+    int kernel_w;
+    int stride_h;
+    int stride_w;
+    int pad_h;
+    int pad_w;
+    int dilation_h;
+    int dilation_w;
+    int activation;
+};
+
+static inline vfloat activate(vfloat v, int activation)
+{
+    if(activation >= 0)
+        v = vf_max(v, vf_set1(0.f));
+
+    if(activation > 0)
+        v = vf_min(v, vf_set1(( float )activation));
+
+    return v;
+}
+
+static inline float activate(float v, int activation)
+{
+    if(activation >= 0)
+        v = std::max(v, 0.f);
+
+    if(activation > 0)
+        v = std::min(v, ( float )activation);
+
+    return v;
+}
+
+static void get_conv_shape(Node* node, conv_shape* s)
+{
+    ConvParam* param = dynamic_cast<Convolution*>(node->GetOp())->GetParam();
+    const TShape& in_shape = node->GetInputTensor(0)->GetShape();
+    const TShape& out_shape = node->GetOutputTensor(0)->GetShape();
+
+    s->inh = in_shape.GetH();
+    s->inw = in_shape.GetW();
+    s->inc = in_shape.GetC();
+    s->outh = out_shape.GetH();
+    s->outw = out_shape.GetW();
+    s->outc = out_shape.GetC();
+    s->kernel_h = param->kernel_h;
+    s->kernel_w = param->kernel_w;
+    s->stride_h = param->stride_h;
+    s->stride_w = param->stride_w;
+    s->pad_h = param->pad_h0;
+    s->pad_w = param->pad_w0;
+    s->dilation_h = param->dilation_h;
+    s->dilation_w = param->dilation_w;
+    s->activation = param->activation;
+}
+
+/*
+ * group 1: the OHWI weight is repacked as [outc / NHWC_OC_BLOCK][kh][kw][inc][NHWC_OC_BLOCK], so that
+ * NHWC_POINT_BLOCK output points x NHWC_OC_BLOCK channels are accumulated in registers while the
+ * input rows are read in place. The taps in the padding read a row of zeros.
+ */
+static void conv_block(const float* input, const float* zero_row, const float* panel, const float* bias,
+                       float* output, const conv_shape* s, int point, int oc_start)
+{
+    const int point_num = std::min(NHWC_POINT_BLOCK, s->outh * s->outw - point);
+    const int oc_num = std::min(NHWC_OC_BLOCK, s->outc - oc_start);
+
+    int ih0[NHWC_POINT_BLOCK];
+    int iw0[NHWC_POINT_BLOCK];
+
+    for(int p = 0; p < NHWC_POINT_BLOCK; p++)
+    {
+        int cur = point + std::min(p, point_num - 1);
+
+        ih0[p] = (cur / s->outw) * s->stride_h - s->pad_h;
+        iw0[p] = (cur % s->outw) * s->stride_w - s->pad_w;
+    }
+
+    vfloat acc[NHWC_POINT_BLOCK][2];
+
+    for(int p = 0; p < NHWC_POINT_BLOCK; p++)
+    {
+        acc[p][0] = vf_set1(0.f);
+        acc[p][1] = vf_set1(0.f);
+    }
+
+    const float* w = panel;
+
+    for(int kh = 0; kh < s->kernel_h; kh++)
+    {
+        for(int kw = 0; kw < s->kernel_w; kw++)
+        {
+            const float* row[NHWC_POINT_BLOCK];
+
+            for(int p = 0; p < NHWC_POINT_BLOCK; p++)
+            {
+                int ih = ih0[p] + kh * s->dilation_h;
+                int iw = iw0[p] + kw * s->dilation_w;
+
+                if(ih < 0 || ih >= s->inh || iw < 0 || iw >= s->inw)
+                    row[p] = zero_row;
+                else
+                    row[p] = input + (ih * s->inw + iw) * s->inc;
+            }
+
+            for(int c = 0; c < s->inc; c++)
+            {
+                vfloat w0 = vf_load(w);
+                vfloat w1 = vf_load(w + VF_LANE);
+
+                for(int p = 0; p < NHWC_POINT_BLOCK; p++)
+                {
+                    vfloat v = vf_set1(row[p][c]);
+
+                    acc[p][0] = vf_fmadd(v, w0, acc[p][0]);
+                    acc[p][1] = vf_fmadd(v, w1, acc[p][1]);
+                }
+
+                w += NHWC_OC_BLOCK;
+            }
+        }
+    }
+
+    float bias_buf[NHWC_OC_BLOCK] = {0.f};
+
+    if(bias)
+        memcpy(bias_buf, bias + oc_start, oc_num * sizeof(float));
+
+    vfloat b0 = vf_load(bias_buf);
+    vfloat b1 = vf_load(bias_buf + VF_LANE);
+
+    for(int p = 0; p < point_num; p++)
+    {
+        float* out = output + (point + p) * s->outc + oc_start;
+        vfloat o0 = activate(vf_add(acc[p][0], b0), s->activation);
+        vfloat o1 = activate(vf_add(acc[p][1], b1), s->activation);
+
+        if(oc_num == NHWC_OC_BLOCK)
+        {
+            vf_store(out, o0);
+            vf_store(out + VF_LANE, o1);
+        }
+        else
+        {
+            float buf[NHWC_OC_BLOCK];
+
+            vf_store(buf, o0);
+            vf_store(buf + VF_LANE, o1);
+            memcpy(out, buf, oc_num * sizeof(float));
+        }
+    }
+}
+
+/* depthwise: the weight is [kh][kw][c], the channels of one output point are a vector */
+static void dw_point(const float* input, const float* weight, const float* bias, float* output, const conv_shape* s,
+                     int oh, int ow)
+{
+    int ih0 = oh * s->stride_h - s->pad_h;
+    int iw0 = ow * s->stride_w - s->pad_w;
+    int channel = s->inc;
+    int c = 0;
+
+    for(; c + VF_LANE <= channel; c += VF_LANE)
+    {
+        vfloat acc = bias ? vf_load(bias + c) : vf_set1(0.f);
+
+        for(int kh = 0; kh < s->kernel_h; kh++)
+        {
+            int ih = ih0 + kh * s->dilation_h;
+
+            if(ih < 0 || ih >= s->inh)
+                continue;
+
+            for(int kw = 0; kw < s->kernel_w; kw++)
+            {
+                int iw = iw0 + kw * s->dilation_w;
+
+                if(iw < 0 || iw >= s->inw)
+                    continue;
+
+                const float* in = input + (ih * s->inw + iw) * channel + c;
+                const float* w = weight + (kh * s->kernel_w + kw) * channel + c;
+
+                acc = vf_fmadd(vf_load(in), vf_load(w), acc);
+            }
+        }
+
+        vf_store(output + c, activate(acc, s->activation));
+    }
+
+    for(; c < channel; c++)
+    {
+        float acc = bias ? bias[c] : 0.f;
+
+        for(int kh = 0; kh < s->kernel_h; kh++)
+        {
+            int ih = ih0 + kh * s->dilation_h;
+
+            if(ih < 0 || ih >= s->inh)
+                continue;
+
+            for(int kw = 0; kw < s->kernel_w; kw++)
+            {
+                int iw = iw0 + kw * s->dilation_w;
+
+                if(iw < 0 || iw >= s->inw)
+                    continue;
+
+                acc += input[(ih * s->inw + iw) * channel + c] * weight[(kh * s->kernel_w + kw) * channel + c];
+            }
+        }
+
+        output[c] = activate(acc, s->activation);
+    }
+}
+
+struct ConvNHWCOps : public NodeOps
+{
+    bool Prerun(Node* node) override;
+    bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
+};
+
+bool ConvNHWCOps::Prerun(Node* node)
+{
+    conv_shape s;
+    get_conv_shape(node, &s);
+
+    const float* weight = ( float* )get_tensor_mem(node->GetInputTensor(1));
+    int kernel_size = s.kernel_h * s.kernel_w * s.inc;
+    int block_num = (s.outc + NHWC_OC_BLOCK - 1) / NHWC_OC_BLOCK;
+
+    float* panel = ( float* )mem_alloc(sizeof(float) * block_num * NHWC_OC_BLOCK * kernel_size);
+    float* zero_row = ( float* )mem_alloc(sizeof(float) * s.inc);
+
+    for(int b = 0; b < block_num; b++)
+    {
+        float* cur = panel + b * NHWC_OC_BLOCK * kernel_size;
+
+        for(int k = 0; k < kernel_size; k++)
+        {
+            for(int j = 0; j < NHWC_OC_BLOCK; j++)
+            {
+                int oc = b * NHWC_OC_BLOCK + j;
+
+                cur[k * NHWC_OC_BLOCK + j] = oc < s.outc ? weight[oc * kernel_size + k] : 0.f;
+            }
+        }
+    }
+
+    memset(zero_row, 0, sizeof(float) * s.inc);
+
+    (*node)["nhwc_panel"] = panel;
+    (*node)["nhwc_zero_row"] = zero_row;
+
+    return true;
+}
+
+bool ConvNHWCOps::Run(Node* node)
+{
+    conv_shape s;
+    get_conv_shape(node, &s);
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    const float* bias = node->GetInputNum() > 2 ? ( float* )GetInputMem(node, 2) : nullptr;
+    const float* panel = any_cast<float*>(node->GetAttr("nhwc_panel"));
+    const float* zero_row = any_cast<float*>(node->GetAttr("nhwc_zero_row"));
+
+    int batch = node->GetInputTensor(0)->GetShape().GetN();
+    int kernel_size = s.kernel_h * s.kernel_w * s.inc;
+    int block_num = (s.outc + NHWC_OC_BLOCK - 1) / NHWC_OC_BLOCK;
+    int point_size = s.outh * s.outw;
+    int point_blocks = (point_size + NHWC_POINT_BLOCK - 1) / NHWC_POINT_BLOCK;
+
+    /* one weight panel is kept hot while the points of the image are walked */
+    for(int n = 0; n < batch; n++)
+    {
+        const float* cur_input = input + n * s.inh * s.inw * s.inc;
+        float* cur_output = output + n * point_size * s.outc;
+
+        ParallelRun(block_num * point_blocks, 4, [&](int start, int end) {
+            for(int w = start; w < end; w++)
+            {
+                int b = w / point_blocks;
+                int p = (w % point_blocks) * NHWC_POINT_BLOCK;
+
+                conv_block(cur_input, zero_row, panel + b * NHWC_OC_BLOCK * kernel_size, bias, cur_output, &s, p,
+                           b * NHWC_OC_BLOCK);
+            }
+        });
+    }
+
+    return true;
+}
+
+bool ConvNHWCOps::Postrun(Node* node)
+{
+    if(node->ExistAttr("nhwc_panel"))
+    {
+        mem_free(any_cast<float*>(node->GetAttr("nhwc_panel")));
+        mem_free(any_cast<float*>(node->GetAttr("nhwc_zero_row")));
+
+        node->RemoveAttr("nhwc_panel");
+        node->RemoveAttr("nhwc_zero_row");
+    }
+
+    return true;
+}
+
+struct ConvDwNHWCOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool ConvDwNHWCOps::Run(Node* node)
+{
+    conv_shape s;
+    get_conv_shape(node, &s);
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    const float* weight = ( float* )GetInputMem(node, 1);
+    float* output = ( float* )GetOutputMem(node, 0);
+    const float* bias = node->GetInputNum() > 2 ? ( float* )GetInputMem(node, 2) : nullptr;
+
+    int batch = node->GetInputTensor(0)->GetShape().GetN();
+    int in_size = s.inh * s.inw * s.inc;
+    int out_size = s.outh * s.outw * s.outc;
+
+    ParallelRun(batch * s.outh, 1, [&](int start, int end) {
+        for(int r = start; r < end; r++)
+        {
+            int n = r / s.outh;
+            int oh = r % s.outh;
+            float* out_row = output + n * out_size + oh * s.outw * s.outc;
+
+            for(int ow = 0; ow < s.outw; ow++)
+                dw_point(input + n * in_size, weight, bias, out_row + ow * s.outc, &s, oh, ow);
+        }
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+
+    if(data_type != TENGINE_DT_FP32 || exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    if(input->GetShape().GetDim().size() != 4)
+        return nullptr;
+
+    Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
+    ConvParam* param = conv_op->GetParam();
+    int input_c = input->GetShape().GetC();
+
+    if(param->group == 1)
+        return new ConvNHWCOps();
+
+    /* a depthwise weight of multiplier 1 only */
+    if(param->group == input_c && param->output_channel == input_c)
+        return new ConvDwNHWCOps();
+
+    return nullptr;
+}
+
+}    // namespace ConvolutionNHWCImpl
+
+void RegisterConvNHWCNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Convolution", ConvolutionNHWCImpl::SelectFunc, 300))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
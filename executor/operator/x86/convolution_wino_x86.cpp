@@ -43,6 +43,7 @@
 #include "node_ops.hpp"
 #include "tensor_mem.hpp"
 #include "graph.hpp"
+#include "weight_cache.hpp"
 #include "operator/convolution.hpp"
 #include "convolution_wino_x86.h"
 #include <math.h>
@@ -68,11 +69,6 @@ struct ConvolutionWionOps : public NodeOps
 // prerun
 bool ConvolutionWionOps::Prerun(Node* node)
 {
-    Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
-    ConvParam* param = conv_op->GetParam();
-    int pad_h = param->pad_h0;
-    int pad_w = param->pad_w0;
-
     const Tensor* input_tensor = node->GetInputTensor(0);
     const TShape& input_shape = input_tensor->GetShape();
     const std::vector<int> in_dims = input_shape.GetDim();
@@ -91,15 +87,29 @@ bool ConvolutionWionOps::Prerun(Node* node)
 
     int trans_ker_size = output_c * input_c * 36 * sizeof(float);
     float* kernel_org = ( float* )get_tensor_mem(kernel_tensor);
-    float* kernel_wino = ( float* )mem_alloc(trans_ker_size);
+    float* kernel_wino = nullptr;
+
+    // transform 3x3 kernel to winograd 6x6 kernel
+    auto transform_kernel = [&](void* blob) {
+        conv3x3s1_winograd43_transform_kernel_sse(kernel_org, ( float* )blob, input_c, output_c);
+        return true;
+    };
+
+    if(WeightCacheEnabled() || WeightShareEnabled())
+    {
+        std::string cache_key = GetWeightCacheKey(cpu_info, "x86.wino43", kernel_org,
+                                                  output_c * input_c * 9 * sizeof(float), {input_c, output_c});
+        kernel_wino = ( float* )AcquireSharedWeight(cache_key, trans_ker_size, transform_kernel);
+    }
 
     int TILE = 4;
     int block_h = (output_h + TILE - 1) / TILE;
     int block_w = (output_w + TILE - 1) / TILE;
     int block = block_h * block_w;
 
-    int padded_inh = TILE * block_h + 2 * pad_h;
-    int padded_inw = TILE * block_w + 2 * pad_w;
+    /* the 6x6 input tiles of the 4x4 output blocks cover TILE * block + 2 rows and columns */
+    int padded_inh = TILE * block_h + 2;
+    int padded_inw = TILE * block_w + 2;
     int pad_inhw = padded_inh * padded_inw;
     float* input_pad = ( float* )mem_alloc(input_c * pad_inhw * sizeof(float));
     memset(input_pad, 0, input_c * pad_inhw * sizeof(float));
@@ -113,8 +123,11 @@ bool ConvolutionWionOps::Prerun(Node* node)
         output_bordered = ( float* )mem_alloc(outw * outh * output_c * sizeof(float));
     }
 
-    // transform 3x3 kernel to winograd 6x6 kernel
-    conv3x3s1_winograd43_transform_kernel_sse(kernel_org, kernel_wino, input_c, output_c);
+    if(kernel_wino == nullptr)
+    {
+        kernel_wino = ( float* )mem_alloc(trans_ker_size);
+        transform_kernel(kernel_wino);
+    }
 
     (*node)["kernel_wino"] = kernel_wino;
     (*node)["input_pad"] = input_pad;
@@ -127,36 +140,7 @@ bool ConvolutionWionOps::Prerun(Node* node)
 
 bool ConvolutionWionOps::Reshape(Node* node)
 {
-    if(node->ExistAttr("kernel_wino"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("kernel_wino"));
-        free(buffer);
-        node->RemoveAttr("kernel_wino");
-    }
-    if(node->ExistAttr("input_pad"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("input_pad"));
-        free(buffer);
-        node->RemoveAttr("input_pad");
-    }
-    if(node->ExistAttr("dot_block"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("dot_block"));
-        free(buffer);
-        node->RemoveAttr("dot_block");
-    }
-    if(node->ExistAttr("transform_input"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("transform_input"));
-        free(buffer);
-        node->RemoveAttr("transform_input");
-    }
-    if(node->ExistAttr("output_bordered"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("output_bordered"));
-        free(buffer);
-        node->RemoveAttr("output_bordered");
-    }
+    Postrun(node);
 
     return Prerun(node);
 }
@@ -180,7 +164,7 @@ bool ConvolutionWionOps::Run(Node* node)
 
     /* input */
     Tensor* input_tensor = node->GetInputTensor(0);
-    float* input = ( float* )get_tensor_mem(input_tensor);
+    float* input = ( float* )GetInputMem(node, 0);
     const TShape& input_shape = input_tensor->GetShape();
     int input_c = input_shape.GetC();
     int input_h = input_shape.GetH();
@@ -189,7 +173,7 @@ bool ConvolutionWionOps::Run(Node* node)
     int inp_chw = input_c * input_h * input_w;
     /* output */
     Tensor* output_tensor = node->GetOutputTensor(0);
-    float* output = ( float* )get_tensor_mem(output_tensor);
+    float* output = ( float* )GetOutputMem(node, 0);
     const TShape& output_shape = output_tensor->GetShape();
     int output_h = output_shape.GetH();
     int output_w = output_shape.GetW();
@@ -199,8 +183,7 @@ bool ConvolutionWionOps::Run(Node* node)
     int output_n = output_shape.GetN();
     /* weight */
     float* kernel_wino = any_cast<float*>(node->GetAttr("kernel_wino"));
-    Tensor* weight_tensor = node->GetInputTensor(1);
-    float* kernel = ( float* )get_tensor_mem(weight_tensor);
+    float* kernel = ( float* )GetInputMem(node, 1);
 
     float* dot_block = any_cast<float*>(node->GetAttr("dot_block"));
     float* transform_input = any_cast<float*>(node->GetAttr("transform_input"));
@@ -225,17 +208,16 @@ bool ConvolutionWionOps::Run(Node* node)
     float* biases = nullptr;
     if(have_biases)
     {
-        biases = ( float* )get_tensor_mem(node->GetInputTensor(2));
+        biases = ( float* )GetInputMem(node, 2);
     }
 
     int block_h = (output_h + TILE - 1) / TILE;
     int block_w = (output_w + TILE - 1) / TILE;
     int block_hw = block_h * block_w;
-    int padded_inh = TILE * block_h + 2 * pad_h;
-    int padded_inw = TILE * block_w + 2 * pad_w;
+    int padded_inh = TILE * block_h + 2;
+    int padded_inw = TILE * block_w + 2;
 
     float* input_pad = any_cast<float*>(node->GetAttr("input_pad"));
-    pad_0_align_3D(input_pad, input, input_h, input_w, padded_inh, padded_inw, input_c, pad_h, pad_w);
 
     if(debug_conv)
     {
@@ -243,14 +225,21 @@ bool ConvolutionWionOps::Run(Node* node)
                   << pad_h << " " << dilation_w << " " << group << "\t" << output_c << " " << output_h << " "
                   << output_w << "\t";
     }
+    /* input_pad holds one image, winograd is only selected for group 1 */
     for(int i = 0; i < batch_number; i++)
     {
-        for(int g = 0; g < group; g++)
+        float* input_tiles = input + i * inp_chw;
+
+        /* only an unpadded input that the blocks cover exactly is read in place */
+        if(input_h != padded_inh || input_w != padded_inw)
         {
-            conv3x3s1_winograd43_sse(input_pad + i * in_chw + g * in_chw_g, output, kernel_wino, dot_block,
-                                     transform_input, output_bordered, biases, padded_inw, padded_inh, input_c,
-                                     output_w, output_h, output_c);
+            pad_0_align_3D(input_pad, input_tiles, input_h, input_w, padded_inh, padded_inw, input_c, pad_h, pad_w);
+            input_tiles = input_pad;
         }
+
+        conv3x3s1_winograd43_sse(input_tiles, output + i * out_chw, kernel_wino, dot_block, transform_input,
+                                 output_bordered, biases, padded_inw, padded_inh, input_c, output_w, output_h,
+                                 output_c);
     }
 
     if(activation >= 0)
@@ -272,7 +261,8 @@ bool ConvolutionWionOps::Postrun(Node* node)
     if(node->ExistAttr("kernel_wino"))
     {
         addr = any_cast<float*>(node->GetAttr("kernel_wino"));
-        mem_free(addr);
+        if(!ReleaseSharedWeight(addr))
+            mem_free(addr);
         node->RemoveAttr("kernel_wino");
     }
     if(node->ExistAttr("input_pad"))
@@ -31,7 +31,9 @@
 #include "node_ops.hpp"
 #include "tensor_mem.hpp"
 #include "graph.hpp"
+#include "weight_cache.hpp"
 #include "operator/convolution.hpp"
+#include "fused_epilogue.hpp"
 #include "convolution_x86.h"
 #include <math.h>
 
@@ -41,14 +43,17 @@ namespace ConvolutionImpl {
 
 struct ConvolutionOps : public NodeOps
 {
+    ConvolutionOps()
+    {
+        fused_epilogue = true;
+    }
+
     bool Prerun(Node* node) override;
     bool Run(Node* node) override;
     bool Postrun(Node* node) override;
     bool Reshape(Node* node) override;
     void im2col(float* data_img, float* data_col, int inh, int inw, int inc, int outh, int outw, int outc, int ksize_h,
                 int ksize_w, int sh, int sw, int ph, int pw, int dh, int dw);
-    void relu(float* data, int size, int activation);
-    void add_bias(float* output, float* bias, int c_out, int hw);
 };
 
 void ConvolutionOps::im2col(float* data_img, float* data_col, int inh, int inw, int inc, int outh, int outw, int outc,
@@ -92,28 +97,7 @@ void ConvolutionOps::im2col(float* data_img, float* data_col, int inh, int inw,
         }
     }
 }
-void ConvolutionOps::relu(float* data, int size, int activation)
-{
-    for(int i = 0; i < size; i++)
-    {
-        data[i] = std::max(data[i], ( float )0);
 
-        if(activation > 0)
-        {
-            data[i] = std::min(data[i], ( float )activation);
-        }
-    }
-}
-void ConvolutionOps::add_bias(float* output, float* bias, int c_out, int hw)
-{
-    for(int c = 0; c < c_out; ++c)
-    {
-        for(int i = 0; i < hw; ++i)
-        {
-            output[c * hw + i] += bias[c];
-        }
-    }
-}
 bool ConvolutionOps::Prerun(Node* node)
 {
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
@@ -123,24 +107,61 @@ bool ConvolutionOps::Prerun(Node* node)
     const TShape& shape = input_tensor->GetShape();
     const std::vector<int> in_dims = shape.GetDim();
 
+    const Tensor* kernel_tensor = node->GetInputTensor(1);
+
     Tensor* output_tensor = node->GetOutputTensor(0);
     TShape& shape1 = output_tensor->GetShape();
     std::vector<int> out_dims = shape1.GetDim();
 
-    int size = param->kernel_h * param->kernel_w * in_dims[1] / param->group * out_dims[2] * out_dims[3];
-    float* buffer = ( float* )std::malloc(sizeof(float) * size);
+    int group = param->group;
+    int m = out_dims[1] / group;
+    int k = param->kernel_h * param->kernel_w * in_dims[1] / group;
+    int n = out_dims[2] * out_dims[3];
+
+    float* buffer = nullptr;
+
+    /* a 1x1 stride 1 conv without padding reads the input as the im2col matrix */
+    if(param->kernel_h != 1 || param->kernel_w != 1 || param->stride_h != 1 || param->stride_w != 1 ||
+       out_dims[2] != in_dims[2] || out_dims[3] != in_dims[3])
+        buffer = ( float* )mem_alloc(sizeof(float) * k * n);
+
+    /* the kernel panels of every group are packed once here, the input panels on each run */
+    int kernel_pack_size = sgemm_kernel_pack_size(m, k);
+    float* kernel_org = ( float* )get_tensor_mem(kernel_tensor);
+    float* input_interleaved = ( float* )mem_alloc(sizeof(float) * sgemm_input_pack_size(n, k));
+    int kernel_interleaved_size = sizeof(float) * kernel_pack_size * group;
+    float* kernel_interleaved = nullptr;
+
+    auto pack_kernel = [&](void* blob) {
+        for(int g = 0; g < group; g++)
+            sgemm_pack_kernel(m, k, kernel_org + g * m * k, ( float* )blob + g * kernel_pack_size);
+
+        return true;
+    };
+
+    if(WeightCacheEnabled() || WeightShareEnabled())
+    {
+        std::string cache_key =
+            GetWeightCacheKey(cpu_info, "x86.sgemm", kernel_org, sizeof(float) * m * k * group, {m, k, group});
+        kernel_interleaved = ( float* )AcquireSharedWeight(cache_key, kernel_interleaved_size, pack_kernel);
+    }
+
+    if(kernel_interleaved == nullptr)
+    {
+        kernel_interleaved = ( float* )mem_alloc(kernel_interleaved_size);
+        pack_kernel(kernel_interleaved);
+    }
+
     (*node)["buffer"] = buffer;
+    (*node)["kernel_interleaved"] = kernel_interleaved;
+    (*node)["input_interleaved"] = input_interleaved;
+
     return true;
 }
 
 bool ConvolutionOps::Reshape(Node* node)
 {
-    if(node->ExistAttr("buffer"))
-    {
-        float* buffer = any_cast<float*>(node->GetAttr("buffer"));
-        free(buffer);
-        node->RemoveAttr("buffer");
-    }
+    Postrun(node);
 
     return Prerun(node);
 }
@@ -156,16 +177,16 @@ bool ConvolutionOps::Run(Node* node)
 
     Tensor* input_tensor = node->GetInputTensor(0);
     Tensor* output_tensor = node->GetOutputTensor(0);
-    Tensor* weight_tensor = node->GetInputTensor(1);
     float* buffer = any_cast<float*>(node->GetAttr("buffer"));
+    float* kernel_interleaved = any_cast<float*>(node->GetAttr("kernel_interleaved"));
+    float* input_interleaved = any_cast<float*>(node->GetAttr("input_interleaved"));
 
     Convolution* conv_op = dynamic_cast<Convolution*>(node->GetOp());
     ConvParam* param = conv_op->GetParam();
     int activation = param->activation;
 
-    float* input = ( float* )get_tensor_mem(input_tensor);
-    float* output = ( float* )get_tensor_mem(output_tensor);
-    float* kernel = ( float* )get_tensor_mem(weight_tensor);
+    float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
 
     const TShape& shape = input_tensor->GetShape();
     const std::vector<int> in_dims = shape.GetDim();
@@ -204,11 +225,40 @@ bool ConvolutionOps::Run(Node* node)
 
     int in_chw_g = inh * inw * inc_g;
     int out_chw_g = outc_g * out_hw;
-    int kernel_size_g = outc_g * ksize_h * ksize_w * inc_g;
+    int kernel_pack_size_g = sgemm_kernel_pack_size(m, k);
 
     bool have_biases = (node->GetInputNum() > 2);
     float* biases = nullptr;
 
+    if(have_biases)
+        biases = ( float* )GetInputMem(node, 2);
+
+    /* the fused epilogue runs on each block of columns just after its gemm */
+    FusedEpilogue ep;
+    bool have_epilogue = node->ExistAttr(ATTR_FUSED_EPILOGUE);
+    float* residual = nullptr;
+    float* slope = nullptr;
+
+    if(have_epilogue)
+    {
+        ep = any_cast<FusedEpilogue>(node->GetAttr(ATTR_FUSED_EPILOGUE));
+
+        if(ep.residual_idx >= 0)
+            residual = ( float* )GetInputMem(node, ep.residual_idx);
+        if(ep.slope_idx >= 0)
+            slope = ( float* )GetInputMem(node, ep.slope_idx);
+    }
+
+    bool need_im2col = (buffer != nullptr);
+
+    /* im2col is split by input channels, the gemm by blocks of 8 output columns */
+    int cpu_number = GetWorkerNumber();
+    int im2col_task = std::min(cpu_number, inc_g);
+    int im2col_step = (inc_g + im2col_task - 1) / im2col_task;
+    int n_block = (n + 7) / 8;
+    int gemm_task = std::min(cpu_number, n_block);
+    int gemm_step = (n_block + gemm_task - 1) / gemm_task;
+
     if(debug_conv)
     {
         std::cout << inc << " " << inh << " " << inw << "\tksp dg: " << ksize_h << " " << stride_h << " " << pad_h
@@ -219,23 +269,63 @@ bool ConvolutionOps::Run(Node* node)
     {
         for(int g = 0; g < group; g++)
         {
-            im2col(input + i * in_chw + g * in_chw_g, buffer, inh, inw, inc_g, outh, outw, outc_g, ksize_h, ksize_w,
-                   stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w);
-            sgemm(m, n, k, kernel + g * kernel_size_g, buffer, output + i * out_chw + g * out_chw_g);
-        }
-    }
-    if(have_biases)
-    {
-        biases = ( float* )get_tensor_mem(node->GetInputTensor(2));
-        for(int i = 0; i < batch_number; i++)
-        {
-            add_bias(output + i * out_chw, biases, outc, out_hw);
+            float* cur_input = input + i * in_chw + g * in_chw_g;
+            float* cur_output = output + i * out_chw + g * out_chw_g;
+            float* cur_kernel = kernel_interleaved + g * kernel_pack_size_g;
+            float* cur_biases = have_biases ? biases + g * outc_g : nullptr;
+            float* cur_residual = residual ? residual + i * out_chw + g * out_chw_g : nullptr;
+            float* cur_slope = slope ? slope + g * outc_g : nullptr;
+            float* col = cur_input;
+
+            if(need_im2col)
+            {
+                col = buffer;
+
+                if(im2col_task == 1)
+                    im2col(cur_input, buffer, inh, inw, inc_g, outh, outw, outc_g, ksize_h, ksize_w, stride_h, stride_w,
+                           pad_h, pad_w, dilation_h, dilation_w);
+                else
+                {
+                    MULTI_THREAD_START(im2col_task, im2col_step, p_id, p_param)
+                        int c_start = p_id * im2col_step;
+                        int c_end = std::min(inc_g, c_start + im2col_step);
+
+                        if(c_start < c_end)
+                            im2col(cur_input + c_start * inh * inw, buffer + c_start * ksize_h * ksize_w * n, inh, inw,
+                                   c_end - c_start, outh, outw, outc_g, ksize_h, ksize_w, stride_h, stride_w, pad_h,
+                                   pad_w, dilation_h, dilation_w);
+                    MULTI_THREAD_END();
+                }
+            }
+
+            if(gemm_task == 1)
+            {
+                sgemm_pack_input(n, k, col, input_interleaved, 0, n);
+                sgemm_compute(m, n, k, cur_kernel, input_interleaved, cur_output, 0, n, cur_biases, activation);
+
+                if(have_epilogue)
+                    RunFusedEpilogue(&ep, cur_output, cur_residual, cur_slope, m, n, 0, n);
+            }
+            else
+            {
+                MULTI_THREAD_START(gemm_task, gemm_step, p_id, p_param)
+                    int n_start = p_id * gemm_step * 8;
+                    int n_end = std::min(n, n_start + gemm_step * 8);
+
+                    if(n_start < n_end)
+                    {
+                        sgemm_pack_input(n, k, col, input_interleaved, n_start, n_end);
+                        sgemm_compute(m, n, k, cur_kernel, input_interleaved, cur_output, n_start, n_end, cur_biases,
+                                      activation);
+
+                        if(have_epilogue)
+                            RunFusedEpilogue(&ep, cur_output, cur_residual, cur_slope, m, n, n_start, n_end);
+                    }
+                MULTI_THREAD_END();
+            }
         }
     }
-    if(activation >= 0)
-    {
-        relu(output, batch_number * out_chw, activation);
-    }
+
     if(debug_conv)
     {
         std::cout << output[0] << " " << output[10] << "\n";
@@ -246,12 +336,20 @@ bool ConvolutionOps::Run(Node* node)
 
 bool ConvolutionOps::Postrun(Node* node)
 {
-    float* addr;
-    if(node->ExistAttr("buffer"))
+    const char* attr_names[] = {"buffer", "kernel_interleaved", "input_interleaved"};
+
+    for(auto name : attr_names)
     {
-        addr = any_cast<float*>(node->GetAttr("buffer"));
-        std::free(addr);
+        if(node->ExistAttr(name))
+        {
+            float* addr = any_cast<float*>(node->GetAttr(name));
+
+            if(addr && !ReleaseSharedWeight(addr))
+                mem_free(addr);
+            node->RemoveAttr(name);
+        }
     }
+
     return true;
 }
 
@@ -39,6 +39,7 @@
 #define __CONVOLUTION_X86_H__
 
 #include <stdlib.h>
+#include <algorithm>
 
 #if __SSE2__
 #include <emmintrin.h>
@@ -47,6 +48,65 @@
 #include <immintrin.h>
 #endif
 
+// add the bias and apply relu/relu6 on the output columns [n_start, n_end) of every output channel
+static void sgemm_epilogue(int M, int N, float* pC, int n_start, int n_end, const float* bias, int activation)
+{
+    if(bias == nullptr && activation < 0)
+        return;
+
+    for(int i = 0; i < M; i++)
+    {
+        float* output = pC + i * N;
+        float b = bias ? bias[i] : 0.f;
+        int j = n_start;
+
+#if __AVX__
+        __m256 _bias = _mm256_set1_ps(b);
+        __m256 _zero = _mm256_setzero_ps();
+        __m256 _max = _mm256_set1_ps(( float )activation);
+
+        for(; j + 7 < n_end; j += 8)
+        {
+            __m256 _out = _mm256_add_ps(_mm256_loadu_ps(output + j), _bias);
+
+            if(activation >= 0)
+                _out = _mm256_max_ps(_out, _zero);
+            if(activation > 0)
+                _out = _mm256_min_ps(_out, _max);
+
+            _mm256_storeu_ps(output + j, _out);
+        }
+#elif __SSE2__
+        __m128 _bias = _mm_set1_ps(b);
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _max = _mm_set1_ps(( float )activation);
+
+        for(; j + 3 < n_end; j += 4)
+        {
+            __m128 _out = _mm_add_ps(_mm_loadu_ps(output + j), _bias);
+
+            if(activation >= 0)
+                _out = _mm_max_ps(_out, _zero);
+            if(activation > 0)
+                _out = _mm_min_ps(_out, _max);
+
+            _mm_storeu_ps(output + j, _out);
+        }
+#endif
+        for(; j < n_end; j++)
+        {
+            float out = output[j] + b;
+
+            if(activation >= 0)
+                out = std::max(out, 0.f);
+            if(activation > 0)
+                out = std::min(out, ( float )activation);
+
+            output[j] = out;
+        }
+    }
+}
+
 #if __AVX__
 // int M = outch;       // outch
 // int N = outw * outh; // outsize or out stride
@@ -54,11 +114,19 @@
 // float* pA = kernel
 // float* pB = input_data
 // float* pC = output_data
-static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop output M, unloop N, packet 8x8, using intrinsic
+static int sgemm_kernel_pack_size(int M, int K)
+{
+    return 8 * K * (M / 8 + (M % 8) / 4 + M % 4);
+}
+
+static int sgemm_input_pack_size(int N, int K)
+{
+    return 8 * K * (N / 8 + N % 8);
+}
+
+// kernel pack 8, done once at prerun
+static void sgemm_pack_kernel(int M, int K, const float* pA, float* pA_t)
 {
-    // printf("sgemm avx2 start\n");
-    // kernel pack 8
-    float* pA_t = (float* )malloc((8*K * (M/8 + (M%8)/4 + M%4)) * sizeof(float));
     {
         int nn_outch = M >> 3;
         int remain_outch_start = nn_outch << 3;
@@ -145,19 +213,17 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
             }
         }
     }
+}
 
-    // printf("kernel interleave\n");
-
-    // data, col2row, pack 8x8
-    float* pB_t = (float* )malloc((8*K * (N/8 + N%8)) * sizeof(float));
+// data, col2row, pack the columns [n_start, n_end) of the im2col buffer, n_start is a multiple of 8
+static void sgemm_pack_input(int N, int K, const float* pB, float* pB_t, int n_start, int n_end)
+{
     {
-        int nn_size = N >> 3;
-        int remian_size_start = nn_size << 3;
+        int remian_size_start = (N >> 3) << 3;
 
         // [ch00, ch10, ch20, ch30, ch40, ch50, ch60, ch70, ch10, ch11, ch12, ch13, ch14, ch15, ch16, ch17 ....]
-        for (int ii=0; ii<nn_size; ii++)
+        for (int i=n_start; i+7<n_end; i+=8)
         {
-            int i = ii * 8;
             const float* img = pB + i;
             float* tmp = pB_t + (i/8) * 8*K;
 
@@ -181,7 +247,7 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
         }
 
         // [ch00, ch01, ch02, ch03 ....]
-        for (int i=remian_size_start; i<N; i++)
+        for (int i=std::max(n_start, remian_size_start); i<n_end; i++)
         {
             const float* img = pB + i;
             float* tmp = pB_t + (i/8 + i%8) * 8*K;
@@ -195,9 +261,12 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
             }
         }
     }
+}
 
-    // printf("data interleave\n");
-
+// compute the output columns [n_start, n_end) with the packed kernel and data, then run the epilogue on them
+static void sgemm_compute(int M, int N, int K, const float* pA_t, const float* pB_t, float* pC, int n_start, int n_end,
+                          const float* bias, int activation)
+{
     int nn_outch = 0;
     int remain_outch_start = 0;
 
@@ -209,20 +278,20 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
     {
         int i = pp * 8;
 
-        float* output0 = pC + (i  )*N;
-        float* output1 = pC + (i+1)*N;
-        float* output2 = pC + (i+2)*N;
-        float* output3 = pC + (i+3)*N;
-        float* output4 = pC + (i+4)*N;
-        float* output5 = pC + (i+5)*N;
-        float* output6 = pC + (i+6)*N;
-        float* output7 = pC + (i+7)*N;
-
-        int j=0;
-        for (; j+7<N; j+=8)
+        float* output0 = pC + (i  )*N + n_start;
+        float* output1 = pC + (i+1)*N + n_start;
+        float* output2 = pC + (i+2)*N + n_start;
+        float* output3 = pC + (i+3)*N + n_start;
+        float* output4 = pC + (i+4)*N + n_start;
+        float* output5 = pC + (i+5)*N + n_start;
+        float* output6 = pC + (i+6)*N + n_start;
+        float* output7 = pC + (i+7)*N + n_start;
+
+        int j=n_start;
+        for (; j+7<n_end; j+=8)
         {
-            float* va = pA_t + (i/8) * 8*K;
-            float* vb = pB_t + (j/8) * 8*K;
+            const float* va = pA_t + (i/8) * 8*K;
+            const float* vb = pB_t + (j/8) * 8*K;
 #if __AVX__
             __m256 _sum0 = _mm256_set1_ps(0.0);
             __m256 _sum1 = _mm256_set1_ps(0.0);
@@ -405,10 +474,10 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
             output7 += 8;
         }
 
-        for (; j<N; j++)
+        for (; j<n_end; j++)
         {
-            float* va = pA_t + (i/8) * 8*K;
-            float* vb = pB_t + (j/8 + j%8) * 8*K;
+            const float* va = pA_t + (i/8) * 8*K;
+            const float* vb = pB_t + (j/8 + j%8) * 8*K;
 
 #if __AVX__
             __m256 _sum0_7 = _mm256_set1_ps(0.0);
@@ -515,16 +584,16 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
     {
         int i = remain_outch_start + pp * 4;
 
-        float* output0 = pC + (i  )*N;
-        float* output1 = pC + (i+1)*N;
-        float* output2 = pC + (i+2)*N;
-        float* output3 = pC + (i+3)*N;
+        float* output0 = pC + (i  )*N + n_start;
+        float* output1 = pC + (i+1)*N + n_start;
+        float* output2 = pC + (i+2)*N + n_start;
+        float* output3 = pC + (i+3)*N + n_start;
 
-        int j=0;
-        for (; j+7<N; j+=8)
+        int j=n_start;
+        for (; j+7<n_end; j+=8)
         {
-            float* va = pA_t + (i/8 + (i%8)/4) * 8*K;
-            float* vb = pB_t + (j/8) * 8*K;
+            const float* va = pA_t + (i/8 + (i%8)/4) * 8*K;
+            const float* vb = pB_t + (j/8) * 8*K;
 #if __AVX__
             __m256 _sum0 = _mm256_set1_ps(0.0);
             __m256 _sum1 = _mm256_set1_ps(0.0);
@@ -643,10 +712,10 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
             output3 += 8;
         }
 
-        for (; j<N; j++)
+        for (; j<n_end; j++)
         {
-            float* va = pA_t + (i/8 + (i%8)/4) * 8*K;
-            float* vb = pB_t + (j/8 + j%8) * 8*K;
+            const float* va = pA_t + (i/8 + (i%8)/4) * 8*K;
+            const float* vb = pB_t + (j/8 + j%8) * 8*K;
 #if __AVX__
             __m128 _sum0_3 = _mm_set1_ps(0.0);
             __m128 _sum0 = _mm_set1_ps(0.0);
@@ -730,13 +799,13 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
     // output ch0
     for (int i=remain_outch_start; i<M; i++)
     {
-        float* output = pC + i*N;
+        float* output = pC + i*N + n_start;
 
-        int j=0;
-        for (; j+7<N; j+=8)
+        int j=n_start;
+        for (; j+7<n_end; j+=8)
         {
-            float* va = pA_t + (i/8 + (i%8)/4 + i%4) * 8*K;
-            float* vb = pB_t + (j/8) * 8*K;
+            const float* va = pA_t + (i/8 + (i%8)/4 + i%4) * 8*K;
+            const float* vb = pB_t + (j/8) * 8*K;
 #if __AVX__
             __m256 _sum0 = _mm256_set1_ps(0.0);
 
@@ -797,10 +866,10 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
             output += 8;
         }
 
-        for (; j<N; j++)
+        for (; j<n_end; j++)
         {
-            float* va = pA_t + (i/8 + (i%8)/4 + i%4) * 8*K;
-            float* vb = pB_t + (j/8 + j%8) * 8*K;
+            const float* va = pA_t + (i/8 + (i%8)/4 + i%4) * 8*K;
+            const float* vb = pB_t + (j/8 + j%8) * 8*K;
 
             int k=0;
 #if __AVX__
@@ -832,10 +901,7 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
         }
     }
 
-    // printf("sgemm avx2 done\n");
-
-    free(pA_t);
-    free(pB_t);
+    sgemm_epilogue(M, N, pC, n_start, n_end, bias, activation);
 }
 #else // SSE2
 // int M = outch;       // outch
@@ -844,10 +910,19 @@ static void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloo
 // float* pA = kernel
 // float* pB = input_data
 // float* pC = output_data
-void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop output M, unloop N, packet 4x4, using intrinsic
+static int sgemm_kernel_pack_size(int M, int K)
+{
+    return 4 * K * (M / 4 + M % 4);
+}
+
+static int sgemm_input_pack_size(int N, int K)
+{
+    return 4 * K * (N / 4 + N % 4);
+}
+
+// kernel pack 4, done once at prerun
+static void sgemm_pack_kernel(int M, int K, const float* pA, float* pA_t)
 {
-    // kernel pack 4
-    float* pA_t = (float* )malloc((4*K * (M/4 + M%4)) * sizeof(float));
     {
         int nn_outch = M >> 2;
         int remain_outch_start = nn_outch << 2;
@@ -892,17 +967,17 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
             }
         }
     }
+}
 
-    // data, col2row, pack
-    float* pB_t = (float* )malloc((4*K * (N/4 + N%4)) * sizeof(float));
+// data, col2row, pack the columns [n_start, n_end) of the im2col buffer, n_start is a multiple of 8
+static void sgemm_pack_input(int N, int K, const float* pB, float* pB_t, int n_start, int n_end)
+{
     {
-        int nn_size = N >> 2;
-        int remian_size_start = nn_size << 2;
+        int remian_size_start = (N >> 2) << 2;
 
         // [ch00, ch10, ch20, ch30, ch01, ch11, ch21, ch31, ch02, ch12, ch22, ch32, ch03, ch13, ch23, ch33 ....]
-        for (int ii=0; ii<nn_size; ii++)
+        for (int i=n_start; i+3<n_end; i+=4)
         {
-            int i = ii * 4;
             const float* img = pB + i;
             float* tmp = pB_t + (i/4) * 4*K;
 
@@ -922,7 +997,7 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
         }
 
         // [ch00, ch01, ch02, ch03 ....]   
-        for (int i=remian_size_start; i<N; i++)
+        for (int i=std::max(n_start, remian_size_start); i<n_end; i++)
         {
             const float* img = pB + i;
             float* tmp = pB_t + (i/4 + i%4) * 4*K;
@@ -936,21 +1011,26 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
             }                
         }
     }
+}
 
+// compute the output columns [n_start, n_end) with the packed kernel and data, then run the epilogue on them
+static void sgemm_compute(int M, int N, int K, const float* pA_t, const float* pB_t, float* pC, int n_start, int n_end,
+                          const float* bias, int activation)
+{
     // output ch0 - ch3
     int i=0;
     for (; i+3<M; i+=4)
     {
-        float* output0 = pC + (i  )*N;
-        float* output1 = pC + (i+1)*N;
-        float* output2 = pC + (i+2)*N;
-        float* output3 = pC + (i+3)*N;
+        float* output0 = pC + (i  )*N + n_start;
+        float* output1 = pC + (i+1)*N + n_start;
+        float* output2 = pC + (i+2)*N + n_start;
+        float* output3 = pC + (i+3)*N + n_start;
 
-        int j=0;
-        for (; j+3<N; j+=4)
+        int j=n_start;
+        for (; j+3<n_end; j+=4)
         {
-            float* va = pA_t + (i/4) * 4*K;
-            float* vb = pB_t + (j/4) * 4*K;
+            const float* va = pA_t + (i/4) * 4*K;
+            const float* vb = pB_t + (j/4) * 4*K;
 #if __SSE__
             __m128 _sum0 = _mm_set1_ps(0.f);
             __m128 _sum1 = _mm_set1_ps(0.f);
@@ -1062,10 +1142,10 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
             output3 += 4;
         }
 
-        for (; j<N; j++)
+        for (; j<n_end; j++)
         {
-            float* va = pA_t + (i/4) * 4*K;
-            float* vb = pB_t + (j/4 + j%4) * 4*K;
+            const float* va = pA_t + (i/4) * 4*K;
+            const float* vb = pB_t + (j/4 + j%4) * 4*K;
 
 #if __SSE__
             __m128 _sum0_3 = _mm_set1_ps(0.f);
@@ -1145,13 +1225,13 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
     // output ch0
     for (; i<M; i++)
     {
-        float* output = pC + i*N;
+        float* output = pC + i*N + n_start;
 
-        int j=0;
-        for (; j+3<N; j+=4)
+        int j=n_start;
+        for (; j+3<n_end; j+=4)
         {
-            float* va = pA_t + (i/4 + i%4) * 4*K;
-            float* vb = pB_t + (j/4) * 4*K;
+            const float* va = pA_t + (i/4 + i%4) * 4*K;
+            const float* vb = pB_t + (j/4) * 4*K;
 #if __SSE__
             __m128 _sum0 = _mm_set1_ps(0.f);
 
@@ -1211,10 +1291,10 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
             output += 4;
         }
 
-        for (; j<N; j++)
+        for (; j<n_end; j++)
         {
-            float* va = pA_t + (i/4 + i%4) * 4*K;
-            float* vb = pB_t + (j/4 + j%4) * 4*K;
+            const float* va = pA_t + (i/4 + i%4) * 4*K;
+            const float* vb = pB_t + (j/4 + j%4) * 4*K;
 
             int k=0;
 #if __SSE__
@@ -1246,8 +1326,7 @@ void sgemm(int M, int N, int K, float* pA, float* pB, float* pC) // unloop outpu
         }
     }
 
-    free(pA_t);
-    free(pB_t);
+    sgemm_epilogue(M, N, pC, n_start, n_end, bias, activation);
 }
 #endif // __AVX2__
 
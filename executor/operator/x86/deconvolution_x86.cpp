@@ -0,0 +1,268 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/deconvolution.hpp"
+#include "convolution_x86.h"
+
+namespace TEngine {
+
+namespace DeconvolutionImpl {
+
+/*
+ * deconvolution as a gemm plus col2im:
+ *   col[outc_g * kh * kw][inh * inw] = kernel^T * input
+ * and every column of col is scattered back to the output window it came from.
+ */
+struct DeconvolutionOps : public NodeOps
+{
+    bool Prerun(Node* node) override;
+    bool Reshape(Node* node) override;
+    bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
+};
+
+/* accumulate the columns of output channel c into its output plane, then bias and activation */
+static void col2im_channel(const float* col, float* output, const float* bias, int c, int inh, int inw, int outh,
+                           int outw, const DeconvParam* p)
+{
+    int ksize = p->kernel_h * p->kernel_w;
+    int n = inh * inw;
+    float b = bias ? bias[c] : 0.f;
+
+    for(int i = 0; i < outh * outw; i++)
+        output[i] = b;
+
+    for(int kh = 0; kh < p->kernel_h; kh++)
+    {
+        for(int kw = 0; kw < p->kernel_w; kw++)
+        {
+            const float* cur_col = col + (c * ksize + kh * p->kernel_w + kw) * n;
+            int off_x = kw * p->dilation_w - p->pad_w0;
+            int off_y = kh * p->dilation_h - p->pad_h0;
+
+            /* the input columns whose output x lands inside the plane */
+            int w_low = 0;
+            while(w_low < inw && w_low * p->stride_w + off_x < 0)
+                w_low++;
+            int w_high = inw;
+            while(w_high > w_low && (w_high - 1) * p->stride_w + off_x >= outw)
+                w_high--;
+
+            for(int h = 0; h < inh; h++)
+            {
+                int y = h * p->stride_h + off_y;
+
+                if(y < 0 || y >= outh)
+                    continue;
+
+                const float* in = cur_col + h * inw;
+                float* out = output + y * outw + off_x;
+
+                if(p->stride_w == 1)
+                {
+                    for(int w = w_low; w < w_high; w++)
+                        out[w] += in[w];
+                }
+                else
+                {
+                    for(int w = w_low; w < w_high; w++)
+                        out[w * p->stride_w] += in[w];
+                }
+            }
+        }
+    }
+
+    /* the activation codes of the reference deconvolution: 0 relu, 1 relu1, 2 relu6 */
+    if(p->activation >= 0)
+    {
+        float max = p->activation == 1 ? 1.f : (p->activation == 2 ? 6.f : 0.f);
+
+        for(int i = 0; i < outh * outw; i++)
+        {
+            float v = std::max(output[i], 0.f);
+
+            if(p->activation == 1 || p->activation == 2)
+                v = std::min(v, max);
+
+            output[i] = v;
+        }
+    }
+}
+
+bool DeconvolutionOps::Prerun(Node* node)
+{
+    Deconvolution* deconv_op = dynamic_cast<Deconvolution*>(node->GetOp());
+    DeconvParam* param = deconv_op->GetParam();
+
+    const std::vector<int>& in_dims = node->GetInputTensor(0)->GetShape().GetDim();
+    const std::vector<int>& out_dims = node->GetOutputTensor(0)->GetShape().GetDim();
+
+    int group = param->group;
+    int m = out_dims[1] / group * param->kernel_h * param->kernel_w;
+    int k = in_dims[1] / group;
+    int n = in_dims[2] * in_dims[3];
+
+    /* the weight is stored [inc_g][outc_g * kh * kw] per group, the gemm wants it transposed */
+    const float* kernel_org = ( float* )GetInputMem(node, 1);
+    int kernel_pack_size = sgemm_kernel_pack_size(m, k);
+    float* kernel_interleaved = ( float* )mem_alloc(sizeof(float) * kernel_pack_size * group);
+    float* kernel_t = ( float* )mem_alloc(sizeof(float) * m * k);
+
+    for(int g = 0; g < group; g++)
+    {
+        const float* cur_kernel = kernel_org + g * m * k;
+
+        for(int i = 0; i < m; i++)
+            for(int j = 0; j < k; j++)
+                kernel_t[i * k + j] = cur_kernel[j * m + i];
+
+        sgemm_pack_kernel(m, k, kernel_t, kernel_interleaved + g * kernel_pack_size);
+    }
+
+    mem_free(kernel_t);
+
+    (*node)["kernel_interleaved"] = kernel_interleaved;
+    (*node)["input_interleaved"] = ( float* )mem_alloc(sizeof(float) * sgemm_input_pack_size(n, k));
+    (*node)["col_buffer"] = ( float* )mem_alloc(sizeof(float) * m * n);
+
+    return true;
+}
+
+bool DeconvolutionOps::Reshape(Node* node)
+{
+    Postrun(node);
+
+    return Prerun(node);
+}
+
+bool DeconvolutionOps::Run(Node* node)
+{
+    Deconvolution* deconv_op = dynamic_cast<Deconvolution*>(node->GetOp());
+    DeconvParam* param = deconv_op->GetParam();
+
+    float* kernel_interleaved = any_cast<float*>(node->GetAttr("kernel_interleaved"));
+    float* input_interleaved = any_cast<float*>(node->GetAttr("input_interleaved"));
+    float* col = any_cast<float*>(node->GetAttr("col_buffer"));
+
+    const std::vector<int>& in_dims = node->GetInputTensor(0)->GetShape().GetDim();
+    const std::vector<int>& out_dims = node->GetOutputTensor(0)->GetShape().GetDim();
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    const float* bias = nullptr;
+
+    if(node->GetInputNum() > 2)
+        bias = ( float* )GetInputMem(node, 2);
+
+    int batch_number = in_dims[0];
+    int inh = in_dims[2];
+    int inw = in_dims[3];
+    int outh = out_dims[2];
+    int outw = out_dims[3];
+    int group = param->group;
+    int inc_g = in_dims[1] / group;
+    int outc_g = out_dims[1] / group;
+
+    int m = outc_g * param->kernel_h * param->kernel_w;
+    int k = inc_g;
+    int n = inh * inw;
+    int kernel_pack_size = sgemm_kernel_pack_size(m, k);
+    int n_block = (n + 7) / 8;
+
+    for(int i = 0; i < batch_number; i++)
+    {
+        for(int g = 0; g < group; g++)
+        {
+            const float* cur_input = input + (i * group + g) * inc_g * n;
+            float* cur_output = output + (i * group + g) * outc_g * outh * outw;
+            const float* cur_bias = bias ? bias + g * outc_g : nullptr;
+            const float* cur_kernel = kernel_interleaved + g * kernel_pack_size;
+
+            ParallelRun(n_block, 2, [&](int start, int end) {
+                int n_start = start * 8;
+                int n_end = std::min(n, end * 8);
+
+                sgemm_pack_input(n, k, cur_input, input_interleaved, n_start, n_end);
+                sgemm_compute(m, n, k, cur_kernel, input_interleaved, col, n_start, n_end, nullptr, -1);
+            });
+
+            ParallelRun(outc_g, 2, [&](int start, int end) {
+                for(int c = start; c < end; c++)
+                    col2im_channel(col, cur_output + c * outh * outw, cur_bias, c, inh, inw, outh, outw, param);
+            });
+        }
+    }
+
+    return true;
+}
+
+bool DeconvolutionOps::Postrun(Node* node)
+{
+    const char* attr_names[] = {"kernel_interleaved", "input_interleaved", "col_buffer"};
+
+    for(auto name : attr_names)
+    {
+        if(node->ExistAttr(name))
+        {
+            float* addr = any_cast<float*>(node->GetAttr(name));
+
+            if(addr)
+                mem_free(addr);
+            node->RemoveAttr(name);
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+        return nullptr;
+
+    DeconvolutionOps* ops = new DeconvolutionOps();
+
+    return ops;
+}
+
+}    // namespace DeconvolutionImpl
+
+void RegisterDeconvNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Deconvolution", DeconvolutionImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,293 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/eltwise.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace EltwiseImpl {
+
+#define ELT_BLOCK (VF_LANE * 16)
+#define ELT_MIN_BLOCK 16
+
+struct EltProd
+{
+    static vfloat v(vfloat a, vfloat b) { return vf_mul(a, b); }
+    static float s(float a, float b) { return a * b; }
+};
+
+struct EltSum
+{
+    static vfloat v(vfloat a, vfloat b) { return vf_add(a, b); }
+    static float s(float a, float b) { return a + b; }
+};
+
+struct EltSub
+{
+    static vfloat v(vfloat a, vfloat b) { return vf_sub(a, b); }
+    static float s(float a, float b) { return a - b; }
+};
+
+struct EltMax
+{
+    static vfloat v(vfloat a, vfloat b) { return vf_max(a, b); }
+    static float s(float a, float b) { return std::max(a, b); }
+};
+
+struct EltDiv
+{
+    static vfloat v(vfloat a, vfloat b) { return vf_div(a, b); }
+    static float s(float a, float b) { return a / b; }
+};
+
+/* out[i] = op(a[i], b[i]), a null stride means the operand is a single broadcast value */
+template <typename OP> static void elt_kernel(const float* a, int a_step, const float* b, int b_step, float* out, int size)
+{
+    int i = 0;
+
+    if(a_step && b_step)
+    {
+        for(; i + VF_LANE <= size; i += VF_LANE)
+            vf_store(out + i, OP::v(vf_load(a + i), vf_load(b + i)));
+
+        for(; i < size; i++)
+            out[i] = OP::s(a[i], b[i]);
+    }
+    else if(a_step)
+    {
+        vfloat vb = vf_set1(b[0]);
+
+        for(; i + VF_LANE <= size; i += VF_LANE)
+            vf_store(out + i, OP::v(vf_load(a + i), vb));
+
+        for(; i < size; i++)
+            out[i] = OP::s(a[i], b[0]);
+    }
+    else
+    {
+        vfloat va = vf_set1(a[0]);
+
+        for(; i + VF_LANE <= size; i += VF_LANE)
+            vf_store(out + i, OP::v(va, vf_load(b + i)));
+
+        for(; i < size; i++)
+            out[i] = OP::s(a[0], b[i]);
+    }
+}
+
+struct EltwiseOps : public NodeOps
+{
+    bool Run(Node* node) override;
+
+    template <typename OP>
+    void Compute(const float* input0, const std::vector<int>& dim0, const float* input1, const std::vector<int>& dim1,
+                 float* output, int layout);
+};
+
+static int dims_size(const std::vector<int>& dims)
+{
+    int size = 1;
+
+    for(unsigned int i = 0; i < dims.size(); i++)
+        size *= dims[i];
+
+    return size;
+}
+
+/*
+ * the broadcast cases supported by the reference eltwise: same shape, a scalar, or one value per channel.
+ * In NHWC the channel values repeat along every point, so that both operands are vectors there
+ */
+template <typename OP>
+void EltwiseOps::Compute(const float* input0, const std::vector<int>& dim0, const float* input1,
+                         const std::vector<int>& dim1, float* output, int layout)
+{
+    int count0 = dims_size(dim0);
+    int count1 = dims_size(dim1);
+
+    if(count0 == count1 || count0 == 1 || count1 == 1)
+    {
+        int size = std::max(count0, count1);
+        int step0 = count0 == 1 ? 0 : 1;
+        int step1 = count1 == 1 ? 0 : 1;
+
+        ParallelRun((size + ELT_BLOCK - 1) / ELT_BLOCK, ELT_MIN_BLOCK, [&](int start, int end) {
+            start *= ELT_BLOCK;
+            end = std::min(size, end * ELT_BLOCK);
+            elt_kernel<OP>(input0 + start * step0, step0, input1 + start * step1, step1, output + start,
+                           end - start);
+        });
+
+        return;
+    }
+
+    if(layout == TENGINE_LAYOUT_NHWC)
+    {
+        bool chan0 = dim0.size() == 4 && dim0[3] == count1;
+        bool chan1 = !chan0 && dim1.size() == 4 && dim1[3] == count0;
+
+        if(!chan0 && !chan1)
+            return;
+
+        int channel = chan0 ? count1 : count0;
+        int point_num = std::max(count0, count1) / channel;
+        int min_point = std::max(1, ELT_MIN_BLOCK * ELT_BLOCK / channel);
+
+        ParallelRun(point_num, min_point, [&](int start, int end) {
+            for(int p = start; p < end; p++)
+            {
+                int offset = p * channel;
+
+                if(chan0)
+                    elt_kernel<OP>(input0 + offset, 1, input1, 1, output + offset, channel);
+                else
+                    elt_kernel<OP>(input0, 1, input1 + offset, 1, output + offset, channel);
+            }
+        });
+
+        return;
+    }
+
+    bool chan0 = dim0.size() > 1 && dim0[1] == count1;
+    bool chan1 = !chan0 && dim1.size() > 1 && dim1[1] == count0;
+
+    if(!chan0 && !chan1)
+        return;
+
+    const std::vector<int>& dims = chan0 ? dim0 : dim1;
+    int channel = dims[1];
+    int plane_num = dims[0] * channel;
+    int plane_size = dims_size(dims) / plane_num;
+    int min_plane = std::max(1, ELT_MIN_BLOCK * ELT_BLOCK / std::max(plane_size, 1));
+
+    ParallelRun(plane_num, min_plane, [&](int start, int end) {
+        for(int p = start; p < end; p++)
+        {
+            int offset = p * plane_size;
+            int c = p % channel;
+
+            if(chan0)
+                elt_kernel<OP>(input0 + offset, 1, input1 + c, 0, output + offset, plane_size);
+            else
+                elt_kernel<OP>(input0 + c, 0, input1 + offset, 1, output + offset, plane_size);
+        }
+    });
+}
+
+bool EltwiseOps::Run(Node* node)
+{
+    Eltwise* elt_op = dynamic_cast<Eltwise*>(node->GetOp());
+    EltwiseParam* param = elt_op->GetParam();
+
+    Tensor* input_tensor0 = node->GetInputTensor(0);
+    Tensor* input_tensor1 = node->GetInputTensor(1);
+    const float* input0 = ( float* )GetInputMem(node, 0);
+    const float* input1 = ( float* )GetInputMem(node, 1);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    const std::vector<int>& dim0 = input_tensor0->GetShape().GetDim();
+    const std::vector<int>& dim1 = input_tensor1->GetShape().GetDim();
+
+    switch(param->type)
+    {
+        case ELT_PROD:
+        case ELT_PROD_SCALAR:
+            Compute<EltProd>(input0, dim0, input1, dim1, output, exec_attr->graph_layout);
+            break;
+        case ELT_SUM:
+        case ELT_SUM_SCALAR:
+            Compute<EltSum>(input0, dim0, input1, dim1, output, exec_attr->graph_layout);
+            break;
+        case ELT_SUB:
+        case ELT_SUB_SCALAR:
+            Compute<EltSub>(input0, dim0, input1, dim1, output, exec_attr->graph_layout);
+            break;
+        case ELT_MAX:
+            Compute<EltMax>(input0, dim0, input1, dim1, output, exec_attr->graph_layout);
+            break;
+        case ELT_DIV:
+            Compute<EltDiv>(input0, dim0, input1, dim1, output, exec_attr->graph_layout);
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    if(node->GetInputNum() != 2 || node->GetInputTensor(1)->GetDataType() != TENGINE_DT_FP32)
+        return nullptr;
+
+    Eltwise* elt_op = dynamic_cast<Eltwise*>(node->GetOp());
+    EltwiseParam* param = elt_op->GetParam();
+
+    switch(param->type)
+    {
+        case ELT_PROD:
+        case ELT_PROD_SCALAR:
+        case ELT_SUM:
+        case ELT_SUM_SCALAR:
+        case ELT_SUB:
+        case ELT_SUB_SCALAR:
+        case ELT_MAX:
+        case ELT_DIV:
+            break;
+        default:
+            return nullptr;
+    }
+
+    EltwiseOps* ops = new EltwiseOps();
+
+    return ops;
+}
+
+}    // namespace EltwiseImpl
+
+void RegisterEltwiseNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Eltwise", EltwiseImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,201 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "tengine_errno.hpp"
+#include "graph.hpp"
+#include "operator/fully_connected.hpp"
+#include "gemm_int8_x86.h"
+
+namespace TEngine {
+
+namespace FCInt8Impl {
+
+/*
+ * symmetric int8 fully connected, output[batch][out] = input[batch][hidden] * weight^T.
+ * The weight is the packed B side of the int8 gemm, so the scales and bias follow the columns.
+ * A weight quant param per output is used per channel, otherwise the first one for all.
+ */
+struct FCInt8Ops : public NodeOps
+{
+    bool Prerun(Node* node) override;
+    bool Reshape(Node* node) override;
+    bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
+};
+
+bool FCInt8Ops::Prerun(Node* node)
+{
+    FullyConnected* fc_op = dynamic_cast<FullyConnected*>(node->GetOp());
+    FCParam* param = fc_op->GetParam();
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* weight_tensor = node->GetInputTensor(1);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+
+    auto i_quant = input_tensor->GetQuantParam();
+    auto w_quant = weight_tensor->GetQuantParam();
+    auto o_quant = output_tensor->GetQuantParam();
+
+    if(i_quant->size() == 0 || w_quant->size() == 0 || o_quant->size() == 0)
+    {
+        LOG_ERROR() << "fc int8: one quant is NONE <" << i_quant->size() << "," << w_quant->size() << ","
+                    << o_quant->size() << ">\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    int out_number = param->num_output;
+    int batch = input_tensor->GetShape().Shape(0);
+    int hidden = input_tensor->GetShape().GetSize() / batch;
+
+    float* scale = ( float* )mem_alloc(sizeof(float) * out_number);
+    bool per_channel = w_quant->size() == ( unsigned int )out_number;
+
+    for(int i = 0; i < out_number; i++)
+        scale[i] = (*i_quant)[0].scale * (*w_quant)[per_channel ? i : 0].scale;
+
+    /* the weight is [out][hidden], or [hidden][out] when its first dim is not the output number */
+    const int8_t* weight = ( int8_t* )GetInputMem(node, 1);
+    bool need_trans = weight_tensor->GetShape().Shape(0) != out_number;
+    int32_t* weight_packed = ( int32_t* )mem_alloc(sizeof(int32_t) * i8gemm_b_pack_size(out_number, hidden));
+
+    if(need_trans)
+        i8gemm_pack_b(out_number, hidden, weight, out_number, 1, weight_packed, 0, out_number);
+    else
+        i8gemm_pack_b(out_number, hidden, weight, 1, hidden, weight_packed, 0, out_number);
+
+    (*node)["int8_scale"] = scale;
+    (*node)["int8_weight_packed"] = weight_packed;
+    (*node)["int8_input_packed"] = ( int32_t* )mem_alloc(sizeof(int32_t) * i8gemm_a_pack_size(batch, hidden));
+
+    return true;
+}
+
+bool FCInt8Ops::Reshape(Node* node)
+{
+    Postrun(node);
+
+    return Prerun(node);
+}
+
+bool FCInt8Ops::Run(Node* node)
+{
+    FullyConnected* fc_op = dynamic_cast<FullyConnected*>(node->GetOp());
+    FCParam* param = fc_op->GetParam();
+
+    const float* scale = any_cast<float*>(node->GetAttr("int8_scale"));
+    const int32_t* weight_packed = any_cast<int32_t*>(node->GetAttr("int8_weight_packed"));
+    int32_t* input_packed = any_cast<int32_t*>(node->GetAttr("int8_input_packed"));
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+
+    const int8_t* input = ( int8_t* )GetInputMem(node, 0);
+    int8_t* output = ( int8_t* )GetOutputMem(node, 0);
+
+    int out_number = param->num_output;
+    int batch = input_tensor->GetShape().Shape(0);
+    int hidden = input_tensor->GetShape().GetSize() / batch;
+    int n_block = (out_number + I8_NB - 1) / I8_NB;
+
+    i8_requant rq;
+    rq.bias = nullptr;
+    rq.scale = scale;
+    rq.per_col = true;
+    rq.out_scale = (*output_tensor->GetQuantParam())[0].scale;
+    rq.activation = -1;
+
+    if(node->GetInputNum() > 2)
+        rq.bias = ( int32_t* )GetInputMem(node, 2);
+
+    i8gemm_pack_a(batch, hidden, input, hidden, input_packed);
+
+    ParallelRun(n_block, 2, [&](int start, int end) {
+        i8gemm_compute(batch, out_number, hidden, input_packed, weight_packed, output, out_number, &rq,
+                       start * I8_NB, std::min(out_number, end * I8_NB));
+    });
+
+    return true;
+}
+
+bool FCInt8Ops::Postrun(Node* node)
+{
+    if(node->ExistAttr("int8_scale"))
+    {
+        mem_free(any_cast<float*>(node->GetAttr("int8_scale")));
+        node->RemoveAttr("int8_scale");
+    }
+
+    const char* attr_names[] = {"int8_weight_packed", "int8_input_packed"};
+
+    for(auto name : attr_names)
+    {
+        if(node->ExistAttr(name))
+        {
+            int32_t* addr = any_cast<int32_t*>(node->GetAttr(name));
+
+            if(addr)
+                mem_free(addr);
+            node->RemoveAttr(name);
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_INT8 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+        return nullptr;
+
+    if(node->GetInputTensor(1)->GetDataType() != TENGINE_DT_INT8)
+        return nullptr;
+
+    if(node->GetInputNum() > 2 && node->GetInputTensor(2)->GetDataType() != TENGINE_DT_INT32)
+        return nullptr;
+
+    FCInt8Ops* ops = new FCInt8Ops();
+
+    return ops;
+}
+
+}    // namespace FCInt8Impl
+
+void RegisterFcInt8NodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "FullyConnected", FCInt8Impl::SelectFunc, 100))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -41,28 +41,58 @@ namespace FCImpl {
 
 struct FcBlasOps : public NodeOps
 {
+    bool Prerun(Node* node) override;
     bool Run(Node* node) override;
+    bool Postrun(Node* node) override;
 };
 
+/* with the fp16/bf16 weight_type of the graph, the const weights are kept as 16 bit only */
+bool FcBlasOps::Prerun(Node* node)
+{
+    Tensor* weight_tensor = node->GetInputTensor(1);
+
+    if(exec_attr->weight_type == EXEC_WEIGHT_FP32 || weight_tensor->GetType() != kConstTensor)
+        return true;
+
+    int weight_size = weight_tensor->GetShape().GetSize();
+    float* weight = ( float* )get_tensor_mem(weight_tensor);
+    unsigned short* weight_16 = ( unsigned short* )mem_alloc(sizeof(unsigned short) * weight_size);
+
+    pack_weight_16bit(exec_attr->weight_type, weight, weight_16, weight_size);
+
+    (*node)["weight_16bit"] = weight_16;
+
+    if(exec_attr->low_mem_mode && weight_tensor->consumer.size() == 1)
+        weight_tensor->FreeMem();
+
+    return true;
+}
+
+bool FcBlasOps::Postrun(Node* node)
+{
+    if(node->ExistAttr("weight_16bit"))
+    {
+        mem_free(any_cast<unsigned short*>(node->GetAttr("weight_16bit")));
+        node->RemoveAttr("weight_16bit");
+    }
+
+    return true;
+}
+
 bool FcBlasOps::Run(Node* node)
 {
     Tensor* input_tensor = node->GetInputTensor(0);
     Tensor* output_tensor = node->GetOutputTensor(0);
-    Tensor* weight_tensor = node->GetInputTensor(1);
     bool has_bias = node->GetInputNum() > 2 ? true : false;
 
-    float* input = ( float* )get_tensor_mem(input_tensor);
-    float* output = ( float* )get_tensor_mem(output_tensor);
-    float* weight = ( float* )get_tensor_mem(weight_tensor);
+    float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    float* weight = ( float* )GetInputMem(node, 1);
 
-    Tensor* bias_tensor;
     float* bias = nullptr;
 
     if(has_bias)
-    {
-        bias_tensor = node->GetInputTensor(2);
-        bias = ( float* )get_tensor_mem(bias_tensor);
-    }
+        bias = ( float* )GetInputMem(node, 2);
 
     const TShape& shape = input_tensor->GetShape();
     const std::vector<int> in_dims = shape.GetDim();
@@ -83,7 +113,18 @@ bool FcBlasOps::Run(Node* node)
     int in_size = inc * inh * inw;
     int outc = out_dims[1];
 
-    innerproduct(batch_number, inc, inh, inw, outc, weight, input, output, bias);
+    if(!node->ExistAttr("weight_16bit"))
+    {
+        innerproduct<EXEC_WEIGHT_FP32>(batch_number, inc, inh, inw, outc, weight, input, output, bias);
+        return true;
+    }
+
+    unsigned short* weight_16 = any_cast<unsigned short*>(node->GetAttr("weight_16bit"));
+
+    if(exec_attr->weight_type == EXEC_WEIGHT_BF16)
+        innerproduct<EXEC_WEIGHT_BF16>(batch_number, inc, inh, inw, outc, weight_16, input, output, bias);
+    else
+        innerproduct<EXEC_WEIGHT_FP16>(batch_number, inc, inh, inw, outc, weight_16, input, output, bias);
 
     return true;
 }
@@ -93,7 +134,11 @@ NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
     Tensor* input = node->GetInputTensor(0);
     const int data_type = input->GetDataType();
     const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
-    if(data_type != TENGINE_DT_FP32 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    /* the input is flattened in memory order, as the weight of the model expects */
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
         return nullptr;
 
     FcBlasOps* ops = new FcBlasOps();
@@ -39,6 +39,10 @@
 #define __FULLY_CONNECTED_X86_H__
 
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "exec_attr.hpp"
 
 #if __SSE2__
 #include <emmintrin.h>
@@ -47,46 +51,255 @@
 #include <immintrin.h>
 #endif
 
-int innerproduct(int inn, int inc, int inh, int inw, int outc, float* weight, float* input, float* output, float* _bias)
+/* fp16 and bf16 weights are rounded to nearest even once, and widened back to fp32 in the row loop */
+static inline unsigned int fc_float_bits(float f)
+{
+    unsigned int u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float fc_bits_float(unsigned int u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline unsigned short float_to_half(float f)
 {
-    size_t elemsize = sizeof(float);
-    int size = inw * inh;
+    unsigned int u = fc_float_bits(f);
+    unsigned int sign = (u >> 16) & 0x8000;
+    unsigned short h;
 
-// outc
-#pragma omp parallel for num_threads(opt.num_threads)
-    for(int n = 0; n < inn; n++)
+    u &= 0x7fffffff;
+
+    if(u >= 0x47800000)
     {
-        for(int p = 0; p < outc; p++)
-        {
-            int q = 0;
-            float sum = _bias ? _bias[p] : 0.f;
-            const float* weight1 = weight + p * inc * size;
-            const float* input1 = input + n * inc * size;
-#if __AVX__ || __SSE__
+        /* overflow to inf, nan stays nan */
+        h = u > 0x7f800000 ? 0x7e00 : 0x7c00;
+    }
+    else if(u < 0x38800000)
+    {
+        /* subnormal half: the fp32 adder does the rounding */
+        h = fc_float_bits(fc_bits_float(u) + 0.5f) - 0x3f000000;
+    }
+    else
+    {
+        unsigned int odd = (u >> 13) & 1;
+
+        u += 0xc8000fff + odd;
+        h = u >> 13;
+    }
+
+    return h | sign;
+}
+
+static inline float half_to_float(unsigned short h)
+{
+    unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+    unsigned int u = (unsigned int)(h & 0x7fff) << 13;
+    unsigned int exp = u & 0x0f800000;
+
+    u += 0x38000000;
+
+    if(exp == 0x0f800000)
+        u += 0x38000000;
+    else if(exp == 0)
+        u = fc_float_bits(fc_bits_float(u + 0x00800000) - fc_bits_float(0x38800000));
+
+    return fc_bits_float(u | sign);
+}
+
+static inline unsigned short float_to_bf16(float f)
+{
+    unsigned int u = fc_float_bits(f);
+
+    if((u & 0x7fffffff) > 0x7f800000)
+        return (u >> 16) | 0x40;
+
+    return (u + 0x7fff + ((u >> 16) & 1)) >> 16;
+}
+
+static inline float bf16_to_float(unsigned short h)
+{
+    return fc_bits_float((unsigned int)h << 16);
+}
+
+static void pack_weight_16bit(int weight_type, const float* weight, unsigned short* weight_16, int size)
+{
+    int i = 0;
+
+    if(weight_type == EXEC_WEIGHT_BF16)
+    {
+        for(; i < size; i++)
+            weight_16[i] = float_to_bf16(weight[i]);
+        return;
+    }
+#if __F16C__
+    for(; i + 3 < size; i += 4)
+        _mm_storel_epi64(( __m128i* )(weight_16 + i), _mm_cvtps_ph(_mm_loadu_ps(weight + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for(; i < size; i++)
+        weight_16[i] = float_to_half(weight[i]);
+}
+
+/* the weight loads of the row loop, for the storage types of EXEC_WEIGHT_XXX */
+template <int weight_type> struct fc_weight;
+
+template <> struct fc_weight<EXEC_WEIGHT_FP32>
+{
+    typedef float type;
+
+    static inline float load(const float* p)
+    {
+        return *p;
+    }
 #if __SSE__
-            float _sum[4] = {0.f};
-            __m128 _sum0 = _mm_set1_ps(0.f);
-            for(; q + 3 < inc * size; q = q + 4)
-            {
-                __m128 _input = _mm_loadu_ps(input1 + q);
-                __m128 _weight = _mm_loadu_ps(weight1 + q);
-                __m128 _sum1 = _mm_mul_ps(_input, _weight);
-                _sum0 = _mm_add_ps(_sum0, _sum1);
-            }
-            _mm_storeu_ps(_sum, _sum0);
-            float tmp = _sum[0] + _sum[1] + _sum[2] + _sum[3];
-            sum = sum + tmp;
-#else    //__AVX__
-         // TODO
+    static inline __m128 load4(const float* p)
+    {
+        return _mm_loadu_ps(p);
+    }
+#endif
+};
+
+template <> struct fc_weight<EXEC_WEIGHT_FP16>
+{
+    typedef unsigned short type;
+
+    static inline float load(const unsigned short* p)
+    {
+        return half_to_float(*p);
+    }
+#if __SSE2__
+    static inline __m128 load4(const unsigned short* p)
+    {
+#if __F16C__
+        return _mm_cvtph_ps(_mm_loadl_epi64(( const __m128i* )p));
+#else
+        return _mm_setr_ps(half_to_float(p[0]), half_to_float(p[1]), half_to_float(p[2]), half_to_float(p[3]));
 #endif
+    }
 #endif
-            for(; q < inc * size; q++)
+};
+
+template <> struct fc_weight<EXEC_WEIGHT_BF16>
+{
+    typedef unsigned short type;
+
+    static inline float load(const unsigned short* p)
+    {
+        return bf16_to_float(*p);
+    }
+#if __SSE2__
+    static inline __m128 load4(const unsigned short* p)
+    {
+        __m128i w = _mm_loadl_epi64(( const __m128i* )p);
+
+        return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), w));
+    }
+#endif
+};
+
+/*
+ * one weight row against up to four samples, each sample keeps the summation order of the single sample path.
+ * sample_num is a template argument so that the sums stay in registers
+ */
+template <int weight_type, int sample_num>
+static void innerproduct_row(int len, const typename fc_weight<weight_type>::type* weight1, const float* input,
+                             float* output, float bias)
+{
+    int q = 0;
+    float sum[4] = {bias, bias, bias, bias};
+#if __SSE__
+    __m128 _sum[4];
+
+    for(int n = 0; n < sample_num; n++)
+        _sum[n] = _mm_set1_ps(0.f);
+
+    /* widening leaves the sums as the bottleneck of the 16 bit weights, they get a second chain */
+    if(weight_type != EXEC_WEIGHT_FP32)
+    {
+        __m128 _sum1[4];
+
+        for(int n = 0; n < sample_num; n++)
+            _sum1[n] = _mm_set1_ps(0.f);
+
+        for(; q + 7 < len; q = q + 8)
+        {
+            __m128 _weight0 = fc_weight<weight_type>::load4(weight1 + q);
+            __m128 _weight1 = fc_weight<weight_type>::load4(weight1 + q + 4);
+
+            for(int n = 0; n < sample_num; n++)
             {
-                float tmp = input1[q] * weight1[q];
-                sum = sum + tmp;
+                _sum[n] = _mm_add_ps(_sum[n], _mm_mul_ps(_mm_loadu_ps(input + n * len + q), _weight0));
+                _sum1[n] = _mm_add_ps(_sum1[n], _mm_mul_ps(_mm_loadu_ps(input + n * len + q + 4), _weight1));
             }
+        }
+
+        for(int n = 0; n < sample_num; n++)
+            _sum[n] = _mm_add_ps(_sum[n], _sum1[n]);
+    }
+
+    for(; q + 3 < len; q = q + 4)
+    {
+        __m128 _weight = fc_weight<weight_type>::load4(weight1 + q);
+
+        for(int n = 0; n < sample_num; n++)
+            _sum[n] = _mm_add_ps(_sum[n], _mm_mul_ps(_mm_loadu_ps(input + n * len + q), _weight));
+    }
+
+    for(int n = 0; n < sample_num; n++)
+    {
+        float tmp[4];
+        _mm_storeu_ps(tmp, _sum[n]);
+        sum[n] = sum[n] + (tmp[0] + tmp[1] + tmp[2] + tmp[3]);
+    }
+#endif
+    for(int n = 0; n < sample_num; n++)
+    {
+        const float* input1 = input + n * len;
+
+        for(int i = q; i < len; i++)
+        {
+            float tmp = input1[i] * fc_weight<weight_type>::load(weight1 + i);
+            sum[n] = sum[n] + tmp;
+        }
+
+        output[n] = sum[n];
+    }
+}
+
+template <int weight_type>
+int innerproduct(int inn, int inc, int inh, int inw, int outc, const typename fc_weight<weight_type>::type* weight,
+                 float* input, float* output, float* _bias)
+{
+    int len = inc * inh * inw;
+
+    /* samples go in groups of four, so that a batch streams the weight once per group instead of per sample */
+    for(int n = 0; n < inn; n += 4)
+    {
+        int sample_num = std::min(4, inn - n);
+
+        for(int p = 0; p < outc; p++)
+        {
+            float* cur_output = output + n * outc + p;
+            const typename fc_weight<weight_type>::type* weight1 = weight + p * len;
+            float* input1 = input + n * len;
+            float bias = _bias ? _bias[p] : 0.f;
+            float out[4];
+
+            if(sample_num == 4)
+                innerproduct_row<weight_type, 4>(len, weight1, input1, out, bias);
+            else if(sample_num == 3)
+                innerproduct_row<weight_type, 3>(len, weight1, input1, out, bias);
+            else if(sample_num == 2)
+                innerproduct_row<weight_type, 2>(len, weight1, input1, out, bias);
+            else
+                innerproduct_row<weight_type, 1>(len, weight1, input1, out, bias);
 
-            output[n * outc + p] = sum;
+            for(int i = 0; i < sample_num; i++)
+                cur_output[i * outc] = out[i];
         }
     }
 
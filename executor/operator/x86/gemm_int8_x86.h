@@ -0,0 +1,341 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#ifndef __GEMM_INT8_X86_H__
+#define __GEMM_INT8_X86_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __SSE4_1__
+#include <smmintrin.h>
+#endif
+#if __AVX2__
+#include <immintrin.h>
+#endif
+
+/*
+ * symmetric int8 gemm for the x86 int8 convolution and fully connected ops:
+ *   C[m][n] = requant(sum_k A[m][k] * B[k][n] + bias)
+ *
+ * Both operands are sign extended to int16 and stored as pairs of neighbouring k in one int32,
+ * so a single pmaddwd (or the VNNI vpdpwssd) does two multiply-adds per lane without any
+ * saturation. pmaddubsw would do four, but it wants an unsigned operand and saturates the
+ * int16 pair sums, which breaks bit exactness with the reference kernels for symmetric int8.
+ *
+ * A is packed in blocks of I8_MB rows:  [m / I8_MB][k / 2][I8_MB]
+ * B is packed in blocks of I8_NB cols:  [n / I8_NB][k / 2][I8_NB]
+ * the tails are zero padded, so the micro kernel never checks bounds.
+ */
+
+#define I8_MB 4
+#if __AVX2__
+#define I8_NB 8
+#else
+#define I8_NB 4
+#endif
+
+namespace TEngine {
+
+struct i8_requant
+{
+    const int32_t* bias;    // may be nullptr
+    const float* scale;    // input_scale * weight_scale
+    bool per_col;    // bias and scale follow n (fc) instead of m (conv)
+    float out_scale;
+    int activation;    // the conv activation code, < 0 for none
+};
+
+static inline int i8gemm_a_pack_size(int m, int k)
+{
+    return (m + I8_MB - 1) / I8_MB * I8_MB * ((k + 1) / 2);
+}
+
+static inline int i8gemm_b_pack_size(int n, int k)
+{
+    return (n + I8_NB - 1) / I8_NB * I8_NB * ((k + 1) / 2);
+}
+
+/* A is row major with a stride of lda */
+static void i8gemm_pack_a(int m, int k, const int8_t* a, int lda, int32_t* pack)
+{
+    int k2 = (k + 1) / 2;
+    int16_t* dst = ( int16_t* )pack;
+
+    for(int mb = 0; mb < m; mb += I8_MB)
+    {
+        for(int kk = 0; kk < k2 * 2; kk++)
+        {
+            for(int r = 0; r < I8_MB; r++)
+            {
+                int row = mb + r;
+                dst[((kk >> 1) * I8_MB + r) * 2 + (kk & 1)] = (row < m && kk < k) ? a[row * lda + kk] : 0;
+            }
+        }
+        dst += I8_MB * k2 * 2;
+    }
+}
+
+/* B(kk, nn) = b[kk * ldk + nn * ldn], only the blocks covering [n_start, n_end) are packed */
+static void i8gemm_pack_b(int n, int k, const int8_t* b, int ldk, int ldn, int32_t* pack, int n_start, int n_end)
+{
+    int k2 = (k + 1) / 2;
+
+    for(int nb = n_start; nb < n_end; nb += I8_NB)
+    {
+        int16_t* dst = ( int16_t* )(pack + nb * k2);
+        int cols = std::min(I8_NB, n - nb);
+
+        if(ldn == 1 && cols == I8_NB)
+        {
+            for(int kk = 0; kk < k; kk++)
+            {
+                const int8_t* src = b + kk * ldk + nb;
+                int16_t* d = dst + (kk >> 1) * I8_NB * 2 + (kk & 1);
+
+                for(int j = 0; j < I8_NB; j++)
+                    d[j * 2] = src[j];
+            }
+        }
+        else
+        {
+            for(int kk = 0; kk < k; kk++)
+            {
+                int16_t* d = dst + (kk >> 1) * I8_NB * 2 + (kk & 1);
+
+                for(int j = 0; j < I8_NB; j++)
+                    d[j * 2] = j < cols ? b[kk * ldk + (nb + j) * ldn] : 0;
+            }
+        }
+
+        if(k & 1)
+        {
+            int16_t* d = dst + (k >> 1) * I8_NB * 2 + 1;
+
+            for(int j = 0; j < I8_NB; j++)
+                d[j * 2] = 0;
+        }
+    }
+}
+
+/* acc[I8_MB][I8_NB] = one packed A block * one packed B block */
+static inline void i8gemm_block(const int32_t* pa, const int32_t* pb, int k2, int32_t* acc)
+{
+#if __AVX2__
+    __m256i c0 = _mm256_setzero_si256();
+    __m256i c1 = _mm256_setzero_si256();
+    __m256i c2 = _mm256_setzero_si256();
+    __m256i c3 = _mm256_setzero_si256();
+
+    for(int kk = 0; kk < k2; kk++)
+    {
+        __m256i b = _mm256_loadu_si256(( const __m256i* )(pb + kk * 8));
+#if __AVXVNNI__
+        c0 = _mm256_dpwssd_avx_epi32(c0, _mm256_set1_epi32(pa[0]), b);
+        c1 = _mm256_dpwssd_avx_epi32(c1, _mm256_set1_epi32(pa[1]), b);
+        c2 = _mm256_dpwssd_avx_epi32(c2, _mm256_set1_epi32(pa[2]), b);
+        c3 = _mm256_dpwssd_avx_epi32(c3, _mm256_set1_epi32(pa[3]), b);
+#elif __AVX512VNNI__ && __AVX512VL__
+        c0 = _mm256_dpwssd_epi32(c0, _mm256_set1_epi32(pa[0]), b);
+        c1 = _mm256_dpwssd_epi32(c1, _mm256_set1_epi32(pa[1]), b);
+        c2 = _mm256_dpwssd_epi32(c2, _mm256_set1_epi32(pa[2]), b);
+        c3 = _mm256_dpwssd_epi32(c3, _mm256_set1_epi32(pa[3]), b);
+#else
+        c0 = _mm256_add_epi32(c0, _mm256_madd_epi16(_mm256_set1_epi32(pa[0]), b));
+        c1 = _mm256_add_epi32(c1, _mm256_madd_epi16(_mm256_set1_epi32(pa[1]), b));
+        c2 = _mm256_add_epi32(c2, _mm256_madd_epi16(_mm256_set1_epi32(pa[2]), b));
+        c3 = _mm256_add_epi32(c3, _mm256_madd_epi16(_mm256_set1_epi32(pa[3]), b));
+#endif
+        pa += 4;
+    }
+
+    _mm256_storeu_si256(( __m256i* )(acc + 0), c0);
+    _mm256_storeu_si256(( __m256i* )(acc + 8), c1);
+    _mm256_storeu_si256(( __m256i* )(acc + 16), c2);
+    _mm256_storeu_si256(( __m256i* )(acc + 24), c3);
+#elif __SSE2__
+    __m128i c0 = _mm_setzero_si128();
+    __m128i c1 = _mm_setzero_si128();
+    __m128i c2 = _mm_setzero_si128();
+    __m128i c3 = _mm_setzero_si128();
+
+    for(int kk = 0; kk < k2; kk++)
+    {
+        __m128i b = _mm_loadu_si128(( const __m128i* )(pb + kk * 4));
+
+        c0 = _mm_add_epi32(c0, _mm_madd_epi16(_mm_set1_epi32(pa[0]), b));
+        c1 = _mm_add_epi32(c1, _mm_madd_epi16(_mm_set1_epi32(pa[1]), b));
+        c2 = _mm_add_epi32(c2, _mm_madd_epi16(_mm_set1_epi32(pa[2]), b));
+        c3 = _mm_add_epi32(c3, _mm_madd_epi16(_mm_set1_epi32(pa[3]), b));
+        pa += 4;
+    }
+
+    _mm_storeu_si128(( __m128i* )(acc + 0), c0);
+    _mm_storeu_si128(( __m128i* )(acc + 4), c1);
+    _mm_storeu_si128(( __m128i* )(acc + 8), c2);
+    _mm_storeu_si128(( __m128i* )(acc + 12), c3);
+#else
+    for(int i = 0; i < I8_MB * I8_NB; i++)
+        acc[i] = 0;
+
+    for(int kk = 0; kk < k2; kk++)
+    {
+        const int16_t* a16 = ( const int16_t* )(pa + kk * I8_MB);
+        const int16_t* b16 = ( const int16_t* )(pb + kk * I8_NB);
+
+        for(int r = 0; r < I8_MB; r++)
+            for(int j = 0; j < I8_NB; j++)
+                acc[r * I8_NB + j] += a16[r * 2] * b16[j * 2] + a16[r * 2 + 1] * b16[j * 2 + 1];
+    }
+#endif
+}
+
+/* same rounding and clamping as the reference int8 kernels */
+static inline int8_t i8_requant_one(int32_t acc, int32_t bias, float scale, const i8_requant* rq)
+{
+    float f = (acc + bias) * scale;
+
+    if(rq->activation >= 0)
+    {
+        if(f < 0 && rq->activation != 1)
+            f = 0;
+        if(rq->activation == 1 && f > 1)
+            f = 1;
+        if(rq->activation == 6 && f > 6)
+            f = 6;
+        if(rq->activation == 1 && f < -1)
+            f = -1;
+    }
+
+    int q = round(f / rq->out_scale);
+
+    return std::min(127, std::max(-127, q));
+}
+
+#if __SSE4_1__
+/* four lanes of i8_requant_one(), round() is half away from zero: trunc, then fix up by the fraction */
+static inline void i8_requant_4(__m128i acc, __m128i bias, __m128 scale, const i8_requant* rq, int8_t* out)
+{
+    __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(acc, bias)), scale);
+
+    if(rq->activation == 1)
+        f = _mm_min_ps(_mm_max_ps(f, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+    else if(rq->activation >= 0)
+    {
+        f = _mm_max_ps(f, _mm_setzero_ps());
+        if(rq->activation == 6)
+            f = _mm_min_ps(f, _mm_set1_ps(6.f));
+    }
+
+    f = _mm_div_ps(f, _mm_set1_ps(rq->out_scale));
+
+    __m128 t = _mm_round_ps(f, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m128 frac = _mm_sub_ps(f, t);
+    __m128 up = _mm_and_ps(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f)), _mm_set1_ps(1.f));
+    __m128 down = _mm_and_ps(_mm_cmple_ps(frac, _mm_set1_ps(-0.5f)), _mm_set1_ps(1.f));
+
+    t = _mm_sub_ps(_mm_add_ps(t, up), down);
+    t = _mm_min_ps(_mm_max_ps(t, _mm_set1_ps(-127.f)), _mm_set1_ps(127.f));
+
+    __m128i q = _mm_cvttps_epi32(t);
+    q = _mm_packs_epi32(q, q);
+    q = _mm_packs_epi16(q, q);
+
+    int32_t packed = _mm_cvtsi128_si32(q);
+    memcpy(out, &packed, 4);
+}
+#endif
+
+/*
+ * requantize acc[I8_MB][I8_NB] into C, the block starts at (m0, n0) and only
+ * rows x cols of it are inside the matrix
+ */
+static void i8gemm_store(const int32_t* acc, int m0, int n0, int rows, int cols, int8_t* c, int ldc,
+                         const i8_requant* rq)
+{
+    for(int r = 0; r < rows; r++)
+    {
+        const int32_t* cur_acc = acc + r * I8_NB;
+        int8_t* cur_c = c + (m0 + r) * ldc + n0;
+        int j = 0;
+
+#if __SSE4_1__
+        __m128i bias_v = _mm_setzero_si128();
+        __m128 scale_v = _mm_setzero_ps();
+
+        if(!rq->per_col)
+        {
+            scale_v = _mm_set1_ps(rq->scale[m0 + r]);
+            if(rq->bias)
+                bias_v = _mm_set1_epi32(rq->bias[m0 + r]);
+        }
+
+        for(; j + 4 <= cols; j += 4)
+        {
+            if(rq->per_col)
+            {
+                scale_v = _mm_loadu_ps(rq->scale + n0 + j);
+                if(rq->bias)
+                    bias_v = _mm_loadu_si128(( const __m128i* )(rq->bias + n0 + j));
+            }
+
+            i8_requant_4(_mm_loadu_si128(( const __m128i* )(cur_acc + j)), bias_v, scale_v, rq, cur_c + j);
+        }
+#endif
+        for(; j < cols; j++)
+        {
+            int idx = rq->per_col ? n0 + j : m0 + r;
+
+            cur_c[j] = i8_requant_one(cur_acc[j], rq->bias ? rq->bias[idx] : 0, rq->scale[idx], rq);
+        }
+    }
+}
+
+/* C[m][n] for the column blocks in [n_start, n_end), A and B already packed */
+static void i8gemm_compute(int m, int n, int k, const int32_t* pa, const int32_t* pb, int8_t* c, int ldc,
+                           const i8_requant* rq, int n_start, int n_end)
+{
+    int k2 = (k + 1) / 2;
+    int32_t acc[I8_MB * I8_NB];
+
+    for(int nb = n_start; nb < n_end; nb += I8_NB)
+    {
+        const int32_t* cur_b = pb + nb * k2;
+        int cols = std::min(I8_NB, n - nb);
+
+        for(int mb = 0; mb < m; mb += I8_MB)
+        {
+            i8gemm_block(pa + mb * k2, cur_b, k2, acc);
+            i8gemm_store(acc, mb, nb, std::min(I8_MB, m - mb), cols, c, ldc, rq);
+        }
+    }
+}
+
+}    // namespace TEngine
+
+#endif
@@ -0,0 +1,328 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/gru.hpp"
+#include "recurrent_x86.h"
+
+namespace TEngine {
+
+namespace GRUImpl {
+
+/* mxnet: gates [r, z, n] of the input with all biases but the n part of h2h, which is hn (gated by r) */
+static void gru_cell_mx(const float* gates, const float* hn, float* h, int hidden)
+{
+    const float* rg = gates;
+    const float* zg = gates + hidden;
+    const float* ng = gates + hidden * 2;
+    int j = 0;
+
+    for(; j + VF_LANE <= hidden; j += VF_LANE)
+    {
+        vfloat r = rnn_sigmoid(vf_load(rg + j));
+        vfloat z = rnn_sigmoid(vf_load(zg + j));
+        vfloat n = rnn_tanh(vf_fmadd(r, vf_load(hn + j), vf_load(ng + j)));
+
+        /* z * h + (1 - z) * n */
+        vf_store(h + j, vf_fmadd(z, vf_sub(vf_load(h + j), n), n));
+    }
+
+    for(; j < hidden; j++)
+    {
+        float r = rnn_sigmoid(rg[j]);
+        float z = rnn_sigmoid(zg[j]);
+        float n = rnn_tanh(ng[j] + r * hn[j]);
+
+        h[j] = z * h[j] + (1 - z) * n;
+    }
+}
+
+/* tensorflow, first half: gates [r, u] to r * h for the candidate, u is kept in place */
+static void gru_gate_tf(float* gates, const float* h, float* rh, int hidden)
+{
+    float* ug = gates + hidden;
+    int j = 0;
+
+    for(; j + VF_LANE <= hidden; j += VF_LANE)
+    {
+        vf_store(rh + j, vf_mul(rnn_sigmoid(vf_load(gates + j)), vf_load(h + j)));
+        vf_store(ug + j, rnn_sigmoid(vf_load(ug + j)));
+    }
+
+    for(; j < hidden; j++)
+    {
+        rh[j] = rnn_sigmoid(gates[j]) * h[j];
+        ug[j] = rnn_sigmoid(ug[j]);
+    }
+}
+
+/* tensorflow, second half: u * h + (1 - u) * tanh(candidate) */
+static void gru_cell_tf(const float* gates, float* h, int hidden)
+{
+    const float* ug = gates + hidden;
+    const float* cg = gates + hidden * 2;
+    int j = 0;
+
+    for(; j + VF_LANE <= hidden; j += VF_LANE)
+    {
+        vfloat u = vf_load(ug + j);
+        vfloat c = rnn_tanh(vf_load(cg + j));
+
+        vf_store(h + j, vf_fmadd(u, vf_sub(vf_load(h + j), c), c));
+    }
+
+    for(; j < hidden; j++)
+    {
+        float c = rnn_tanh(cg[j]);
+
+        h[j] = ug[j] * h[j] + (1 - ug[j]) * c;
+    }
+}
+
+/*
+ * both formats project the input to [T * batch, 3 * hidden] before the time loop, the recurrent part is
+ * w_h_ru (the r and z/u gates) and w_h_c (the candidate, on h for mxnet and on r * h for tensorflow)
+ */
+struct GRUOps : public RecurrentX86Ops
+{
+    bool Prerun(Node* node) override;
+    bool Run(Node* node) override;
+
+    float* w_x_ru = nullptr;
+    float* w_x_c = nullptr;
+    float* w_h_ru = nullptr;
+    float* w_h_c = nullptr;
+    float* bias_ru = nullptr;
+    float* bias_c = nullptr;
+    float* bias_hc = nullptr;
+    const float* init_h = nullptr;
+    int input_size = 0;
+};
+
+/* the weights are found by name as RefGRU does */
+bool GRUOps::Prerun(Node* node)
+{
+    GRU* gru_op = dynamic_cast<GRU*>(node->GetOp());
+    GRUParam* param = gru_op->GetParam();
+
+    Tensor* init_h_tensor = nullptr;
+    Tensor* kernel_tensor = nullptr;
+    Tensor* bias_tensor = nullptr;
+    Tensor* candidate_kernel_tensor = nullptr;
+    Tensor* candidate_bias_tensor = nullptr;
+    Tensor* fused_kernel_tensor = nullptr;
+    int in_num = node->GetInputNum();
+
+    for(int i = 0; i < in_num; i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+        const std::string& name = tensor->GetName();
+
+        if(name.find(gru_op->GetInitHiddenName()) != std::string::npos)
+            init_h_tensor = tensor;
+        if(name.find(gru_op->GetBiasName()) != std::string::npos)
+            bias_tensor = tensor;
+        if(name.find(gru_op->GetKernelName()) != std::string::npos)
+            kernel_tensor = tensor;
+        if(name.find(gru_op->GetCandidateKernelName()) != std::string::npos)
+            candidate_kernel_tensor = tensor;
+        if(name.find(gru_op->GetCandidateBiasName()) != std::string::npos)
+            candidate_bias_tensor = tensor;
+        if(name.find(gru_op->Geti2hweightName()) != std::string::npos)
+            kernel_tensor = tensor;
+        if(name.find(gru_op->Geti2hbiasName()) != std::string::npos)
+            bias_tensor = tensor;
+        if(name.find(gru_op->Geth2hweightName()) != std::string::npos)
+            candidate_kernel_tensor = tensor;
+        if(name.find(gru_op->Geth2hbiasName()) != std::string::npos)
+            candidate_bias_tensor = tensor;
+        if(name.find(gru_op->GetFusedKernelName()) != std::string::npos)
+            fused_kernel_tensor = tensor;
+    }
+
+    int hidden_size = param->hidden_size;
+    bool mxnet = param->mxnet_flag == 1;
+
+    input_size = mxnet ? node->GetInputTensor(0)->GetShape().Shape(2) : param->input_size;
+
+    const float* kernel = GetInputData(node, kernel_tensor);
+    const float* bias = GetInputData(node, bias_tensor);
+    const float* candidate_kernel = GetInputData(node, candidate_kernel_tensor);
+    const float* candidate_bias = GetInputData(node, candidate_bias_tensor);
+
+    if(fused_kernel_tensor)
+    {
+        kernel = GetInputData(node, fused_kernel_tensor);
+        candidate_kernel = kernel + input_size * hidden_size * 3;
+        bias = candidate_kernel + hidden_size * hidden_size * 3;
+        candidate_bias = bias + hidden_size * 3;
+    }
+
+    if(kernel == nullptr || candidate_kernel == nullptr)
+    {
+        LOG_ERROR() << "GRU " << node->GetName() << ": no kernel\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    if(mxnet)
+    {
+        /* i2h [3 * hidden, input] and h2h [3 * hidden, hidden], gates r, z, n */
+        w_x_ru = PackWeight(kernel, input_size, hidden_size * 2, 1, input_size);
+        w_x_c = PackWeight(kernel + hidden_size * 2 * input_size, input_size, hidden_size, 1, input_size);
+        w_h_ru = PackWeight(candidate_kernel, hidden_size, hidden_size * 2, 1, hidden_size);
+        w_h_c = PackWeight(candidate_kernel + hidden_size * 2 * hidden_size, hidden_size, hidden_size, 1, hidden_size);
+        bias_ru = PackBias(bias, candidate_bias, hidden_size * 2);
+        bias_c = PackBias(bias ? bias + hidden_size * 2 : nullptr, nullptr, hidden_size);
+        bias_hc = PackBias(candidate_bias ? candidate_bias + hidden_size * 2 : nullptr, nullptr, hidden_size);
+    }
+    else
+    {
+        /* gates kernel [input + hidden, 2 * hidden] for r, u and candidate kernel [input + hidden, hidden] */
+        w_x_ru = PackWeight(kernel, input_size, hidden_size * 2, hidden_size * 2, 1);
+        w_x_c = PackWeight(candidate_kernel, input_size, hidden_size, hidden_size, 1);
+        w_h_ru = PackWeight(kernel + input_size * hidden_size * 2, hidden_size, hidden_size * 2, hidden_size * 2, 1);
+        w_h_c = PackWeight(candidate_kernel + input_size * hidden_size, hidden_size, hidden_size, hidden_size, 1);
+        bias_ru = PackBias(bias, nullptr, hidden_size * 2);
+        bias_c = PackBias(candidate_bias, nullptr, hidden_size);
+    }
+
+    init_h = GetInputData(node, init_h_tensor);
+
+    return true;
+}
+
+bool GRUOps::Run(Node* node)
+{
+    GRU* gru_op = dynamic_cast<GRU*>(node->GetOp());
+    GRUParam* param = gru_op->GetParam();
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const TShape& input_shape = input_tensor->GetShape();
+    bool mxnet = param->mxnet_flag == 1;
+
+    int seq_lens = mxnet ? input_shape.Shape(0) : input_shape.Shape(1);
+    int batch_size = mxnet ? input_shape.Shape(1) : input_shape.Shape(0);
+    int hidden_size = param->hidden_size;
+    int gate_size = 3 * hidden_size;
+    int output_len = param->output_len;
+
+    if(mxnet && input_shape.Shape(2) != input_size)
+    {
+        LOG_ERROR() << "GRU " << node->GetName() << ": input size changed after prerun\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    int rows = seq_lens * batch_size;
+    float* gates = GetScratch(rows * gate_size + batch_size * hidden_size * 2);
+
+    if(gates == nullptr)
+    {
+        set_tengine_errno(ENOMEM);
+        return false;
+    }
+
+    float* h = gates + rows * gate_size;
+    float* h_tmp = h + batch_size * hidden_size;
+
+    InitState(h, init_h, batch_size, hidden_size);
+
+    /* the input to hidden part of all timesteps at once */
+    Gemm(input, input_size, w_x_ru, bias_ru, gates, gate_size, rows, input_size, hidden_size * 2, false);
+    Gemm(input, input_size, w_x_c, bias_c, gates + hidden_size * 2, gate_size, rows, input_size, hidden_size, false);
+
+    for(int t = 0; t < seq_lens; t++)
+    {
+        float* step_gates = gates + t * batch_size * gate_size;
+
+        Gemm(h, hidden_size, w_h_ru, nullptr, step_gates, gate_size, batch_size, hidden_size, hidden_size * 2, true);
+
+        if(mxnet)
+        {
+            /* h_tmp is the n part of h2h */
+            Gemm(h, hidden_size, w_h_c, bias_hc, h_tmp, hidden_size, batch_size, hidden_size, hidden_size, false);
+
+            for(int b = 0; b < batch_size; b++)
+                gru_cell_mx(step_gates + b * gate_size, h_tmp + b * hidden_size, h + b * hidden_size, hidden_size);
+        }
+        else
+        {
+            /* h_tmp is r * h */
+            for(int b = 0; b < batch_size; b++)
+                gru_gate_tf(step_gates + b * gate_size, h + b * hidden_size, h_tmp + b * hidden_size, hidden_size);
+
+            Gemm(h_tmp, hidden_size, w_h_c, nullptr, step_gates + hidden_size * 2, gate_size, batch_size, hidden_size,
+                 hidden_size, true);
+
+            for(int b = 0; b < batch_size; b++)
+                gru_cell_tf(step_gates + b * gate_size, h + b * hidden_size, hidden_size);
+        }
+
+        if(t + output_len >= seq_lens)
+        {
+            memcpy(output, h, sizeof(float) * batch_size * hidden_size);
+            output += batch_size * hidden_size;
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    GRUOps* ops = new GRUOps();
+
+    return ops;
+}
+
+}    // namespace GRUImpl
+
+void RegisterGRUNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "GRU", GRUImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
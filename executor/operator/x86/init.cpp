@@ -29,14 +29,44 @@ namespace TEngine {
 extern void RegisterConvNodeExec_x86(void);
 extern void RegisterConvWinoNodeExec_x86(void);
 extern void RegisterConvDwNodeExec_x86(void);
+extern void RegisterConvNHWCNodeExec_x86(void);
 extern void RegisterFcNodeExec_x86(void);
+extern void RegisterPoolingNodeExec_x86(void);
+extern void RegisterReluNodeExec_x86(void);
+extern void RegisterEltwiseNodeExec_x86(void);
+extern void RegisterSoftmaxNodeExec_x86(void);
+extern void RegisterBatchNormNodeExec_x86(void);
+extern void RegisterConcatNodeExec_x86(void);
+extern void RegisterUpsampleNodeExec_x86(void);
+extern void RegisterDeconvNodeExec_x86(void);
+extern void RegisterConvInt8NodeExec_x86(void);
+extern void RegisterFcInt8NodeExec_x86(void);
+extern void RegisterTransposeNodeExec_x86(void);
+extern void RegisterLSTMNodeExec_x86(void);
+extern void RegisterGRUNodeExec_x86(void);
+extern void RegisterRNNNodeExec_x86(void);
 
 void RegisterX86Ops(void)
 {
     RegisterConvNodeExec_x86();
     RegisterConvWinoNodeExec_x86();
     RegisterConvDwNodeExec_x86();
+    RegisterConvNHWCNodeExec_x86();
     RegisterFcNodeExec_x86();
+    RegisterPoolingNodeExec_x86();
+    RegisterReluNodeExec_x86();
+    RegisterEltwiseNodeExec_x86();
+    RegisterSoftmaxNodeExec_x86();
+    RegisterBatchNormNodeExec_x86();
+    RegisterConcatNodeExec_x86();
+    RegisterUpsampleNodeExec_x86();
+    RegisterDeconvNodeExec_x86();
+    RegisterConvInt8NodeExec_x86();
+    RegisterFcInt8NodeExec_x86();
+    RegisterTransposeNodeExec_x86();
+    RegisterLSTMNodeExec_x86();
+    RegisterGRUNodeExec_x86();
+    RegisterRNNNodeExec_x86();
 }
 
 }    // namespace TEngine
@@ -0,0 +1,326 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/lstm.hpp"
+#include "recurrent_x86.h"
+
+namespace TEngine {
+
+namespace LSTMImpl {
+
+/*
+ * one step of the cell for a row of the batch, gates holds the 4 * cell pre-activations in the order given by
+ * the offsets. The peephole weights are nullptr for the models without them.
+ */
+static void lstm_cell(const float* gates, float* c, float* h, int cell, int i_off, int f_off, int g_off, int o_off,
+                      const float* w_i, const float* w_f, const float* w_o)
+{
+    const float* ig = gates + i_off * cell;
+    const float* fg = gates + f_off * cell;
+    const float* gg = gates + g_off * cell;
+    const float* og = gates + o_off * cell;
+    int j = 0;
+
+    for(; j + VF_LANE <= cell; j += VF_LANE)
+    {
+        vfloat v_c = vf_load(c + j);
+        vfloat v_i = vf_load(ig + j);
+        vfloat v_f = vf_load(fg + j);
+        vfloat v_o = vf_load(og + j);
+
+        if(w_f)
+        {
+            v_i = vf_fmadd(v_c, vf_load(w_i + j), v_i);
+            v_f = vf_fmadd(v_c, vf_load(w_f + j), v_f);
+        }
+
+        v_c = vf_add(vf_mul(v_c, rnn_sigmoid(v_f)), vf_mul(rnn_tanh(vf_load(gg + j)), rnn_sigmoid(v_i)));
+
+        if(w_o)
+            v_o = vf_fmadd(v_c, vf_load(w_o + j), v_o);
+
+        vf_store(c + j, v_c);
+        vf_store(h + j, vf_mul(rnn_tanh(v_c), rnn_sigmoid(v_o)));
+    }
+
+    for(; j < cell; j++)
+    {
+        float i = ig[j];
+        float f = fg[j];
+        float o = og[j];
+
+        if(w_f)
+        {
+            i += c[j] * w_i[j];
+            f += c[j] * w_f[j];
+        }
+
+        c[j] = c[j] * rnn_sigmoid(f) + rnn_tanh(gg[j]) * rnn_sigmoid(i);
+
+        if(w_o)
+            o += c[j] * w_o[j];
+
+        h[j] = rnn_tanh(c[j]) * rnn_sigmoid(o);
+    }
+}
+
+struct LSTMOps : public RecurrentX86Ops
+{
+    bool Prerun(Node* node) override;
+    bool Run(Node* node) override;
+
+    float* w_x = nullptr;
+    float* w_h = nullptr;
+    float* w_proj = nullptr;
+    float* bias = nullptr;
+    const float* w_i = nullptr;
+    const float* w_f = nullptr;
+    const float* w_o = nullptr;
+    const float* init_h = nullptr;
+    const float* init_c = nullptr;
+    int input_size = 0;
+};
+
+/* the weights are found by name as RefLSTM does, then packed as [input, 4 * cell] and [hidden, 4 * cell] */
+bool LSTMOps::Prerun(Node* node)
+{
+    LSTM* lstm_op = dynamic_cast<LSTM*>(node->GetOp());
+    LSTMParam* param = lstm_op->GetParam();
+
+    Tensor* kernel_tensor = nullptr;
+    Tensor* bias_tensor = nullptr;
+    Tensor* init_c_tensor = nullptr;
+    Tensor* init_h_tensor = nullptr;
+    Tensor* w_f_tensor = nullptr;
+    Tensor* w_i_tensor = nullptr;
+    Tensor* w_o_tensor = nullptr;
+    Tensor* proj_tensor = nullptr;
+    Tensor* h2h_kernel_tensor = nullptr;
+    Tensor* h2h_bias_tensor = nullptr;
+    Tensor* fused_kernel_tensor = nullptr;
+    int in_num = node->GetInputNum();
+
+    for(int i = 0; i < in_num; i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+        const std::string& name = tensor->GetName();
+
+        if(name.find(lstm_op->GetKernelName()) != std::string::npos &&
+           name.find(lstm_op->GetProjectionName()) == std::string::npos)
+            kernel_tensor = tensor;
+        if(name.find(lstm_op->GetInitCellName()) != std::string::npos)
+            init_c_tensor = tensor;
+        if(name.find(lstm_op->GetInitHiddenName()) != std::string::npos)
+            init_h_tensor = tensor;
+        if(name.find(lstm_op->GetBiasName()) != std::string::npos &&
+           name.find(lstm_op->Geth2hBiasName()) == std::string::npos)
+            bias_tensor = tensor;
+        if(name.find(lstm_op->GetPeepholeForgetName()) != std::string::npos)
+            w_f_tensor = tensor;
+        if(name.find(lstm_op->GetPeepholeOutputName()) != std::string::npos)
+            w_o_tensor = tensor;
+        if(name.find(lstm_op->GetPeepholeInputName()) != std::string::npos)
+            w_i_tensor = tensor;
+        if(name.find(lstm_op->GetProjectionName()) != std::string::npos)
+            proj_tensor = tensor;
+        if(name.find(lstm_op->Geti2hKernelName()) != std::string::npos)
+            kernel_tensor = tensor;
+        if(name.find(lstm_op->Geti2hBiasName()) != std::string::npos)
+            bias_tensor = tensor;
+        if(name.find(lstm_op->Geth2hKernelName()) != std::string::npos)
+            h2h_kernel_tensor = tensor;
+        if(name.find(lstm_op->Geth2hBiasName()) != std::string::npos)
+            h2h_bias_tensor = tensor;
+        if(name.find(lstm_op->GetFusedKernelName()) != std::string::npos)
+            fused_kernel_tensor = tensor;
+    }
+
+    int hidden_size = param->hidden_size;
+    int cell_size = param->cell_size;
+    int gate_size = 4 * cell_size;
+    bool mxnet = param->mxnet_flag == 1;
+
+    input_size = mxnet ? node->GetInputTensor(0)->GetShape().Shape(2) : param->input_size;
+
+    const float* kernel = GetInputData(node, kernel_tensor);
+    const float* h2h_kernel = GetInputData(node, h2h_kernel_tensor);
+    const float* i2h_bias = GetInputData(node, bias_tensor);
+    const float* h2h_bias = GetInputData(node, h2h_bias_tensor);
+
+    if(fused_kernel_tensor)
+    {
+        const float* fused_kernel = GetInputData(node, fused_kernel_tensor);
+        int kernel_size = get_tensor_mem_size(fused_kernel_tensor) / sizeof(float);
+
+        kernel = fused_kernel;
+        h2h_kernel = kernel + input_size * hidden_size * 4;
+        i2h_bias = kernel + kernel_size - hidden_size * 4 * 2;
+        h2h_bias = i2h_bias + hidden_size * 4;
+    }
+
+    if(kernel == nullptr || (mxnet && h2h_kernel == nullptr))
+    {
+        LOG_ERROR() << "LSTM " << node->GetName() << ": no kernel\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    if(mxnet)
+    {
+        /* i2h [4 * cell, input] and h2h [4 * cell, hidden], gates i, f, c, o and the forget gate gets + 1 */
+        w_x = PackWeight(kernel, input_size, gate_size, 1, input_size);
+        w_h = PackWeight(h2h_kernel, hidden_size, gate_size, 1, hidden_size);
+        bias = PackBias(i2h_bias, h2h_bias, gate_size, 1.f, cell_size, 2 * cell_size);
+    }
+    else
+    {
+        /* kernel [input + hidden, 4 * cell], gates i, c, f, o and the forget gate gets forget_bias */
+        w_x = PackWeight(kernel, input_size, gate_size, gate_size, 1);
+        w_h = PackWeight(kernel + input_size * gate_size, hidden_size, gate_size, gate_size, 1);
+        bias = PackBias(i2h_bias, nullptr, gate_size, param->forget_bias, 2 * cell_size, 3 * cell_size);
+
+        if(param->has_projection)
+            w_proj = PackWeight(GetInputData(node, proj_tensor), cell_size, hidden_size, hidden_size, 1);
+
+        if(param->has_peephole)
+        {
+            w_i = GetInputData(node, w_i_tensor);
+            w_f = GetInputData(node, w_f_tensor);
+            w_o = GetInputData(node, w_o_tensor);
+        }
+    }
+
+    init_h = GetInputData(node, init_h_tensor);
+    init_c = init_h ? GetInputData(node, init_c_tensor) : nullptr;
+
+    return true;
+}
+
+bool LSTMOps::Run(Node* node)
+{
+    LSTM* lstm_op = dynamic_cast<LSTM*>(node->GetOp());
+    LSTMParam* param = lstm_op->GetParam();
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const TShape& input_shape = input_tensor->GetShape();
+    bool mxnet = param->mxnet_flag == 1;
+
+    int seq_lens = mxnet ? input_shape.Shape(0) : input_shape.Shape(1);
+    int batch_size = mxnet ? input_shape.Shape(1) : input_shape.Shape(0);
+    int hidden_size = param->hidden_size;
+    int cell_size = param->cell_size;
+    int gate_size = 4 * cell_size;
+    int output_len = param->output_len;
+
+    if(mxnet && input_shape.Shape(2) != input_size)
+    {
+        LOG_ERROR() << "LSTM " << node->GetName() << ": input size changed after prerun\n";
+        set_tengine_errno(EINVAL);
+        return false;
+    }
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    int rows = seq_lens * batch_size;
+    float* gates = GetScratch(rows * gate_size + batch_size * (hidden_size + cell_size * 2));
+
+    if(gates == nullptr)
+    {
+        set_tengine_errno(ENOMEM);
+        return false;
+    }
+
+    float* h = gates + rows * gate_size;
+    float* c = h + batch_size * hidden_size;
+    float* cell_out = w_proj ? c + batch_size * cell_size : h;
+
+    InitState(h, init_h, batch_size, hidden_size);
+    InitState(c, init_c, batch_size, cell_size);
+
+    /* the input to hidden part of all timesteps at once, the input of each step follows the previous one */
+    Gemm(input, input_size, w_x, bias, gates, gate_size, rows, input_size, gate_size, false);
+
+    int i_off = 0;
+    int f_off = mxnet ? 1 : 2;
+    int g_off = mxnet ? 2 : 1;
+    int o_off = 3;
+
+    for(int t = 0; t < seq_lens; t++)
+    {
+        float* step_gates = gates + t * batch_size * gate_size;
+
+        Gemm(h, hidden_size, w_h, nullptr, step_gates, gate_size, batch_size, hidden_size, gate_size, true);
+
+        for(int b = 0; b < batch_size; b++)
+            lstm_cell(step_gates + b * gate_size, c + b * cell_size, cell_out + b * cell_size, cell_size, i_off, f_off,
+                      g_off, o_off, w_i, w_f, w_o);
+
+        if(w_proj)
+            Gemm(cell_out, cell_size, w_proj, nullptr, h, hidden_size, batch_size, cell_size, hidden_size, false);
+
+        if(t + output_len >= seq_lens)
+        {
+            memcpy(output, h, sizeof(float) * batch_size * hidden_size);
+            output += batch_size * hidden_size;
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    LSTMOps* ops = new LSTMOps();
+
+    return ops;
+}
+
+}    // namespace LSTMImpl
+
+void RegisterLSTMNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "LSTM", LSTMImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#ifndef __MATH_X86_H__
+#define __MATH_X86_H__
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __AVX__
+#include <immintrin.h>
+#endif
+
+/*
+ * vectorized exp() for the x86 kernels, the cephes polynomial as used by sse_mathfun/avx_mathfun.
+ * The integer part only uses SSE2, so the AVX version does not need AVX2.
+ */
+
+#define EXP_HI 88.3762626647949f
+#define EXP_LO -88.3762626647949f
+#define EXP_LOG2EF 1.44269504088896341f
+#define EXP_C1 0.693359375f
+#define EXP_C2 -2.12194440e-4f
+#define EXP_P0 1.9875691500E-4f
+#define EXP_P1 1.3981999507E-3f
+#define EXP_P2 8.3334519073E-3f
+#define EXP_P3 4.1665795894E-2f
+#define EXP_P4 1.6666665459E-1f
+#define EXP_P5 5.0000001201E-1f
+
+#if __SSE2__
+static inline __m128 exp_ps(__m128 x)
+{
+    x = _mm_min_ps(x, _mm_set1_ps(EXP_HI));
+    x = _mm_max_ps(x, _mm_set1_ps(EXP_LO));
+
+    /* exp(x) = 2^n * exp(g), n = floor(x / ln2 + 0.5) */
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2EF)), _mm_set1_ps(0.5f));
+    __m128 tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    __m128 mask = _mm_and_ps(_mm_cmpgt_ps(tmp, fx), _mm_set1_ps(1.f));
+    fx = _mm_sub_ps(tmp, mask);
+
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C2)));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.f));
+
+    __m128i emm0 = _mm_cvttps_epi32(fx);
+    emm0 = _mm_slli_epi32(_mm_add_epi32(emm0, _mm_set1_epi32(0x7f)), 23);
+
+    return _mm_mul_ps(y, _mm_castsi128_ps(emm0));
+}
+#endif
+
+#if __AVX__
+static inline __m256 exp256_ps(__m256 x)
+{
+    x = _mm256_min_ps(x, _mm256_set1_ps(EXP_HI));
+    x = _mm256_max_ps(x, _mm256_set1_ps(EXP_LO));
+
+    __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2EF)), _mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(EXP_C1)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(EXP_C2)));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(EXP_P0);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P1));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P2));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P3));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P4));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P5));
+    y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, z), x), _mm256_set1_ps(1.f));
+
+    __m256i emm0 = _mm256_cvttps_epi32(fx);
+    __m128i lo = _mm256_castsi256_si128(emm0);
+    __m128i hi = _mm256_extractf128_si256(emm0, 1);
+    lo = _mm_slli_epi32(_mm_add_epi32(lo, _mm_set1_epi32(0x7f)), 23);
+    hi = _mm_slli_epi32(_mm_add_epi32(hi, _mm_set1_epi32(0x7f)), 23);
+    emm0 = _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(emm0));
+}
+#endif
+
+/*
+ * thin wrappers so the elementwise kernels can be written once for AVX (8 lanes) or SSE (4 lanes)
+ */
+#if __AVX__
+#define VF_LANE 8
+typedef __m256 vfloat;
+static inline vfloat vf_load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void vf_store(float* p, vfloat v) { _mm256_storeu_ps(p, v); }
+static inline vfloat vf_set1(float a) { return _mm256_set1_ps(a); }
+static inline vfloat vf_add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vf_sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vf_mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vf_div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vf_max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+static inline vfloat vf_min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+static inline vfloat vf_exp(vfloat a) { return exp256_ps(a); }
+/* a * b + c */
+#if __FMA__
+static inline vfloat vf_fmadd(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+static inline vfloat vf_fmadd(vfloat a, vfloat b, vfloat c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+/* p[0], p[2], ... p[14] */
+static inline vfloat vf_load_even(const float* p)
+{
+    __m256 a = _mm256_loadu_ps(p);
+    __m256 b = _mm256_loadu_ps(p + 8);
+    __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+    __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+    return _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+}
+static inline float vf_reduce_add(vfloat v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+static inline float vf_reduce_max(vfloat v)
+{
+    __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#else
+#define VF_LANE 4
+typedef __m128 vfloat;
+static inline vfloat vf_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void vf_store(float* p, vfloat v) { _mm_storeu_ps(p, v); }
+static inline vfloat vf_set1(float a) { return _mm_set1_ps(a); }
+static inline vfloat vf_add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vf_sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vf_mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vf_div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+static inline vfloat vf_max(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+static inline vfloat vf_min(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+static inline vfloat vf_exp(vfloat a) { return exp_ps(a); }
+static inline vfloat vf_fmadd(vfloat a, vfloat b, vfloat c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+/* p[0], p[2], p[4], p[6] */
+static inline vfloat vf_load_even(const float* p)
+{
+    return _mm_shuffle_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _MM_SHUFFLE(2, 0, 2, 0));
+}
+static inline float vf_reduce_add(vfloat s)
+{
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+static inline float vf_reduce_max(vfloat s)
+{
+    s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+#endif
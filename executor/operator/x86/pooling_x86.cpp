@@ -0,0 +1,372 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/pooling.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace PoolingImpl {
+
+struct pool_shape
+{
+    int inh;
+    int inw;
+    int outh;
+    int outw;
+    int kernel_h;
+    int kernel_w;
+    int stride_h;
+    int stride_w;
+    int pad_h;
+    int pad_w;
+    int method;
+    int caffe_flavor;
+};
+
+/* one output point, the same window rules as the reference pooling */
+static float pool_point(const float* input, const pool_shape* s, int ph, int pw)
+{
+    int h_start = ph * s->stride_h - s->pad_h;
+    int h_end = std::min(h_start + s->kernel_h, s->inh + s->pad_h);
+    int w_start = pw * s->stride_w - s->pad_w;
+    int w_end = std::min(w_start + s->kernel_w, s->inw + s->pad_w);
+    int pool_size = 1;
+
+    if(s->caffe_flavor)
+        pool_size = (h_end - h_start) * (w_end - w_start);
+
+    h_start = std::max(h_start, 0);
+    w_start = std::max(w_start, 0);
+    h_end = std::min(h_end, s->inh);
+    w_end = std::min(w_end, s->inw);
+
+    if(!s->caffe_flavor)
+        pool_size = (h_end - h_start) * (w_end - w_start);
+
+    if(s->method == kPoolMax)
+    {
+        float max = input[h_start * s->inw + w_start];
+
+        for(int i = h_start; i < h_end; i++)
+            for(int j = w_start; j < w_end; j++)
+                max = std::max(max, input[i * s->inw + j]);
+
+        return max;
+    }
+
+    float sum = 0.f;
+
+    for(int i = h_start; i < h_end; i++)
+        for(int j = w_start; j < w_end; j++)
+            sum += input[i * s->inw + j];
+
+    return sum / pool_size;
+}
+
+/* VF_LANE adjacent outputs whose windows are all inside the input */
+static inline void pool_block(const float* row, const pool_shape* s, float* output)
+{
+    vfloat acc;
+
+    if(s->method == kPoolMax)
+        acc = s->stride_w == 1 ? vf_load(row) : vf_load_even(row);
+    else
+        acc = vf_set1(0.f);
+
+    for(int i = 0; i < s->kernel_h; i++)
+    {
+        const float* cur = row + i * s->inw;
+
+        for(int j = 0; j < s->kernel_w; j++)
+        {
+            vfloat v = s->stride_w == 1 ? vf_load(cur + j) : vf_load_even(cur + j);
+
+            if(s->method == kPoolMax)
+                acc = vf_max(acc, v);
+            else
+                acc = vf_add(acc, v);
+        }
+    }
+
+    if(s->method != kPoolMax)
+        acc = vf_div(acc, vf_set1(( float )(s->kernel_h * s->kernel_w)));
+
+    vf_store(output, acc);
+}
+
+static void pool_global(const float* input, float* output, const pool_shape* s)
+{
+    int size = s->inh * s->inw;
+    int i = 0;
+
+    if(s->method == kPoolMax)
+    {
+        float max = input[0];
+
+        if(size >= VF_LANE)
+        {
+            vfloat acc = vf_load(input);
+
+            for(i = VF_LANE; i + VF_LANE <= size; i += VF_LANE)
+                acc = vf_max(acc, vf_load(input + i));
+
+            max = vf_reduce_max(acc);
+        }
+
+        for(; i < size; i++)
+            max = std::max(max, input[i]);
+
+        output[0] = max;
+    }
+    else
+    {
+        vfloat acc = vf_set1(0.f);
+
+        for(; i + VF_LANE <= size; i += VF_LANE)
+            acc = vf_add(acc, vf_load(input + i));
+
+        float sum = vf_reduce_add(acc);
+
+        for(; i < size; i++)
+            sum += input[i];
+
+        output[0] = sum / size;
+    }
+}
+
+static void pool_plane(const float* input, float* output, const pool_shape* s)
+{
+    if(s->outh == 1 && s->outw == 1 && s->kernel_h == s->inh && s->kernel_w == s->inw && s->pad_h == 0 &&
+       s->pad_w == 0)
+    {
+        pool_global(input, output, s);
+        return;
+    }
+
+    bool simd = (s->stride_w == 1 || s->stride_w == 2);
+
+    /* the widest lane read of a block: stride 2 loads 2 * VF_LANE floats per tap */
+    int span = s->stride_w == 1 ? VF_LANE : 2 * VF_LANE;
+
+    for(int ph = 0; ph < s->outh; ph++)
+    {
+        float* out_row = output + ph * s->outw;
+        int h_start = ph * s->stride_h - s->pad_h;
+        int pw = 0;
+
+        if(!simd || h_start < 0 || h_start + s->kernel_h > s->inh)
+        {
+            for(; pw < s->outw; pw++)
+                out_row[pw] = pool_point(input, s, ph, pw);
+
+            continue;
+        }
+
+        const float* in_row = input + h_start * s->inw;
+
+        while(pw < s->outw)
+        {
+            int w_start = pw * s->stride_w - s->pad_w;
+
+            if(w_start >= 0 && pw + VF_LANE <= s->outw && w_start + span + s->kernel_w - 1 <= s->inw)
+            {
+                pool_block(in_row + w_start, s, out_row + pw);
+                pw += VF_LANE;
+            }
+            else
+            {
+                out_row[pw] = pool_point(input, s, ph, pw);
+                pw++;
+            }
+        }
+    }
+}
+
+/* NHWC: all the channels of one output point, the channels are the vector lanes */
+static void pool_point_nhwc(const float* input, const pool_shape* s, int channel, int ph, int pw, float* output)
+{
+    int h_start = ph * s->stride_h - s->pad_h;
+    int h_end = std::min(h_start + s->kernel_h, s->inh + s->pad_h);
+    int w_start = pw * s->stride_w - s->pad_w;
+    int w_end = std::min(w_start + s->kernel_w, s->inw + s->pad_w);
+    int pool_size = 1;
+
+    if(s->caffe_flavor)
+        pool_size = (h_end - h_start) * (w_end - w_start);
+
+    h_start = std::max(h_start, 0);
+    w_start = std::max(w_start, 0);
+    h_end = std::min(h_end, s->inh);
+    w_end = std::min(w_end, s->inw);
+
+    if(!s->caffe_flavor)
+        pool_size = (h_end - h_start) * (w_end - w_start);
+
+    const float* first = input + (h_start * s->inw + w_start) * channel;
+    bool is_max = s->method == kPoolMax;
+    int c = 0;
+
+    for(; c + VF_LANE <= channel; c += VF_LANE)
+    {
+        vfloat acc = is_max ? vf_load(first + c) : vf_set1(0.f);
+
+        for(int i = h_start; i < h_end; i++)
+        {
+            for(int j = w_start; j < w_end; j++)
+            {
+                vfloat v = vf_load(input + (i * s->inw + j) * channel + c);
+
+                acc = is_max ? vf_max(acc, v) : vf_add(acc, v);
+            }
+        }
+
+        if(!is_max)
+            acc = vf_div(acc, vf_set1(( float )pool_size));
+
+        vf_store(output + c, acc);
+    }
+
+    for(; c < channel; c++)
+    {
+        float acc = is_max ? first[c] : 0.f;
+
+        for(int i = h_start; i < h_end; i++)
+        {
+            for(int j = w_start; j < w_end; j++)
+            {
+                float v = input[(i * s->inw + j) * channel + c];
+
+                acc = is_max ? std::max(acc, v) : acc + v;
+            }
+        }
+
+        output[c] = is_max ? acc : acc / pool_size;
+    }
+}
+
+struct PoolingOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool PoolingOps::Run(Node* node)
+{
+    Pooling* pooling_op = dynamic_cast<Pooling*>(node->GetOp());
+    PoolParam* param = pooling_op->GetParam();
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+    const TShape& in_shape = input_tensor->GetShape();
+    const TShape& out_shape = output_tensor->GetShape();
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    pool_shape s;
+    s.inh = in_shape.GetH();
+    s.inw = in_shape.GetW();
+    s.outh = out_shape.GetH();
+    s.outw = out_shape.GetW();
+    s.kernel_h = param->kernel_h;
+    s.kernel_w = param->kernel_w;
+    s.stride_h = param->stride_h;
+    s.stride_w = param->stride_w;
+    s.pad_h = param->pad_h0;
+    s.pad_w = param->pad_w0;
+    s.method = param->alg;
+    s.caffe_flavor = param->caffe_flavor;
+
+    if(exec_attr->graph_layout == TENGINE_LAYOUT_NHWC)
+    {
+        int channel = in_shape.GetC();
+        int in_size = s.inh * s.inw * channel;
+        int row_size = s.outw * channel;
+
+        ParallelRun(in_shape.GetN() * s.outh, 1, [&](int start, int end) {
+            for(int r = start; r < end; r++)
+            {
+                int n = r / s.outh;
+                int ph = r % s.outh;
+
+                for(int pw = 0; pw < s.outw; pw++)
+                    pool_point_nhwc(input + n * in_size, &s, channel, ph, pw, output + r * row_size + pw * channel);
+            }
+        });
+
+        return true;
+    }
+
+    int plane_num = in_shape.GetN() * in_shape.GetC();
+    int in_size = s.inh * s.inw;
+    int out_size = s.outh * s.outw;
+
+    ParallelRun(plane_num, 1, [&](int start, int end) {
+        for(int p = start; p < end; p++)
+            pool_plane(input + p * in_size, output + p * out_size, &s);
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW &&
+       (exec_attr->graph_layout != TENGINE_LAYOUT_NHWC || input->GetShape().GetDim().size() != 4))
+        return nullptr;
+
+    Pooling* pooling_op = dynamic_cast<Pooling*>(node->GetOp());
+    PoolParam* param = pooling_op->GetParam();
+
+    if(param->alg != kPoolMax && param->alg != kPoolAvg)
+        return nullptr;
+
+    PoolingOps* ops = new PoolingOps();
+
+    return ops;
+}
+
+}    // namespace PoolingImpl
+
+void RegisterPoolingNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Pooling", PoolingImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,325 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#ifndef __RECURRENT_X86_H__
+#define __RECURRENT_X86_H__
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "tensor_mem.hpp"
+#include "math_x86.h"
+#include "node_ops.hpp"
+
+/*
+ * shared pieces of the x86 LSTM/GRU/RNN kernels: the input to hidden projection of every timestep is one
+ * gemm before the time loop, and each step only adds the hidden to hidden product of the (small) batch on
+ * top of it, then runs the gate activations in one fused pass. The weights are packed once at Prerun.
+ */
+
+/* columns of a packed weight panel, and rows of the input handled together */
+#define RNN_NR (VF_LANE * 2)
+#define RNN_MR 4
+
+static inline int rnn_panel_num(int n)
+{
+    return (n + RNN_NR - 1) / RNN_NR;
+}
+
+/*
+ * packs the k x n weight, whose element (p, j) is at w[p * ldk + j * ldn], into panels of RNN_NR columns,
+ * so both the [k, n] kernels of tensorflow and the transposed [n, k] kernels of mxnet are read the same way
+ */
+static inline void rnn_pack_weight(const float* w, float* packed, int k, int n, int ldk, int ldn)
+{
+    for(int p = 0; p < rnn_panel_num(n); p++)
+    {
+        for(int kk = 0; kk < k; kk++)
+        {
+            for(int j = 0; j < RNN_NR; j++)
+            {
+                int col = p * RNN_NR + j;
+
+                *packed++ = col < n ? w[kk * ldk + col * ldn] : 0.f;
+            }
+        }
+    }
+}
+
+/* c[MR, cols] = a[MR, k] * panel + (acc ? c : bias), the bias is padded to the whole panel */
+template <int MR>
+static inline void rnn_gemm_block(const float* a, int lda, const float* panel, float* c, int ldc, int k, int cols,
+                                  const float* bias, bool acc)
+{
+    vfloat sum0[MR];
+    vfloat sum1[MR];
+    float tmp[RNN_NR];
+
+    for(int r = 0; r < MR; r++)
+    {
+        if(acc)
+        {
+            const float* src = c + r * ldc;
+
+            if(cols < RNN_NR)
+            {
+                memset(tmp, 0, sizeof(tmp));
+                memcpy(tmp, src, cols * sizeof(float));
+                src = tmp;
+            }
+
+            sum0[r] = vf_load(src);
+            sum1[r] = vf_load(src + VF_LANE);
+        }
+        else if(bias)
+        {
+            sum0[r] = vf_load(bias);
+            sum1[r] = vf_load(bias + VF_LANE);
+        }
+        else
+        {
+            sum0[r] = vf_set1(0.f);
+            sum1[r] = vf_set1(0.f);
+        }
+    }
+
+    for(int p = 0; p < k; p++)
+    {
+        vfloat b0 = vf_load(panel);
+        vfloat b1 = vf_load(panel + VF_LANE);
+
+        for(int r = 0; r < MR; r++)
+        {
+            vfloat va = vf_set1(a[r * lda + p]);
+
+            sum0[r] = vf_fmadd(va, b0, sum0[r]);
+            sum1[r] = vf_fmadd(va, b1, sum1[r]);
+        }
+
+        panel += RNN_NR;
+    }
+
+    for(int r = 0; r < MR; r++)
+    {
+        float* dst = c + r * ldc;
+
+        if(cols == RNN_NR)
+        {
+            vf_store(dst, sum0[r]);
+            vf_store(dst + VF_LANE, sum1[r]);
+        }
+        else
+        {
+            vf_store(tmp, sum0[r]);
+            vf_store(tmp + VF_LANE, sum1[r]);
+            memcpy(dst, tmp, cols * sizeof(float));
+        }
+    }
+}
+
+/* the activations of the gates, sigmoid clipped to [-30, 30] as the reference kernels do */
+static inline vfloat rnn_sigmoid(vfloat x)
+{
+    x = vf_min(vf_max(x, vf_set1(-30.f)), vf_set1(30.f));
+
+    return vf_div(vf_set1(1.f), vf_add(vf_set1(1.f), vf_exp(vf_sub(vf_set1(0.f), x))));
+}
+
+/* tanh(x) = 2 * sigmoid(2x) - 1 */
+static inline vfloat rnn_tanh(vfloat x)
+{
+    return vf_sub(vf_mul(vf_set1(2.f), rnn_sigmoid(vf_add(x, x))), vf_set1(1.f));
+}
+
+/*
+ * the tails of the cell loops go through the vector activations too, so that a unit gets the same value
+ * whether its index falls in a full vector or not
+ */
+static inline float rnn_sigmoid(float x)
+{
+    float tmp[VF_LANE];
+
+    vf_store(tmp, rnn_sigmoid(vf_set1(x)));
+
+    return tmp[0];
+}
+
+static inline float rnn_tanh(float x)
+{
+    float tmp[VF_LANE];
+
+    vf_store(tmp, rnn_tanh(vf_set1(x)));
+
+    return tmp[0];
+}
+
+namespace TEngine {
+
+struct RecurrentX86Ops : public NodeOps
+{
+    /* c[m, n] = a[m, k] * packed + (acc ? c : bias), bias is nullptr or padded to whole panels */
+    void Gemm(const float* a, int lda, const float* packed, const float* bias, float* c, int ldc, int m, int k, int n,
+              bool acc)
+    {
+        int panel_num = rnn_panel_num(n);
+        int row_block = (m + RNN_MR - 1) / RNN_MR;
+
+        /* the per step products of a small batch are only split when a thread gets enough of them */
+        int min_work = std::max(2, (1 << 16) / (k * RNN_NR * std::min(m, RNN_MR) + 1));
+
+        ParallelRun(panel_num * row_block, min_work, [&](int start, int end) {
+            for(int w = start; w < end; w++)
+            {
+                int p = w / row_block;
+                int row = (w % row_block) * RNN_MR;
+                int col = p * RNN_NR;
+                int cols = std::min(RNN_NR, n - col);
+                const float* panel = packed + p * k * RNN_NR;
+                const float* a_row = a + row * lda;
+                const float* b_col = bias ? bias + col : nullptr;
+                float* c_blk = c + row * ldc + col;
+
+                switch(std::min(RNN_MR, m - row))
+                {
+                    case 4:
+                        rnn_gemm_block<4>(a_row, lda, panel, c_blk, ldc, k, cols, b_col, acc);
+                        break;
+                    case 3:
+                        rnn_gemm_block<3>(a_row, lda, panel, c_blk, ldc, k, cols, b_col, acc);
+                        break;
+                    case 2:
+                        rnn_gemm_block<2>(a_row, lda, panel, c_blk, ldc, k, cols, b_col, acc);
+                        break;
+                    default:
+                        rnn_gemm_block<1>(a_row, lda, panel, c_blk, ldc, k, cols, b_col, acc);
+                        break;
+                }
+            }
+        });
+    }
+
+    /* packs a k x n weight, see rnn_pack_weight() */
+    float* PackWeight(const float* w, int k, int n, int ldk, int ldn)
+    {
+        float* packed = Alloc(rnn_panel_num(n) * RNN_NR * k);
+
+        rnn_pack_weight(w, packed, k, n, ldk, ldn);
+
+        return packed;
+    }
+
+    /* b0 + b1 (+ extra on [extra_start, extra_end)), either bias may be nullptr, padded to whole panels */
+    float* PackBias(const float* b0, const float* b1, int n, float extra = 0.f, int extra_start = 0,
+                    int extra_end = 0)
+    {
+        float* bias = Alloc(rnn_panel_num(n) * RNN_NR);
+
+        for(int i = 0; i < n; i++)
+        {
+            bias[i] = (b0 ? b0[i] : 0.f) + (b1 ? b1[i] : 0.f);
+
+            if(i >= extra_start && i < extra_end)
+                bias[i] += extra;
+        }
+
+        return bias;
+    }
+
+    /* the data of an input found by name, read through the io table of its slot */
+    float* GetInputData(Node* node, Tensor* tensor)
+    {
+        if(tensor == nullptr)
+            return nullptr;
+
+        for(unsigned int i = 0; i < node->GetInputNum(); i++)
+        {
+            if(node->GetInputTensor(i) == tensor)
+                return ( float* )GetInputMem(node, i);
+        }
+
+        return nullptr;
+    }
+
+    /* the states and the projected inputs, grown when the sequence or the batch of the input grows */
+    float* GetScratch(int size)
+    {
+        if(size > scratch_size)
+        {
+            if(scratch)
+                mem_free(scratch);
+
+            scratch = ( float* )mem_alloc(sizeof(float) * size);
+            scratch_size = scratch ? size : 0;
+        }
+
+        return scratch;
+    }
+
+    /* init_h (and init_c) of one batch are copied to each row, zero without them */
+    static void InitState(float* state, const float* init, int batch, int size)
+    {
+        for(int i = 0; i < batch; i++)
+        {
+            if(init)
+                memcpy(state + i * size, init, sizeof(float) * size);
+            else
+                memset(state + i * size, 0, sizeof(float) * size);
+        }
+    }
+
+    float* Alloc(int size)
+    {
+        float* buf = ( float* )mem_alloc(sizeof(float) * (size + RNN_NR));
+
+        memset(buf, 0, sizeof(float) * (size + RNN_NR));
+        packed_bufs.push_back(buf);
+
+        return buf;
+    }
+
+    bool Postrun(Node* node) override
+    {
+        for(auto buf : packed_bufs)
+            mem_free(buf);
+
+        packed_bufs.clear();
+
+        if(scratch)
+            mem_free(scratch);
+
+        scratch = nullptr;
+        scratch_size = 0;
+
+        return true;
+    }
+
+    std::vector<float*> packed_bufs;
+    float* scratch = nullptr;
+    int scratch_size = 0;
+};
+
+}    // namespace TEngine
+
+#endif
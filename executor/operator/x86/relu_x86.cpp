@@ -0,0 +1,243 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/relu.hpp"
+#include "operator/relu6.hpp"
+#include "operator/prelu.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace ReluImpl {
+
+/* out = max(x, 0) + slope * min(x, 0), the same formula as the reference relu */
+static void relu_kernel(const float* input, float* output, int size, float slope)
+{
+    vfloat zero = vf_set1(0.f);
+    int i = 0;
+
+    if(slope == 0.f)
+    {
+        for(; i + VF_LANE <= size; i += VF_LANE)
+            vf_store(output + i, vf_max(vf_load(input + i), zero));
+
+        for(; i < size; i++)
+            output[i] = std::max(input[i], 0.f);
+    }
+    else
+    {
+        vfloat v_slope = vf_set1(slope);
+
+        for(; i + VF_LANE <= size; i += VF_LANE)
+        {
+            vfloat v = vf_load(input + i);
+            vf_store(output + i, vf_add(vf_max(v, zero), vf_mul(v_slope, vf_min(v, zero))));
+        }
+
+        for(; i < size; i++)
+            output[i] = std::max(input[i], 0.f) + slope * std::min(input[i], 0.f);
+    }
+}
+
+static void relu6_kernel(const float* input, float* output, int size)
+{
+    vfloat zero = vf_set1(0.f);
+    vfloat six = vf_set1(6.f);
+    int i = 0;
+
+    for(; i + VF_LANE <= size; i += VF_LANE)
+        vf_store(output + i, vf_min(vf_max(vf_load(input + i), zero), six));
+
+    for(; i < size; i++)
+        output[i] = std::min(std::max(input[i], 0.f), 6.f);
+}
+
+/* elementwise jobs are cut in blocks of this many floats, and stay single threaded below ELT_MIN_BLOCK blocks */
+#define ELT_BLOCK (VF_LANE * 16)
+#define ELT_MIN_BLOCK 16
+
+struct ReluOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool ReluOps::Run(Node* node)
+{
+    ReLu* relu_op = dynamic_cast<ReLu*>(node->GetOp());
+    ReLuParam* param = relu_op->GetParam();
+    float slope = param->negative_slope;
+
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    int size = input_tensor->GetShape().GetSize();
+
+    ParallelRun((size + ELT_BLOCK - 1) / ELT_BLOCK, ELT_MIN_BLOCK, [&](int start, int end) {
+        start *= ELT_BLOCK;
+        end = std::min(size, end * ELT_BLOCK);
+        relu_kernel(input + start, output + start, end - start, slope);
+    });
+
+    return true;
+}
+
+struct Relu6Ops : public NodeOps
+{
+    bool OnBind(Node* node) override;
+    bool Run(Node* node) override;
+};
+
+bool Relu6Ops::OnBind(Node* node)
+{
+    inplace_t io_map;
+
+    io_map[0] = 0;
+
+    node->SetAttr(ATTR_INPLACE, io_map);
+    return true;
+}
+
+bool Relu6Ops::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    int size = input_tensor->GetShape().GetSize();
+
+    ParallelRun((size + ELT_BLOCK - 1) / ELT_BLOCK, ELT_MIN_BLOCK, [&](int start, int end) {
+        start *= ELT_BLOCK;
+        end = std::min(size, end * ELT_BLOCK);
+        relu6_kernel(input + start, output + start, end - start);
+    });
+
+    return true;
+}
+
+struct PReluOps : public NodeOps
+{
+    bool OnBind(Node* node) override;
+    bool Run(Node* node) override;
+};
+
+bool PReluOps::OnBind(Node* node)
+{
+    inplace_t io_map;
+
+    io_map[0] = 0;
+
+    node->SetAttr(ATTR_INPLACE, io_map);
+    return true;
+}
+
+bool PReluOps::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+    const float* slope = ( float* )GetInputMem(node, 1);
+    /* one slope for all channels, as the fused conv epilogue reads it */
+    bool one_slope = node->GetInputTensor(1)->GetShape().GetSize() == 1;
+
+    const std::vector<int>& dims = input_tensor->GetShape().GetDim();
+    int channel = dims[1];
+    int plane_num = dims[0] * channel;
+    int plane_size = 1;
+
+    for(unsigned int i = 2; i < dims.size(); i++)
+        plane_size *= dims[i];
+
+    int min_plane = std::max(1, ELT_MIN_BLOCK * ELT_BLOCK / std::max(plane_size, 1));
+
+    ParallelRun(plane_num, min_plane, [&](int start, int end) {
+        for(int p = start; p < end; p++)
+            relu_kernel(input + p * plane_size, output + p * plane_size, plane_size,
+                        one_slope ? slope[0] : slope[p % channel]);
+    });
+
+    return true;
+}
+
+static bool fp32_nchw(Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+
+    return data_type == TENGINE_DT_FP32 && exec_attr->graph_layout == TENGINE_LAYOUT_NCHW;
+}
+
+/* relu and relu6 do not depend on the layout */
+static bool fp32_any_layout(Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+
+    return data_type == TENGINE_DT_FP32 &&
+           (exec_attr->graph_layout == TENGINE_LAYOUT_NCHW || exec_attr->graph_layout == TENGINE_LAYOUT_NHWC);
+}
+
+NodeOps* SelectReluFunc(const CPUInfo* cpu_info, Node* node)
+{
+    if(!fp32_any_layout(node))
+        return nullptr;
+
+    return new ReluOps();
+}
+
+NodeOps* SelectRelu6Func(const CPUInfo* cpu_info, Node* node)
+{
+    if(!fp32_any_layout(node))
+        return nullptr;
+
+    return new Relu6Ops();
+}
+
+NodeOps* SelectPReluFunc(const CPUInfo* cpu_info, Node* node)
+{
+    if(!fp32_nchw(node) || node->GetInputTensor(0)->GetShape().GetDim().size() < 2)
+        return nullptr;
+
+    return new PReluOps();
+}
+
+}    // namespace ReluImpl
+
+void RegisterReluNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "ReLu", ReluImpl::SelectReluFunc, 500) ||
+       !NodeOpsRegistryManager::RegisterOPImplementor("x86", "ReLu6", ReluImpl::SelectRelu6Func, 500) ||
+       !NodeOpsRegistryManager::RegisterOPImplementor("x86", "PReLU", ReluImpl::SelectPReluFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+#include "logger.hpp"
+#include "tengine_errno.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/rnn.hpp"
+#include "recurrent_x86.h"
+
+namespace TEngine {
+
+namespace RNNImpl {
+
+/* h = tanh(gates) */
+static void rnn_cell(const float* gates, float* h, int size)
+{
+    int j = 0;
+
+    for(; j + VF_LANE <= size; j += VF_LANE)
+        vf_store(h + j, rnn_tanh(vf_load(gates + j)));
+
+    for(; j < size; j++)
+        h[j] = rnn_tanh(gates[j]);
+}
+
+struct RNNOps : public RecurrentX86Ops
+{
+    bool Prerun(Node* node) override;
+    bool Run(Node* node) override;
+
+    float* w_x = nullptr;
+    float* w_h = nullptr;
+    float* bias = nullptr;
+    const float* init_h = nullptr;
+};
+
+/* kernel [input + hidden, hidden], the bias and init_h are found by name as RefRNN does */
+bool RNNOps::Prerun(Node* node)
+{
+    RNN* rnn_op = dynamic_cast<RNN*>(node->GetOp());
+    RNNParam* param = rnn_op->GetParam();
+
+    int input_size = param->input_size;
+    int hidden_size = param->hidden_size;
+    int in_num = node->GetInputNum();
+    const float* bias_data = nullptr;
+
+    init_h = nullptr;
+
+    for(int i = 0; i < in_num; i++)
+    {
+        Tensor* tensor = node->GetInputTensor(i);
+        const std::string& name = tensor->GetName();
+
+        if(name.find(rnn_op->GetInitHiddenName()) != std::string::npos)
+            init_h = ( float* )GetInputMem(node, i);
+        if(name.find(rnn_op->GetBiasName()) != std::string::npos)
+            bias_data = ( float* )GetInputMem(node, i);
+    }
+
+    const float* kernel = ( float* )GetInputMem(node, 1);
+
+    w_x = PackWeight(kernel, input_size, hidden_size, hidden_size, 1);
+    w_h = PackWeight(kernel + input_size * hidden_size, hidden_size, hidden_size, hidden_size, 1);
+    bias = PackBias(bias_data, nullptr, hidden_size);
+
+    return true;
+}
+
+bool RNNOps::Run(Node* node)
+{
+    RNN* rnn_op = dynamic_cast<RNN*>(node->GetOp());
+    RNNParam* param = rnn_op->GetParam();
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const TShape& input_shape = input_tensor->GetShape();
+
+    int seq_lens = input_shape.Shape(0);
+    int batch_size = input_shape.Shape(1);
+    int input_size = param->input_size;
+    int hidden_size = param->hidden_size;
+    int output_len = param->output_len;
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    int rows = seq_lens * batch_size;
+    float* gates = GetScratch((rows + batch_size) * hidden_size);
+
+    if(gates == nullptr)
+    {
+        set_tengine_errno(ENOMEM);
+        return false;
+    }
+
+    float* h = gates + rows * hidden_size;
+
+    InitState(h, init_h, batch_size, hidden_size);
+
+    /* the input to hidden part of all timesteps at once */
+    Gemm(input, input_size, w_x, bias, gates, hidden_size, rows, input_size, hidden_size, false);
+
+    for(int t = 0; t < seq_lens; t++)
+    {
+        float* step_gates = gates + t * batch_size * hidden_size;
+
+        Gemm(h, hidden_size, w_h, nullptr, step_gates, hidden_size, batch_size, hidden_size, hidden_size, true);
+        rnn_cell(step_gates, h, batch_size * hidden_size);
+
+        if(t + output_len >= seq_lens)
+        {
+            memcpy(output, h, sizeof(float) * batch_size * hidden_size);
+            output += batch_size * hidden_size;
+        }
+    }
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    RNNOps* ops = new RNNOps();
+
+    return ops;
+}
+
+}    // namespace RNNImpl
+
+void RegisterRNNNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "RNN", RNNImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,236 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/softmax.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace SoftmaxImpl {
+
+/* columns of a strided softmax handled by one work item */
+#define SOFTMAX_COLS (VF_LANE * 8)
+
+/* softmax over on_size contiguous floats */
+static void softmax_row(const float* input, float* output, int on_size)
+{
+    float max = input[0];
+    int i = 0;
+
+    if(on_size >= VF_LANE)
+    {
+        vfloat v_max = vf_load(input);
+
+        for(i = VF_LANE; i + VF_LANE <= on_size; i += VF_LANE)
+            v_max = vf_max(v_max, vf_load(input + i));
+
+        max = vf_reduce_max(v_max);
+    }
+
+    for(; i < on_size; i++)
+        max = std::max(max, input[i]);
+
+    vfloat v_max = vf_set1(max);
+    vfloat v_sum = vf_set1(0.f);
+
+    for(i = 0; i + VF_LANE <= on_size; i += VF_LANE)
+    {
+        vfloat v = vf_exp(vf_sub(vf_load(input + i), v_max));
+        vf_store(output + i, v);
+        v_sum = vf_add(v_sum, v);
+    }
+
+    float sum = vf_reduce_add(v_sum);
+
+    for(; i < on_size; i++)
+    {
+        output[i] = exp(input[i] - max);
+        sum += output[i];
+    }
+
+    vfloat v_scale = vf_set1(1.f / sum);
+
+    for(i = 0; i + VF_LANE <= on_size; i += VF_LANE)
+        vf_store(output + i, vf_mul(vf_load(output + i), v_scale));
+
+    float scale = 1.f / sum;
+
+    for(; i < on_size; i++)
+        output[i] *= scale;
+}
+
+/* softmax along a strided axis, for the columns [start, end) of each on_size x in_size block */
+static void softmax_cols(const float* input, float* output, int on_size, int in_size, int start, int end)
+{
+    float max[SOFTMAX_COLS];
+    float sum[SOFTMAX_COLS];
+    int cols = end - start;
+
+    memcpy(max, input + start, cols * sizeof(float));
+
+    for(int j = 1; j < on_size; j++)
+    {
+        const float* in = input + j * in_size + start;
+        int l = 0;
+
+        for(; l + VF_LANE <= cols; l += VF_LANE)
+            vf_store(max + l, vf_max(vf_load(max + l), vf_load(in + l)));
+
+        for(; l < cols; l++)
+            max[l] = std::max(max[l], in[l]);
+    }
+
+    memset(sum, 0, cols * sizeof(float));
+
+    for(int j = 0; j < on_size; j++)
+    {
+        const float* in = input + j * in_size + start;
+        float* out = output + j * in_size + start;
+        int l = 0;
+
+        for(; l + VF_LANE <= cols; l += VF_LANE)
+        {
+            vfloat v = vf_exp(vf_sub(vf_load(in + l), vf_load(max + l)));
+            vf_store(out + l, v);
+            vf_store(sum + l, vf_add(vf_load(sum + l), v));
+        }
+
+        for(; l < cols; l++)
+        {
+            out[l] = exp(in[l] - max[l]);
+            sum[l] += out[l];
+        }
+    }
+
+    for(int l = 0; l < cols; l++)
+        sum[l] = 1.f / sum[l];
+
+    for(int j = 0; j < on_size; j++)
+    {
+        float* out = output + j * in_size + start;
+        int l = 0;
+
+        for(; l + VF_LANE <= cols; l += VF_LANE)
+            vf_store(out + l, vf_mul(vf_load(out + l), vf_load(sum + l)));
+
+        for(; l < cols; l++)
+            out[l] *= sum[l];
+    }
+}
+
+struct SoftmaxOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool SoftmaxOps::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const std::vector<int>& dims = input_tensor->GetShape().GetDim();
+    Softmax* softmax_op = dynamic_cast<Softmax*>(node->GetOp());
+    SoftmaxParam* param = softmax_op->GetParam();
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    int dim_size = dims.size();
+    int axis = param->axis;
+
+    if(axis < 0)
+        axis += dim_size;
+    if(axis >= dim_size)
+        axis = dim_size - 1;
+
+    int out_size = 1;
+    for(int i = 0; i < axis; i++)
+        out_size *= dims[i];
+
+    int in_size = 1;
+    for(int i = axis + 1; i < dim_size; i++)
+        in_size *= dims[i];
+
+    int on_size = dims[axis];
+
+    if(in_size == 1)
+    {
+        ParallelRun(out_size, std::max(1, 4096 / on_size), [&](int start, int end) {
+            for(int i = start; i < end; i++)
+                softmax_row(input + i * on_size, output + i * on_size, on_size);
+        });
+
+        return true;
+    }
+
+    int col_block = (in_size + SOFTMAX_COLS - 1) / SOFTMAX_COLS;
+
+    ParallelRun(out_size * col_block, std::max(1, 4096 / (on_size * SOFTMAX_COLS)), [&](int start, int end) {
+        for(int w = start; w < end; w++)
+        {
+            int i = w / col_block;
+            int col_start = (w % col_block) * SOFTMAX_COLS;
+            int col_end = std::min(in_size, col_start + SOFTMAX_COLS);
+            int offset = i * on_size * in_size;
+
+            softmax_cols(input + offset, output + offset, on_size, in_size, col_start, col_end);
+        }
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32)
+        return nullptr;
+
+    /* the axis is an index of the dims, whatever the layout */
+    if(exec_attr->graph_layout != TENGINE_LAYOUT_NCHW && exec_attr->graph_layout != TENGINE_LAYOUT_NHWC)
+        return nullptr;
+
+    SoftmaxOps* ops = new SoftmaxOps();
+
+    return ops;
+}
+
+}    // namespace SoftmaxImpl
+
+void RegisterSoftmaxNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Softmax", SoftmaxImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/transpose.hpp"
+
+namespace TEngine {
+
+namespace TransposeImpl {
+
+#define TRANS_TILE 16
+
+/*
+ * the layout changes NCHW <-> NHWC: each image is a [rows][cols] matrix written as [cols][rows],
+ * walked by tiles so that both sides stay in the cache
+ */
+static void transpose_tile(const float* input, float* output, int rows, int cols, int row_start, int col_start)
+{
+    int row_end = std::min(rows, row_start + TRANS_TILE);
+    int col_end = std::min(cols, col_start + TRANS_TILE);
+
+    for(int c = col_start; c < col_end; c++)
+    {
+        float* out = output + c * rows;
+
+        for(int r = row_start; r < row_end; r++)
+            out[r] = input[r * cols + c];
+    }
+}
+
+struct TransposeOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool TransposeOps::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    const std::vector<int>& dims = input_tensor->GetShape().GetDim();
+    TransposeParam* param = dynamic_cast<Transpose*>(node->GetOp())->GetParam();
+
+    const float* input = ( float* )get_tensor_mem(input_tensor);
+    float* output = ( float* )get_tensor_mem(node->GetOutputTensor(0));
+
+    int rows, cols;
+
+    /* {0, 3, 1, 2}: [h * w][c] to [c][h * w], {0, 2, 3, 1}: [c][h * w] to [h * w][c] */
+    if(param->tr_shape[1] == 3)
+    {
+        rows = dims[1] * dims[2];
+        cols = dims[3];
+    }
+    else
+    {
+        rows = dims[1];
+        cols = dims[2] * dims[3];
+    }
+
+    int image_size = rows * cols;
+    int row_tiles = (rows + TRANS_TILE - 1) / TRANS_TILE;
+    int col_tiles = (cols + TRANS_TILE - 1) / TRANS_TILE;
+    int tile_num = row_tiles * col_tiles;
+
+    ParallelRun(dims[0] * tile_num, 16, [&](int start, int end) {
+        for(int t = start; t < end; t++)
+        {
+            int n = t / tile_num;
+            int tile = t % tile_num;
+
+            transpose_tile(input + n * image_size, output + n * image_size, rows, cols,
+                           (tile / col_tiles) * TRANS_TILE, (tile % col_tiles) * TRANS_TILE);
+        }
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    TransposeParam* param = dynamic_cast<Transpose*>(node->GetOp())->GetParam();
+
+    if(input->GetDataType() != TENGINE_DT_FP32 || input->GetShape().GetDim().size() != 4)
+        return nullptr;
+
+    const std::vector<int>& perm = param->tr_shape;
+    const std::vector<int> to_nchw{0, 3, 1, 2};
+    const std::vector<int> to_nhwc{0, 2, 3, 1};
+
+    if(perm != to_nchw && perm != to_nhwc)
+        return nullptr;
+
+    TransposeOps* ops = new TransposeOps();
+
+    return ops;
+}
+
+}    // namespace TransposeImpl
+
+void RegisterTransposeNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Transpose", TransposeImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, OPEN AI LAB
+ */
+
+#include <iostream>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "node_ops.hpp"
+#include "tensor_mem.hpp"
+#include "graph.hpp"
+#include "operator/upsample.hpp"
+#include "math_x86.h"
+
+namespace TEngine {
+
+namespace UpsampleImpl {
+
+/* nearest neighbour: build one output row from its input row, then repeat it for the other rows */
+static void upsample_plane(const float* input, float* output, int in_h, int in_w, int out_h, int out_w, int scale)
+{
+    for(int h = 0; h < out_h; h++)
+    {
+        float* out_row = output + h * out_w;
+
+        if(h % scale != 0)
+        {
+            memcpy(out_row, out_row - out_w, out_w * sizeof(float));
+            continue;
+        }
+
+        const float* in_row = input + (h / scale) * in_w;
+        int w = 0;
+
+        if(scale == 2)
+        {
+            for(; w + 8 <= out_w; w += 8)
+            {
+                __m128 v = _mm_loadu_ps(in_row + w / 2);
+                _mm_storeu_ps(out_row + w, _mm_unpacklo_ps(v, v));
+                _mm_storeu_ps(out_row + w + 4, _mm_unpackhi_ps(v, v));
+            }
+        }
+
+        for(; w < out_w; w++)
+            out_row[w] = in_row[w / scale];
+    }
+}
+
+struct UpsampleOps : public NodeOps
+{
+    bool Run(Node* node) override;
+};
+
+bool UpsampleOps::Run(Node* node)
+{
+    Tensor* input_tensor = node->GetInputTensor(0);
+    Tensor* output_tensor = node->GetOutputTensor(0);
+    Upsample* upsample_op = dynamic_cast<Upsample*>(node->GetOp());
+    UpsampleParam* param = upsample_op->GetParam();
+
+    const std::vector<int>& dims = input_tensor->GetShape().GetDim();
+    const std::vector<int>& out_dims = output_tensor->GetShape().GetDim();
+
+    int scale = param->scale;
+    int plane_num = out_dims[0] * out_dims[1];
+    int in_h = dims[2];
+    int in_w = dims[3];
+    int out_h = out_dims[2];
+    int out_w = out_dims[3];
+
+    const float* input = ( float* )GetInputMem(node, 0);
+    float* output = ( float* )GetOutputMem(node, 0);
+
+    ParallelRun(plane_num, std::max(1, 16384 / (out_h * out_w)), [&](int start, int end) {
+        for(int p = start; p < end; p++)
+            upsample_plane(input + p * in_h * in_w, output + p * out_h * out_w, in_h, in_w, out_h, out_w, scale);
+    });
+
+    return true;
+}
+
+NodeOps* SelectFunc(const CPUInfo* cpu_info, Node* node)
+{
+    Tensor* input = node->GetInputTensor(0);
+    const int data_type = input->GetDataType();
+    const ExecAttr* exec_attr = any_cast<const ExecAttr*>(node->GetAttr(ATTR_EXEC_ATTR));
+    if(data_type != TENGINE_DT_FP32 || exec_attr->graph_layout != TENGINE_LAYOUT_NCHW)
+        return nullptr;
+
+    Upsample* upsample_op = dynamic_cast<Upsample*>(node->GetOp());
+    UpsampleParam* param = upsample_op->GetParam();
+
+    if(input->GetShape().GetDim().size() != 4 || ( int )param->scale < 1)
+        return nullptr;
+
+    UpsampleOps* ops = new UpsampleOps();
+
+    return ops;
+}
+
+}    // namespace UpsampleImpl
+
+void RegisterUpsampleNodeExec_x86(void)
+{
+    if(!NodeOpsRegistryManager::RegisterOPImplementor("x86", "Upsample", UpsampleImpl::SelectFunc, 500))
+        LOG_ERROR() << __FUNCTION__ << " :Regist OP failed for prio \n";
+}
+
+}    // namespace TEngine
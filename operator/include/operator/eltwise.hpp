@@ -58,6 +58,8 @@ public:
     void SetSchema(void) override;
 
     bool InferShape(const std::vector<TShape>& ishape, std::vector<TShape>& oshape, int layout) override;
+
+    float GetFops(const std::vector<TShape>& inputs, const std::vector<TShape>& outputs) override;
 };
 
 }    // namespace TEngine
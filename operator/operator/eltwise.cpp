@@ -55,6 +55,11 @@ bool Eltwise::InferShape(const std::vector<TShape>& ishape, std::vector<TShape>&
     return true;
 }
 
+float Eltwise::GetFops(const std::vector<TShape>& inputs, const std::vector<TShape>& outputs)
+{
+    return outputs[0].GetSize();
+}
+
 void Eltwise::SetSchema(void)
 {
     Input({"input:float32"})
@@ -81,12 +81,12 @@ float FullyConnected::GetFops(const std::vector<TShape>& inputs, const std::vect
     const TShape& input = inputs[0];
     const TShape& weight = inputs[1];
 
-    int m = input.GetN();
-
-    int n = weight.GetH();
-    int k = weight.GetW();
+    /* the weight is {n, k} or {n, k, 1, 1} */
+    int m = input.Shape(0);
+    int n = weight.Shape(0);
+    int k = weight.GetSize() / n;
 
-    float fops = m * n * k * 2;
+    float fops = 2.f * m * n * k;
 
     return fops;
 }
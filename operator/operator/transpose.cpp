@@ -75,7 +75,7 @@ bool Transpose::InferShape(const std::vector<TEngine::TShape>& ishape, std::vect
 */
     TShape shape;
     shape.SetDim(out_shape);
-    shape.SetDataLayout(input.GetDataLayout());
+    shape.SetDataLayout(layout);
  
     oshape[0] = shape;
     return true;
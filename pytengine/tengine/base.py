@@ -199,6 +199,17 @@ Tengine_type = [
 ]
 
 
+# the numpy dtype of each Tengine data type, in the order of Tengine_type
+Tengine_np_type = [
+    np.float32,
+    np.float16,
+    np.int8,
+    np.uint8,
+    np.int32,
+    np.int16
+]
+
+
 class DType:
     def __init__(self, enum):
         self.enum = enum
@@ -26,6 +26,8 @@ class Graph(object):
         else:
             self.graph = _LIB.create_graph(ctypes.c_void_p(context), None)
         self.attr = {}
+        # the arrays set as tensor buffers, by tensor handle, see Tensor.buf
+        self._buffers = {}
         pass
 
     def __del__(self):
@@ -37,6 +39,7 @@ class Graph(object):
             _LIB.destroy_graph(ctypes.c_void_p(self.graph))
             print("release graph")
         self.graph = None
+        self._buffers.clear()
         pass
 
     def __getitem__(self, idx):
@@ -133,7 +136,7 @@ class Graph(object):
         """
         _LIB.get_graph_input_node = node_t
         node = _LIB.get_graph_input_node(ctypes.c_void_p(self.graph), idx)
-        return Node(node=node)
+        return Node(graph=self, node=node)
 
     def getOutputNodeNumber(self):
         """
@@ -150,7 +153,7 @@ class Graph(object):
         """
         _LIB.get_graph_output_node.restype = node_t
         node = _LIB.get_graph_output_node(ctypes.c_void_p(self.graph), idx)
-        return Node(node=node)
+        return Node(graph=self, node=node)
 
     def getOutputTensor(self, nodeidx, idx):
         """
@@ -161,7 +164,7 @@ class Graph(object):
         """
         _LIB.get_graph_output_tensor.restype = tensor_t
         tensor = _LIB.get_graph_output_tensor(ctypes.c_void_p(self.graph), nodeidx, idx)
-        return Tensor(tensor=tensor)
+        return Tensor(graph=self, tensor=tensor)
 
     def getInputTensor(self, nodeidx, idx):
         """
@@ -172,7 +175,7 @@ class Graph(object):
         """
         _LIB.get_graph_input_tensor.restype = tensor_t
         tensor = _LIB.get_graph_input_tensor(ctypes.c_void_p(self.graph), nodeidx, idx)
-        return Tensor(tensor=tensor)
+        return Tensor(graph=self, tensor=tensor)
 
     def getNodeByName(self, name):
         """
@@ -182,7 +185,7 @@ class Graph(object):
         """
         _LIB.get_graph_node.restype = node_t
         node = _LIB.get_graph_node(ctypes.c_void_p(self.graph), c_str(name))
-        return Node(node=node)
+        return Node(graph=self, node=node)
 
     def getNodeNumber(self):
         """
@@ -199,7 +202,7 @@ class Graph(object):
         """
         _LIB.get_graph_node_by_idx = node_t
         node = _LIB.get_graph_node_by_idx(ctypes.c_void_p(self.graph), idx)
-        return Node(node=node)
+        return Node(graph=self, node=node)
 
     def getTensorByName(self, name):
         """
@@ -209,7 +212,7 @@ class Graph(object):
         """
         _LIB.get_graph_tensor.restype = tensor_t
         tensor = _LIB.get_graph_tensor(ctypes.c_void_p(self.graph), c_str(name))
-        return Tensor(tensor=tensor)
+        return Tensor(graph=self, tensor=tensor)
 
     def setAttr(self, attr_name, obj):
         """
@@ -334,6 +337,29 @@ class Graph(object):
         _LIB.get_graph_perf_stat(ctypes.c_void_p(self.graph), ctypes.byref(info), size)
         return info
 
+    def startProfiling(self):
+        """
+        start a profiling session: each node executed by the following runs is recorded
+        :return: 0: success, -1: fail
+        """
+        return _LIB.start_graph_profiling(ctypes.c_void_p(self.graph))
+
+    def stopProfiling(self):
+        """
+        stop the profiling session, the records are kept for dumpProfiling()
+        :return: 0: success, -1: fail
+        """
+        return _LIB.stop_graph_profiling(ctypes.c_void_p(self.graph))
+
+    def dumpProfiling(self, file_name, format):
+        """
+        write the profiling records into a JSON file
+        :param file_name: <str> the file to write
+        :param format: <int> tg.GRAPH_PROF_CHROME_TRACE or tg.GRAPH_PROF_SUMMARY
+        :return: 0: success, -1: fail
+        """
+        return _LIB.dump_graph_profiling(ctypes.c_void_p(self.graph), c_str(file_name), format)
+
     def dump(self):
         """
         Dump the run-time graph.
@@ -355,9 +381,8 @@ class Graph(object):
 
         data = image
         if type(data) is np.ndarray:
-            data = data.swapaxes(1,2)
-            data = data.swapaxes(0,1)
-            data = data.flatten()
+            # HWC to CHW, copied once into the buffer the graph reads
+            data = np.ascontiguousarray(data.transpose(2, 0, 1), dtype=np.float32)
         input_tensor.shape = shape
         input_tensor.buf = data
         pass
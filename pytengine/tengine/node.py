@@ -20,6 +20,7 @@ class Node(object):
         else:
             _LIB.create_graph_node.restype = node_t
             self.node = _LIB.create_graph_node(ctypes.c_void_p(graph.graph), c_str(name), c_str(op))
+        self._graph = graph
         self._attr = {}
         pass
 
@@ -58,7 +59,7 @@ class Node(object):
         """
         _LIB.get_node_input_tensor.restype = tensor_t
         tensor =  _LIB.get_node_input_tensor(ctypes.c_void_p(self.node), idx)
-        return Tensor(tensor=tensor)
+        return Tensor(graph=self._graph, tensor=tensor)
 
     def getOutputTensorByIdx(self, idx):
         """
@@ -68,7 +69,7 @@ class Node(object):
         """
         _LIB.get_node_output_tensor.restype = tensor_t
         tensor = _LIB.get_node_output_tensor(ctypes.c_void_p(self.node), idx)
-        return Tensor(tensor = tensor)
+        return Tensor(graph=self._graph, tensor=tensor)
 
     def setInputTensorByIdx(self, idx, tensor):
         """
@@ -181,6 +181,10 @@ tg.Device = Device
  tg.GRAPH_PERF_STAT_RESET,
  tg.GRAPH_PERF_STAT_GET) = map(int, range(6))
 
+# /* graph profiling dump format */
+(tg.GRAPH_PROF_CHROME_TRACE,
+ tg.GRAPH_PROF_SUMMARY) = map(int, range(2))
+
 # /* quant mode */
 (tg.TENGINE_QUANT_FP16,
  tg.TENGINE_QUANT_INT8,
@@ -2,10 +2,14 @@
 """Information about Tengine."""
 
 import ctypes
-from .base import _LIB, c_str, tensor_t, ctypes2numpy_shared, ctypes2buffer, DType, check_call
+from .base import _LIB, c_str, tensor_t, ctypes2numpy_shared, ctypes2buffer, DType, Tengine_np_type, check_call
 import numpy as np
 import time
 
+# the tensors of the runtime may have more dims than MAX_SHAPE_DIM_NUM
+_MAX_DIM_NUM = 8
+
+
 class Tensor(object):
     def __init__(self, graph=None, name=None, type=None,tensor=None):
         """
@@ -20,6 +24,8 @@ class Tensor(object):
         else:
             _LIB.create_graph_tensor.restype = tensor_t
             self.tensor = _LIB.create_graph_tensor(ctypes.c_void_p(graph.graph), c_str(name), type)
+        # the graph keeps the arrays set as buffers: it returns a new Tensor object on each call
+        self._graph = graph
         self._data = None
         self._buf = None
         self.shape_number = None
@@ -56,12 +62,12 @@ class Tensor(object):
     def shape(self):
         """
         get the shape of tensor
-        :return: <list> An int array
+        :return: <ndarray> An int array, one element per valid dim
         """
-        dim = (ctypes.c_int * self.length)(0, 0, 0, 0)
+        dim = (ctypes.c_int * _MAX_DIM_NUM)()
         _LIB.get_tensor_shape.restype = ctypes.c_int
-        self.shape_number = _LIB.get_tensor_shape(ctypes.c_void_p(self.tensor), ctypes.cast(dim, ctypes.POINTER(ctypes.c_int)), 4)
-        return ctypes2numpy_shared(ctypes.cast(dim, ctypes.POINTER(ctypes.c_int)), (1, 4))[0]
+        self.shape_number = _LIB.get_tensor_shape(ctypes.c_void_p(self.tensor), ctypes.cast(dim, ctypes.POINTER(ctypes.c_int)), _MAX_DIM_NUM)
+        return np.array(dim[:max(self.shape_number, 0)], dtype=np.int32)
 
     @property
     def shape_num(self):
@@ -98,46 +104,76 @@ class Tensor(object):
             return None
         return _LIB.get_tensor_buffer(ctypes.c_void_p(self.tensor))
 
+    @property
+    def __array_interface__(self):
+        """
+        numpy array interface over the tensor buffer: np.asarray(tensor) is a view, no data is copied.
+        The view is valid as long as the buffer is, i.e. until the graph is reshaped or postrun
+        :return: <dict> the array interface, version 3
+        """
+        _LIB.get_tensor_buffer.restype = ctypes.c_void_p
+        addr = _LIB.get_tensor_buffer(ctypes.c_void_p(self.tensor))
+        if not addr:
+            raise ValueError("the tensor has no buffer yet")
+        dtype = np.dtype(Tengine_np_type[_LIB.get_tensor_data_type(ctypes.c_void_p(self.tensor))])
+        shape = tuple(int(d) for d in self.shape)
+        if int(np.prod(shape)) * dtype.itemsize > _LIB.get_tensor_buffer_size(ctypes.c_void_p(self.tensor)):
+            shape = (_LIB.get_tensor_buffer_size(ctypes.c_void_p(self.tensor)) // dtype.itemsize,)
+        return {'shape': shape, 'typestr': dtype.str, 'data': (addr, False), 'version': 3}
+
+    def numpy(self):
+        """
+        Get the tensor data as a numpy array sharing the tensor buffer.
+        :return: <ndarray> a view of the buffer, in the tensor shape and data type
+        """
+        return np.asarray(self)
+
+    def memoryview(self):
+        """
+        Get the tensor data as a memoryview over the tensor buffer.
+        :return: <memoryview>
+        """
+        return memoryview(self.numpy())
+
     @property
     def buf(self):
         """
-        Get the byte size of a tensor should occupy. only for buf that user set themselves
-        :return: <list> data list
+        Get the tensor buffer, without copy.
+        :return: <ndarray> a view of the buffer, None if the buffer is not set
         """
-        if not self._buf:
+        _LIB.get_tensor_buffer.restype = ctypes.c_void_p
+        if not _LIB.get_tensor_buffer(ctypes.c_void_p(self.tensor)):
             return None
-        if self._buf[0] is ctypes.c_char:
-            _LIB.get_tensor_buffer.restype = ctypes.POINTER(self._buf[0])
-            res = _LIB.get_tensor_buffer(ctypes.c_void_p(self.tensor))
-            return res[:self._buf[1]]
-        _LIB.get_tensor_buffer.restype = ctypes.POINTER(self._buf[0])
-        res = _LIB.get_tensor_buffer(ctypes.c_void_p(self.tensor))
-        return res[:self._buf[1]]
+        return self.numpy()
 
     @buf.setter
     def buf(self, value):
         """
         Set the buffer of the tensor.
-        :param value: <int list> or <float list> or <str list>
+        A contiguous numpy array of the tensor data type is used in place: the graph reads and writes its memory.
+        Anything else is converted once. The graph keeps the array alive until the next buffer of the tensor is set,
+        or until the graph is destroyed.
+        :param value: <ndarray> or <int list> or <float list>
         :return: None
         """
+        dtype = Tengine_np_type[_LIB.get_tensor_data_type(ctypes.c_void_p(self.tensor))]
+        array = np.require(value, dtype=dtype, requirements=['C_CONTIGUOUS', 'ALIGNED'])
         _LIB.set_tensor_buffer.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int]
-        check_call(_LIB.set_tensor_buffer(self.tensor, np.ctypeslib.as_ctypes(value), len(value) * ctypes.sizeof((ctypes.c_float))))
+        check_call(_LIB.set_tensor_buffer(self.tensor, array.ctypes.data, array.nbytes))
+        self._buf = array
+        if self._graph is not None:
+            self._graph._buffers[self.tensor] = array
 
     def getData(self):
         """
         get tensor data.
         :return: <list>
         """
-        if self._data[0] == ctypes.c_int:
-            c_data = (ctypes.c_int * self._data[1])(0)
-            check_call(_LIB.get_tensor_data(ctypes.c_void_p(self.tensor), ctypes.pointer(c_data), ctypes.sizeof(ctypes.c_int)))
-            return ctypes2numpy_shared(ctypes.cast(c_data, ctypes.POINTER(ctypes.c_int)), (1, self._data[1]))
-        elif self._data[0] == ctypes.c_float:
-            c_data = (ctypes.c_float * self._data[1])(0.0)
-            check_call(_LIB.get_tensor_data(ctypes.c_void_p(self.tensor), ctypes.cast(c_data, ctypes.c_char_p),
-                                 ctypes.sizeof(ctypes.c_float)))
-            return c_data[:self._data[1]]
+        if self._data[0] == ctypes.c_int or self._data[0] == ctypes.c_float:
+            # copied straight into the numpy array
+            data = np.empty((1, self._data[1]), dtype=np.int32 if self._data[0] == ctypes.c_int else np.float32)
+            check_call(_LIB.get_tensor_data(ctypes.c_void_p(self.tensor), ctypes.c_void_p(data.ctypes.data), data.nbytes))
+            return data if self._data[0] == ctypes.c_int else data[0]
         elif self._data[0] == ctypes.c_char:
             c_data = ctypes.create_string_buffer("", self._data[1])
             check_call(_LIB.get_tensor_data(ctypes.c_void_p(self.tensor), ctypes.cast(c_data, ctypes.c_void_p),
@@ -149,7 +185,7 @@ class Tensor(object):
     def setData(self, data):
         """
         Copy the data to tensor buffer.
-        :param data: <int> or <float> or <str> or <list>  the input data
+        :param data: <int> or <float> or <str> or <list> or <ndarray>  the input data
         :return: None
         """
         if type(data) == type(0):
@@ -168,6 +204,12 @@ class Tensor(object):
             c_data = ctypes.create_string_buffer(data)
             check_call(_LIB.set_tensor_data(ctypes.c_void_p(self.tensor), ctypes.cast(c_data, ctypes.c_char_p),
                                         ctypes.sizeof(c_data)))
+        elif isinstance(data, np.ndarray):
+            array = np.require(data, dtype=Tengine_np_type[_LIB.get_tensor_data_type(ctypes.c_void_p(self.tensor))],
+                               requirements=['C_CONTIGUOUS', 'ALIGNED'])
+            self._data = [ctypes.c_int if array.dtype == np.int32 else ctypes.c_float, array.size]
+            check_call(_LIB.set_tensor_data(ctypes.c_void_p(self.tensor), ctypes.c_void_p(array.ctypes.data),
+                                        array.nbytes))
         elif type(data) == type([]):
             size = len(data)
             if size:
@@ -0,0 +1,112 @@
+# coding: utf-8
+"""Tensor buffers as numpy arrays, on a data -> ReLu graph.
+
+Run from the pytengine directory, with libtengine.so in LD_LIBRARY_PATH:
+    python3 tests/test_tensor.py
+"""
+
+import sys
+import os
+import gc
+import weakref
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+from tengine import tg
+
+
+def create_graph():
+    graph = tg.Graph(None)
+    input_node = tg.Node(graph, "data", "InputOp")
+    input_tensor = tg.Tensor(graph, "data", tg.TENGINE_DT_FP32)
+    input_node.setOutputTensorByIdx(0, input_tensor, tg.TENSOR_TYPE_INPUT)
+
+    relu_node = tg.Node(graph, "relu", "ReLu")
+    relu_node.setInputTensorByIdx(0, input_tensor)
+    relu_tensor = tg.Tensor(graph, "relu", tg.TENGINE_DT_FP32)
+    relu_node.setOutputTensorByIdx(0, relu_tensor, tg.TENSOR_TYPE_VAR)
+
+    graph.setNode(["data"], ["relu"])
+    return graph
+
+
+def test_buffer_view(graph):
+    data = np.random.RandomState(1).randn(1, 2, 3, 5).astype(np.float32)
+
+    input_tensor = graph.getInputTensor(0, 0)
+    input_tensor.shape = data.shape
+    # only the valid dims
+    assert list(input_tensor.shape) == [1, 2, 3, 5]
+
+    # used in place: the graph reads the array itself
+    input_tensor.buf = data
+    assert np.shares_memory(input_tensor.buf, data)
+    assert input_tensor.buf.shape == data.shape and input_tensor.buf.dtype == np.float32
+
+    graph.preRun()
+    data[0, 0, 0, 0] = -1.0
+    data[0, 1, 2, 4] = 2.5
+    graph.run(1)
+
+    output_tensor = graph.getOutputTensor(0, 0)
+    output = np.asarray(output_tensor)
+    assert output.shape == (1, 2, 3, 5) and output.dtype == np.float32
+    assert np.array_equal(output, np.maximum(data, 0))
+    assert np.shares_memory(output_tensor.numpy(), output_tensor.buf)
+    assert output_tensor.memoryview().nbytes == data.nbytes
+
+    # another dtype and a non contiguous array are converted once, the converted array outlives the tensor object
+    data64 = np.random.RandomState(2).randn(1, 2, 5, 3).transpose(0, 1, 3, 2)
+    graph.getInputTensor(0, 0).buf = data64
+    gc.collect()
+    assert not np.shares_memory(input_tensor.buf, data64)
+    graph.run(1)
+    assert np.array_equal(graph.getOutputTensor(0, 0).numpy(), np.maximum(data64.astype(np.float32), 0))
+
+
+def test_copy(graph):
+    data = np.random.RandomState(3).randn(1, 2, 3, 5).astype(np.float32)
+
+    input_tensor = graph.getInputTensor(0, 0)
+    input_tensor.setData(data)
+    assert np.array_equal(input_tensor.getData(), data.flatten())
+
+    graph.run(1)
+    assert np.array_equal(graph.getOutputTensor(0, 0).numpy(), np.maximum(data, 0))
+
+
+def test_buffer_lifetime():
+    # the converted arrays belong to their graph, and go with it
+    graph = create_graph()
+    other = create_graph()
+    graph.getInputTensor(0, 0).buf = np.zeros((1, 2, 3, 5), dtype=np.float64)
+    other.getTensorByName("data").buf = np.zeros((1, 2, 3, 5), dtype=np.float64)
+    gc.collect()
+    assert len(graph._buffers) == 1 and len(other._buffers) == 1
+
+    array = weakref.ref(list(graph._buffers.values())[0])
+    other_array = weakref.ref(list(other._buffers.values())[0])
+
+    # a new buffer of the tensor drops the previous array
+    graph.getInputTensor(0, 0).buf = np.ones((1, 2, 3, 5), dtype=np.float64)
+    gc.collect()
+    assert array() is None and len(graph._buffers) == 1
+
+    array = weakref.ref(list(graph._buffers.values())[0])
+    del graph
+    gc.collect()
+    assert array() is None and other_array() is not None
+    del other
+    gc.collect()
+    assert other_array() is None
+
+
+if __name__ == "__main__":
+    graph = create_graph()
+    test_buffer_view(graph)
+    test_copy(graph)
+    graph.postRun()
+    del graph
+    test_buffer_lifetime()
+    print("pass")
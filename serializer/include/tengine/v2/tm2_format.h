@@ -40,6 +40,9 @@ extern "C" {
 
 #define TM2_NOT_SET 0x00
 
+/* const buffer data is aligned to this in the file, so a mapped file can be used in place */
+#define TM2_BUFFER_ALIGN 64
+
 /* Type define */
 typedef uint32_t tm_uoffset_t; /* offset is 4-byte unsigned integer */
 typedef uint32_t tm_size_t; /* size is 4-byte unsigned integer */
@@ -55,7 +55,8 @@ public:
         return false;
     }
 
-    bool LoadBinaryFile(const char* tm_fname, int& fd, void*& buf, int& size);
+    bool LoadBinaryFile(const char* tm_fname, int& fd, void*& buf, int& size, bool keep_map = false);
+    bool IsKeepMapping(void);
 
     virtual bool LoadModelFromMem(void* mmap_buf, StaticGraph* graph)
     {
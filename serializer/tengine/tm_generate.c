@@ -45,6 +45,16 @@ uint32_t WriteTmFileAlign4(void* const start_ptr, uint32_t* cur_pos, const void*
     return WriteTmFileAlign1(start_ptr, cur_pos, buf, buf_size);
 }
 
+uint32_t WriteTmFileAlign64(void* const start_ptr, uint32_t* cur_pos, const void* buf, const uint32_t buf_size)
+{
+    uint32_t buf_pos = ALIGN(*cur_pos, 64);
+
+    memset(start_ptr + *cur_pos, 0, buf_pos - *cur_pos);
+    *cur_pos = buf_pos;
+
+    return WriteTmFileAlign1(start_ptr, cur_pos, buf, buf_size);
+}
+
 uint32_t WriteTmObject(void* const start_ptr, uint32_t* cur_pos, const void* buf, const uint32_t buf_size)
 {
     return WriteTmFileAlign4(start_ptr, cur_pos, buf, buf_size);
@@ -29,6 +29,7 @@
 #include "operator_manager.hpp"
 #include "static_graph.hpp"
 #include "graph.hpp"
+#include "weight_cache.hpp"
 
 #include "tm_serializer.hpp"
 
@@ -105,7 +106,27 @@ bool TmSerializer::SaveModel(std::vector<void*>& addr_list, std::vector<int>& si
     return ret;
 }
 
-bool TmSerializer::LoadBinaryFile(const char* tm_fname, int& fd, void*& buf, int& size)
+/*
+ * TM_MMAP_WEIGHT keeps the model file mapped for the lifetime of the graph and lets the const
+ * tensors point into it instead of copying them out. The mapping is private: pages nobody writes
+ * stay shared with the page cache (and with other processes loading the same file), a kernel
+ * that rewrites its weights in place only gets its own copy of the touched pages.
+ */
+bool TmSerializer::IsKeepMapping(void)
+{
+    const char* env = std::getenv("TM_MMAP_WEIGHT");
+
+    /* the graphs sharing their weights keep the original ones in the page cache */
+    if(WeightShareEnabled())
+        return true;
+
+    if(env && env[0] != '0')
+        return true;
+    else
+        return false;
+}
+
+bool TmSerializer::LoadBinaryFile(const char* tm_fname, int& fd, void*& buf, int& size, bool keep_map)
 {
     fd = open(tm_fname, O_RDONLY);
     if(fd == -1)
@@ -118,10 +139,15 @@ bool TmSerializer::LoadBinaryFile(const char* tm_fname, int& fd, void*& buf, int
     fstat(fd, &sb);
     size = sb.st_size;
 
-    buf = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if(keep_map)
+        buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    else
+        buf = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
     if(buf == MAP_FAILED)
     {
         LOG_ERROR() << "Mmap of \'" << tm_fname << "\' failed\n";
+        close(fd);
         return false;
     }
 
@@ -133,13 +159,21 @@ bool TmSerializer::LoadModel(const std::vector<std::string>& file_list, StaticGr
     int fd;
     void* mmap_buf;
     int mmap_size;
+    bool keep_map = IsKeepMapping();
 
     if(file_list.size() != GetFileNum())
         return false;
 
-    if(!LoadBinaryFile(file_list[0].c_str(), fd, mmap_buf, mmap_size))
+    if(!LoadBinaryFile(file_list[0].c_str(), fd, mmap_buf, mmap_size, keep_map))
         return false;
 
+    /* the graph owns the mapping from here on, and unmaps it when destroyed */
+    if(keep_map)
+    {
+        graph->mem_map_addr = mmap_buf;
+        graph->mem_map_size = mmap_size;
+    }
+
     SetGraphSource(graph, file_list[0]);
     SetGraphSourceFormat(graph, "tengine");
     SetGraphConstTensorFile(graph, file_list[0]);
@@ -157,7 +191,8 @@ bool TmSerializer::LoadModel(const std::vector<std::string>& file_list, StaticGr
 
     bool ret = tm_serializer->LoadModelFromMem(mmap_buf, graph);
 
-    munmap(const_cast<void*>(mmap_buf), mmap_size);
+    if(!keep_map)
+        munmap(const_cast<void*>(mmap_buf), mmap_size);
     close(fd);
     return ret;
 }
@@ -378,7 +378,7 @@ tm_uoffset_t TmSerializer2::SaveTmSubgraph(void* const start_ptr, tm_uoffset_t*
         {
             /* TM2_FOR_BENCHMARK environment variable does not exist */
             tm_buf.offset_data =
-                WriteTmFileAlign1(start_ptr, cur_pos, reinterpret_cast<const uint8_t*>(buf_ptrs[i]), tm_buf.size);
+                WriteTmFileAlign64(start_ptr, cur_pos, reinterpret_cast<const uint8_t*>(buf_ptrs[i]), tm_buf.size);
         }
         v_buffers->offsets[i] = WriteTmObject(start_ptr, cur_pos, &tm_buf, sizeof(TM2_Buffer));
     }
@@ -537,6 +537,22 @@ bool TmSerializer2::LoadNode(StaticGraph* graph, StaticNode* node, const TM2_Nod
     return true;
 }
 
+/*
+ * A const buffer can be used in place when the graph keeps the file mapped, its data is aligned
+ * like a malloc'ed buffer would be, and the 128 bytes behind it that kernels may over-read are
+ * still inside the file.
+ */
+static bool CanUseMappedBuffer(StaticGraph* graph, const TM2_Buffer* tm_buf, void* mmap_buf)
+{
+    if(graph->mem_map_addr != mmap_buf || tm_buf->offset_data == TM2_NOT_SET)
+        return false;
+
+    if(tm_buf->offset_data % 16)
+        return false;
+
+    return ( size_t )tm_buf->offset_data + tm_buf->size + 128 <= graph->mem_map_size;
+}
+
 bool TmSerializer2::LoadTensor(StaticGraph* graph, const TM2_Tensor* tm_tensor, const TM2_Buffer* tm_buf,
                                void* mmap_buf)
 {
@@ -583,7 +599,13 @@ bool TmSerializer2::LoadTensor(StaticGraph* graph, const TM2_Tensor* tm_tensor,
     SetTensorDataType(tensor, tm_tensor->data_type);
 
     /* Set the memory size and pointer */
-    if(tm_tensor->type == kConstTensor)
+    if(tm_tensor->type == kConstTensor && CanUseMappedBuffer(graph, tm_buf, mmap_buf))
+    {
+        SetTensorSize(tensor, tm_buf->size);
+        SetConstTensorMappedBuffer(tensor, ( char* )mmap_buf + tm_buf->offset_data);
+        SetConstTensorFileLocation(tensor, -1, 0);
+    }
+    else if(tm_tensor->type == kConstTensor)
     {
         SetTensorSize(tensor, tm_buf->size);
         void* buf = malloc(tm_buf->size + 128);
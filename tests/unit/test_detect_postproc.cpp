@@ -0,0 +1,434 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+#include "graph.hpp"
+#include "detect_postproc.hpp"
+#include "operator/detection_output.hpp"
+
+using namespace TEngine;
+
+struct Rect
+{
+    float x0, y0, x1, y1;
+    float score;
+    int class_idx;
+};
+
+static float rand_float(void)
+{
+    return ( float )rand() / RAND_MAX;
+}
+
+/* the NMS of the DetectionOutput kernel before the shared library, with the IoU division */
+static void old_nms(const std::vector<Rect>& boxes, float threshold, std::vector<int>& picked)
+{
+    picked.clear();
+
+    for(unsigned int i = 0; i < boxes.size(); i++)
+    {
+        const Rect& a = boxes[i];
+        bool keep = true;
+
+        for(unsigned int j = 0; j < picked.size() && keep; j++)
+        {
+            const Rect& b = boxes[picked[j]];
+
+            if(a.x0 > b.x1 || a.x1 < b.x0 || a.y0 > b.y1 || a.y1 < b.y0)
+                continue;
+
+            float inter = (std::min(a.x1, b.x1) - std::max(a.x0, b.x0)) * (std::min(a.y1, b.y1) - std::max(a.y0, b.y0));
+            float area_a = (a.x1 - a.x0) * (a.y1 - a.y0);
+            float area_b = (b.x1 - b.x0) * (b.y1 - b.y0);
+
+            if(inter / (area_a + area_b - inter) > threshold)
+                keep = false;
+        }
+
+        if(keep)
+            picked.push_back(i);
+    }
+}
+
+static void to_arrays(const std::vector<Rect>& rects, BoxArrays& boxes)
+{
+    boxes.Resize(rects.size());
+
+    for(unsigned int i = 0; i < rects.size(); i++)
+    {
+        float rect[4] = {rects[i].x0, rects[i].y0, rects[i].x1, rects[i].y1};
+
+        boxes.Set(i, rect);
+    }
+}
+
+/* ties keep the index order, also when top_k cuts a run of equal scores */
+static int test_topk_ties(void)
+{
+    /* scores at stride 2, the odd slots must be ignored */
+    float score[] = {0.5f, 9.f, 0.9f, 9.f, 0.5f, 9.f, 0.7f, 9.f, 0.9f, 9.f, 0.5f, 9.f, 0.1f, 9.f, 0.5f, 9.f};
+    int expect_all[] = {1, 4, 3, 0, 2, 5, 7, 6};
+    int expect_top4[] = {1, 4, 3, 0};
+
+    for(int top_k = 0; top_k <= 4; top_k += 4)
+    {
+        std::vector<int> idx = {7, 6, 5, 4, 3, 2, 1, 0};
+        const int* expect = top_k ? expect_top4 : expect_all;
+        int expect_num = top_k ? 4 : 8;
+
+        SelectTopK(score, 2, idx, top_k);
+
+        if(( int )idx.size() != expect_num || !std::equal(idx.begin(), idx.end(), expect))
+        {
+            printf("topk %d: wrong order:", top_k);
+
+            for(int i : idx)
+                printf(" %d", i);
+
+            printf("\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* greedy keeps c, which overlaps only b. fast drops it, b overlaps it and b is better */
+static int test_nms_chain(void)
+{
+    std::vector<Rect> rects = {{0, 0, 10, 10}, {4, 0, 14, 10}, {8, 0, 18, 10}};
+    BoxArrays boxes;
+    std::vector<int> picked;
+    std::vector<int> fast_picked;
+
+    to_arrays(rects, boxes);
+
+    NmsSortedBoxes(boxes, 0.3f, false, picked);
+    NmsSortedBoxes(boxes, 0.3f, true, fast_picked);
+
+    if(picked != std::vector<int>({0, 2}) || fast_picked != std::vector<int>({0}))
+    {
+        printf("nms chain: greedy keeps %u, fast keeps %u\n", ( unsigned int )picked.size(),
+               ( unsigned int )fast_picked.size());
+        return -1;
+    }
+
+    return 0;
+}
+
+/* greedy matches the old NMS, fast keeps a subset of it */
+static int test_nms_random(void)
+{
+    srand(3);
+
+    for(int round = 0; round < 20; round++)
+    {
+        int n = 50 + round * 50;
+        std::vector<Rect> rects(n);
+
+        for(int i = 0; i < n; i++)
+        {
+            float x = rand_float() * 100;
+            float y = rand_float() * 100;
+
+            rects[i] = {x, y, x + 5 + rand_float() * 20, y + 5 + rand_float() * 20, 0, 0};
+        }
+
+        BoxArrays boxes;
+        std::vector<int> old_picked;
+        std::vector<int> picked;
+        std::vector<int> fast_picked;
+
+        to_arrays(rects, boxes);
+
+        old_nms(rects, 0.45f, old_picked);
+        NmsSortedBoxes(boxes, 0.45f, false, picked);
+        NmsSortedBoxes(boxes, 0.45f, true, fast_picked);
+
+        if(picked != old_picked)
+        {
+            printf("nms round %d: greedy keeps %u, the old NMS %u\n", round, ( unsigned int )picked.size(),
+                   ( unsigned int )old_picked.size());
+            return -1;
+        }
+
+        if(!std::includes(picked.begin(), picked.end(), fast_picked.begin(), fast_picked.end()))
+        {
+            printf("nms round %d: fast keeps a box greedy drops\n", round);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+struct DetectionCase
+{
+    int num_prior;
+    int num_classes;
+    float confidence_threshold;
+    float nms_threshold;
+    int nms_top_k;
+    int keep_top_k;
+};
+
+/* the DetectionOutput kernel before the shared library: decode, per class sort + NMS, global sort */
+static void old_detection_output(const DetectionCase& t, const float* loc, const float* conf, const float* prior,
+                                 std::vector<Rect>& result)
+{
+    std::vector<Rect> boxes(t.num_prior);
+
+    for(int i = 0; i < t.num_prior; i++)
+    {
+        const float* l = loc + i * 4;
+        const float* pbox = prior + i * 4;
+        const float* pvar = pbox + t.num_prior * 4;
+        float pbox_w = pbox[2] - pbox[0];
+        float pbox_h = pbox[3] - pbox[1];
+        float pbox_cx = (pbox[0] + pbox[2]) * 0.5f;
+        float pbox_cy = (pbox[1] + pbox[3]) * 0.5f;
+        float bbox_cx = pvar[0] * l[0] * pbox_w + pbox_cx;
+        float bbox_cy = pvar[1] * l[1] * pbox_h + pbox_cy;
+        float bbox_w = pbox_w * exp(pvar[2] * l[2]);
+        float bbox_h = pbox_h * exp(pvar[3] * l[3]);
+
+        boxes[i].x0 = bbox_cx - bbox_w * 0.5f;
+        boxes[i].y0 = bbox_cy - bbox_h * 0.5f;
+        boxes[i].x1 = bbox_cx + bbox_w * 0.5f;
+        boxes[i].y1 = bbox_cy + bbox_h * 0.5f;
+    }
+
+    result.clear();
+
+    for(int c = 1; c < t.num_classes; c++)
+    {
+        std::vector<Rect> class_box;
+        std::vector<int> picked;
+
+        for(int i = 0; i < t.num_prior; i++)
+        {
+            float score = conf[i * t.num_classes + c];
+
+            if(score > t.confidence_threshold)
+            {
+                class_box.push_back(boxes[i]);
+                class_box.back().score = score;
+                class_box.back().class_idx = c;
+            }
+        }
+
+        std::sort(class_box.begin(), class_box.end(), [](const Rect& a, const Rect& b) { return a.score > b.score; });
+
+        if(t.nms_top_k < ( int )class_box.size())
+            class_box.resize(t.nms_top_k);
+
+        old_nms(class_box, t.nms_threshold, picked);
+
+        for(int i : picked)
+            result.push_back(class_box[i]);
+    }
+
+    std::sort(result.begin(), result.end(), [](const Rect& a, const Rect& b) { return a.score > b.score; });
+
+    if(t.keep_top_k < ( int )result.size())
+        result.resize(t.keep_top_k);
+}
+
+static void add_input(graph_t graph, const char* name, const int* dims, const float* data, int size)
+{
+    node_t node = create_graph_node(graph, name, "InputOp");
+    tensor_t tensor = create_graph_tensor(graph, name, TENGINE_DT_FP32);
+
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(tensor, dims, 4);
+    set_tensor_buffer(tensor, ( void* )data, size * sizeof(float));
+
+    release_graph_tensor(tensor);
+    release_graph_node(node);
+}
+
+graph_t create_test_graph(const DetectionCase& t, const float* loc, const float* conf, const float* prior)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    int loc_dims[4] = {1, t.num_prior * 4, 1, 1};
+    int conf_dims[4] = {1, t.num_prior * t.num_classes, 1, 1};
+    int prior_dims[4] = {1, 2, t.num_prior * 4, 1};
+
+    add_input(graph, "loc", loc_dims, loc, t.num_prior * 4);
+    add_input(graph, "conf", conf_dims, conf, t.num_prior * t.num_classes);
+    add_input(graph, "prior", prior_dims, prior, t.num_prior * 8);
+
+    node_t node = create_graph_node(graph, "detect", "DetectionOutput");
+    const char* inputs[] = {"loc", "conf", "prior"};
+
+    for(int i = 0; i < 3; i++)
+    {
+        tensor_t tensor = get_graph_tensor(graph, inputs[i]);
+
+        set_node_input_tensor(node, i, tensor);
+        release_graph_tensor(tensor);
+    }
+
+    tensor_t output_tensor = create_graph_tensor(graph, "detect", TENGINE_DT_FP32);
+
+    set_node_output_tensor(node, 0, output_tensor, TENSOR_TYPE_VAR);
+    release_graph_tensor(output_tensor);
+
+    DetectionOutputParam* param =
+        dynamic_cast<DetectionOutput*>(reinterpret_cast<Node*>(node)->GetOp())->GetParam();
+
+    param->num_classes = t.num_classes;
+    param->confidence_threshold = t.confidence_threshold;
+    param->nms_threshold = t.nms_threshold;
+    param->nms_top_k = t.nms_top_k;
+    param->keep_top_k = t.keep_top_k;
+
+    release_graph_node(node);
+
+    const char* outputs[] = {"detect"};
+
+    if(set_graph_input_node(graph, inputs, 3) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+/* the priors overlap in clusters, and the scores are all different, so the old sort has one order.
+   keep_top_k is above the kept boxes, all of them are compared */
+static int test_detection_output(void)
+{
+    DetectionCase t = {1200, 6, 0.3f, 0.45f, 100, 500};
+    std::vector<float> loc(t.num_prior * 4);
+    std::vector<float> conf(t.num_prior * t.num_classes);
+    std::vector<float> prior(t.num_prior * 8);
+    int score_num = conf.size();
+
+    srand(5);
+
+    for(int i = 0; i < t.num_prior; i++)
+    {
+        float cx = (i % 10) * 0.1f + 0.05f;
+        float cy = (i / 10 % 10) * 0.1f + 0.05f;
+        float half = 0.03f + (i / 100) * 0.01f;
+        float* pbox = prior.data() + i * 4;
+        float* pvar = pbox + t.num_prior * 4;
+
+        pbox[0] = cx - half;
+        pbox[1] = cy - half;
+        pbox[2] = cx + half;
+        pbox[3] = cy + half;
+        pvar[0] = pvar[1] = 0.1f;
+        pvar[2] = pvar[3] = 0.2f;
+
+        for(int k = 0; k < 4; k++)
+            loc[i * 4 + k] = rand_float() * 2 - 1;
+    }
+
+    for(int i = 0; i < score_num; i++)
+        conf[i] = ( float )(( long )i * 7919 % score_num) / score_num;
+
+    std::vector<Rect> expect;
+
+    old_detection_output(t, loc.data(), conf.data(), prior.data(), expect);
+
+    graph_t graph = create_test_graph(t, loc.data(), conf.data(), prior.data());
+
+    if(graph == nullptr)
+        return -1;
+
+    /* the old kernel had only greedy NMS */
+    unsetenv("DETECT_FAST_NMS");
+
+    if(prerun_graph(graph) < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return -1;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    const float* output = ( const float* )get_tensor_buffer(output_tensor);
+    int dims[4];
+    int ret = 0;
+
+    get_tensor_shape(output_tensor, dims, 4);
+
+    if(dims[1] != ( int )expect.size() || expect.empty())
+    {
+        printf("detection output: %d boxes, the old kernel %u\n", dims[1], ( unsigned int )expect.size());
+        ret = -1;
+    }
+
+    for(int i = 0; i < dims[1] && ret == 0; i++)
+    {
+        const float* out = output + i * 6;
+        const Rect& r = expect[i];
+
+        if(out[0] != r.class_idx || out[1] != r.score || std::fabs(out[2] - r.x0) > 1e-6 ||
+           std::fabs(out[3] - r.y0) > 1e-6 || std::fabs(out[4] - r.x1) > 1e-6 || std::fabs(out[5] - r.y1) > 1e-6)
+        {
+            printf("detection output: box %d: class %f score %f vs class %d score %f\n", i, out[0], out[1],
+                   r.class_idx, r.score);
+            ret = -1;
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    postrun_graph(graph);
+    destroy_graph(graph);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+
+    init_tengine();
+
+    if(test_topk_ties() < 0 || test_nms_chain() < 0 || test_nms_random() < 0 || test_detection_output() < 0)
+        ret = -1;
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+
+/* the fully connected layer with the weights stored as fp32, fp16 and bf16,
+   checked against a plain fp32 dot product within the rounding bound of the storage */
+
+static float rand_float(void)
+{
+    return ( float )rand() / RAND_MAX - 0.5f;
+}
+
+graph_t create_test_graph(int batch, int in_size, int out_size, int weight_type, const float* weight, const float* bias)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    if(set_graph_attr(graph, "weight_type", &weight_type, sizeof(int)) < 0)
+    {
+        std::cerr << "set weight_type failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    int dims[2] = {batch, in_size};
+    set_tensor_shape(input_tensor, dims, 2);
+
+    node_t fc_node = create_graph_node(graph, "fc", "FullyConnected");
+    set_node_input_tensor(fc_node, 0, input_tensor);
+    set_node_attr_int(fc_node, "num_output", &out_size);
+
+    node_t w_node = create_graph_node(graph, "fc/weight", "Const");
+    tensor_t w_tensor = create_graph_tensor(graph, "fc/weight", TENGINE_DT_FP32);
+    set_node_output_tensor(w_node, 0, w_tensor, TENSOR_TYPE_CONST);
+    int w_dims[2] = {out_size, in_size};
+    set_tensor_shape(w_tensor, w_dims, 2);
+    set_tensor_buffer(w_tensor, ( void* )weight, out_size * in_size * sizeof(float));
+    set_node_input_tensor(fc_node, 1, w_tensor);
+
+    node_t b_node = create_graph_node(graph, "fc/bias", "Const");
+    tensor_t b_tensor = create_graph_tensor(graph, "fc/bias", TENGINE_DT_FP32);
+    set_node_output_tensor(b_node, 0, b_tensor, TENSOR_TYPE_CONST);
+    int b_dims[1] = {out_size};
+    set_tensor_shape(b_tensor, b_dims, 1);
+    set_tensor_buffer(b_tensor, ( void* )bias, out_size * sizeof(float));
+    set_node_input_tensor(fc_node, 2, b_tensor);
+
+    tensor_t output_tensor = create_graph_tensor(graph, "fc", TENGINE_DT_FP32);
+    set_node_output_tensor(fc_node, 0, output_tensor, TENSOR_TYPE_VAR);
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(w_tensor);
+    release_graph_tensor(b_tensor);
+    release_graph_tensor(output_tensor);
+    release_graph_node(input_node);
+    release_graph_node(w_node);
+    release_graph_node(b_node);
+    release_graph_node(fc_node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"fc"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+/* eps is the relative rounding error of one stored weight */
+int test_weight_type(int batch, int in_size, int out_size, int weight_type, float eps)
+{
+    std::vector<float> weight(out_size * in_size);
+    std::vector<float> bias(out_size);
+    std::vector<float> input(batch * in_size);
+
+    for(auto& v : weight)
+        v = rand_float();
+    for(auto& v : bias)
+        v = rand_float();
+    for(auto& v : input)
+        v = rand_float();
+
+    graph_t graph = create_test_graph(batch, in_size, out_size, weight_type, weight.data(), bias.data());
+
+    if(graph == nullptr)
+        return -1;
+
+    tensor_t input_tensor = get_graph_input_tensor(graph, 0, 0);
+    set_tensor_buffer(input_tensor, input.data(), input.size() * sizeof(float));
+    release_graph_tensor(input_tensor);
+
+    if(prerun_graph(graph) < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    const float* output = ( const float* )get_tensor_buffer(output_tensor);
+    int ret = 0;
+
+    for(int n = 0; n < batch && ret == 0; n++)
+    {
+        for(int i = 0; i < out_size; i++)
+        {
+            const float* x = input.data() + n * in_size;
+            const float* w = weight.data() + i * in_size;
+            double sum = bias[i];
+            double mag = std::fabs(bias[i]);
+
+            for(int k = 0; k < in_size; k++)
+            {
+                sum += ( double )x[k] * w[k];
+                mag += std::fabs(( double )x[k] * w[k]);
+            }
+
+            /* the storage rounding plus the fp32 accumulation */
+            double bound = mag * (eps + 1e-5);
+            float off = output[n * out_size + i] - ( float )sum;
+
+            if(std::fabs(off) > bound)
+            {
+                printf("mismatch: weight_type %d batch %d [%d][%d] %f vs %f, off %f bound %f\n", weight_type, batch, n,
+                       i, output[n * out_size + i], ( float )sum, off, bound);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    postrun_graph(graph);
+    destroy_graph(graph);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    init_tengine();
+
+    int ret = 0;
+
+    /* a single sample, and a batch with a group of four and a remainder */
+    for(int batch = 1; batch <= 5; batch += 4)
+    {
+        if(test_weight_type(batch, 300, 67, TENGINE_WEIGHT_FP32, 0.f) < 0)
+            ret = -1;
+        if(test_weight_type(batch, 300, 67, TENGINE_WEIGHT_FP16, 1.f / 2048) < 0)
+            ret = -1;
+        if(test_weight_type(batch, 300, 67, TENGINE_WEIGHT_BF16, 1.f / 256) < 0)
+            ret = -1;
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
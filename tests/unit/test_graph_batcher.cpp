@@ -0,0 +1,377 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+
+#include "tengine_c_api.h"
+
+/*
+ * data [1, 2, 3, 3] -> ReLu out, run through a batcher from several threads. Each request gets the ReLu of
+ * its own sample back. The batch of the last run is read from dim 0 of the input, which the batcher
+ * reshapes. The delays are long, so that the timing checks hold on a loaded machine.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static const int c = 2, h = 3, w = 3;
+static const int size = c * h * w;
+
+struct Request
+{
+    std::vector<float> input;
+    std::vector<float> output;
+    int output_size;
+    int ret;
+};
+
+static void init_request(Request& req, int id)
+{
+    req.input.resize(size);
+    req.output.assign(size + 1, -1.f);
+    req.output_size = size * sizeof(float);
+    req.ret = 1;
+
+    for(int k = 0; k < size; k++)
+        req.input[k] = (k % 3 - 1) * (id + 1) + 0.5f * k;
+}
+
+static void run_request(batcher_t batcher, Request* req)
+{
+    const void* input_data[] = {req->input.data()};
+    void* output_data[] = {req->output.data()};
+
+    req->ret = run_graph_batcher(batcher, input_data, output_data, &req->output_size);
+}
+
+/* every request returns expect_ret, the ones that succeed get their own ReLu and nothing past it */
+static int check_requests(const std::vector<Request>& reqs, const std::vector<int>& expect_ret, const char* desc)
+{
+    for(unsigned int i = 0; i < reqs.size(); i++)
+    {
+        const Request& req = reqs[i];
+
+        if(req.ret != expect_ret[i])
+        {
+            printf("%s: request %u returned %d\n", desc, i, req.ret);
+            return -1;
+        }
+
+        if(req.ret != 0)
+            continue;
+
+        for(int k = 0; k < size; k++)
+        {
+            float v = req.input[k];
+
+            if(req.output[k] != (v > 0 ? v : 0))
+            {
+                printf("%s: request %u [%d] %f vs %f\n", desc, i, k, req.output[k], v);
+                return -1;
+            }
+        }
+
+        if(req.output[size] != -1.f)
+        {
+            printf("%s: request %u got more than its sample\n", desc, i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* run the requests from one thread each, returns the seconds until the last one is done */
+static double run_threads(batcher_t batcher, std::vector<Request>& reqs)
+{
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+
+    for(auto& req : reqs)
+        threads.push_back(std::thread(run_request, batcher, &req));
+
+    for(auto& t : threads)
+        t.join();
+
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static int last_batch(graph_t graph)
+{
+    tensor_t tensor = get_graph_input_tensor(graph, 0, 0);
+    int dims[4];
+
+    get_tensor_shape(tensor, dims, 4);
+    release_graph_tensor(tensor);
+
+    return dims[0];
+}
+
+graph_t create_test_graph(float* input)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, c, h, w};
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, dims, 4);
+    set_tensor_buffer(input_tensor, input, size * sizeof(float));
+
+    node_t relu_node = create_graph_node(graph, "out", "ReLu");
+    tensor_t output_tensor = create_graph_tensor(graph, "out", TENGINE_DT_FP32);
+
+    set_node_input_tensor(relu_node, 0, input_tensor);
+    set_node_output_tensor(relu_node, 0, output_tensor, TENSOR_TYPE_VAR);
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+    release_graph_node(input_node);
+    release_graph_node(relu_node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"out"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+/* max_batch requests fill a batch long before the delay is out */
+static int test_coalesce(graph_t graph)
+{
+    batcher_t batcher = create_graph_batcher(graph, 4, 5000000);
+    std::vector<Request> reqs(4);
+
+    for(int i = 0; i < 4; i++)
+        init_request(reqs[i], i);
+
+    double seconds = run_threads(batcher, reqs);
+    int ret = check_requests(reqs, {0, 0, 0, 0}, "coalesce");
+
+    if(ret == 0 && (seconds > 4 || last_batch(graph) != 4))
+    {
+        printf("coalesce: %.3f s, last batch %d\n", seconds, last_batch(graph));
+        ret = -1;
+    }
+
+    destroy_graph_batcher(batcher);
+
+    return ret;
+}
+
+/* a lone request runs alone once the delay is out */
+static int test_delay_flush(graph_t graph)
+{
+    batcher_t batcher = create_graph_batcher(graph, 4, 200000);
+    std::vector<Request> reqs(1);
+
+    init_request(reqs[0], 7);
+
+    double seconds = run_threads(batcher, reqs);
+    int ret = check_requests(reqs, {0}, "delay flush");
+
+    if(ret == 0 && (seconds < 0.19 || seconds > 4 || last_batch(graph) != 1))
+    {
+        printf("delay flush: %.3f s, last batch %d\n", seconds, last_batch(graph));
+        ret = -1;
+    }
+
+    destroy_graph_batcher(batcher);
+
+    return ret;
+}
+
+/* 6 requests with max_batch 4: no batch is larger, every sample gets its own output */
+static int test_split(graph_t graph)
+{
+    batcher_t batcher = create_graph_batcher(graph, 4, 100000);
+    std::vector<Request> reqs(6);
+
+    for(int i = 0; i < 6; i++)
+        init_request(reqs[i], i + 10);
+
+    run_threads(batcher, reqs);
+
+    int ret = check_requests(reqs, {0, 0, 0, 0, 0, 0}, "split");
+
+    if(ret == 0 && last_batch(graph) > 4)
+    {
+        printf("split: last batch %d\n", last_batch(graph));
+        ret = -1;
+    }
+
+    destroy_graph_batcher(batcher);
+
+    return ret;
+}
+
+/* a too small output buffer fails its own request only */
+static int test_small_output(graph_t graph)
+{
+    batcher_t batcher = create_graph_batcher(graph, 2, 5000000);
+    std::vector<Request> reqs(2);
+
+    init_request(reqs[0], 3);
+    init_request(reqs[1], 4);
+    reqs[1].output_size = size * sizeof(float) - 1;
+
+    run_threads(batcher, reqs);
+
+    int ret = check_requests(reqs, {0, -1}, "small output");
+
+    if(ret == 0 && reqs[1].output[0] != -1.f)
+    {
+        printf("small output: the failed request got an output\n");
+        ret = -1;
+    }
+
+    destroy_graph_batcher(batcher);
+
+    return ret;
+}
+
+/* destroy runs the queued requests at once instead of waiting for the delay */
+static int test_destroy_queued(graph_t graph)
+{
+    batcher_t batcher = create_graph_batcher(graph, 4, 10000000);
+    std::vector<Request> reqs(3);
+    std::vector<std::thread> threads;
+
+    for(int i = 0; i < 3; i++)
+    {
+        init_request(reqs[i], i + 20);
+        threads.push_back(std::thread(run_request, batcher, &reqs[i]));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    Clock::time_point start = Clock::now();
+    int ret = destroy_graph_batcher(batcher);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for(auto& t : threads)
+        t.join();
+
+    if(ret < 0 || seconds > 5)
+    {
+        printf("destroy: returned %d after %.3f s\n", ret, seconds);
+        ret = -1;
+    }
+
+    if(check_requests(reqs, {0, 0, 0}, "destroy") < 0)
+        ret = -1;
+
+    return ret;
+}
+
+/* after destroy the graph has its own input again */
+static int test_direct_run(graph_t graph, const float* input)
+{
+    tensor_t input_tensor = get_graph_input_tensor(graph, 0, 0);
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    int ret = 0;
+
+    if(get_tensor_buffer(input_tensor) != input || last_batch(graph) != 1)
+    {
+        printf("the input buffer is not given back, batch %d\n", last_batch(graph));
+        ret = -1;
+    }
+    else if(run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        ret = -1;
+    }
+    else
+    {
+        const float* output = ( const float* )get_tensor_buffer(output_tensor);
+
+        for(int k = 0; k < size; k++)
+        {
+            if(output[k] != (input[k] > 0 ? input[k] : 0))
+            {
+                printf("direct run: [%d] %f vs %f\n", k, output[k], input[k]);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    Request direct;
+
+    init_request(direct, 100);
+    init_tengine();
+
+    graph_t graph = create_test_graph(direct.input.data());
+
+    if(graph == nullptr)
+        return -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    int ret = 0;
+
+    if(test_coalesce(graph) < 0 || test_direct_run(graph, direct.input.data()) < 0)
+        ret = -1;
+
+    if(test_delay_flush(graph) < 0 || test_split(graph) < 0 || test_small_output(graph) < 0)
+        ret = -1;
+
+    if(test_destroy_queued(graph) < 0 || test_direct_run(graph, direct.input.data()) < 0)
+        ret = -1;
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
@@ -0,0 +1,431 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+#include "graph_executor.hpp"
+#include "operator/reshape.hpp"
+
+using namespace TEngine;
+
+/*
+ * Each graph runs with one of the PadFold, ConvEltwise, ConvActivation and ReshapeChain passes on,
+ * and off through GRAPH_OPT_DISABLE. The pass must remove nodes, and keep the output dims and data.
+ */
+
+static std::list<std::vector<float>> buffers;
+static unsigned int seed = 1;
+
+static float rand_float(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (( int )((seed >> 16) & 0x7fff) - 16384) / 16384.f;
+}
+
+static void add_input(graph_t graph, const char* name, int c, int h, int w)
+{
+    node_t node = create_graph_node(graph, name, "InputOp");
+    tensor_t tensor = create_graph_tensor(graph, name, TENGINE_DT_FP32);
+    int dims[4] = {1, c, h, w};
+
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(tensor, dims, 4);
+
+    buffers.emplace_back(c * h * w);
+
+    for(auto& v : buffers.back())
+        v = rand_float();
+
+    set_tensor_buffer(tensor, buffers.back().data(), c * h * w * sizeof(float));
+
+    release_graph_tensor(tensor);
+    release_graph_node(node);
+}
+
+static void add_const(graph_t graph, node_t node, int idx, const std::string& name, const int* dims, int dim_num)
+{
+    node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+    tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+    int size = 1;
+
+    for(int i = 0; i < dim_num; i++)
+        size *= dims[i];
+
+    buffers.emplace_back(size);
+
+    for(auto& v : buffers.back())
+        v = rand_float();
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims, dim_num);
+    set_tensor_buffer(tensor, buffers.back().data(), size * sizeof(float));
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_tensor(tensor);
+    release_graph_node(c_node);
+}
+
+/* a node with one output tensor of its own name */
+static node_t add_node(graph_t graph, const char* name, const char* op, const std::vector<const char*>& inputs)
+{
+    node_t node = create_graph_node(graph, name, op);
+
+    for(unsigned int i = 0; i < inputs.size(); i++)
+    {
+        tensor_t tensor = get_graph_tensor(graph, inputs[i]);
+
+        set_node_input_tensor(node, i, tensor);
+        release_graph_tensor(tensor);
+    }
+
+    tensor_t tensor = create_graph_tensor(graph, name, TENGINE_DT_FP32);
+
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_VAR);
+    release_graph_tensor(tensor);
+
+    return node;
+}
+
+static void add_conv(graph_t graph, const char* name, const char* input, int input_c, int output_c, int kernel,
+                     int pad0, int pad1)
+{
+    node_t node = add_node(graph, name, "Convolution", {input});
+    int one = 1;
+    int w_dims[4] = {output_c, input_c, kernel, kernel};
+    int b_dims[1] = {output_c};
+
+    set_node_attr_int(node, "kernel_h", &kernel);
+    set_node_attr_int(node, "kernel_w", &kernel);
+    set_node_attr_int(node, "stride_h", &one);
+    set_node_attr_int(node, "stride_w", &one);
+    set_node_attr_int(node, "pad_h0", &pad0);
+    set_node_attr_int(node, "pad_w0", &pad0);
+    set_node_attr_int(node, "pad_h1", &pad1);
+    set_node_attr_int(node, "pad_w1", &pad1);
+    set_node_attr_int(node, "dilation_h", &one);
+    set_node_attr_int(node, "dilation_w", &one);
+    set_node_attr_int(node, "output_channel", &output_c);
+    set_node_attr_int(node, "group", &one);
+
+    add_const(graph, node, 1, std::string(name) + "/weight", w_dims, 4);
+    add_const(graph, node, 2, std::string(name) + "/bias", b_dims, 1);
+
+    release_graph_node(node);
+}
+
+/* pad_2 is H and pad_3 is W, _h is the leading side and _w the trailing side */
+static void add_pad(graph_t graph, const char* name, const char* input, int top, int bottom, int left, int right)
+{
+    node_t node = add_node(graph, name, "Pad", {input});
+    int zero = 0;
+    float value = 0.f;
+
+    set_node_attr_int(node, "mode", &zero);
+    set_node_attr_int(node, "pad_0_h", &zero);
+    set_node_attr_int(node, "pad_0_w", &zero);
+    set_node_attr_int(node, "pad_1_h", &zero);
+    set_node_attr_int(node, "pad_1_w", &zero);
+    set_node_attr_int(node, "pad_2_h", &top);
+    set_node_attr_int(node, "pad_2_w", &bottom);
+    set_node_attr_int(node, "pad_3_h", &left);
+    set_node_attr_int(node, "pad_3_w", &right);
+    set_node_attr_float(node, "value", &value);
+
+    release_graph_node(node);
+}
+
+static void add_reshape(graph_t graph, const char* name, const char* input, const std::vector<int>& shape)
+{
+    node_t node = add_node(graph, name, "Reshape", {input});
+    ReshapeParam* param = dynamic_cast<Reshape*>(reinterpret_cast<Node*>(node)->GetOp())->GetParam();
+
+    param->re_shape = shape;
+    param->dim_size = shape.size();
+
+    release_graph_node(node);
+}
+
+static void add_simple(graph_t graph, const char* name, const char* op, const std::vector<const char*>& inputs)
+{
+    release_graph_node(add_node(graph, name, op, inputs));
+}
+
+static void add_eltwise_sum(graph_t graph, const char* name, const char* input0, const char* input1)
+{
+    node_t node = add_node(graph, name, "Eltwise", {input0, input1});
+    int type = 2;    // ELT_SUM
+
+    set_node_attr_int(node, "type", &type);
+    release_graph_node(node);
+}
+
+/* the Pad leads on one side only, the conv on the other: 1 + 0 and 0 + 1 on each axis */
+static void build_pad_asymmetric(graph_t graph)
+{
+    add_input(graph, "data", 8, 15, 13);
+    add_pad(graph, "pad", "data", 0, 1, 0, 1);
+    add_conv(graph, "conv", "pad", 8, 16, 3, 1, 0);
+}
+
+static void build_pad_pool(graph_t graph)
+{
+    add_input(graph, "data", 8, 15, 13);
+    add_simple(graph, "relu", "ReLu", {"data"});
+    add_pad(graph, "pad", "relu", 1, 1, 1, 1);
+
+    node_t node = add_node(graph, "pool", "Pooling", {"pad"});
+    int kernel = 3, stride = 2, zero = 0;
+
+    set_node_attr_int(node, "kernel_h", &kernel);
+    set_node_attr_int(node, "kernel_w", &kernel);
+    set_node_attr_int(node, "stride_h", &stride);
+    set_node_attr_int(node, "stride_w", &stride);
+    set_node_attr_int(node, "pad_h0", &zero);
+    set_node_attr_int(node, "pad_w0", &zero);
+    set_node_attr_int(node, "pad_h1", &zero);
+    set_node_attr_int(node, "pad_w1", &zero);
+    set_node_attr_int(node, "alg", &zero);
+    release_graph_node(node);
+}
+
+/* the residual relu comes after the conv in the node order, the fused conv must wait for it */
+static void build_residual_later(graph_t graph)
+{
+    add_input(graph, "data", 8, 12, 12);
+    add_conv(graph, "conv", "data", 8, 16, 3, 1, 1);
+    add_conv(graph, "branch", "data", 8, 16, 1, 0, 0);
+    add_simple(graph, "branch_relu", "ReLu", {"branch"});
+    add_eltwise_sum(graph, "sum", "conv", "branch_relu");
+}
+
+/* a residual block: the relu after the sum goes into the epilogue too */
+static void build_residual_relu(graph_t graph)
+{
+    add_input(graph, "data", 16, 12, 12);
+    add_simple(graph, "pre", "ReLu6", {"data"});
+    add_conv(graph, "conv", "pre", 16, 16, 3, 1, 1);
+    add_eltwise_sum(graph, "sum", "pre", "conv");
+    add_simple(graph, "relu", "ReLu", {"sum"});
+}
+
+static void build_prelu(graph_t graph, int slope_size)
+{
+    add_input(graph, "data", 8, 12, 12);
+    add_conv(graph, "conv", "data", 8, 16, 3, 1, 1);
+
+    node_t node = add_node(graph, "prelu", "PReLU", {"conv"});
+    int dims[1] = {slope_size};
+
+    add_const(graph, node, 1, "prelu/slope", dims, 1);
+    release_graph_node(node);
+}
+
+static void build_prelu_one(graph_t graph)
+{
+    build_prelu(graph, 1);
+}
+
+static void build_prelu_channel(graph_t graph)
+{
+    build_prelu(graph, 16);
+}
+
+static void build_reshape_keep_batch(graph_t graph)
+{
+    add_input(graph, "data", 8, 4, 6);
+    add_reshape(graph, "flat", "data", {0, -1});
+    add_reshape(graph, "split", "flat", {0, 8, 24});
+}
+
+/* the batch dim changes along the chain, so that it is not kept as 0 */
+static void build_reshape_new_batch(graph_t graph)
+{
+    add_input(graph, "data", 8, 4, 6);
+    add_reshape(graph, "rows", "data", {8, -1});
+    add_reshape(graph, "cols", "rows", {0, 4, 6});
+}
+
+struct TestCase
+{
+    const char* name;
+    const char* pass;
+    void (*build)(graph_t graph);
+    const char* output;
+};
+
+static graph_t create_test_graph(const TestCase& t)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    seed = 1;
+    t.build(graph);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {t.output};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static graph_t run_case(const TestCase& t, bool disable)
+{
+    graph_t graph = create_test_graph(t);
+
+    if(graph == nullptr)
+        return nullptr;
+
+    if(disable)
+        setenv("GRAPH_OPT_DISABLE", t.pass, 1);
+
+    int ret = prerun_graph(graph);
+
+    unsetenv("GRAPH_OPT_DISABLE");
+
+    if(ret < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << t.name << ": run failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static int op_node_number(graph_t graph)
+{
+    Graph* optimized = reinterpret_cast<GraphExecutor*>(graph)->GetOptimizedGraph();
+    int number = 0;
+
+    for(Node* node : optimized->seq_nodes)
+    {
+        if(node->GetOp()->GetName() != "Const")
+            number++;
+    }
+
+    return number;
+}
+
+static int compare_output(const TestCase& t, graph_t graph, graph_t ref_graph)
+{
+    if(op_node_number(graph) >= op_node_number(ref_graph))
+    {
+        printf("%s: %s fused nothing\n", t.name, t.pass);
+        return -1;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    tensor_t ref_output_tensor = get_graph_output_tensor(ref_graph, 0, 0);
+    int dims[4] = {0};
+    int ref_dims[4] = {0};
+    int dim_num = get_tensor_shape(output_tensor, dims, 4);
+    int ref_dim_num = get_tensor_shape(ref_output_tensor, ref_dims, 4);
+    int ret = 0;
+
+    if(dim_num != ref_dim_num || std::vector<int>(dims, dims + 4) != std::vector<int>(ref_dims, ref_dims + 4))
+    {
+        printf("%s: the output shape differs\n", t.name);
+        ret = -1;
+    }
+
+    const float* output = ( const float* )get_tensor_buffer(output_tensor);
+    const float* ref_output = ( const float* )get_tensor_buffer(ref_output_tensor);
+    int size = get_tensor_buffer_size(ref_output_tensor) / sizeof(float);
+
+    for(int i = 0; i < size && ret == 0; i++)
+    {
+        if(std::fabs(output[i] - ref_output[i]) > 1e-4 + 1e-4 * std::fabs(ref_output[i]))
+        {
+            printf("%s: mismatch [%d] %f vs %f\n", t.name, i, output[i], ref_output[i]);
+            ret = -1;
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    release_graph_tensor(ref_output_tensor);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    TestCase cases[] = {
+        {"pad_asymmetric", "PadFold", build_pad_asymmetric, "conv"},
+        {"pad_pool", "PadFold", build_pad_pool, "pool"},
+        {"residual_later", "ConvEltwise", build_residual_later, "sum"},
+        {"residual_relu", "ConvEltwise", build_residual_relu, "relu"},
+        {"prelu_one", "ConvActivation", build_prelu_one, "prelu"},
+        {"prelu_channel", "ConvActivation", build_prelu_channel, "prelu"},
+        {"reshape_keep_batch", "ReshapeChain", build_reshape_keep_batch, "split"},
+        {"reshape_new_batch", "ReshapeChain", build_reshape_new_batch, "cols"},
+    };
+
+    init_tengine();
+
+    int ret = 0;
+
+    for(unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        /* both graphs stay alive until compared, the buffers until both are gone */
+        graph_t graph = run_case(cases[i], false);
+        graph_t ref_graph = run_case(cases[i], true);
+
+        if(graph == nullptr || ref_graph == nullptr || compare_output(cases[i], graph, ref_graph) < 0)
+            ret = -1;
+
+        for(graph_t g : {graph, ref_graph})
+        {
+            if(g == nullptr)
+                continue;
+
+            postrun_graph(g);
+            destroy_graph(g);
+        }
+
+        buffers.clear();
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
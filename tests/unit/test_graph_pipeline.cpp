@@ -0,0 +1,315 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+#include "tengine_c_api.h"
+
+/*
+ * data -> ReLu out, run through a pipeline of depth 1 and 2. The pre stage fills each frame with values
+ * of its id, the post stage checks the outputs and the frame order. The same pipeline runs a full stream,
+ * an empty one, a failing pre and a failing post stage, then a full stream again.
+ */
+
+static const int c = 2, h = 4, w = 4;
+static const int size = c * h * w;
+
+struct StreamTest
+{
+    int frame_num; /* the pre stage ends the stream at this frame */
+    int fail_pre; /* the frame the pre stage fails on, -1 for none */
+    int fail_post;
+
+    std::vector<int> pre_ids;
+    std::vector<int> post_ids;
+    bool wrong_output;
+};
+
+static float input_value(int id, int k)
+{
+    return (k % 3 - 1) * (id + 1) + 0.25f * k;
+}
+
+static int pre_stage(struct pipeline_frame* frame, void* arg)
+{
+    StreamTest* t = ( StreamTest* )arg;
+
+    t->pre_ids.push_back(frame->id);
+
+    if(frame->id == t->fail_pre)
+        return -1;
+
+    if(frame->id == t->frame_num)
+        return 1;
+
+    float* input = ( float* )frame->input_data[0];
+
+    if(frame->input_num != 1 || frame->input_size[0] != size * ( int )sizeof(float))
+    {
+        t->wrong_output = true;
+        return -1;
+    }
+
+    for(int k = 0; k < size; k++)
+        input[k] = input_value(frame->id, k);
+
+    return 0;
+}
+
+static int post_stage(struct pipeline_frame* frame, void* arg)
+{
+    StreamTest* t = ( StreamTest* )arg;
+    const float* output = ( const float* )frame->output_data[0];
+
+    t->post_ids.push_back(frame->id);
+
+    if(frame->output_num != 1 || frame->output_size[0] != size * ( int )sizeof(float))
+    {
+        t->wrong_output = true;
+        return -1;
+    }
+
+    for(int k = 0; k < size; k++)
+    {
+        float v = input_value(frame->id, k);
+
+        if(output[k] != (v > 0 ? v : 0))
+            t->wrong_output = true;
+    }
+
+    return frame->id == t->fail_post ? -1 : 0;
+}
+
+graph_t create_test_graph(float* input)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, c, h, w};
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, dims, 4);
+    set_tensor_buffer(input_tensor, input, size * sizeof(float));
+
+    node_t relu_node = create_graph_node(graph, "out", "ReLu");
+    tensor_t output_tensor = create_graph_tensor(graph, "out", TENGINE_DT_FP32);
+
+    set_node_input_tensor(relu_node, 0, input_tensor);
+    set_node_output_tensor(relu_node, 0, output_tensor, TENSOR_TYPE_VAR);
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+    release_graph_node(input_node);
+    release_graph_node(relu_node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"out"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+/* the post stage sees frames 0 .. post_num - 1 in order, the pre stage frames 0 .. pre_num - 1 */
+static int run_stream(pipeline_t pipeline, StreamTest& t, int expect_ret, int pre_num, int post_num)
+{
+    t.pre_ids.clear();
+    t.post_ids.clear();
+    t.wrong_output = false;
+
+    int ret = run_graph_pipeline(pipeline);
+    bool in_order = ( int )t.pre_ids.size() == pre_num && ( int )t.post_ids.size() == post_num;
+
+    for(int i = 0; in_order && i < pre_num; i++)
+        in_order = t.pre_ids[i] == i;
+
+    for(int i = 0; in_order && i < post_num; i++)
+        in_order = t.post_ids[i] == i;
+
+    if(ret != expect_ret || !in_order || t.wrong_output)
+    {
+        printf("stream of %d, pre fails at %d, post fails at %d: returned %d, %u pre and %u post calls%s%s\n",
+               t.frame_num, t.fail_pre, t.fail_post, ret, ( unsigned int )t.pre_ids.size(),
+               ( unsigned int )t.post_ids.size(), in_order ? "" : ", out of order",
+               t.wrong_output ? ", wrong output" : "");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_depth(graph_t graph, int depth)
+{
+    StreamTest t;
+    pipeline_t pipeline = create_graph_pipeline(graph, depth, pre_stage, post_stage, &t);
+
+    if(pipeline == nullptr)
+    {
+        std::cerr << "create_graph_pipeline failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    int ret = 0;
+
+    /* 10 frames, the pre stage is called once more to end the stream */
+    t = {10, -1, -1};
+    ret |= run_stream(pipeline, t, 10, 11, 10);
+
+    /* an empty stream */
+    t = {0, -1, -1};
+    ret |= run_stream(pipeline, t, 0, 1, 0);
+
+    /*
+     * the pre stage fails on frame 3: the frames before it may or may not be postprocessed before the
+     * stop, so only the frame order is checked
+     */
+    t = {10, 3, -1};
+    t.pre_ids.clear();
+    t.post_ids.clear();
+    t.wrong_output = false;
+
+    if(run_graph_pipeline(pipeline) != -1 || t.pre_ids.size() != 4 || t.post_ids.size() > 3 || t.wrong_output)
+    {
+        printf("depth %d: the failing pre stage is not stopped\n", depth);
+        ret = -1;
+    }
+
+    for(unsigned int i = 0; i < t.post_ids.size(); i++)
+    {
+        if(t.post_ids[i] != ( int )i)
+            ret = -1;
+    }
+
+    /* the post stage fails on frame 2, the pre stage is at most depth frames ahead of it */
+    t = {10, -1, 2};
+    t.pre_ids.clear();
+    t.post_ids.clear();
+    t.wrong_output = false;
+
+    if(run_graph_pipeline(pipeline) != -1 || t.post_ids.size() != 3 || t.pre_ids.size() > ( unsigned int )(3 + depth) ||
+       t.wrong_output)
+    {
+        printf("depth %d: the failing post stage is not stopped\n", depth);
+        ret = -1;
+    }
+
+    /* a failed run leaves the pipeline usable */
+    t = {7, -1, -1};
+    ret |= run_stream(pipeline, t, 7, 8, 7);
+
+    destroy_graph_pipeline(pipeline);
+
+    if(ret != 0)
+        printf("depth %d failed\n", depth);
+
+    return ret;
+}
+
+/* destroy points the input back to the buffer of the user, so that the graph runs directly again */
+static int test_direct_run(graph_t graph, const float* input)
+{
+    tensor_t input_tensor = get_graph_input_tensor(graph, 0, 0);
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    int ret = 0;
+
+    if(get_tensor_buffer(input_tensor) != input)
+    {
+        printf("the input buffer is not given back\n");
+        ret = -1;
+    }
+    else if(run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        ret = -1;
+    }
+    else
+    {
+        const float* output = ( const float* )get_tensor_buffer(output_tensor);
+
+        for(int k = 0; k < size; k++)
+        {
+            if(output[k] != (input[k] > 0 ? input[k] : 0))
+            {
+                printf("direct run: [%d] %f vs %f\n", k, output[k], input[k]);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<float> input(size);
+
+    for(int k = 0; k < size; k++)
+        input[k] = input_value(100, k);
+
+    init_tengine();
+
+    graph_t graph = create_test_graph(input.data());
+
+    if(graph == nullptr)
+        return -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    int ret = 0;
+
+    for(int depth = 1; depth <= 2; depth++)
+    {
+        if(test_depth(graph, depth) < 0 || test_direct_run(graph, input.data()) < 0)
+            ret = -1;
+    }
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
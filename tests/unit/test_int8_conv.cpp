@@ -0,0 +1,364 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+
+/*
+ * the x86 int8 Convolution and FullyConnected ops against a scalar int8 convolution written here, bit for bit.
+ * The reference int8 kernels need CONFIG_KERNEL_INT8, so they are not used. The convolutions take the im2col
+ * path, and the 1x1 s1 ones the direct one, with odd channel and spatial sizes, groups, a batch of two and
+ * per channel kernel scales.
+ */
+
+static unsigned int seed = 5;
+
+static int rand_int(int lo, int hi)
+{
+    seed = seed * 1103515245 + 12345;
+
+    return lo + ( int )((seed >> 8) % (hi - lo + 1));
+}
+
+static std::vector<int8_t> rand_int8(int size)
+{
+    std::vector<int8_t> data(size);
+
+    for(auto& v : data)
+        v = rand_int(-127, 127);
+
+    return data;
+}
+
+static int8_t ref_requant(int32_t acc, int32_t bias, float scale, float out_scale, int activation)
+{
+    float f = ( float )(acc + bias) * scale;
+
+    if(activation == 1)
+        f = std::min(1.f, std::max(-1.f, f));
+    else if(activation >= 0)
+    {
+        f = std::max(0.f, f);
+
+        if(activation == 6)
+            f = std::min(6.f, f);
+    }
+
+    int q = ( int )std::round(f / out_scale);
+
+    return std::min(127, std::max(-127, q));
+}
+
+struct ConvTest
+{
+    int batch, inc, inh, inw, outc;
+    int kernel, stride, pad, dilation, group;
+    int activation;
+    bool per_channel;
+};
+
+struct Int8Data
+{
+    std::vector<int8_t> input;
+    std::vector<int8_t> weight;
+    std::vector<int32_t> bias;
+    float in_scale;
+    std::vector<float> w_scale;
+    float out_scale;
+};
+
+static tensor_t add_tensor(graph_t graph, node_t node, int idx, const char* name, int data_type,
+                           const std::vector<int>& dims, void* data, int size, const float* scale, int scale_num)
+{
+    node_t c_node = create_graph_node(graph, name, "Const");
+    tensor_t tensor = create_graph_tensor(graph, name, data_type);
+    std::vector<int> zero(scale_num, 0);
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims.data(), dims.size());
+    set_tensor_buffer(tensor, data, size);
+    set_tensor_quant_param(tensor, scale, zero.data(), scale_num);
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_node(c_node);
+
+    return tensor;
+}
+
+/* data -> op out, the op gets its attributes from set_attr */
+static graph_t create_test_graph(const char* op, const std::vector<int>& in_dims, Int8Data& d,
+                                 const std::vector<int>& w_dims, void (*set_attr)(node_t, const void*),
+                                 const void* arg)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    int zero = 0;
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_INT8);
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, in_dims.data(), in_dims.size());
+    set_tensor_buffer(input_tensor, d.input.data(), d.input.size());
+    set_tensor_quant_param(input_tensor, &d.in_scale, &zero, 1);
+
+    node_t node = create_graph_node(graph, "out", op);
+    tensor_t output_tensor = create_graph_tensor(graph, "out", TENGINE_DT_INT8);
+
+    set_node_input_tensor(node, 0, input_tensor);
+    set_node_output_tensor(node, 0, output_tensor, TENSOR_TYPE_VAR);
+    set_tensor_quant_param(output_tensor, &d.out_scale, &zero, 1);
+    set_attr(node, arg);
+
+    int bias_dims = d.bias.size();
+
+    release_graph_tensor(add_tensor(graph, node, 1, "out/weight", TENGINE_DT_INT8, w_dims, d.weight.data(),
+                                    d.weight.size(), d.w_scale.data(), d.w_scale.size()));
+    release_graph_tensor(add_tensor(graph, node, 2, "out/bias", TENGINE_DT_INT32, {bias_dims}, d.bias.data(),
+                                    d.bias.size() * sizeof(int32_t), &d.in_scale, 1));
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+    release_graph_node(input_node);
+    release_graph_node(node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"out"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static int run_and_compare(graph_t graph, const std::vector<int8_t>& ref, const char* desc)
+{
+    if(graph == nullptr || prerun_graph(graph) < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << desc << ": ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    const int8_t* output = ( const int8_t* )get_tensor_buffer(output_tensor);
+    int ret = 0;
+
+    if(get_tensor_buffer_size(output_tensor) != ( int )ref.size())
+    {
+        printf("%s: output size %d vs %d\n", desc, get_tensor_buffer_size(output_tensor), ( int )ref.size());
+        ret = -1;
+    }
+
+    for(unsigned int i = 0; ret == 0 && i < ref.size(); i++)
+    {
+        if(output[i] != ref[i])
+        {
+            printf("%s: [%u] %d vs %d\n", desc, i, output[i], ref[i]);
+            ret = -1;
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    postrun_graph(graph);
+    destroy_graph(graph);
+
+    return ret;
+}
+
+static void set_conv_attr(node_t node, const void* arg)
+{
+    const ConvTest* t = ( const ConvTest* )arg;
+
+    set_node_attr_int(node, "kernel_h", &t->kernel);
+    set_node_attr_int(node, "kernel_w", &t->kernel);
+    set_node_attr_int(node, "stride_h", &t->stride);
+    set_node_attr_int(node, "stride_w", &t->stride);
+    set_node_attr_int(node, "pad_h0", &t->pad);
+    set_node_attr_int(node, "pad_w0", &t->pad);
+    set_node_attr_int(node, "pad_h1", &t->pad);
+    set_node_attr_int(node, "pad_w1", &t->pad);
+    set_node_attr_int(node, "dilation_h", &t->dilation);
+    set_node_attr_int(node, "dilation_w", &t->dilation);
+    set_node_attr_int(node, "output_channel", &t->outc);
+    set_node_attr_int(node, "group", &t->group);
+    set_node_attr_int(node, "activation", &t->activation);
+}
+
+static int test_conv(const ConvTest& t, const char* desc)
+{
+    int inc_g = t.inc / t.group;
+    int outc_g = t.outc / t.group;
+    int ksize = (t.kernel - 1) * t.dilation + 1;
+    int outh = (t.inh + 2 * t.pad - ksize) / t.stride + 1;
+    int outw = (t.inw + 2 * t.pad - ksize) / t.stride + 1;
+    Int8Data d;
+
+    d.input = rand_int8(t.batch * t.inc * t.inh * t.inw);
+    d.weight = rand_int8(t.outc * inc_g * t.kernel * t.kernel);
+    d.in_scale = 0.03f;
+    d.out_scale = 0.02f * std::sqrt(( float )(inc_g * t.kernel * t.kernel));
+    d.w_scale.resize(t.per_channel ? t.outc : 1);
+
+    for(auto& s : d.w_scale)
+        s = 0.0005f * rand_int(1, 40);
+
+    for(int i = 0; i < t.outc; i++)
+        d.bias.push_back(rand_int(-20000, 20000));
+
+    std::vector<int8_t> ref(t.batch * t.outc * outh * outw);
+
+    for(int b = 0; b < t.batch; b++)
+    {
+        for(int oc = 0; oc < t.outc; oc++)
+        {
+            int g = oc / outc_g;
+            float scale = d.in_scale * d.w_scale[t.per_channel ? oc : 0];
+
+            for(int oh = 0; oh < outh; oh++)
+            {
+                for(int ow = 0; ow < outw; ow++)
+                {
+                    int32_t acc = 0;
+
+                    for(int ic = 0; ic < inc_g; ic++)
+                    {
+                        for(int ky = 0; ky < t.kernel; ky++)
+                        {
+                            for(int kx = 0; kx < t.kernel; kx++)
+                            {
+                                int iy = oh * t.stride - t.pad + ky * t.dilation;
+                                int ix = ow * t.stride - t.pad + kx * t.dilation;
+
+                                if(iy < 0 || iy >= t.inh || ix < 0 || ix >= t.inw)
+                                    continue;
+
+                                int c = g * inc_g + ic;
+
+                                acc += d.input[((b * t.inc + c) * t.inh + iy) * t.inw + ix] *
+                                       d.weight[((oc * inc_g + ic) * t.kernel + ky) * t.kernel + kx];
+                            }
+                        }
+                    }
+
+                    ref[((b * t.outc + oc) * outh + oh) * outw + ow] =
+                        ref_requant(acc, d.bias[oc], scale, d.out_scale, t.activation);
+                }
+            }
+        }
+    }
+
+    graph_t graph = create_test_graph("Convolution", {t.batch, t.inc, t.inh, t.inw}, d,
+                                      {t.outc, inc_g, t.kernel, t.kernel}, set_conv_attr, &t);
+
+    return run_and_compare(graph, ref, desc);
+}
+
+static void set_fc_attr(node_t node, const void* arg)
+{
+    set_node_attr_int(node, "num_output", ( const int* )arg);
+}
+
+/* the weight is [out][hidden], the op infers no other layout. The input is [batch, hidden] or [batch, c, h, w] */
+static int test_fc(const std::vector<int>& in_dims, int out, bool per_channel, const char* desc)
+{
+    int batch = in_dims[0];
+    int hidden = 1;
+    Int8Data d;
+
+    for(unsigned int i = 1; i < in_dims.size(); i++)
+        hidden *= in_dims[i];
+
+    d.input = rand_int8(batch * hidden);
+    d.weight = rand_int8(out * hidden);
+    d.in_scale = 0.03f;
+    d.out_scale = 0.02f * std::sqrt(( float )hidden);
+    d.w_scale.resize(per_channel ? out : 1);
+
+    for(auto& s : d.w_scale)
+        s = 0.0005f * rand_int(1, 40);
+
+    for(int i = 0; i < out; i++)
+        d.bias.push_back(rand_int(-20000, 20000));
+
+    std::vector<int8_t> ref(batch * out);
+
+    for(int b = 0; b < batch; b++)
+    {
+        for(int o = 0; o < out; o++)
+        {
+            int32_t acc = 0;
+
+            for(int k = 0; k < hidden; k++)
+                acc += d.input[b * hidden + k] * d.weight[o * hidden + k];
+
+            ref[b * out + o] =
+                ref_requant(acc, d.bias[o], d.in_scale * d.w_scale[per_channel ? o : 0], d.out_scale, -1);
+        }
+    }
+
+    graph_t graph = create_test_graph("FullyConnected", in_dims, d, {out, hidden}, set_fc_attr, &out);
+
+    return run_and_compare(graph, ref, desc);
+}
+
+int main(int argc, char* argv[])
+{
+    init_tengine();
+
+    int ret = 0;
+
+    /* batch inc h w outc, kernel stride pad dilation group, activation per_channel */
+    ret |= test_conv({2, 5, 9, 11, 7, 3, 1, 1, 1, 1, 0, true}, "3x3 s1 p1 relu");
+    ret |= test_conv({1, 8, 13, 10, 6, 3, 2, 2, 2, 2, -1, false}, "3x3 s2 d2 group 2");
+    ret |= test_conv({2, 3, 17, 5, 13, 5, 1, 2, 1, 1, 6, true}, "5x5 relu6");
+    ret |= test_conv({1, 6, 7, 7, 9, 3, 1, 1, 1, 3, 1, true}, "3x3 group 3 clip");
+    ret |= test_conv({2, 11, 7, 5, 9, 1, 1, 0, 1, 1, -1, true}, "1x1 direct");
+    ret |= test_conv({1, 16, 4, 8, 32, 1, 1, 0, 1, 1, 0, true}, "1x1 direct full blocks");
+    ret |= test_conv({1, 10, 9, 9, 6, 1, 1, 0, 1, 2, -1, true}, "1x1 direct group 2");
+    ret |= test_conv({1, 7, 9, 9, 5, 1, 2, 0, 1, 1, -1, true}, "1x1 s2 im2col");
+
+    ret |= test_fc({1, 37}, 13, true, "fc");
+    ret |= test_fc({5, 64}, 24, true, "fc full blocks");
+    ret |= test_fc({3, 29}, 11, false, "fc per tensor");
+    ret |= test_fc({2, 3, 3, 3}, 17, true, "fc 4d input");
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
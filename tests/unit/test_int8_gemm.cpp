@@ -0,0 +1,170 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "gemm_int8_x86.h"
+
+using namespace TEngine;
+
+/*
+ * the int8 gemm of executor/operator/x86 against a scalar int8 gemm, bit for bit. The micro kernel and the
+ * requantization are picked at compile time, so this test is built once per instruction set, see
+ * CMakeLists.txt: the scalar kernel, the SSE2 4x4 one with the scalar requantization, the SSE2 4x4 one with
+ * the SSE4.1 requantization and the AVX2 4x8 one.
+ */
+
+static unsigned int seed = 11;
+
+static int rand_int(int lo, int hi)
+{
+    seed = seed * 1103515245 + 12345;
+
+    return lo + ( int )((seed >> 8) % (hi - lo + 1));
+}
+
+/* the requantization of the reference int8 kernels, written out again */
+static int8_t ref_requant(int32_t acc, int32_t bias, float scale, float out_scale, int activation)
+{
+    float f = ( float )(acc + bias) * scale;
+
+    if(activation == 1)
+        f = std::min(1.f, std::max(-1.f, f));
+    else if(activation >= 0)
+    {
+        f = std::max(0.f, f);
+
+        if(activation == 6)
+            f = std::min(6.f, f);
+    }
+
+    int q = ( int )std::round(f / out_scale);
+
+    return std::min(127, std::max(-127, q));
+}
+
+/*
+ * C[m][n] = A[m][k] * B(k, n), B(k, n) = b[k * ldk + n * ldn]. The scale and bias follow n for the fully
+ * connected layout (per_col) and m for the convolution one.
+ */
+static int test_gemm(int m, int n, int k, bool per_col, bool b_trans, bool has_bias, int activation)
+{
+    std::vector<int8_t> a(m * k), b(k * n), c(m * n), ref_c(m * n);
+    int scale_num = per_col ? n : m;
+    std::vector<float> scale(scale_num);
+    std::vector<int32_t> bias(scale_num);
+
+    for(auto& v : a)
+        v = rand_int(-127, 127);
+    for(auto& v : b)
+        v = rand_int(-127, 127);
+
+    /* per channel scales, the output scale keeps most of the outputs inside [-127, 127] */
+    for(int i = 0; i < scale_num; i++)
+    {
+        scale[i] = 0.00001f * rand_int(1, 40);
+        bias[i] = rand_int(-20000, 20000);
+    }
+
+    int ldk = b_trans ? 1 : n;
+    int ldn = b_trans ? k : 1;
+    float out_scale = 0.02f * std::sqrt(( float )k);
+
+    for(int i = 0; i < m; i++)
+    {
+        for(int j = 0; j < n; j++)
+        {
+            int32_t acc = 0;
+            int idx = per_col ? j : i;
+
+            for(int p = 0; p < k; p++)
+                acc += a[i * k + p] * b[p * ldk + j * ldn];
+
+            ref_c[i * n + j] = ref_requant(acc, has_bias ? bias[idx] : 0, scale[idx], out_scale, activation);
+        }
+    }
+
+    std::vector<int32_t> pa(i8gemm_a_pack_size(m, k));
+    std::vector<int32_t> pb(i8gemm_b_pack_size(n, k));
+    i8_requant rq;
+
+    rq.bias = has_bias ? bias.data() : nullptr;
+    rq.scale = scale.data();
+    rq.per_col = per_col;
+    rq.out_scale = out_scale;
+    rq.activation = activation;
+
+    i8gemm_pack_a(m, k, a.data(), k, pa.data());
+
+    /* two column ranges, as the ops split the blocks between threads */
+    int n_half = (n / 2 + I8_NB - 1) / I8_NB * I8_NB;
+
+    if(n_half > n)
+        n_half = n;
+
+    i8gemm_pack_b(n, k, b.data(), ldk, ldn, pb.data(), 0, n_half);
+    i8gemm_pack_b(n, k, b.data(), ldk, ldn, pb.data(), n_half, n);
+    i8gemm_compute(m, n, k, pa.data(), pb.data(), c.data(), n, &rq, n_half, n);
+    i8gemm_compute(m, n, k, pa.data(), pb.data(), c.data(), n, &rq, 0, n_half);
+
+    for(int i = 0; i < m * n; i++)
+    {
+        if(c[i] != ref_c[i])
+        {
+            printf("m %d n %d k %d per_col %d trans %d bias %d act %d: [%d][%d] %d vs %d\n", m, n, k, per_col, b_trans,
+                   has_bias, activation, i / n, i % n, c[i], ref_c[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    /* full blocks, then odd tails of m, n and k */
+    int sizes[][3] = {{4, 8, 16}, {8, 16, 32}, {1, 1, 1}, {3, 5, 7}, {5, 9, 3}, {7, 13, 27}, {9, 31, 64}, {17, 6, 75}};
+    int activations[] = {-1, 0, 1, 6};
+    int ret = 0;
+
+    for(auto& s : sizes)
+    {
+        for(int act : activations)
+        {
+            /* the convolution: scales per row, B is the im2col output or the input of a 1x1 conv as is */
+            ret |= test_gemm(s[0], s[1], s[2], false, false, true, act);
+            ret |= test_gemm(s[0], s[1], s[2], false, false, false, act);
+
+            /* the fully connected: scales per column, the weight is [out][hidden] or [hidden][out] */
+            ret |= test_gemm(s[0], s[1], s[2], true, true, true, act);
+            ret |= test_gemm(s[0], s[1], s[2], true, false, true, act);
+        }
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    return ret;
+}
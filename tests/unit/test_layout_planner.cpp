@@ -0,0 +1,324 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+#include "graph_executor.hpp"
+#include "tensor_mem.hpp"
+
+using namespace TEngine;
+
+/*
+ * An NHWC graph conv -> grouped conv -> grouped conv -> conv. The grouped convs only have NCHW x86
+ * kernels, so the planner moves both into one NCHW region: one Transpose in and one out, and their
+ * weights relaid out from [out][kh][kw][in] to [out][in][kh][kw]. The output must match the graph
+ * with the planner disabled.
+ */
+
+struct ConvDesc
+{
+    const char* name;
+    const char* input;
+    int input_c, output_c, kernel, group;
+};
+
+static const ConvDesc convs[] = {
+    {"c1", "data", 8, 16, 3, 1},
+    {"g1", "c1", 16, 16, 3, 4},
+    {"g2", "g1", 16, 16, 1, 2},
+    {"c2", "g2", 16, 16, 1, 1},
+};
+
+static const int conv_num = sizeof(convs) / sizeof(convs[0]);
+static const int h = 20, w = 20;
+
+static float rand_float(void)
+{
+    return ( float )rand() / RAND_MAX - 0.5f;
+}
+
+static void add_const_input(graph_t graph, node_t node, int idx, const std::string& name, const int* dims, int dim_num,
+                            std::vector<float>& buffer)
+{
+    node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+    tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims, dim_num);
+    set_tensor_buffer(tensor, buffer.data(), buffer.size() * sizeof(float));
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_tensor(tensor);
+    release_graph_node(c_node);
+}
+
+graph_t create_test_graph(std::vector<std::vector<float>>& weights, std::vector<std::vector<float>>& biases,
+                          std::vector<float>& input)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr || set_graph_layout(graph, TENGINE_LAYOUT_NHWC) < 0)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, h, w, convs[0].input_c};
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, dims, 4);
+    set_tensor_buffer(input_tensor, input.data(), input.size() * sizeof(float));
+
+    release_graph_tensor(input_tensor);
+    release_graph_node(input_node);
+
+    for(int i = 0; i < conv_num; i++)
+    {
+        const ConvDesc& desc = convs[i];
+        node_t node = create_graph_node(graph, desc.name, "Convolution");
+        tensor_t tensor = get_graph_tensor(graph, desc.input);
+        int pad = desc.kernel / 2;
+        int one = 1;
+
+        set_node_input_tensor(node, 0, tensor);
+        release_graph_tensor(tensor);
+
+        set_node_attr_int(node, "kernel_h", &desc.kernel);
+        set_node_attr_int(node, "kernel_w", &desc.kernel);
+        set_node_attr_int(node, "stride_h", &one);
+        set_node_attr_int(node, "stride_w", &one);
+        set_node_attr_int(node, "pad_h0", &pad);
+        set_node_attr_int(node, "pad_w0", &pad);
+        set_node_attr_int(node, "pad_h1", &pad);
+        set_node_attr_int(node, "pad_w1", &pad);
+        set_node_attr_int(node, "dilation_h", &one);
+        set_node_attr_int(node, "dilation_w", &one);
+        set_node_attr_int(node, "output_channel", &desc.output_c);
+        set_node_attr_int(node, "group", &desc.group);
+
+        int w_dims[4] = {desc.output_c, desc.kernel, desc.kernel, desc.input_c / desc.group};
+        int b_dims[1] = {desc.output_c};
+
+        add_const_input(graph, node, 1, std::string(desc.name) + "/weight", w_dims, 4, weights[i]);
+        add_const_input(graph, node, 2, std::string(desc.name) + "/bias", b_dims, 1, biases[i]);
+
+        tensor = create_graph_tensor(graph, desc.name, TENGINE_DT_FP32);
+        set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_VAR);
+
+        release_graph_tensor(tensor);
+        release_graph_node(node);
+    }
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {convs[conv_num - 1].name};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+/* the NHWC weight of a group conv is [out / group][kh][kw][group][in / group], as the reference kernel reads it */
+static int check_weight(Graph* graph, const ConvDesc& desc, const std::vector<float>& nhwc_weight)
+{
+    Node* node = graph->FindNode(desc.name);
+
+    if(node == nullptr)
+    {
+        printf("node %s not found\n", desc.name);
+        return -1;
+    }
+
+    Tensor* tensor = node->GetInputTensor(1);
+    const std::vector<int>& dims = tensor->GetShape().GetDim();
+    int kernel_size = desc.kernel * desc.kernel;
+    int output_c = desc.output_c / desc.group;
+    int input_c = desc.input_c / desc.group;
+
+    if(dims.size() != 4 || dims[0] != desc.output_c || dims[1] != input_c || dims[2] != desc.kernel ||
+       dims[3] != desc.kernel)
+    {
+        printf("%s: the weight is not in [out][in][kh][kw]\n", desc.name);
+        return -1;
+    }
+
+    const float* data = ( const float* )get_tensor_mem(tensor);
+
+    for(int g = 0; g < desc.group; g++)
+        for(int c = 0; c < output_c; c++)
+            for(int ic = 0; ic < input_c; ic++)
+                for(int k = 0; k < kernel_size; k++)
+                {
+                    float expect = nhwc_weight[((c * kernel_size + k) * desc.group + g) * input_c + ic];
+                    float value = data[((g * output_c + c) * input_c + ic) * kernel_size + k];
+
+                    if(value != expect)
+                    {
+                        printf("%s: weight [%d][%d][%d] %f vs %f\n", desc.name, g * output_c + c, ic, k, value,
+                               expect);
+                        return -1;
+                    }
+                }
+
+    return 0;
+}
+
+static int check_plan(graph_t graph, const std::vector<std::vector<float>>& weights)
+{
+    Graph* optimized = reinterpret_cast<GraphExecutor*>(graph)->GetOptimizedGraph();
+    std::vector<std::string> transposes;
+
+    for(Node* node : optimized->seq_nodes)
+    {
+        if(node->GetOp()->GetName() == "Transpose")
+            transposes.push_back(node->GetName());
+    }
+
+    if(transposes.size() != 2 || transposes[0] != "c1.nchw" || transposes[1] != "g2.nhwc")
+    {
+        printf("the transposes are not c1.nchw and g2.nhwc:");
+
+        for(auto& name : transposes)
+            printf(" %s", name.c_str());
+
+        printf("\n");
+        return -1;
+    }
+
+    Node* g1 = optimized->FindNode("g1");
+    Node* c2 = optimized->FindNode("c2");
+
+    if(g1->GetInputTensor(0)->GetName() != "c1.nchw" || c2->GetInputTensor(0)->GetName() != "g2.nhwc")
+    {
+        printf("the region is not read through the transposes\n");
+        return -1;
+    }
+
+    if(check_weight(optimized, convs[1], weights[1]) < 0 || check_weight(optimized, convs[2], weights[2]) < 0)
+        return -1;
+
+    /* the convs which stay in NHWC keep their weights */
+    Tensor* c1_weight = optimized->FindNode("c1")->GetInputTensor(1);
+
+    if(c1_weight->GetShape().GetDim()[3] != convs[0].input_c)
+    {
+        printf("c1: the weight was relaid out\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::vector<float>> weights(conv_num);
+    std::vector<std::vector<float>> biases(conv_num);
+    std::vector<float> input(h * w * convs[0].input_c);
+
+    for(int i = 0; i < conv_num; i++)
+    {
+        weights[i].resize(convs[i].output_c * convs[i].kernel * convs[i].kernel * convs[i].input_c / convs[i].group);
+        biases[i].resize(convs[i].output_c);
+
+        for(auto& v : weights[i])
+            v = rand_float();
+        for(auto& v : biases[i])
+            v = rand_float();
+    }
+
+    for(auto& v : input)
+        v = rand_float();
+
+    init_tengine();
+
+    /* the planner writes the relaid out weights to new memory, both graphs share the buffers */
+    graph_t graph = create_test_graph(weights, biases, input);
+    graph_t ref_graph = create_test_graph(weights, biases, input);
+
+    if(graph == nullptr || ref_graph == nullptr)
+        return -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    setenv("GRAPH_OPT_DISABLE", "LayoutPlan", 1);
+
+    if(prerun_graph(ref_graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    unsetenv("GRAPH_OPT_DISABLE");
+
+    int ret = check_plan(graph, weights);
+
+    if(run_graph(graph, 1) < 0 || run_graph(ref_graph, 1) < 0)
+    {
+        std::cerr << "run_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    tensor_t ref_output_tensor = get_graph_output_tensor(ref_graph, 0, 0);
+    const float* output = ( const float* )get_tensor_buffer(output_tensor);
+    const float* ref_output = ( const float* )get_tensor_buffer(ref_output_tensor);
+    int size = get_tensor_buffer_size(output_tensor) / sizeof(float);
+
+    for(int i = 0; i < size && ret == 0; i++)
+    {
+        if(std::fabs(output[i] - ref_output[i]) > 1e-4 + 1e-4 * std::fabs(ref_output[i]))
+        {
+            printf("mismatch: [%d] %f vs %f\n", i, output[i], ref_output[i]);
+            ret = -1;
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    release_graph_tensor(ref_output_tensor);
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+    postrun_graph(ref_graph);
+    destroy_graph(ref_graph);
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
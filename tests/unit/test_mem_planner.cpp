@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cpu_mem_planner.hpp"
+
+using namespace TEngine;
+
+struct BufferDesc
+{
+    int size;
+    int first_use;
+    int last_use;
+};
+
+/* every offset aligned, and two buffers alive at the same node never overlap in the arena */
+static int check_plan(const MemPlanner& planner, const std::vector<BufferDesc>& descs, int align)
+{
+    int arena_size = planner.GetArenaSize();
+
+    for(unsigned int i = 0; i < descs.size(); i++)
+    {
+        int offset = planner.GetOffset(i);
+        int size = (descs[i].size + align - 1) / align * align;
+
+        if(offset < 0 || offset % align || offset + size > arena_size)
+        {
+            printf("buffer %u: offset %d size %d out of the arena %d or not aligned\n", i, offset, size, arena_size);
+            return -1;
+        }
+
+        for(unsigned int j = 0; j < i; j++)
+        {
+            if(descs[i].last_use < descs[j].first_use || descs[j].last_use < descs[i].first_use)
+                continue;
+
+            int other = planner.GetOffset(j);
+            int other_size = (descs[j].size + align - 1) / align * align;
+
+            if(offset < other + other_size && other < offset + size)
+            {
+                printf("buffer %u [%d, %d) and %u [%d, %d) are alive together and overlap\n", i, offset,
+                       offset + size, j, other, other + other_size);
+                return -1;
+            }
+        }
+    }
+
+    if(arena_size > planner.GetNaiveSize())
+    {
+        printf("arena %d is bigger than the naive sum %d\n", arena_size, planner.GetNaiveSize());
+        return -1;
+    }
+
+    return 0;
+}
+
+static int plan(MemPlanner& planner, const std::vector<BufferDesc>& descs, int align)
+{
+    for(unsigned int i = 0; i < descs.size(); i++)
+        planner.AddBuffer(descs[i].size, descs[i].first_use, descs[i].last_use);
+
+    planner.Plan();
+
+    return check_plan(planner, descs, align);
+}
+
+/* disjoint lifetimes reuse the same memory */
+static int test_disjoint(void)
+{
+    MemPlanner planner(64);
+    std::vector<BufferDesc> descs = {{1000, 0, 1}, {1000, 2, 3}, {500, 4, 5}};
+
+    if(plan(planner, descs, 64) < 0)
+        return -1;
+
+    if(planner.GetOffset(0) != 0 || planner.GetOffset(1) != 0 || planner.GetOffset(2) != 0 ||
+       planner.GetArenaSize() != 1024)
+    {
+        printf("disjoint: offsets %d %d %d arena %d\n", planner.GetOffset(0), planner.GetOffset(1),
+               planner.GetOffset(2), planner.GetArenaSize());
+        return -1;
+    }
+
+    return 0;
+}
+
+/* a chain of layers: a buffer lives from its producer to its consumer, two neighbours at most */
+static int test_chain(void)
+{
+    MemPlanner planner(16);
+    std::vector<BufferDesc> descs;
+    int sizes[] = {4000, 1000, 3000, 200, 5000, 100, 2500};
+    int number = sizeof(sizes) / sizeof(sizes[0]);
+    int peak = 0;
+
+    for(int i = 0; i < number; i++)
+    {
+        descs.push_back({sizes[i], i, i + 1});
+
+        int pair = (sizes[i] + 15) / 16 * 16 + (i > 0 ? (sizes[i - 1] + 15) / 16 * 16 : 0);
+
+        if(pair > peak)
+            peak = pair;
+    }
+
+    if(plan(planner, descs, 16) < 0)
+        return -1;
+
+    if(planner.GetArenaSize() > peak)
+    {
+        printf("chain: arena %d is bigger than the peak %d\n", planner.GetArenaSize(), peak);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* a buffer which gets one more in-place tensor lives longer, and stops sharing with a later one */
+static int test_extend(void)
+{
+    MemPlanner planner(32);
+    std::vector<BufferDesc> descs = {{100, 0, 1}, {100, 2, 3}};
+
+    planner.AddBuffer(descs[0].size, descs[0].first_use, descs[0].last_use);
+    planner.AddBuffer(descs[1].size, descs[1].first_use, descs[1].last_use);
+    planner.ExtendBuffer(0, 200, 2);
+
+    descs[0] = {200, 0, 2};
+
+    planner.Plan();
+
+    if(check_plan(planner, descs, 32) < 0)
+        return -1;
+
+    if(planner.GetArenaSize() != 224 + 128)
+    {
+        printf("extend: arena %d\n", planner.GetArenaSize());
+        return -1;
+    }
+
+    return 0;
+}
+
+/* odd sizes rounded up to the alignment */
+static int test_align(void)
+{
+    MemPlanner planner(128);
+    std::vector<BufferDesc> descs = {{1, 0, 3}, {129, 0, 3}, {127, 1, 2}, {256, 2, 3}};
+
+    if(plan(planner, descs, 128) < 0)
+        return -1;
+
+    if(planner.GetNaiveSize() != 128 + 256 + 128 + 256)
+    {
+        printf("align: naive size %d\n", planner.GetNaiveSize());
+        return -1;
+    }
+
+    return 0;
+}
+
+/* random lifetimes, checked pairwise */
+static int test_random(void)
+{
+    srand(7);
+
+    for(int round = 0; round < 20; round++)
+    {
+        MemPlanner planner(64);
+        std::vector<BufferDesc> descs;
+        int node_number = 50;
+
+        for(int i = 0; i < 100; i++)
+        {
+            int first_use = rand() % node_number;
+            int last_use = first_use + rand() % 8;
+
+            descs.push_back({1 + rand() % 100000, first_use, last_use});
+        }
+
+        if(plan(planner, descs, 64) < 0)
+        {
+            printf("random: round %d\n", round);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+
+    if(test_disjoint() < 0 || test_chain() < 0 || test_extend() < 0 || test_align() < 0 || test_random() < 0)
+        ret = -1;
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    return ret;
+}
@@ -0,0 +1,340 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+
+/*
+ * the NHWC convolution, depthwise convolution, pooling and eltwise kernels against the reference registry.
+ * The reference eltwise takes dim 1 as the channel in NHWC too, so the per channel broadcast is checked
+ * against the plain loop instead
+ */
+
+struct TestCase
+{
+    const char* op;
+    int c, h, w;
+    /* convolution and pooling */
+    int out_c, kernel, stride, pad0, pad1, group;
+    /* pooling: 0 max, 1 avg; eltwise: the type */
+    int alg;
+    /* eltwise: the second operand is one value per channel */
+    bool channel_const;
+};
+
+static unsigned int seed = 1;
+
+static float rand_float(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (( int )((seed >> 16) & 0x7fff) - 16384) / 16384.f;
+}
+
+int float_mismatch(const float* a, const float* b, int size)
+{
+    for(int i = 0; i < size; i++)
+    {
+        float off = a[i] - b[i];
+
+        if(std::fabs(off) > 1e-4 + 1e-4 * std::fabs(b[i]))
+        {
+            printf("mismatch:\n\t[%d]\t---a:    %f ,%f   :b---        off: %f\n", i, a[i], b[i], off);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void add_const_input(graph_t graph, node_t node, int idx, const std::string& name, const int* dims, int dim_num,
+                            std::vector<std::vector<float>>& buffers)
+{
+    node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+    tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims, dim_num);
+
+    int size = 1;
+
+    for(int i = 0; i < dim_num; i++)
+        size *= dims[i];
+
+    buffers.emplace_back(size);
+
+    for(auto& v : buffers.back())
+        v = rand_float();
+
+    set_tensor_buffer(tensor, buffers.back().data(), size * sizeof(float));
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_tensor(tensor);
+    release_graph_node(c_node);
+}
+
+static void set_window_attr(node_t node, const TestCase& t)
+{
+    set_node_attr_int(node, "kernel_h", &t.kernel);
+    set_node_attr_int(node, "kernel_w", &t.kernel);
+    set_node_attr_int(node, "stride_h", &t.stride);
+    set_node_attr_int(node, "stride_w", &t.stride);
+    set_node_attr_int(node, "pad_h0", &t.pad0);
+    set_node_attr_int(node, "pad_w0", &t.pad0);
+    set_node_attr_int(node, "pad_h1", &t.pad1);
+    set_node_attr_int(node, "pad_w1", &t.pad1);
+}
+
+/* the same seed gives both graphs of a case the same weights and input */
+graph_t create_test_graph(const TestCase& t, std::vector<std::vector<float>>& buffers)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr || set_graph_layout(graph, TENGINE_LAYOUT_NHWC) < 0)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, t.h, t.w, t.c};
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, dims, 4);
+
+    node_t test_node = create_graph_node(graph, "test", t.op);
+    set_node_input_tensor(test_node, 0, input_tensor);
+
+    std::string op = t.op;
+
+    if(op == "Convolution")
+    {
+        int dilation = 1;
+        int w_dims[4] = {t.out_c, t.kernel, t.kernel, t.c / t.group};
+        int b_dims[1] = {t.out_c};
+
+        set_window_attr(test_node, t);
+        set_node_attr_int(test_node, "output_channel", &t.out_c);
+        set_node_attr_int(test_node, "group", &t.group);
+        set_node_attr_int(test_node, "dilation_h", &dilation);
+        set_node_attr_int(test_node, "dilation_w", &dilation);
+
+        add_const_input(graph, test_node, 1, "test/weight", w_dims, 4, buffers);
+        add_const_input(graph, test_node, 2, "test/bias", b_dims, 1, buffers);
+    }
+    else if(op == "Pooling")
+    {
+        set_window_attr(test_node, t);
+        set_node_attr_int(test_node, "alg", &t.alg);
+    }
+    else
+    {
+        set_node_attr_int(test_node, "type", &t.alg);
+
+        if(t.channel_const)
+        {
+            int c_dims[1] = {t.c};
+
+            add_const_input(graph, test_node, 1, "test/operand", c_dims, 1, buffers);
+        }
+        else
+        {
+            node_t input1_node = create_graph_node(graph, "data1", "InputOp");
+            tensor_t input1_tensor = create_graph_tensor(graph, "data1", TENGINE_DT_FP32);
+
+            set_node_output_tensor(input1_node, 0, input1_tensor, TENSOR_TYPE_INPUT);
+            set_tensor_shape(input1_tensor, dims, 4);
+            set_node_input_tensor(test_node, 1, input1_tensor);
+
+            release_graph_tensor(input1_tensor);
+            release_graph_node(input1_node);
+        }
+    }
+
+    tensor_t output_tensor = create_graph_tensor(graph, "test", TENGINE_DT_FP32);
+    set_node_output_tensor(test_node, 0, output_tensor, TENSOR_TYPE_VAR);
+
+    release_graph_tensor(output_tensor);
+    release_graph_tensor(input_tensor);
+    release_graph_node(test_node);
+    release_graph_node(input_node);
+
+    const char* two_inputs[] = {"data", "data1"};
+    const char* outputs[] = {"test"};
+    int input_num = (op == "Eltwise" && !t.channel_const) ? 2 : 1;
+
+    if(set_graph_input_node(graph, two_inputs, input_num) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    for(int i = 0; i < input_num; i++)
+    {
+        tensor_t tensor = get_graph_input_tensor(graph, i, 0);
+        int size = get_tensor_buffer_size(tensor) / sizeof(float);
+
+        buffers.emplace_back(size);
+
+        for(auto& v : buffers.back())
+            v = rand_float();
+
+        set_tensor_buffer(tensor, buffers.back().data(), size * sizeof(float));
+        release_graph_tensor(tensor);
+    }
+
+    return graph;
+}
+
+/* the graph stays alive until both outputs are compared, so a kernel that writes nothing can not pass on
+   the memory of the other graph */
+static graph_t run_case(const TestCase& t, bool reference, std::vector<std::vector<float>>& buffers,
+                        const float*& output, int& size)
+{
+    seed = 1;
+
+    graph_t graph = create_test_graph(t, buffers);
+
+    if(graph == nullptr)
+        return nullptr;
+
+    /* the planner would move an op without an NHWC kernel, keep every node in NHWC */
+    if(reference)
+    {
+        setenv("OPS_REGISTRY", "reference", 1);
+        setenv("OP_NAME", t.op, 1);
+    }
+    else
+        setenv("GRAPH_OPT_DISABLE", "LayoutPlan", 1);
+
+    int ret = prerun_graph(graph);
+
+    unsetenv("OPS_REGISTRY");
+    unsetenv("OP_NAME");
+    unsetenv("GRAPH_OPT_DISABLE");
+
+    if(ret < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return nullptr;
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+
+    output = ( const float* )get_tensor_buffer(output_tensor);
+    size = get_tensor_buffer_size(output_tensor) / sizeof(float);
+
+    release_graph_tensor(output_tensor);
+
+    return graph;
+}
+
+static void release_case(graph_t graph)
+{
+    if(graph == nullptr)
+        return;
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+}
+
+/* the const operand is created with the node, before the input */
+static void channel_eltwise(const TestCase& t, const std::vector<std::vector<float>>& buffers,
+                            std::vector<float>& result)
+{
+    const std::vector<float>& operand = buffers[0];
+    const std::vector<float>& input = buffers[1];
+
+    result.resize(input.size());
+
+    for(unsigned int i = 0; i < input.size(); i++)
+        result[i] = t.alg == 0 ? input[i] * operand[i % t.c] : input[i] + operand[i % t.c];
+}
+
+int main(int argc, char* argv[])
+{
+    /* op, c, h, w, out_c, kernel, stride, pad0, pad1, group, alg, channel_const */
+    TestCase cases[] = {
+        {"Convolution", 8, 13, 11, 16, 3, 1, 1, 1, 1, 0, false},
+        {"Convolution", 5, 15, 15, 7, 3, 2, 0, 1, 1, 0, false},
+        {"Convolution", 16, 9, 9, 24, 1, 1, 0, 0, 1, 0, false},
+        {"Convolution", 19, 12, 10, 19, 3, 1, 1, 1, 19, 0, false},
+        {"Convolution", 32, 14, 14, 32, 3, 2, 0, 1, 32, 0, false},
+        {"Convolution", 12, 11, 11, 12, 5, 1, 2, 2, 12, 0, false},
+        {"Pooling", 11, 14, 14, 0, 2, 2, 0, 0, 0, 0, false},
+        {"Pooling", 11, 15, 15, 0, 3, 2, 1, 1, 0, 0, false},
+        {"Pooling", 20, 15, 15, 0, 3, 2, 1, 1, 0, 1, false},
+        {"Eltwise", 13, 7, 9, 0, 0, 0, 0, 0, 0, 2, false},
+        {"Eltwise", 13, 7, 9, 0, 0, 0, 0, 0, 0, 0, false},
+        {"Eltwise", 13, 7, 9, 0, 0, 0, 0, 0, 0, 0, true},
+        {"Eltwise", 16, 7, 9, 0, 0, 0, 0, 0, 0, 2, true},
+    };
+
+    init_tengine();
+
+    int ret = 0;
+
+    for(unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        std::vector<std::vector<float>> buffers;
+        std::vector<std::vector<float>> ref_buffers;
+        std::vector<float> channel_output;
+        const float* output = nullptr;
+        const float* ref_output = nullptr;
+        int size = 0;
+        int ref_size = 0;
+        graph_t ref_graph = nullptr;
+        graph_t graph = run_case(cases[i], false, buffers, output, size);
+
+        if(graph && cases[i].channel_const)
+        {
+            channel_eltwise(cases[i], buffers, channel_output);
+            ref_output = channel_output.data();
+            ref_size = channel_output.size();
+        }
+        else if(graph)
+            ref_graph = run_case(cases[i], true, ref_buffers, ref_output, ref_size);
+
+        if(ref_output == nullptr || size != ref_size || float_mismatch(output, ref_output, size) < 0)
+        {
+            printf("case %u: %s failed\n", i, cases[i].op);
+            ret = -1;
+        }
+
+        release_case(graph);
+        release_case(ref_graph);
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
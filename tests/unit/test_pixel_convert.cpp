@@ -0,0 +1,295 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#include "net.h"
+
+/*
+ * the pixel conversion and resize of core/lib/net.cpp. The SSE2/SSSE3/AVX2 paths are picked at compile time,
+ * so this test is built with net.cpp once per instruction set, see CMakeLists.txt. Every build must give the
+ * hash of the scalar build, bit for bit, and the fused resize + normalize must match the two separate steps
+ */
+
+namespace ncnn {
+/* not in net.h */
+void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h,
+                        int stride);
+void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h,
+                        int stride);
+void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h,
+                        int stride);
+void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h,
+                        int stride);
+void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h);
+}    // namespace ncnn
+
+using namespace ncnn;
+
+/* the output hash of the scalar build (-U__SSE2__) */
+static const uint64_t expected_hash = 0xa6c201ea3cb1b3a2ull;
+
+static uint64_t hash = 1469598103934665603ull;
+static unsigned int seed = 7;
+
+static unsigned int rand_int(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* FNV-1a */
+static void hash_bytes(const void* data, size_t size)
+{
+    const unsigned char* p = ( const unsigned char* )data;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+static void hash_mat(const Mat& m)
+{
+    for(int q = 0; q < m.c; q++)
+        hash_bytes(( const float* )m.channel(q), m.w * m.h * sizeof(float));
+}
+
+static void free_mat(Mat& m)
+{
+    free(m.data);
+    m.data = nullptr;
+}
+
+static bool same_mat(const Mat& a, const Mat& b)
+{
+    if(a.w != b.w || a.h != b.h || a.c != b.c)
+        return false;
+
+    for(int q = 0; q < a.c; q++)
+    {
+        if(memcmp(( const float* )a.channel(q), ( const float* )b.channel(q), a.w * a.h * sizeof(float)))
+            return false;
+    }
+
+    return true;
+}
+
+static void resize_c(int cn, const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w,
+                     int h)
+{
+    if(cn == 1)
+        resize_bilinear_c1(src, srcw, srch, srcstride, dst, w, h, w);
+    else if(cn == 2)
+        resize_bilinear_c2(src, srcw, srch, srcstride, dst, w, h, w * 2);
+    else if(cn == 3)
+        resize_bilinear_c3(src, srcw, srch, srcstride, dst, w, h, w * 3);
+    else
+        resize_bilinear_c4(src, srcw, srch, srcstride, dst, w, h, w * 4);
+}
+
+/* random sizes and strides, wide sources every 7th round for the vector loops */
+static int test_random(void)
+{
+    int types[4] = {Mat::PIXEL_RGB, Mat::PIXEL_BGR, Mat::PIXEL_RGB2BGR, Mat::PIXEL_BGR2RGB};
+
+    for(int it = 0; it < 300; it++)
+    {
+        int sw = 2 + rand_int() % 96 + (it % 7 == 0 ? 300 : 0);
+        int sh = 2 + rand_int() % 82;
+        int tw = 1 + rand_int() % 120;
+        int th = 1 + rand_int() % 90;
+
+        for(int cn = 1; cn <= 4; cn++)
+        {
+            int stride = sw * cn + rand_int() % 5;
+            std::vector<unsigned char> src(stride * sh);
+            /* the tail past the image must stay untouched */
+            std::vector<unsigned char> dst(tw * cn * th + 16, 0xcd);
+
+            for(auto& v : src)
+                v = rand_int();
+
+            resize_c(cn, src.data(), sw, sh, stride, dst.data(), tw, th);
+            hash_bytes(dst.data(), dst.size());
+        }
+
+        std::vector<unsigned char> image(sw * sh * 3);
+        float mean[3] = {rand_int() % 256 * 0.5f, rand_int() % 256 * 0.25f, 17.3f};
+        float norm[3] = {1 / 58.f, 1 / 57.f, 0.0178f};
+
+        for(auto& v : image)
+            v = rand_int();
+
+        for(int t = 0; t < 4; t++)
+        {
+            Mat m = Mat::from_pixels(image.data(), types[t], sw, sh);
+
+            hash_mat(m);
+
+            /* no mean, mean, norm, both */
+            for(int mode = 0; mode < 4; mode++)
+            {
+                const float* mean_vals = (mode & 1) ? mean : nullptr;
+                const float* norm_vals = (mode & 2) ? norm : nullptr;
+
+                Mat split = Mat::from_pixels_resize(image.data(), types[t], sw, sh, tw, th);
+                split.substract_mean_normalize(mean_vals, norm_vals);
+
+                Mat fused = Mat::from_pixels_resize_normalize(image.data(), types[t], sw, sh, tw, th, mean_vals,
+                                                              norm_vals);
+                bool same = same_mat(split, fused);
+
+                hash_mat(fused);
+                free_mat(split);
+                free_mat(fused);
+
+                /* same size: no resize, only the conversion */
+                split = Mat::from_pixels(image.data(), types[t], sw, sh);
+                split.substract_mean_normalize(mean_vals, norm_vals);
+                fused = Mat::from_pixels_resize_normalize(image.data(), types[t], sw, sh, sw, sh, mean_vals, norm_vals);
+                same = same && same_mat(split, fused);
+
+                free_mat(split);
+                free_mat(fused);
+
+                if(!same)
+                {
+                    printf("round %d type %d mode %d: %dx%d -> %dx%d, the fused normalize differs\n", it, t, mode, sw,
+                           sh, tw, th);
+                    return -1;
+                }
+            }
+
+            free_mat(m);
+        }
+
+        /* gray goes through the generic fallback */
+        Mat gray = Mat::from_pixels_resize_normalize(image.data(), Mat::PIXEL_GRAY, sw, sh, tw, th, mean, norm);
+
+        hash_mat(gray);
+        free_mat(gray);
+
+        if(tw >= 2 && th >= 2)
+        {
+            int yuv_w = sw / 2 * 2;
+            int yuv_h = sh / 2 * 2;
+            std::vector<unsigned char> yuv(yuv_w * yuv_h * 3 / 2);
+            std::vector<unsigned char> yuv_out(tw / 2 * 2 * (th / 2 * 2) * 3 / 2);
+
+            for(auto& v : yuv)
+                v = rand_int();
+
+            resize_bilinear_yuv420sp(yuv.data(), yuv_w, yuv_h, yuv_out.data(), tw / 2 * 2, th / 2 * 2);
+            hash_bytes(yuv_out.data(), yuv_out.size());
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * a channel of c4 must match c1 on that channel. The upscale reuses the previous source row, the 4x downscale
+ * steps 4 rows at a time and must not take the one row shortcut
+ */
+static int test_c4_rows(void)
+{
+    int sizes[2][4] = {{7, 5, 23, 17}, {92, 68, 23, 17}};
+
+    for(int n = 0; n < 2; n++)
+    {
+        int sw = sizes[n][0], sh = sizes[n][1], w = sizes[n][2], h = sizes[n][3];
+        std::vector<unsigned char> src(sw * sh * 4);
+        std::vector<unsigned char> dst(w * h * 4);
+        std::vector<unsigned char> plane(sw * sh);
+        std::vector<unsigned char> plane_dst(w * h);
+
+        for(auto& v : src)
+            v = rand_int();
+
+        resize_bilinear_c4(src.data(), sw, sh, sw * 4, dst.data(), w, h, w * 4);
+
+        for(int k = 0; k < 4; k++)
+        {
+            for(int i = 0; i < sw * sh; i++)
+                plane[i] = src[i * 4 + k];
+
+            resize_bilinear_c1(plane.data(), sw, sh, sw, plane_dst.data(), w, h, w);
+
+            for(int i = 0; i < w * h; i++)
+            {
+                if(dst[i * 4 + k] != plane_dst[i])
+                {
+                    printf("c4 %dx%d -> %dx%d: pixel %d channel %d %d vs c1 %d\n", sw, sh, w, h, i, k,
+                           dst[i * 4 + k], plane_dst[i]);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* a copy shares the data with the same channel step */
+static int test_copy(void)
+{
+    std::vector<unsigned char> image(5 * 3 * 3, 1);
+    Mat m = Mat::from_pixels(image.data(), Mat::PIXEL_RGB, 5, 3);
+    Mat copy(m);
+    int ret = 0;
+
+    if(copy.cstep != m.cstep || ( const float* )copy.channel(2) != ( const float* )m.channel(2))
+    {
+        printf("copy: cstep %d vs %d\n", ( int )copy.cstep, ( int )m.cstep);
+        ret = -1;
+    }
+
+    free_mat(m);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+
+    if(test_random() < 0 || test_c4_rows() < 0 || test_copy() < 0)
+        ret = -1;
+
+    if(ret == 0 && hash != expected_hash)
+    {
+        printf("hash %016llx, the scalar build gives %016llx\n", ( unsigned long long )hash,
+               ( unsigned long long )expected_hash);
+        ret = -1;
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    return ret;
+}
@@ -0,0 +1,395 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <string>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+#include "graph.hpp"
+#include "operator/lstm.hpp"
+#include "operator/gru.hpp"
+#include "operator/rnn.hpp"
+
+using namespace TEngine;
+
+/*
+ * LSTM, GRU and RNN against the reference kernels (OPS_REGISTRY=reference), in the tensorflow and mxnet
+ * layouts. The hidden sizes of 13 and 11 leave a tail after the 8 or 4 lanes of the vector loops, 16 does not.
+ */
+
+static std::list<std::vector<float>> buffers;
+
+static float* new_buffer(int size)
+{
+    buffers.emplace_back(size);
+
+    for(auto& v : buffers.back())
+        v = ( float )rand() / RAND_MAX - 0.5f;
+
+    return buffers.back().data();
+}
+
+struct Weight
+{
+    std::string name;
+    std::vector<int> dims;
+    float* data;
+};
+
+struct RecurrentTest
+{
+    const char* desc;
+    const char* op;
+    std::vector<int> input_dims;
+    std::vector<Weight> weights;
+    std::function<void(Node*)> set_param;
+    int output_size; /* the output_len * batch * hidden values the kernels write */
+    float* input;
+};
+
+static Weight weight(const char* name, std::vector<int> dims)
+{
+    int size = 1;
+
+    for(int d : dims)
+        size *= d;
+
+    return {name, dims, new_buffer(size)};
+}
+
+static graph_t create_test_graph(const RecurrentTest& t)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int input_size = 1;
+
+    for(int d : t.input_dims)
+        input_size *= d;
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, t.input_dims.data(), t.input_dims.size());
+    set_tensor_buffer(input_tensor, t.input, input_size * sizeof(float));
+
+    node_t node = create_graph_node(graph, "rnn", t.op);
+    tensor_t output_tensor = create_graph_tensor(graph, "rnn", TENGINE_DT_FP32);
+
+    set_node_input_tensor(node, 0, input_tensor);
+    set_node_output_tensor(node, 0, output_tensor, TENSOR_TYPE_VAR);
+
+    /* the kernels find the weights by the name */
+    for(unsigned int i = 0; i < t.weights.size(); i++)
+    {
+        const Weight& w = t.weights[i];
+        std::string name = std::string("rnn/") + w.name;
+        node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+        tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+        int size = 1;
+
+        for(int d : w.dims)
+            size *= d;
+
+        set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+        set_tensor_shape(tensor, w.dims.data(), w.dims.size());
+        set_tensor_buffer(tensor, w.data, size * sizeof(float));
+        set_node_input_tensor(node, i + 1, tensor);
+
+        release_graph_tensor(tensor);
+        release_graph_node(c_node);
+    }
+
+    t.set_param(reinterpret_cast<Node*>(node));
+
+    release_graph_tensor(input_tensor);
+    release_graph_tensor(output_tensor);
+    release_graph_node(input_node);
+    release_graph_node(node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"rnn"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static int run_test(RecurrentTest& t)
+{
+    int input_size = 1;
+
+    for(int d : t.input_dims)
+        input_size *= d;
+
+    t.input = new_buffer(input_size);
+
+    graph_t graph = create_test_graph(t);
+    graph_t ref_graph = create_test_graph(t);
+
+    if(graph == nullptr || ref_graph == nullptr)
+        return -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        std::cerr << t.desc << ": prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    setenv("OPS_REGISTRY", "reference", 1);
+
+    if(prerun_graph(ref_graph) < 0)
+    {
+        std::cerr << t.desc << ": prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    unsetenv("OPS_REGISTRY");
+
+    int ret = 0;
+
+    /* twice, the second run must not depend on the state the first one left */
+    for(int i = 0; i < 2 && ret == 0; i++)
+    {
+        if(run_graph(graph, 1) < 0 || run_graph(ref_graph, 1) < 0)
+        {
+            std::cerr << t.desc << ": run_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+            return -1;
+        }
+
+        tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+        tensor_t ref_output_tensor = get_graph_output_tensor(ref_graph, 0, 0);
+        const float* output = ( const float* )get_tensor_buffer(output_tensor);
+        const float* ref_output = ( const float* )get_tensor_buffer(ref_output_tensor);
+
+        for(int k = 0; k < t.output_size; k++)
+        {
+            if(std::fabs(output[k] - ref_output[k]) > 1e-4f)
+            {
+                printf("%s: [%d] %f vs ref %f\n", t.desc, k, output[k], ref_output[k]);
+                ret = -1;
+                break;
+            }
+        }
+
+        release_graph_tensor(output_tensor);
+        release_graph_tensor(ref_output_tensor);
+    }
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+    postrun_graph(ref_graph);
+    destroy_graph(ref_graph);
+
+    return ret;
+}
+
+/* input [batch, seq, input] for tensorflow and [seq, batch, input] for mxnet, cell is hidden without projection */
+static RecurrentTest lstm_test(const char* desc, bool mxnet, int batch, int seq, int input, int hidden, int cell,
+                               int output_len, bool peephole, bool projection, bool init_state)
+{
+    RecurrentTest t;
+
+    t.desc = desc;
+    t.op = "LSTM";
+    t.input_dims = mxnet ? std::vector<int>{seq, batch, input} : std::vector<int>{batch, seq, input};
+    t.output_size = output_len * batch * hidden;
+
+    if(mxnet)
+    {
+        t.weights.push_back(weight("i2h_weight", {4 * cell, input}));
+        t.weights.push_back(weight("i2h_bias", {4 * cell}));
+        t.weights.push_back(weight("h2h_weight", {4 * hidden, hidden}));
+        t.weights.push_back(weight("h2h_bias", {4 * hidden}));
+    }
+    else
+    {
+        t.weights.push_back(weight("kernel", {input + hidden, 4 * cell}));
+        t.weights.push_back(weight("bias", {4 * cell}));
+    }
+
+    if(peephole)
+    {
+        t.weights.push_back(weight("w_i_diag", {cell}));
+        t.weights.push_back(weight("w_f_diag", {cell}));
+        t.weights.push_back(weight("w_o_diag", {cell}));
+    }
+
+    if(projection)
+        t.weights.push_back(weight("projection", {cell, hidden}));
+
+    if(init_state)
+    {
+        t.weights.push_back(weight("init_h", {hidden}));
+        t.weights.push_back(weight("init_c", {cell}));
+    }
+
+    t.set_param = [=](Node* node) {
+        LSTMParam* param = dynamic_cast<LSTM*>(node->GetOp())->GetParam();
+
+        param->forget_bias = mxnet ? 0.f : 0.75f;
+        param->clip = 0.f;
+        param->output_len = output_len;
+        param->sequence_len = seq;
+        param->input_size = input;
+        param->hidden_size = hidden;
+        param->cell_size = cell;
+        param->has_peephole = peephole;
+        param->has_projection = projection;
+        param->has_clip = 0;
+        param->has_bias = 1;
+        param->has_init_state = init_state;
+        param->mxnet_flag = mxnet;
+    };
+
+    return t;
+}
+
+static RecurrentTest gru_test(const char* desc, bool mxnet, int batch, int seq, int input, int hidden, int output_len,
+                              bool init_state)
+{
+    RecurrentTest t;
+
+    t.desc = desc;
+    t.op = "GRU";
+    t.input_dims = mxnet ? std::vector<int>{seq, batch, input} : std::vector<int>{batch, seq, input};
+    t.output_size = output_len * batch * hidden;
+
+    if(mxnet)
+    {
+        t.weights.push_back(weight("i2h_weight", {3 * hidden, input}));
+        t.weights.push_back(weight("i2h_bias", {3 * hidden}));
+        t.weights.push_back(weight("h2h_weight", {3 * hidden, hidden}));
+        t.weights.push_back(weight("h2h_bias", {3 * hidden}));
+    }
+    else
+    {
+        t.weights.push_back(weight("gates/kernel", {input + hidden, 2 * hidden}));
+        t.weights.push_back(weight("gates/bias", {2 * hidden}));
+        t.weights.push_back(weight("candidate/kernel", {input + hidden, hidden}));
+        t.weights.push_back(weight("candidate/bias", {hidden}));
+    }
+
+    if(init_state)
+        t.weights.push_back(weight("init_h", {hidden}));
+
+    t.set_param = [=](Node* node) {
+        GRUParam* param = dynamic_cast<GRU*>(node->GetOp())->GetParam();
+
+        param->clip = 0.f;
+        param->output_len = output_len;
+        param->sequence_len = seq;
+        param->input_size = input;
+        param->hidden_size = hidden;
+        param->has_clip = 0;
+        param->has_gate_bias = 1;
+        param->has_candidate_bias = 1;
+        param->has_init_state = init_state;
+        param->mxnet_flag = mxnet;
+    };
+
+    return t;
+}
+
+/* input [seq, batch, input], the kernel is the first weight */
+static RecurrentTest rnn_test(const char* desc, int batch, int seq, int input, int hidden, int output_len,
+                              bool init_state)
+{
+    RecurrentTest t;
+
+    t.desc = desc;
+    t.op = "RNN";
+    t.input_dims = {seq, batch, input};
+    t.output_size = output_len * batch * hidden;
+
+    t.weights.push_back(weight("kernel", {input + hidden, hidden}));
+    t.weights.push_back(weight("bias", {hidden}));
+
+    if(init_state)
+        t.weights.push_back(weight("init_h", {hidden}));
+
+    t.set_param = [=](Node* node) {
+        RNNParam* param = dynamic_cast<RNN*>(node->GetOp())->GetParam();
+
+        param->clip = 0.f;
+        param->output_len = output_len;
+        param->sequence_len = seq;
+        param->input_size = input;
+        param->hidden_size = hidden;
+        param->has_clip = 0;
+        param->has_bias = 1;
+        param->has_init_state = init_state;
+        param->activation = RNN_ACT_TANH;
+    };
+
+    return t;
+}
+
+int main(int argc, char* argv[])
+{
+    init_tengine();
+
+    /* the tensorflow output is [batch, batch, hidden], so output_len stays within the batch there */
+    std::vector<RecurrentTest> tests = {
+        lstm_test("lstm tf", false, 3, 4, 5, 13, 13, 3, false, false, false),
+        lstm_test("lstm tf peephole projection", false, 3, 4, 7, 11, 13, 2, true, true, false),
+        lstm_test("lstm tf init state", false, 2, 5, 6, 16, 16, 1, true, false, true),
+        lstm_test("lstm mxnet", true, 3, 4, 5, 13, 13, 4, false, false, false),
+        lstm_test("lstm mxnet init state", true, 2, 3, 9, 16, 16, 2, false, false, true),
+        gru_test("gru tf", false, 3, 4, 5, 13, 3, false),
+        gru_test("gru tf init state", false, 2, 3, 6, 16, 1, true),
+        gru_test("gru mxnet", true, 3, 4, 5, 13, 4, false),
+        gru_test("gru mxnet init state", true, 2, 3, 6, 11, 3, true),
+        rnn_test("rnn", 3, 4, 5, 13, 4, false),
+        rnn_test("rnn init state", 2, 3, 6, 16, 2, true),
+    };
+
+    int ret = 0;
+
+    for(auto& t : tests)
+    {
+        if(run_test(t) < 0)
+            ret = -1;
+    }
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
@@ -0,0 +1,615 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "tengine_c_api.h"
+#include "graph_executor.hpp"
+#include "weight_cache.hpp"
+
+using namespace TEngine;
+
+/*
+ * The shared weight blobs of executor/lib/weight_cache.cpp. TENGINE_WEIGHT_CACHE and TENGINE_WEIGHT_SHARE
+ * are read once, so they are set before anything else and hold for the whole test:
+ *  - the refcount of a blob, which lives from the first acquire to the last release;
+ *  - the disk cache: a blob saved by one acquire is mapped back by the next one, a broken file is made again;
+ *  - two graphs of one model, conv + batchnorm: the fused weights are shared in memory only, and the last
+ *    graph destroyed frees them.
+ */
+
+static std::string cache_dir;
+static int fill_num;
+
+static void fill_pattern(void* blob, int size, int salt)
+{
+    unsigned char* p = ( unsigned char* )blob;
+
+    for(int i = 0; i < size; i++)
+        p[i] = ( unsigned char )(i * 7 + salt);
+}
+
+static bool check_pattern(const void* blob, int size, int salt)
+{
+    const unsigned char* p = ( const unsigned char* )blob;
+
+    for(int i = 0; i < size; i++)
+    {
+        if(p[i] != ( unsigned char )(i * 7 + salt))
+            return false;
+    }
+
+    return true;
+}
+
+static void* acquire(const std::string& key, int size, int salt, bool memory_only)
+{
+    return AcquireSharedWeight(key, size, [&](void* blob) {
+        fill_num++;
+        fill_pattern(blob, size, salt);
+        return true;
+    }, memory_only);
+}
+
+static std::string cache_path(const std::string& key)
+{
+    return cache_dir + "/" + key + ".bin";
+}
+
+static long file_size(const std::string& path)
+{
+    struct stat st;
+
+    if(stat(path.c_str(), &st) < 0)
+        return -1;
+
+    return st.st_size;
+}
+
+/* the files of the cache dir whose name starts with prefix */
+static int count_files(const char* prefix)
+{
+    DIR* dir = opendir(cache_dir.c_str());
+    int num = 0;
+
+    if(dir == nullptr)
+        return 0;
+
+    while(struct dirent* ent = readdir(dir))
+    {
+        if(!strncmp(ent->d_name, prefix, strlen(prefix)))
+            num++;
+    }
+
+    closedir(dir);
+
+    return num;
+}
+
+static int test_refcount(void)
+{
+    const int size = 1000;
+    int salt = 3;
+    std::string key = GetWeightCacheKey(nullptr, "test.ref", &salt, sizeof(salt), {size});
+
+    fill_num = 0;
+
+    /* two users of one key: one fill, one blob */
+    void* a = acquire(key, size, salt, true);
+    void* b = acquire(key, size, salt, true);
+
+    if(a == nullptr || a != b || fill_num != 1 || !check_pattern(a, size, salt))
+    {
+        printf("refcount: acquired %p and %p, %d fills\n", a, b, fill_num);
+        return -1;
+    }
+
+    /* the same key with another size is another blob */
+    void* other = acquire(key, size / 2, salt + 1, true);
+
+    if(other == nullptr || other == a || fill_num != 2 || !ReleaseSharedWeight(other))
+    {
+        printf("refcount: the blob of another size is %p, %d fills\n", other, fill_num);
+        return -1;
+    }
+
+    /* the blob outlives the first release */
+    if(!ReleaseSharedWeight(a) || acquire(key, size, salt, true) != a || fill_num != 2)
+    {
+        printf("refcount: the blob is gone after one release of two\n");
+        return -1;
+    }
+
+    if(!ReleaseSharedWeight(a) || !ReleaseSharedWeight(b))
+    {
+        printf("refcount: a reference is lost\n");
+        return -1;
+    }
+
+    /* freed with the last reference, so unknown to the cache from now on */
+    if(ReleaseSharedWeight(a))
+    {
+        printf("refcount: the blob is still there after the last release\n");
+        return -1;
+    }
+
+    void* c = acquire(key, size, salt, true);
+
+    if(c == nullptr || fill_num != 3 || !check_pattern(c, size, salt) || !ReleaseSharedWeight(c))
+    {
+        printf("refcount: the blob is not made again, %d fills\n", fill_num);
+        return -1;
+    }
+
+    /* a buffer of the kernel's own, which it frees itself */
+    std::vector<char> own(size);
+
+    if(ReleaseSharedWeight(own.data()))
+    {
+        printf("refcount: a buffer that is not shared is released\n");
+        return -1;
+    }
+
+    /* a memory only blob never reaches the disk */
+    if(count_files("test.ref-") != 0)
+    {
+        printf("refcount: the memory only blob is saved\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* writes len bytes at offset of the file, or cuts it to offset when data is null */
+static bool damage_file(const std::string& path, long offset, const void* data, int len)
+{
+    if(data == nullptr)
+        return truncate(path.c_str(), offset) == 0;
+
+    FILE* fp = fopen(path.c_str(), "r+b");
+
+    if(fp == nullptr)
+        return false;
+
+    bool ret = fseek(fp, offset, SEEK_SET) == 0 && fwrite(data, len, 1, fp) == 1;
+
+    return fclose(fp) == 0 && ret;
+}
+
+/* the blob is made, saved, and made again when the file is broken */
+static int acquire_filled(const std::string& key, int size, int salt, const char* desc)
+{
+    fill_num = 0;
+
+    void* addr = acquire(key, size, salt, false);
+    int ret = 0;
+
+    if(addr == nullptr || fill_num != 1 || !check_pattern(addr, size, salt))
+    {
+        printf("disk cache %s: the blob is not filled, %d fills\n", desc, fill_num);
+        ret = -1;
+    }
+    else if(file_size(cache_path(key)) != 64 + size)
+    {
+        printf("disk cache %s: the file has %ld bytes\n", desc, file_size(cache_path(key)));
+        ret = -1;
+    }
+
+    if(addr && !ReleaseSharedWeight(addr))
+        ret = -1;
+
+    return ret;
+}
+
+static int test_disk_cache(void)
+{
+    const int size = 4096 + 20;
+    int salt = 5;
+    std::string key = GetWeightCacheKey(nullptr, "test.disk", &salt, sizeof(salt), {size});
+    std::string path = cache_path(key);
+
+    if(acquire_filled(key, size, salt, "first") < 0)
+        return -1;
+
+    /* a new process, or the last graph gone: the blob comes from the file */
+    fill_num = 0;
+
+    void* addr = acquire(key, size, salt, false);
+
+    if(addr == nullptr || fill_num != 0 || !check_pattern(addr, size, salt))
+    {
+        printf("disk cache: the saved blob is not mapped back, %d fills\n", fill_num);
+        return -1;
+    }
+
+    if(!ReleaseSharedWeight(addr))
+    {
+        printf("disk cache: the mapped blob is not released\n");
+        return -1;
+    }
+
+    /* the header: magic "TMWCACHE" then the 64 bit size of the blob */
+    uint64_t wrong_size = size - 1;
+
+    if(!damage_file(path, 0, "TMWCACHX", 8) || acquire_filled(key, size, salt, "bad magic") < 0)
+        return -1;
+
+    if(!damage_file(path, 8, &wrong_size, sizeof(wrong_size)) || acquire_filled(key, size, salt, "bad size") < 0)
+        return -1;
+
+    if(!damage_file(path, 64 + size - 1, nullptr, 0) || acquire_filled(key, size, salt, "truncated") < 0)
+        return -1;
+
+    /* repaired by the last acquire */
+    fill_num = 0;
+    addr = acquire(key, size, salt, false);
+
+    if(addr == nullptr || fill_num != 0 || !check_pattern(addr, size, salt) || !ReleaseSharedWeight(addr))
+    {
+        printf("disk cache: the blob saved again is not mapped back\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static std::list<std::vector<float>> buffers;
+static unsigned int seed = 1;
+
+static float rand_float(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (( int )((seed >> 16) & 0x7fff) - 16384) / 16384.f;
+}
+
+/* a Const with random data in [lo, lo + 1), or the data of a model when the same seed is used again */
+static void add_const(graph_t graph, node_t node, int idx, const std::string& name, const int* dims, int dim_num,
+                      float lo)
+{
+    node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+    tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+    int size = 1;
+
+    for(int i = 0; i < dim_num; i++)
+        size *= dims[i];
+
+    buffers.emplace_back(size);
+
+    for(auto& v : buffers.back())
+        v = lo + 0.5f + 0.5f * rand_float();
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims, dim_num);
+    set_tensor_buffer(tensor, buffers.back().data(), size * sizeof(float));
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_tensor(tensor);
+    release_graph_node(c_node);
+}
+
+static node_t add_node(graph_t graph, const char* name, const char* op, const char* input)
+{
+    node_t node = create_graph_node(graph, name, op);
+    tensor_t tensor = get_graph_tensor(graph, input);
+
+    set_node_input_tensor(node, 0, tensor);
+    release_graph_tensor(tensor);
+
+    tensor = create_graph_tensor(graph, name, TENGINE_DT_FP32);
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_VAR);
+    release_graph_tensor(tensor);
+
+    return node;
+}
+
+static const int input_c = 8, output_c = 16, input_h = 12, input_w = 12;
+static std::vector<float> input_data(input_c * input_h * input_w);
+
+/* data -> conv 3x3 -> batchnorm, the weights come from the same seed in every graph, as from one model */
+static graph_t create_model_graph(void)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    seed = 1;
+
+    node_t node = create_graph_node(graph, "data", "InputOp");
+    tensor_t tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, input_c, input_h, input_w};
+
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(tensor, dims, 4);
+    set_tensor_buffer(tensor, input_data.data(), input_data.size() * sizeof(float));
+    release_graph_tensor(tensor);
+    release_graph_node(node);
+
+    node = add_node(graph, "conv", "Convolution", "data");
+
+    int one = 1, kernel = 3, output = output_c;
+    int w_dims[4] = {output_c, input_c, kernel, kernel};
+    int c_dims[1] = {output_c};
+
+    set_node_attr_int(node, "kernel_h", &kernel);
+    set_node_attr_int(node, "kernel_w", &kernel);
+    set_node_attr_int(node, "stride_h", &one);
+    set_node_attr_int(node, "stride_w", &one);
+    set_node_attr_int(node, "pad_h0", &one);
+    set_node_attr_int(node, "pad_w0", &one);
+    set_node_attr_int(node, "pad_h1", &one);
+    set_node_attr_int(node, "pad_w1", &one);
+    set_node_attr_int(node, "dilation_h", &one);
+    set_node_attr_int(node, "dilation_w", &one);
+    set_node_attr_int(node, "output_channel", &output);
+    set_node_attr_int(node, "group", &one);
+
+    add_const(graph, node, 1, "conv/weight", w_dims, 4, -0.5f);
+    add_const(graph, node, 2, "conv/bias", c_dims, 1, -0.5f);
+    release_graph_node(node);
+
+    node = add_node(graph, "bn", "BatchNormalization", "conv");
+
+    add_const(graph, node, 1, "bn/gamma", c_dims, 1, 0.5f);
+    add_const(graph, node, 2, "bn/beta", c_dims, 1, -0.5f);
+    add_const(graph, node, 3, "bn/mean", c_dims, 1, -0.5f);
+    add_const(graph, node, 4, "bn/var", c_dims, 1, 0.5f);
+    release_graph_node(node);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"bn"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static graph_t run_model_graph(bool fuse)
+{
+    graph_t graph = create_model_graph();
+
+    if(graph == nullptr)
+        return nullptr;
+
+    if(!fuse)
+        setenv("GRAPH_OPT_DISABLE", "ConvBN", 1);
+
+    int ret = prerun_graph(graph);
+
+    unsetenv("GRAPH_OPT_DISABLE");
+
+    if(ret < 0 || run_graph(graph, 1) < 0)
+    {
+        std::cerr << "run failed: ERRNO: " << get_tengine_errno() << "\n";
+        destroy_graph(graph);
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static std::vector<float> get_output(graph_t graph)
+{
+    tensor_t tensor = get_graph_output_tensor(graph, 0, 0);
+    const float* data = ( const float* )get_tensor_buffer(tensor);
+    std::vector<float> output(data, data + get_tensor_buffer_size(tensor) / sizeof(float));
+
+    release_graph_tensor(tensor);
+
+    return output;
+}
+
+static int compare_output(graph_t graph, const std::vector<float>& expect, const char* desc)
+{
+    std::vector<float> output = get_output(graph);
+
+    if(output.size() != expect.size())
+    {
+        printf("%s: %u outputs vs %u\n", desc, ( unsigned )output.size(), ( unsigned )expect.size());
+        return -1;
+    }
+
+    for(unsigned int i = 0; i < output.size(); i++)
+    {
+        if(std::fabs(output[i] - expect[i]) > 1e-4f * (1 + std::fabs(expect[i])))
+        {
+            printf("%s: [%u] %f vs %f\n", desc, i, output[i], expect[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* the conv that took the batchnorm in */
+static Node* find_fused_conv(graph_t graph)
+{
+    Graph* optimized = reinterpret_cast<GraphExecutor*>(graph)->GetOptimizedGraph();
+
+    for(Node* node : optimized->seq_nodes)
+    {
+        if(node->GetOp()->GetName() == "Convolution" && node->ExistAttr("Fused.Batch"))
+            return node;
+    }
+
+    return nullptr;
+}
+
+struct FusedBlobs
+{
+    void* weight;
+    void* bias;
+    void* packed;
+};
+
+static bool get_fused_blobs(graph_t graph, FusedBlobs& blobs)
+{
+    Node* node = find_fused_conv(graph);
+
+    if(node == nullptr)
+        return false;
+
+    blobs.weight = node->GetInputTensor(1)->GetMemAddr();
+    blobs.bias = node->GetInputTensor(2)->GetMemAddr();
+    blobs.packed = nullptr;
+
+    /* the packed kernel of the x86 sgemm conv */
+    if(node->ExistAttr("kernel_interleaved"))
+        blobs.packed = any_cast<float*>(node->GetAttr("kernel_interleaved"));
+
+    return true;
+}
+
+static int test_model_graphs(void)
+{
+    for(auto& v : input_data)
+        v = rand_float();
+
+    /* the conv and the batchnorm apart, nothing to share but the packed kernel */
+    graph_t ref_graph = run_model_graph(false);
+
+    if(ref_graph == nullptr)
+        return -1;
+
+    std::vector<float> expect = get_output(ref_graph);
+
+    postrun_graph(ref_graph);
+    destroy_graph(ref_graph);
+
+    graph_t graph0 = run_model_graph(true);
+    graph_t graph1 = run_model_graph(true);
+    FusedBlobs blobs0, blobs1;
+    int ret = 0;
+
+    if(graph0 == nullptr || graph1 == nullptr || !get_fused_blobs(graph0, blobs0) || !get_fused_blobs(graph1, blobs1))
+    {
+        printf("model graphs: conv + batchnorm is not fused\n");
+        return -1;
+    }
+
+    if(blobs0.weight != blobs1.weight || blobs0.bias != blobs1.bias || blobs0.packed != blobs1.packed)
+    {
+        printf("model graphs: the fused weights are not shared\n");
+        ret = -1;
+    }
+
+    if(compare_output(graph0, expect, "graph 0") < 0 || compare_output(graph1, expect, "graph 1") < 0)
+        ret = -1;
+
+    /* the fused weights are made again from the weights of each graph, so a disk hit would save nothing */
+    if(count_files("fused-") != 0)
+    {
+        printf("model graphs: the fused weights are saved\n");
+        ret = -1;
+    }
+
+    /* the second graph keeps the blobs alive */
+    postrun_graph(graph0);
+    destroy_graph(graph0);
+
+    if(run_graph(graph1, 1) < 0 || compare_output(graph1, expect, "graph 1 alone") < 0)
+        ret = -1;
+
+    postrun_graph(graph1);
+    destroy_graph(graph1);
+
+    if(ReleaseSharedWeight(blobs1.weight) || ReleaseSharedWeight(blobs1.bias) ||
+       (blobs1.packed && ReleaseSharedWeight(blobs1.packed)))
+    {
+        printf("model graphs: the shared weights outlive the last graph\n");
+        ret = -1;
+    }
+
+    return ret;
+}
+
+static void remove_cache_dir(void)
+{
+    DIR* dir = opendir(cache_dir.c_str());
+
+    if(dir == nullptr)
+        return;
+
+    while(struct dirent* ent = readdir(dir))
+    {
+        if(ent->d_name[0] != '.')
+            unlink((cache_dir + "/" + ent->d_name).c_str());
+    }
+
+    closedir(dir);
+    rmdir(cache_dir.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    char dir_template[] = "/tmp/tengine_weight_cache_XXXXXX";
+
+    if(mkdtemp(dir_template) == nullptr)
+    {
+        printf("cannot create the cache dir\n");
+        return -1;
+    }
+
+    cache_dir = dir_template;
+    setenv("TENGINE_WEIGHT_CACHE", cache_dir.c_str(), 1);
+    setenv("TENGINE_WEIGHT_SHARE", "1", 1);
+
+    init_tengine();
+
+    int ret = 0;
+
+    if(!WeightCacheEnabled() || !WeightShareEnabled())
+    {
+        printf("the weight cache is not enabled\n");
+        ret = -1;
+    }
+
+    if(ret == 0 && (test_refcount() < 0 || test_disk_cache() < 0 || test_model_graphs() < 0))
+        ret = -1;
+
+    remove_cache_dir();
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}
@@ -0,0 +1,340 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * License); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * AS IS BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (c) 2020, Open AI Lab
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "tengine_c_api.h"
+#include "graph.hpp"
+#include "operator/split.hpp"
+
+using namespace TEngine;
+
+/*
+ * A branching graph, run with the planned memory and the zero-copy views of the concat and split
+ * parts, and with GRAPH_OPT_DISABLE=ZeroCopyView:
+ *
+ *   data -> conv a, conv b, relu c -> concat cat -> split s0, s1
+ *   s0 -> conv e, s1 -> conv f -> concat cat2 -> conv out
+ *
+ * The nodes run in the reverse order of the concat inputs, and an input aliased into the concat must
+ * be produced after the inputs before it, so only a is a view of cat. The split of 12 and 20 channels
+ * runs the reference kernel when the views are off.
+ */
+
+static std::list<std::vector<float>> buffers;
+static const int h = 12, w = 12;
+
+static float rand_float(void)
+{
+    return ( float )rand() / RAND_MAX - 0.5f;
+}
+
+static float* new_buffer(int size)
+{
+    buffers.emplace_back(size);
+
+    for(auto& v : buffers.back())
+        v = rand_float();
+
+    return buffers.back().data();
+}
+
+static node_t add_node(graph_t graph, const char* name, const char* op, const std::vector<const char*>& inputs)
+{
+    node_t node = create_graph_node(graph, name, op);
+
+    for(unsigned int i = 0; i < inputs.size(); i++)
+    {
+        tensor_t tensor = get_graph_tensor(graph, inputs[i]);
+
+        set_node_input_tensor(node, i, tensor);
+        release_graph_tensor(tensor);
+    }
+
+    tensor_t tensor = create_graph_tensor(graph, name, TENGINE_DT_FP32);
+
+    set_node_output_tensor(node, 0, tensor, TENSOR_TYPE_VAR);
+    release_graph_tensor(tensor);
+
+    return node;
+}
+
+static void add_const(graph_t graph, node_t node, int idx, const std::string& name, const int* dims, int dim_num,
+                      const float* data)
+{
+    node_t c_node = create_graph_node(graph, name.c_str(), "Const");
+    tensor_t tensor = create_graph_tensor(graph, name.c_str(), TENGINE_DT_FP32);
+    int size = 1;
+
+    for(int i = 0; i < dim_num; i++)
+        size *= dims[i];
+
+    set_node_output_tensor(c_node, 0, tensor, TENSOR_TYPE_CONST);
+    set_tensor_shape(tensor, dims, dim_num);
+    set_tensor_buffer(tensor, ( void* )data, size * sizeof(float));
+    set_node_input_tensor(node, idx, tensor);
+
+    release_graph_tensor(tensor);
+    release_graph_node(c_node);
+}
+
+/* the weights are drawn once and shared by both graphs */
+static void add_conv(graph_t graph, const char* name, const char* input, int input_c, int output_c, int kernel,
+                     const float* weight, const float* bias)
+{
+    node_t node = add_node(graph, name, "Convolution", {input});
+    int one = 1;
+    int pad = kernel / 2;
+    int w_dims[4] = {output_c, input_c, kernel, kernel};
+    int b_dims[1] = {output_c};
+
+    set_node_attr_int(node, "kernel_h", &kernel);
+    set_node_attr_int(node, "kernel_w", &kernel);
+    set_node_attr_int(node, "stride_h", &one);
+    set_node_attr_int(node, "stride_w", &one);
+    set_node_attr_int(node, "pad_h0", &pad);
+    set_node_attr_int(node, "pad_w0", &pad);
+    set_node_attr_int(node, "pad_h1", &pad);
+    set_node_attr_int(node, "pad_w1", &pad);
+    set_node_attr_int(node, "dilation_h", &one);
+    set_node_attr_int(node, "dilation_w", &one);
+    set_node_attr_int(node, "output_channel", &output_c);
+    set_node_attr_int(node, "group", &one);
+
+    add_const(graph, node, 1, std::string(name) + "/weight", w_dims, 4, weight);
+    add_const(graph, node, 2, std::string(name) + "/bias", b_dims, 1, bias);
+
+    release_graph_node(node);
+}
+
+static void add_concat(graph_t graph, const char* name, const std::vector<const char*>& inputs)
+{
+    node_t node = add_node(graph, name, "Concat", inputs);
+    int axis = 1;
+
+    set_node_attr_int(node, "axis", &axis);
+    release_graph_node(node);
+}
+
+struct ConvWeight
+{
+    float* weight;
+    float* bias;
+};
+
+graph_t create_test_graph(const float* input, const std::vector<ConvWeight>& convs)
+{
+    graph_t graph = create_graph(nullptr, nullptr, nullptr);
+
+    if(graph == nullptr)
+    {
+        std::cerr << "create failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    node_t input_node = create_graph_node(graph, "data", "InputOp");
+    tensor_t input_tensor = create_graph_tensor(graph, "data", TENGINE_DT_FP32);
+    int dims[4] = {1, 8, h, w};
+
+    set_node_output_tensor(input_node, 0, input_tensor, TENSOR_TYPE_INPUT);
+    set_tensor_shape(input_tensor, dims, 4);
+    set_tensor_buffer(input_tensor, ( void* )input, 8 * h * w * sizeof(float));
+
+    release_graph_tensor(input_tensor);
+    release_graph_node(input_node);
+
+    add_conv(graph, "a", "data", 8, 8, 3, convs[0].weight, convs[0].bias);
+    add_conv(graph, "b", "data", 8, 16, 1, convs[1].weight, convs[1].bias);
+    release_graph_node(add_node(graph, "c", "ReLu", {"data"}));
+    add_concat(graph, "cat", {"a", "b", "c"});
+
+    node_t split_node = add_node(graph, "s0", "Split", {"cat"});
+    tensor_t s1_tensor = create_graph_tensor(graph, "s1", TENGINE_DT_FP32);
+    SplitParam* split_param = dynamic_cast<Split*>(reinterpret_cast<Node*>(split_node)->GetOp())->GetParam();
+
+    split_param->axis = 1;
+    split_param->is_caffe = false;
+    split_param->is_onnx = false;
+    split_param->split_sizes_ = {12, 20};
+
+    set_node_output_tensor(split_node, 1, s1_tensor, TENSOR_TYPE_VAR);
+    release_graph_tensor(s1_tensor);
+    release_graph_node(split_node);
+
+    add_conv(graph, "e", "s0", 12, 8, 1, convs[2].weight, convs[2].bias);
+    add_conv(graph, "f", "s1", 20, 8, 1, convs[3].weight, convs[3].bias);
+    add_concat(graph, "cat2", {"e", "f"});
+    add_conv(graph, "out", "cat2", 16, 8, 3, convs[4].weight, convs[4].bias);
+
+    const char* inputs[] = {"data"};
+    const char* outputs[] = {"out"};
+
+    if(set_graph_input_node(graph, inputs, 1) < 0 || set_graph_output_node(graph, outputs, 1) < 0)
+    {
+        std::cerr << "set inputs/outputs failed: ERRNO: " << get_tengine_errno() << "\n";
+        return nullptr;
+    }
+
+    return graph;
+}
+
+static char* tensor_mem(graph_t graph, const char* name)
+{
+    tensor_t tensor = get_graph_tensor(graph, name);
+    char* mem = ( char* )get_tensor_buffer(tensor);
+
+    release_graph_tensor(tensor);
+
+    return mem;
+}
+
+/* a view sits at its offset inside the whole tensor, any other part outside of it */
+static bool is_view(graph_t graph, const char* name, char* whole, int whole_size, int offset, int size)
+{
+    char* part = tensor_mem(graph, name);
+
+    if(part == whole + offset)
+        return true;
+
+    if(part < whole + whole_size && whole < part + size)
+        printf("%s overlaps the whole tensor at a wrong place\n", name);
+
+    return false;
+}
+
+static int check_views(graph_t graph, bool expect)
+{
+    int plane = h * w * sizeof(float);
+    char* cat = tensor_mem(graph, "cat");
+    int whole = 32 * plane;
+    bool views[5] = {
+        is_view(graph, "a", cat, whole, 0, 8 * plane),
+        is_view(graph, "b", cat, whole, 8 * plane, 16 * plane),
+        is_view(graph, "c", cat, whole, 24 * plane, 8 * plane),
+        is_view(graph, "s0", cat, whole, 0, 12 * plane),
+        is_view(graph, "s1", cat, whole, 12 * plane, 20 * plane),
+    };
+    bool expected[5] = {expect, false, false, expect, expect};
+
+    for(int i = 0; i < 5; i++)
+    {
+        if(views[i] != expected[i])
+        {
+            printf("view %d: %d, expected %d\n", i, views[i], expected[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int conv_desc[5][3] = {{8, 8, 3}, {8, 16, 1}, {12, 8, 1}, {20, 8, 1}, {16, 8, 3}};
+    std::vector<ConvWeight> convs;
+
+    for(int i = 0; i < 5; i++)
+    {
+        ConvWeight conv;
+
+        conv.weight = new_buffer(conv_desc[i][0] * conv_desc[i][1] * conv_desc[i][2] * conv_desc[i][2]);
+        conv.bias = new_buffer(conv_desc[i][1]);
+        convs.push_back(conv);
+    }
+
+    const float* input = new_buffer(8 * h * w);
+
+    init_tengine();
+
+    graph_t graph = create_test_graph(input, convs);
+    graph_t ref_graph = create_test_graph(input, convs);
+
+    if(graph == nullptr || ref_graph == nullptr)
+        return -1;
+
+    if(prerun_graph(graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    setenv("GRAPH_OPT_DISABLE", "ZeroCopyView", 1);
+
+    if(prerun_graph(ref_graph) < 0)
+    {
+        std::cerr << "prerun_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+        return -1;
+    }
+
+    unsetenv("GRAPH_OPT_DISABLE");
+
+    int ret = 0;
+
+    if(check_views(graph, true) < 0 || check_views(ref_graph, false) < 0)
+        ret = -1;
+
+    /* twice, so that the second run starts from the memory the first one left */
+    for(int i = 0; i < 2; i++)
+    {
+        if(run_graph(graph, 1) < 0 || run_graph(ref_graph, 1) < 0)
+        {
+            std::cerr << "run_graph failed: ERRNO: " << get_tengine_errno() << "\n";
+            return -1;
+        }
+    }
+
+    tensor_t output_tensor = get_graph_output_tensor(graph, 0, 0);
+    tensor_t ref_output_tensor = get_graph_output_tensor(ref_graph, 0, 0);
+    const float* output = ( const float* )get_tensor_buffer(output_tensor);
+    const float* ref_output = ( const float* )get_tensor_buffer(ref_output_tensor);
+    int size = get_tensor_buffer_size(output_tensor) / sizeof(float);
+
+    for(int i = 0; i < size && ret == 0; i++)
+    {
+        if(output[i] != ref_output[i])
+        {
+            printf("mismatch: [%d] %f vs %f\n", i, output[i], ref_output[i]);
+            ret = -1;
+        }
+    }
+
+    release_graph_tensor(output_tensor);
+    release_graph_tensor(ref_output_tensor);
+
+    postrun_graph(graph);
+    destroy_graph(graph);
+    postrun_graph(ref_graph);
+    destroy_graph(ref_graph);
+
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+
+    release_tengine();
+
+    return ret;
+}